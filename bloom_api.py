@@ -5,6 +5,12 @@ from datetime import date
 import blpapi
 import pdblp
 from xbbg import blp
+import bspricer
+
+#ONE VOL SURFACE PER TICKER, ONLY THE EXPIRIES WHOSE QUOTES CHANGED ARE REFITTED ON A REFRESH
+Vol_surfaces={}
+#the expiries last quoted into the surface of each ticker, as year fractions from the day they were quoted
+Surface_expiries={}
 
 #Function to get the dividend dates and dividends based on the tikcer searched
 def Bloom_ticker_api():
@@ -101,6 +107,8 @@ def Bloom_ticker_api():
     CHF_Tenor = ['1 WK', '2 W', '1 MO', '2 MO', '3 MO', '4 MO', '5 MO', '6 MO', '7 MO', '8 MO', '9 MO', '10 MO', '11 MO', '12 MO', '15 MO', '18 MO', '21 MO', '2 YR', '3 YR']
     CHF_days= [7, 14, 30, 60, 90, 120, 150, 180, 210, 240, 270, 300, 330, 360, 450, 540, 630, 720, 1080]
 
+#SONIA ACCRUES ON ACTUAL/365, ESTR AND SARON ON ACTUAL/360
+    Day_basis=360
     Input_value= Search_Bloom_ticker
     if(Input_value== 'EUR'):
         Input_value=EURO_Curncy
@@ -110,6 +118,7 @@ def Bloom_ticker_api():
         Input_value=GBP_Curncy
         Input_tenor=GBP_Tenor
         Input_days= GBP_days
+        Day_basis=365
     elif(Input_value== 'CHF'):
         Input_value=CHF_Curncy
         Input_tenor=CHF_Tenor
@@ -121,20 +130,22 @@ def Bloom_ticker_api():
     bloom_data_array, Final_display_array=[],[]
     con = pdblp.BCon(timeout=20000)
     con.start()
-    for i in range(len(Input_value)):
-        bloom_data=con.ref(Input_value[i] ,flds=["PX_LAST"])
-        bloom_data_array.append(bloom_data['value'])
+#all the swap tickers of the curve in one request
+    bloom_data=con.ref(Input_value ,flds=["PX_LAST"])
+    Swap_rates=dict(zip(bloom_data['ticker'], bloom_data['value']))
+    for i in Input_value:
+        bloom_data_array.append(Swap_rates[i])
     
     for i in  range(len(bloom_data_array)):
         False_display=[]
         False_display.append(Input_tenor[i])
         False_display.append(Input_days[i])
-        False_display.append(bloom_data_array[i][0])
+        False_display.append(bloom_data_array[i])
         Final_display_array.insert(i,False_display)
 
     print('Final_curreny_rates_array :',Final_display_array)
     
-    Output={'Final_display_array':Final_display_array, 'Ticker':Ticker_data, 'Spot_price':Spot_Price,'Dividend_date':Dividend_date, 'Dividend_rate':Dividend_rate }
+    Output={'Final_display_array':Final_display_array, 'Ticker':Ticker_data, 'Spot_price':Spot_Price,'Dividend_date':Dividend_date, 'Dividend_rate':Dividend_rate, 'Day_basis':Day_basis }
     return  Output
 
 def dvd_hist_all_response_handler(event):
@@ -211,27 +222,44 @@ def Bloom_strike_api():
 
 
 
-#For match the closest interest rate possible by matching with nearest dates
-def closest(Interest_data, res): 
-    return Interest_data[min(range(len(Interest_data)), key = lambda i: abs(Interest_data[i][1]-res))]
+#ONE BOOTSTRAPPED CURVE PER SET OF SWAP TENORS, A QUOTE THAT TICKS ONLY RE-BOOTSTRAPS ITS TENOR AND THE LONGER ONES
+Discount_curves={}
+
+def Bloom_discount_curve(Interest_data, Day_basis):
+    Curve_days=[int(i[1]) for i in Interest_data]
+    Curve_rates=[float(i[2])/100 for i in Interest_data]
+    Key=(tuple(Curve_days), Day_basis)
+    if Key not in Discount_curves:
+        Discount_curves[Key]=[bspricer.CurveBuilder(Day_basis), None]
+        Discount_curves[Key][0].set_quotes(Curve_days, Curve_rates)
+    else:
+        for i in range(len(Curve_rates)):
+            if Discount_curves[Key][1][i] != Curve_rates[i]:
+                Discount_curves[Key][0].update_quote(i, Curve_rates[i])
+    Discount_curves[Key][1]=Curve_rates
+    Discount_curves[Key][0].publish()
+    return Discount_curves[Key][0]
 
 
-#TO GET THE CLOSEST INTEREST RATE DEPENDING UPON THE MATURITY 
+#TO GET THE ZERO RATE TO THE MATURITY FROM THE CURVE BOOTSTRAPPED FROM THE SWAP RATES OF Bloom_ticker_api
 def Bloom_get_interestrate():
     Maturity_items = request.get_json()
     Mat_date, Interest_data=[],[]
+#the day count basis of the curve comes from the currency search in Bloom_ticker_api, Actual/360 if the page did not send one
+    Day_basis=360.0
     
     for i in Maturity_items:
         Mat_date.append(i['Maturity_data'])
         Interest_data=(i['Interest_Rate'])
+        Day_basis=float(i.get('Day_basis', Day_basis))
         
     dt = str(date.today())
 
     res = abs(datetime.datetime.strptime(dt, "%Y-%m-%d") - datetime.datetime.strptime(Mat_date[0], "%m/%d/%y")).days
     #print(res)
 
-    Interest_value=closest(Interest_data, res)
-    New_Interest_value=Interest_value[2]/100
+    Curve=Bloom_discount_curve(Interest_data, Day_basis)
+    New_Interest_value=Curve.zero_rates([res/365.0])[0]
     
     return {'New_Interest_value':New_Interest_value }    
 
@@ -297,6 +325,109 @@ def Bloom_refresh_api():
         Strikes_combined_data.append(Strikes_list_data)
 
     #Option_market_values order is VOl followed by BID followed by ASK prices 
-    Output={ 'Strike_price_value': Market_spot[0],'Option_market_values': Strikes_combined_data }
+    #Chain_value is the strategy repriced from the refreshed spot and vols, or None if a leg is not complete
+    Chain_value=None
+    try:
+        Chain_value=Chain_strategy_value(float(Market_spot[0]), Refresh_Data, [float(i[0]) for i in Strikes_combined_data])
+    except (IndexError, KeyError, TypeError, ValueError) as e:
+        print('Strategy not repriced:', e)
+    Output={ 'Strike_price_value': Market_spot[0],'Option_market_values': Strikes_combined_data, 'Chain_value': Chain_value }
     
     return Output
+
+
+
+#PRICE THE STRATEGY OF THE REFRESHED LEGS WITH ONE FORWARD PDE SOLVE PER EXPIRY, WHICH PRICES EVERY STRIKE OF THAT EXPIRY AT ONCE
+#EACH LEG GIVES ITS STRIKE, MATURITY ("%m/%d/%y"), TYPE, STYLE AND MULTIPLE, THE FIRST ONE THE RATE AS A DECIMAL AND THE DIVIDENDS ("%d-%m-%Y")
+#A STRIKE QUOTED BY BOTH A CALL AND A PUT LEG OF AN EXPIRY TAKES THE VOL OF THE FIRST
+def Chain_strategy_value(Spot, Legs, Vols):
+    
+    today=date.today()
+    Rate=float(Legs[0]['Interest_Rate'])
+    Div_times=[(datetime.datetime.strptime(i, '%d-%m-%Y').date() - today).days / 365.0 for i in (Legs[0].get('Dividend_date') or [])]
+    Div_amounts=[float(i) for i in (Legs[0].get('Dividend') or [])]
+
+    Expiry_rows={}
+    for i in range(len(Legs)):
+        Expiry=(datetime.datetime.strptime(Legs[i]['Maturity_data'], "%m/%d/%y").date() - today).days / 365.0
+        if Expiry <= 0 or not Vols[i] > 0:
+            raise ValueError('leg ' + str(i) + ' has expired or has no vol')
+        Expiry_rows.setdefault(Expiry, []).append(i)
+
+    Value=0.0
+    for Expiry in Expiry_rows:
+        Rows=Expiry_rows[Expiry]
+        Strike_vols={}
+        for i in Rows:
+            Strike_vols.setdefault(float(Legs[i]['Strike_value']), Vols[i])
+        Strikes=sorted(Strike_vols)
+        Paid=[k for k in range(len(Div_times)) if 0 < Div_times[k] <= Expiry]
+        Prices=bspricer.price_chain(Spot, Rate, Expiry, Strikes, [Strike_vols[k] for k in Strikes], [Div_times[k] for k in Paid], [Div_amounts[k] for k in Paid])
+        for i in Rows:
+            Column=('american_' if int(Legs[i]['Option_data_zone']) else '') + ('call' if int(Legs[i]['Option_type_data']) else 'put')
+            Value+=float(Legs[i]['Multiple']) * Prices[Column][Strikes.index(float(Legs[i]['Strike_value']))]
+    return Value
+
+
+
+#BUILD THE VOL SURFACE OF THE TICKER FROM THE IVOL_MID OF ITS WHOLE OPT_CHAIN AND RETURN THE SURFACE VOL OF EVERY LEG
+#LEGS ARE GIVEN AS STRIKE AND MATURITY ("%m/%d/%y"), THE RATE AS A DECIMAL
+def Bloom_surface_api():
+    
+    con = pdblp.BCon(timeout=20000)
+    con.start()
+    Surface_data= request.get_json()
+    Ticker_data=Surface_data['ticker_name']
+    Rate=float(Surface_data['Interest_Rate'])
+    
+    Market_spot=con.ref(Ticker_data + "Equity",flds=['last_price'])
+    Market_spot=float(Market_spot.loc[:,"value"][0])
+
+    Chain_data=con.bulkref(Ticker_data + "Equity",flds=['OPT_CHAIN'])
+    Chain_data=list(Chain_data.loc[:,"value"])
+    data=con.ref(Chain_data, flds=['IVOL_MID'])
+    
+    today=datetime.datetime.strptime(str(date.today()), "%Y-%m-%d")
+
+#OPTION TICKERS LOOK LIKE "XYZ US 11/18/22 P45 Equity", ONLY THE OUT OF THE MONEY SIDE OF EACH STRIKE IS KEPT
+    Expiry_quotes={}
+    for i in range(len(data)):
+        Option_ticker=data['ticker'].iloc[i]
+        volatility=data['value'].iloc[i]
+        parts=Option_ticker.split()
+        if len(parts) < 4 or not volatility == volatility or volatility <= 0:
+            continue
+        Option_type=parts[-2][0]
+        Strike=float(parts[-2][1:])
+        if (Option_type == 'P') != (Strike < Market_spot):
+            continue
+        Expiry=(datetime.datetime.strptime(parts[-3], "%m/%d/%y") - today).days / 365.0
+        if Expiry <= 0:
+            continue
+        Expiry_quotes.setdefault(Expiry, []).append((Strike, volatility/100))
+
+    if Ticker_data not in Vol_surfaces:
+        Vol_surfaces[Ticker_data]=bspricer.VolSurfaceBuilder()
+    Builder=Vol_surfaces[Ticker_data]
+    Quoted_expiries=set()
+    for Expiry in Expiry_quotes:
+        Quotes=sorted(Expiry_quotes[Expiry])
+        if len(Quotes) < 3:
+            continue
+        Builder.update(Market_spot, Rate, Expiry, [q[0] for q in Quotes], [q[1] for q in Quotes], [], [])
+        Quoted_expiries.add(Expiry)
+#expiries are keyed by year fraction from today, so the keys of earlier days, expired or not, and the expiries no longer quoted are dropped
+    for Expiry in Surface_expiries.get(Ticker_data, set()) - Quoted_expiries:
+        Builder.remove(Expiry)
+    Surface_expiries[Ticker_data]=Quoted_expiries
+    Surface_version=Builder.publish()
+
+    Leg_strikes, Leg_expiries=[],[]
+    for i in Surface_data['legs']:
+        Leg_strikes.append(float(i['Strike_value']))
+        Leg_expiries.append((datetime.datetime.strptime(i['Maturity_data'], "%m/%d/%y") - today).days / 365.0)
+    Surface_vols=[]
+    if Surface_version > 0 and len(Leg_strikes) > 0:
+        Surface_vols=["{0:.3f}".format(v) for v in Builder.vols(Leg_strikes, Leg_expiries)]
+
+    return {'Surface_version': Surface_version, 'Vol_values': Surface_vols }
@@ -424,6 +424,7 @@ class EntitlementsVerificationRequestResponseExample {
 
     void registerCallbacks()
     {
+        d_sessionRouter.setPrintEvents(true);
         d_sessionRouter.registerExceptionHandler(
                 [this](Session *session,
                         const Event& event,
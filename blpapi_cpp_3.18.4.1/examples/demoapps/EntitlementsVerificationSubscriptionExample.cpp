@@ -373,6 +373,7 @@ class EntitlementsVerificationSubscriptionExample {
 
     void registerCallbacks()
     {
+        d_sessionRouter.setPrintEvents(true);
         d_sessionRouter.registerExceptionHandler(
                 [this](Session *session,
                         const Event& event,
@@ -29,7 +29,7 @@
 #include <iomanip>
 #include <iostream>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #include <util/ConnectionAndAuthOptions.h>
 #include <util/SubscriptionOptions.h>
@@ -41,14 +41,14 @@ using namespace blpapi;
 namespace {
 
 class SessionEventHandler : public EventHandler {
-    const std::unordered_map<int, std::string>& d_topicMap;
+    const std::vector<std::string>& d_topics;
     void processSubscriptionStatus(const Event& event);
     void processSubscriptionDataEvent(const Event& event);
     void processGenericMessage(const Event& event);
 
   public:
-    SessionEventHandler(const std::unordered_map<int, std::string>& topicMap)
-        : d_topicMap(topicMap)
+    SessionEventHandler(const std::vector<std::string>& topics)
+        : d_topics(topics)
     {
     }
 
@@ -61,7 +61,7 @@ void SessionEventHandler::processSubscriptionStatus(const Event& event)
     while (msgIter.next()) {
         Message msg = msgIter.message();
         auto topicId = msg.correlationId().asInteger();
-        auto topic = d_topicMap.at(topicId);
+        const std::string& topic = d_topics.at(topicId);
         std::cout << Utils::getFormattedCurrentTime() << ": " << topic << "\n";
         msg.print(std::cout) << "\n";
 
@@ -82,7 +82,7 @@ void SessionEventHandler::processSubscriptionDataEvent(const Event& event)
     while (msgIter.next()) {
         Message msg = msgIter.message();
         auto topicId = msg.correlationId().asInteger();
-        auto topic = d_topicMap.at(topicId);
+        const std::string& topic = d_topics.at(topicId);
         std::cout << Utils::getFormattedCurrentTime() << ": " << topic << "\n";
         msg.print(std::cout) << "\n";
     }
@@ -113,7 +113,7 @@ void SessionEventHandler::processGenericMessage(const Event& event)
             msg.print(std::cout) << "\n";
 
             auto topicId = msg.correlationId().asInteger();
-            auto topic = d_topicMap.at(topicId);
+            const std::string& topic = d_topics.at(topicId);
             std::cout << Names::dataLoss()
                       << " - The application is too slow to "
                       << "process events and the event queue is overflowing. "
@@ -165,7 +165,9 @@ class SubscriptionExample {
     ConnectionAndAuthOptions d_connectionAndAuthOptions;
     SubscriptionOptions d_subscriptionOptions;
     int d_eventQueueSize;
-    std::unordered_map<int, std::string> d_topicMap;
+    // The topic of each subscription, indexed by its integer correlation
+    // id, which are handed out densely from 0.
+    std::vector<std::string> d_topics;
 
     bool parseCommandLine(int argc, const char **argv)
     {
@@ -210,7 +212,7 @@ class SubscriptionExample {
         d_subscriptionOptions.setUpSessionOptions(sessionOptions);
         sessionOptions.setMaxEventQueueSize(d_eventQueueSize);
 
-        SessionEventHandler handler(d_topicMap);
+        SessionEventHandler handler(d_topics);
         Session session(sessionOptions, &handler);
 
         if (!session.start()) {
@@ -231,7 +233,10 @@ class SubscriptionExample {
         const SubscriptionList subscriptions
                 = d_subscriptionOptions.createSubscriptionList(
                         [this](size_t topicId, const std::string& topic) {
-                            d_topicMap[topicId] = topic;
+                            if (d_topics.size() <= topicId) {
+                                d_topics.resize(topicId + 1);
+                            }
+                            d_topics[topicId] = topic;
                             return CorrelationId(topicId);
                         });
 
@@ -246,6 +246,7 @@ class UserModeExample {
 
     void registerCallbacks()
     {
+        d_sessionRouter.setPrintEvents(true);
         d_sessionRouter.registerExceptionHandler(
                 [this](Session *session,
                         const Event& event,
@@ -21,15 +21,23 @@
 #ifndef SESSION_ROUTER_H
 #define SESSION_ROUTER_H
 
+#include <blpapi_correlationid.h>
 #include <blpapi_event.h>
 #include <blpapi_message.h>
+#include <blpapi_name.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <exception>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <set>
+#include <utility>
+#include <vector>
 
 #include <util/Utils.h>
 
@@ -37,10 +45,82 @@ namespace BloombergLP {
 
 enum class ExampleState { STARTING, STARTED, TERMINATED };
 
+template <typename VALUE>
+class DenseTable
+// 'DenseTable' maps the integer keys of a dense range to values, held in
+// an array indexed by the key less the smallest key. A lookup is one
+// subtraction and one bounds check.
+{
+  private:
+    long long d_base;
+    std::vector<VALUE> d_values;
+    std::vector<bool> d_present;
+
+  public:
+    DenseTable();
+
+    void assign(const std::vector<std::pair<long long, VALUE> >& entries);
+    // Make this table hold exactly the specified 'entries', whose keys
+    // must be distinct.
+
+    const VALUE *find(long long key) const;
+    // Return the value of the specified 'key', or a null pointer if it has
+    // none.
+};
+
+template <typename KEY, typename VALUE, typename HASH>
+class FlatTable
+// 'FlatTable' is an immutable open addressing hash table: the entries are
+// held in one array, and a power of two sized array of slots indexes it,
+// probed linearly from the hash of the key, so a lookup touches two
+// arrays and no nodes.
+{
+  private:
+    std::vector<std::pair<KEY, VALUE> > d_entries;
+    std::vector<int> d_slots; // index into 'd_entries', or -1 if empty
+    size_t d_mask;
+
+  public:
+    FlatTable();
+
+    void assign(const std::vector<std::pair<KEY, VALUE> >& entries);
+    // Make this table hold exactly the specified 'entries', whose keys
+    // must be distinct.
+
+    const VALUE *find(const KEY& key) const;
+    // Return the value of the specified 'key', or a null pointer if it has
+    // none.
+};
+
+struct SessionRouterHash
+// 'SessionRouterHash' hashes the correlation ids and message type names
+// handlers are registered for.
+{
+    static size_t mix(uint64_t value);
+    // Return the specified 'value' with its bits mixed, so that keys
+    // differing only in their high bits, or aligned pointers, spread
+    // over the slots.
+
+    size_t operator()(const blpapi::CorrelationId& cid) const;
+
+    size_t operator()(const blpapi::Name& name) const;
+};
+
 template <typename SessionType>
 class SessionRouter : public SessionType::EventHandler
 // 'SessionRouter' provides user means to register for events/messages they
 // are interested in. It promotes async processing of event and messages.
+//
+// Registration is rare and dispatch is on every message, so the handlers
+// are kept for dispatch in an immutable snapshot, published through an
+// atomic pointer by the registration functions, which rebuild it under a
+// mutex. Dispatch loads the snapshot and looks the handlers up without
+// taking a lock or copying them: event type handlers from arrays indexed
+// by event type, integer correlation id handlers from an array indexed by
+// correlation id if the ids registered are dense, and the others from
+// flat hash tables. Dispatch is wait-free. A snapshot replaced while
+// events are being dispatched is freed by a later registration, once no
+// event is being dispatched, or by the destructor.
 {
   private:
     using Cid = blpapi::CorrelationId;
@@ -80,9 +160,21 @@ class SessionRouter : public SessionType::EventHandler
 
     using EventHandlersByEvent = std::map<Event::EventType, EventHandler>;
 
+    struct Snapshot {
+        DenseTable<EventHandler> d_eventHandlersByEventType;
+        DenseTable<MessageHandler> d_messageHandlersByEventType;
+        DenseTable<MessageHandler> d_messageHandlersByIntegerCid;
+        FlatTable<Cid, MessageHandler, SessionRouterHash>
+                d_messageHandlersByCid;
+        FlatTable<Name, MessageHandler, SessionRouterHash>
+                d_messageHandlersByName;
+        ExceptionHandler d_exceptionHandler;
+    };
+
     mutable std::mutex d_mutex;
 
   private:
+    // The handlers as registered, guarded by 'd_mutex'.
     MessageHandlersByCid d_messageHandlersByCid;
     MessageHandlersByEvent d_messageHandlersByEventType;
     MessageHandlersByName d_messageHandlersByName;
@@ -91,10 +183,26 @@ class SessionRouter : public SessionType::EventHandler
 
     ExceptionHandler d_exceptionHandler;
 
+    // The snapshot dispatched from, and those it replaced that may still
+    // be in use, guarded by 'd_mutex'.
+    std::atomic<const Snapshot *> d_snapshot;
+    std::vector<std::unique_ptr<const Snapshot> > d_retired;
+    std::atomic<int> d_dispatching;
+
+    std::atomic<bool> d_printEvents;
+
+    void publish();
+    // Replace the snapshot with one of the handlers as registered. The
+    // caller must hold 'd_mutex'.
+
   public:
     SessionRouter();
     ~SessionRouter();
 
+    void setPrintEvents(bool printEvents);
+    // Print every message of every event processed to 'std::cout' if the
+    // specified 'printEvents' is true. By default events are not printed.
+
     void registerMessageHandler(
             Event::EventType eventType, const MessageHandler& messageHandler);
     // Registers 'messageHandler' for the given 'eventType'. The
@@ -128,15 +236,212 @@ class SessionRouter : public SessionType::EventHandler
     bool processEvent(const Event& event, SessionType *session) override;
 };
 
+template <typename VALUE>
+inline DenseTable<VALUE>::DenseTable()
+    : d_base(0)
+{
+}
+
+template <typename VALUE>
+inline void DenseTable<VALUE>::assign(
+        const std::vector<std::pair<long long, VALUE> >& entries)
+{
+    d_values.clear();
+    d_present.clear();
+    if (entries.empty()) {
+        return;
+    }
+
+    long long low = entries[0].first;
+    long long high = entries[0].first;
+    for (const auto& entry : entries) {
+        low = std::min(low, entry.first);
+        high = std::max(high, entry.first);
+    }
+    d_base = low;
+    d_values.resize(static_cast<size_t>(high - low + 1));
+    d_present.resize(d_values.size());
+    for (const auto& entry : entries) {
+        d_values[static_cast<size_t>(entry.first - low)] = entry.second;
+        d_present[static_cast<size_t>(entry.first - low)] = true;
+    }
+}
+
+template <typename VALUE>
+inline const VALUE *DenseTable<VALUE>::find(long long key) const
+{
+    const unsigned long long index
+            = static_cast<unsigned long long>(key - d_base);
+    if (index >= d_values.size() || !d_present[index]) {
+        return nullptr;
+    }
+    return &d_values[index];
+}
+
+template <typename KEY, typename VALUE, typename HASH>
+inline FlatTable<KEY, VALUE, HASH>::FlatTable()
+    : d_mask(0)
+{
+}
+
+template <typename KEY, typename VALUE, typename HASH>
+inline void FlatTable<KEY, VALUE, HASH>::assign(
+        const std::vector<std::pair<KEY, VALUE> >& entries)
+{
+    d_entries = entries;
+    d_slots.clear();
+    if (entries.empty()) {
+        return;
+    }
+
+    // At most half the slots are used, so probes stay short.
+    size_t size = 2;
+    while (size < 2 * entries.size()) {
+        size *= 2;
+    }
+    d_slots.assign(size, -1);
+    d_mask = size - 1;
+    for (size_t i = 0; i < d_entries.size(); ++i) {
+        size_t slot = HASH()(d_entries[i].first) & d_mask;
+        while (d_slots[slot] >= 0) {
+            slot = (slot + 1) & d_mask;
+        }
+        d_slots[slot] = static_cast<int>(i);
+    }
+}
+
+template <typename KEY, typename VALUE, typename HASH>
+inline const VALUE *FlatTable<KEY, VALUE, HASH>::find(const KEY& key) const
+{
+    if (d_slots.empty()) {
+        return nullptr;
+    }
+    for (size_t slot = HASH()(key) & d_mask; d_slots[slot] >= 0;
+            slot = (slot + 1) & d_mask) {
+        const std::pair<KEY, VALUE>& entry = d_entries[d_slots[slot]];
+        if (entry.first == key) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+inline size_t SessionRouterHash::mix(uint64_t value)
+{
+    // The finalizer of MurmurHash3.
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return static_cast<size_t>(value);
+}
+
+inline size_t SessionRouterHash::operator()(
+        const blpapi::CorrelationId& cid) const
+{
+    uint64_t value = 0;
+    switch (cid.valueType()) {
+    case blpapi::CorrelationId::POINTER_VALUE:
+        value = reinterpret_cast<uintptr_t>(cid.asPointer());
+        break;
+    case blpapi::CorrelationId::INT_VALUE:
+    case blpapi::CorrelationId::AUTOGEN_VALUE:
+        value = static_cast<uint64_t>(cid.asInteger());
+        break;
+    default:
+        break;
+    }
+    return mix(value ^ (static_cast<uint64_t>(cid.classId()) << 48)
+            ^ (static_cast<uint64_t>(cid.valueType()) << 60));
+}
+
+inline size_t SessionRouterHash::operator()(const blpapi::Name& name) const
+{
+    return mix(name.hash());
+}
+
 template <typename SessionType>
 inline SessionRouter<SessionType>::SessionRouter()
     : d_exceptionHandler(nullptr)
+    , d_snapshot(new Snapshot())
+    , d_dispatching(0)
+    , d_printEvents(false)
 {
 }
 
 template <typename SessionType>
 inline SessionRouter<SessionType>::~SessionRouter()
 {
+    delete d_snapshot.load();
+}
+
+template <typename SessionType>
+inline void SessionRouter<SessionType>::publish()
+{
+    std::unique_ptr<Snapshot> snapshot(new Snapshot());
+
+    std::vector<std::pair<long long, EventHandler> > eventHandlers;
+    for (const auto& entry : d_eventHandlersByEventType) {
+        eventHandlers.emplace_back(entry.first, entry.second);
+    }
+    snapshot->d_eventHandlersByEventType.assign(eventHandlers);
+
+    std::vector<std::pair<long long, MessageHandler> > byEventType;
+    for (const auto& entry : d_messageHandlersByEventType) {
+        byEventType.emplace_back(entry.first, entry.second);
+    }
+    snapshot->d_messageHandlersByEventType.assign(byEventType);
+
+    // Integer correlation ids are usually handed out in sequence, so go in
+    // an array unless they are spread too far apart.
+    std::vector<std::pair<long long, MessageHandler> > byIntegerCid;
+    std::vector<std::pair<Cid, MessageHandler> > byCid;
+    long long low = 0;
+    long long high = 0;
+    for (const auto& entry : d_messageHandlersByCid) {
+        const Cid& cid = entry.first;
+        if (cid.valueType() != Cid::INT_VALUE || cid.classId() != 0) {
+            byCid.emplace_back(cid, entry.second);
+            continue;
+        }
+        if (byIntegerCid.empty()) {
+            low = high = cid.asInteger();
+        }
+        low = std::min(low, cid.asInteger());
+        high = std::max(high, cid.asInteger());
+        byIntegerCid.emplace_back(cid.asInteger(), entry.second);
+    }
+    if (!byIntegerCid.empty()
+            && static_cast<unsigned long long>(high - low)
+                    > 4 * byIntegerCid.size() + 64) {
+        for (const auto& entry : byIntegerCid) {
+            byCid.emplace_back(Cid(entry.first), entry.second);
+        }
+        byIntegerCid.clear();
+    }
+    snapshot->d_messageHandlersByIntegerCid.assign(byIntegerCid);
+    snapshot->d_messageHandlersByCid.assign(byCid);
+
+    std::vector<std::pair<Name, MessageHandler> > byName(
+            d_messageHandlersByName.begin(), d_messageHandlersByName.end());
+    snapshot->d_messageHandlersByName.assign(byName);
+
+    snapshot->d_exceptionHandler = d_exceptionHandler;
+
+    d_retired.emplace_back(d_snapshot.exchange(snapshot.release()));
+
+    // A dispatch that starts from now on loads the new snapshot, so once
+    // none is under way the replaced ones are no longer in use.
+    if (d_dispatching.load() == 0) {
+        d_retired.clear();
+    }
+}
+
+template <typename SessionType>
+inline void SessionRouter<SessionType>::setPrintEvents(bool printEvents)
+{
+    d_printEvents.store(printEvents, std::memory_order_relaxed);
 }
 
 template <typename SessionType>
@@ -145,6 +450,7 @@ inline void SessionRouter<SessionType>::registerEventHandler(
 {
     std::lock_guard<std::mutex> lg(d_mutex);
     d_eventHandlersByEventType[eventType] = eventHandler;
+    publish();
 }
 
 template <typename SessionType>
@@ -153,6 +459,7 @@ inline void SessionRouter<SessionType>::registerMessageHandler(
 {
     std::lock_guard<std::mutex> lg(d_mutex);
     d_messageHandlersByEventType[eventType] = messageHandler;
+    publish();
 }
 
 template <typename SessionType>
@@ -161,6 +468,7 @@ inline void SessionRouter<SessionType>::registerMessageHandler(
 {
     std::lock_guard<std::mutex> lg(d_mutex);
     d_messageHandlersByName[messageType] = messageHandler;
+    publish();
 }
 
 template <typename SessionType>
@@ -169,6 +477,7 @@ inline void SessionRouter<SessionType>::registerMessageHandler(
 {
     std::lock_guard<std::mutex> lg(d_mutex);
     d_messageHandlersByCid[cid] = messageHandler;
+    publish();
 }
 
 template <typename SessionType>
@@ -177,6 +486,7 @@ inline void SessionRouter<SessionType>::registerExceptionHandler(
 {
     std::lock_guard<std::mutex> lg(d_mutex);
     d_exceptionHandler = exceptionHandler;
+    publish();
 }
 
 template <typename SessionType>
@@ -185,6 +495,7 @@ inline void SessionRouter<SessionType>::deregisterEventHandler(
 {
     std::lock_guard<std::mutex> lg(d_mutex);
     d_eventHandlersByEventType.erase(eventType);
+    publish();
 }
 
 template <typename SessionType>
@@ -193,6 +504,7 @@ inline void SessionRouter<SessionType>::deregisterMessageHandler(
 {
     std::lock_guard<std::mutex> lg(d_mutex);
     d_messageHandlersByEventType.erase(eventType);
+    publish();
 }
 
 template <typename SessionType>
@@ -201,6 +513,7 @@ inline void SessionRouter<SessionType>::deregisterMessageHandler(
 {
     std::lock_guard<std::mutex> lg(d_mutex);
     d_messageHandlersByName.erase(messageType);
+    publish();
 }
 
 template <typename SessionType>
@@ -209,6 +522,7 @@ inline void SessionRouter<SessionType>::deregisterMessageHandler(
 {
     std::lock_guard<std::mutex> lg(d_mutex);
     d_messageHandlersByCid.erase(cid);
+    publish();
 }
 
 template <typename SessionType>
@@ -216,91 +530,76 @@ inline void SessionRouter<SessionType>::deregisterExceptionHandler()
 {
     std::lock_guard<std::mutex> lg(d_mutex);
     d_exceptionHandler = nullptr;
+    publish();
 }
 
 template <typename SessionType>
 inline bool SessionRouter<SessionType>::processEvent(
         const Event& event, SessionType *session)
 {
-    try {
-        Utils::printEvent(event);
+    // The snapshot is not freed while 'd_dispatching' counts this call.
+    struct Dispatch {
+        std::atomic<int>& d_dispatching;
 
-        EventHandler eh;
+        explicit Dispatch(std::atomic<int>& dispatching)
+            : d_dispatching(dispatching)
         {
-            std::lock_guard<std::mutex> lg(d_mutex);
-            auto const it = d_eventHandlersByEventType.find(event.eventType());
-            if (it != d_eventHandlersByEventType.end()) {
-                eh = it->second;
-            }
+            ++d_dispatching;
+        }
+
+        ~Dispatch() { --d_dispatching; }
+    } dispatch(d_dispatching);
+    const Snapshot& snapshot = *d_snapshot.load();
+
+    try {
+        if (d_printEvents.load(std::memory_order_relaxed)) {
+            Utils::printEvent(event);
         }
 
+        const Event::EventType eventType = event.eventType();
+        const EventHandler *eh
+                = snapshot.d_eventHandlersByEventType.find(eventType);
         if (eh) {
-            eh(session, event);
+            (*eh)(session, event);
         }
 
         // Invoke registered messagehandlers.
+        const MessageHandler *byEventType
+                = snapshot.d_messageHandlersByEventType.find(eventType);
         blpapi::MessageIterator it(event);
         while (it.next()) {
             Message msg = it.message();
             const int cidCount = msg.numCorrelationIds();
 
-            for (unsigned i = 0; i < cidCount; ++i) {
+            for (int i = 0; i < cidCount; ++i) {
                 auto const& cid = msg.correlationId(i);
-                MessageHandler mh;
-                {
-                    std::lock_guard<std::mutex> lg(d_mutex);
-                    auto const it = d_messageHandlersByCid.find(cid);
-                    if (it != d_messageHandlersByCid.end()) {
-                        mh = it->second;
-                    }
+                const MessageHandler *mh = nullptr;
+                if (cid.valueType() == Cid::INT_VALUE && cid.classId() == 0) {
+                    mh = snapshot.d_messageHandlersByIntegerCid.find(
+                            cid.asInteger());
                 }
-
-                if (mh) {
-                    mh(session, event, msg);
-                }
-            }
-
-            {
-                MessageHandler mh;
-                {
-                    std::lock_guard<std::mutex> lg(d_mutex);
-                    auto const it = d_messageHandlersByEventType.find(
-                            event.eventType());
-                    if (it != d_messageHandlersByEventType.end()) {
-                        mh = it->second;
-                    }
+                if (!mh) {
+                    mh = snapshot.d_messageHandlersByCid.find(cid);
                 }
 
                 if (mh) {
-                    mh(session, event, msg);
+                    (*mh)(session, event, msg);
                 }
             }
 
-            {
-                MessageHandler mh;
-                {
-                    std::lock_guard<std::mutex> lg(d_mutex);
-                    auto const it
-                            = d_messageHandlersByName.find(msg.messageType());
-                    if (it != d_messageHandlersByName.end()) {
-                        mh = it->second;
-                    }
-                }
+            if (byEventType) {
+                (*byEventType)(session, event, msg);
+            }
 
-                if (mh) {
-                    mh(session, event, msg);
-                }
+            const MessageHandler *mh
+                    = snapshot.d_messageHandlersByName.find(msg.messageType());
+            if (mh) {
+                (*mh)(session, event, msg);
             }
         }
     } catch (const std::exception& exception) {
-        ExceptionHandler eh;
-        {
-            std::lock_guard<std::mutex> lg(d_mutex);
-            eh = d_exceptionHandler;
-        }
-
-        if (eh) {
-            eh(session, event, exception);
+        if (snapshot.d_exceptionHandler) {
+            snapshot.d_exceptionHandler(session, event, exception);
         } else {
             std::cerr << "Exception in processing events\n"
                       << exception.what() << "\n";
@@ -0,0 +1,216 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Messages per second decoded from synthetic MarketDataEvents, looking each
+// field up by string, as the event processor used to, scanning every field
+// of a message for the planned ones, and with a FieldPlan. Real market data
+// messages carry dozens to hundreds of fields, so the messages are padded
+// with filler fields to each of several widths. Run with an optional number
+// of messages:
+//     mktnotifierbenchmarks [messages]
+
+#include <blpapi_element.h>
+#include <blpapi_event.h>
+#include <blpapi_messageformatter.h>
+#include <blpapi_testutil.h>
+
+#include <fieldplan.h>
+#include <testSchemas.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+namespace blp = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const int k_REPEATS = 10;
+const int k_FILLER_ID = 1000; // past the ids of the test schema's fields
+const char k_FIELDS_TAG[]
+        = "<description>fields in subscription</description>";
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Return the test market data schema with `fillers` more Float64 fields,
+// FILLER_0 and so on, ahead of the fields Tick has slots for.
+std::string paddedSchema(int fillers)
+{
+    std::string schema = getMktDataSchemaString();
+    std::ostringstream elements;
+    for (int i = 0; i < fillers; ++i) {
+        elements << "<element name=\"FILLER_" << i
+                 << "\" type=\"Float64\" id=\"" << k_FILLER_ID + i
+                 << "\" minOccurs=\"0\" maxOccurs=\"1\">"
+                 << "<description>Filler</description></element>";
+    }
+    const size_t at = schema.find(k_FIELDS_TAG) + sizeof k_FIELDS_TAG - 1;
+    return schema.insert(at, elements.str());
+}
+
+// Return an event of `messages` MarketDataEvents, each setting the prices,
+// sizes and volume, and `fillers` filler fields.
+blp::Event marketDataEvent(int messages, int fillers)
+{
+    std::istringstream schemaStream(paddedSchema(fillers));
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+    const blp::SchemaElementDefinition schemaDef
+            = service.getEventDefinition(blp::Name("MarketDataEvents"));
+    blp::Event event
+            = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    for (int i = 0; i < messages; ++i) {
+        blptst::MessageFormatter formatter
+                = blptst::TestUtil::appendMessage(event, schemaDef);
+        std::ostringstream content;
+        content << "{";
+        for (int f = 0; f < fillers; ++f) {
+            content << "\"FILLER_" << f << "\": " << f << ", ";
+        }
+        content << "\"LAST_PRICE\": " << 100.0 + 0.01 * (i % 100)
+                << ", \"BID\": 99.9, \"ASK\": 100.1, \"VOLUME\": " << i
+                << ", \"BID_SIZE\": 10, \"ASK_SIZE\": 20"
+                << ", \"SIZE_LAST_TRADE\": 5}";
+        formatter.formatMessageJson(content.str().c_str());
+    }
+    return event;
+}
+
+// Load into `tick` the fields of `msg`, looking each up by string.
+void decodeByString(Tick *tick, const blp::Message& msg)
+{
+    if (msg.hasElement("BID")) {
+        tick->d_bid = msg.getElementAsFloat64("BID");
+    }
+    if (msg.hasElement("ASK")) {
+        tick->d_ask = msg.getElementAsFloat64("ASK");
+    }
+    if (msg.hasElement("LAST_PRICE")) {
+        tick->d_lastPrice = msg.getElementAsFloat64("LAST_PRICE");
+    }
+    if (msg.hasElement("IVOL_MID")) {
+        tick->d_impliedVol = msg.getElementAsFloat64("IVOL_MID");
+    }
+}
+
+// Load into `tick` the fields of `msg`, scanning every field of the
+// message and matching it against interned names, as FieldPlan used to.
+void decodeByScan(Tick *tick, const blp::Message& msg)
+{
+    static const blp::Name NAMES[]
+            = { blp::Name("BID"), blp::Name("ASK"), blp::Name("LAST_PRICE"),
+                  blp::Name("IVOL_MID") };
+    static double Tick::*const SLOTS[] = { &Tick::d_bid,
+        &Tick::d_ask,
+        &Tick::d_lastPrice,
+        &Tick::d_impliedVol };
+    const blp::Element fields = msg.asElement();
+    const size_t numFields = fields.numElements();
+    for (size_t i = 0; i < numFields; ++i) {
+        const blp::Element field = fields.getElement(i);
+        const blp::Name name = field.name();
+        for (size_t j = 0; j < sizeof NAMES / sizeof *NAMES; ++j) {
+            if (NAMES[j] == name) {
+                if (!field.isNull()) {
+                    tick->*SLOTS[j] = field.getValueAsFloat64();
+                }
+                break;
+            }
+        }
+    }
+}
+
+// Decode every message of `event` with `decode` and return the time taken,
+// adding the prices decoded to `checksum`.
+template <class DECODE>
+double decodeAll(double *checksum, const blp::Event& event, DECODE decode)
+{
+    const Clock::time_point start = Clock::now();
+    blp::MessageIterator msgIter(event);
+    while (msgIter.next()) {
+        Tick tick;
+        decode(&tick, msgIter.message());
+        *checksum += tick.d_bid + tick.d_ask + tick.d_lastPrice;
+    }
+    return seconds(start);
+}
+
+struct PlanDecoder {
+    const FieldPlan *d_plan;
+
+    void operator()(Tick *tick, const blp::Message& msg) const
+    {
+        d_plan->decode(tick, msg);
+    }
+};
+}
+
+int main(int argc, char **argv)
+{
+    const int messages = argc > 1 ? std::atoi(argv[1]) : 20000;
+    if (messages < 1) {
+        std::fprintf(stderr, "usage: %s [messages >= 1]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> fields;
+    fields.push_back("BID");
+    fields.push_back("ASK");
+    fields.push_back("LAST_PRICE");
+    fields.push_back("IVOL_MID");
+    const FieldPlan plan(fields);
+    const PlanDecoder planDecoder = { &plan };
+
+    const int fillerCounts[] = { 0, 50, 250 };
+    for (size_t c = 0; c < sizeof fillerCounts / sizeof *fillerCounts; ++c) {
+        const blp::Event event = marketDataEvent(messages, fillerCounts[c]);
+        double checksum = 0.0;
+        double byString = 1e30;
+        double byScan = 1e30;
+        double byPlan = 1e30;
+        for (int r = 0; r < k_REPEATS; ++r) {
+            byString = std::min(
+                    byString, decodeAll(&checksum, event, decodeByString));
+            byScan = std::min(
+                    byScan, decodeAll(&checksum, event, decodeByScan));
+            byPlan = std::min(
+                    byPlan, decodeAll(&checksum, event, planDecoder));
+        }
+
+        std::printf("%d messages of %d fields (checksum %g)\n",
+                messages,
+                fillerCounts[c] + 7,
+                checksum);
+        std::printf("  %-20s %10.0f messages/s\n", "string lookups",
+                messages / byString);
+        std::printf("  %-20s %10.0f messages/s\n", "element scan",
+                messages / byScan);
+        std::printf("  %-20s %10.0f messages/s\n", "field plan",
+                messages / byPlan);
+    }
+    return 0;
+}
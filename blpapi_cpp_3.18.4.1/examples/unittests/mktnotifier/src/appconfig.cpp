@@ -58,6 +58,26 @@ const char USAGE[]
           "Equity)\n"
           "\t[-f    <field>]        field to subscribe to (default: empty)\n"
           "\t[-o    <option>]       subscription options (default: empty)\n"
+          "\t[-strategy <spec>]     strategy to value live, as\n"
+          "\t\t<name>=<leg>[;<leg>...] with each leg\n"
+          "\t\t<topic>,<C|P>,<strike>,<expiry in years>,<quantity>\n"
+          "\t[-chain <security>]   subscribe to the option chain of\n"
+          "\t\t<security>, for example \"IBM US Equity\"\n"
+          "\t[-shards <n>]          worker threads processing data, 0 for\n"
+          "\t\t                        the dispatcher thread (default: 2)\n"
+          "\t[-cpu  <cpu>]          pin the workers to CPUs from <cpu> on\n"
+          "\t[-sink <sink>]         where notifications are written, one\n"
+          "\t\tof stdout, file:<path> or binary:<path> (default: stdout)\n"
+          "\t[-backpressure <policy>] when notifications back up, drop\n"
+          "\t\tthem or block the caller (default: block)\n"
+          "\t[-latency <path>]     record the latency of each stage and\n"
+          "\t\tappend its percentiles to <path> periodically\n"
+          "\t[-latencyinterval <s>] seconds between those dumps (default:\n"
+          "\t\t10)\n"
+          "\t[-capture <path>]     append every event received to the\n"
+          "\t\tjournal <path>, for mktreplay\n"
+          "\t[-store <directory>]  append every tick to the per-day tick\n"
+          "\t\tsegments in <directory>\n"
           "\t[-auth <option>]       authentication option (default: user):\n"
           "\t\tnone\n"
           "\t\tuser                    as a user using OS logon information\n"
@@ -74,6 +94,11 @@ const char USAGE[]
 
 AppConfig::AppConfig()
     : d_port(8194)
+    , d_shards(2)
+    , d_firstCpu(-1)
+    , d_sink("stdout")
+    , d_dropNotifications(false)
+    , d_latencyInterval(10)
 {
 }
 
@@ -94,6 +119,39 @@ bool AppConfig::parseCommandLine(int argc, char **argv)
             d_fields.push_back(argv[++i]);
         } else if (!std::strcmp(argv[i], "-o") && i + 1 < argc) {
             d_options.push_back(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-strategy") && i + 1 < argc) {
+            d_strategies.push_back(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-chain") && i + 1 < argc) {
+            d_chains.push_back(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-shards") && i + 1 < argc) {
+            d_shards = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-cpu") && i + 1 < argc) {
+            d_firstCpu = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-sink") && i + 1 < argc) {
+            d_sink = argv[++i];
+        } else if (!std::strcmp(argv[i], "-backpressure") && i + 1 < argc) {
+            ++i;
+            if (!std::strcmp(argv[i], "drop")) {
+                d_dropNotifications = true;
+            } else if (!std::strcmp(argv[i], "block")) {
+                d_dropNotifications = false;
+            } else {
+                printUsage();
+                return false;
+            }
+        } else if (!std::strcmp(argv[i], "-latency") && i + 1 < argc) {
+            d_latencyPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "-latencyinterval")
+                && i + 1 < argc) {
+            d_latencyInterval = std::atoi(argv[++i]);
+            if (d_latencyInterval < 1) {
+                printUsage();
+                return false;
+            }
+        } else if (!std::strcmp(argv[i], "-capture") && i + 1 < argc) {
+            d_capturePath = argv[++i];
+        } else if (!std::strcmp(argv[i], "-store") && i + 1 < argc) {
+            d_storeDirectory = argv[++i];
         } else if (!std::strcmp(argv[i], "-auth") && i + 1 < argc) {
             ++i;
             if (!std::strcmp(argv[i], AUTH_OPTION_NONE)) {
@@ -131,6 +189,20 @@ bool AppConfig::parseCommandLine(int argc, char **argv)
         d_topics.push_back("/ticker/IBM US Equity");
     }
 
+    if (d_fields.empty()
+            && (!d_strategies.empty() || !d_chains.empty()
+                    || !d_storeDirectory.empty())) {
+        d_fields.emplace_back("BID");
+        d_fields.emplace_back("ASK");
+        d_fields.emplace_back("LAST_PRICE");
+        d_fields.emplace_back("IVOL_MID");
+        if (!d_storeDirectory.empty()) {
+            d_fields.emplace_back("BID_SIZE");
+            d_fields.emplace_back("ASK_SIZE");
+            d_fields.emplace_back("SIZE_LAST_TRADE");
+        }
+    }
+
     if (d_fields.empty()) {
         d_fields.emplace_back("LAST_PRICE");
     }
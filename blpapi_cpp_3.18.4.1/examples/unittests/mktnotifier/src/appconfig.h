@@ -33,6 +33,16 @@ class AppConfig {
     std::vector<std::string> d_options;
     std::string d_authOptions;
     std::string d_service;
+    std::vector<std::string> d_strategies;
+    std::vector<std::string> d_chains;
+    int d_shards;
+    int d_firstCpu;
+    std::string d_sink;
+    bool d_dropNotifications;
+    std::string d_latencyPath; // empty unless latencies are recorded
+    int d_latencyInterval; // seconds between latency dumps
+    std::string d_capturePath; // empty unless events are captured
+    std::string d_storeDirectory; // empty unless ticks are stored
 
     AppConfig();
     bool parseCommandLine(int argc, char **argv);
@@ -47,4 +47,14 @@ void Application::run()
             d_config->d_fields,
             d_config->d_options,
             identity);
+
+    d_identity = identity;
+    if (d_chainManager && !refreshChains()) {
+        std::cerr << "Failed to retrieve an option chain." << std::endl;
+    }
+}
+
+bool Application::refreshChains()
+{
+    return !d_chainManager || d_chainManager->refresh(d_identity);
 }
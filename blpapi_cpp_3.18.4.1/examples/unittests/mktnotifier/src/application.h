@@ -25,6 +25,7 @@
 
 #include "appconfig.h"
 #include "authorizer.h"
+#include "chainmanager.h"
 #include "eventprocessor.h"
 #include "subscriber.h"
 
@@ -37,27 +38,36 @@ class Application {
     ISubscriber *d_subscriber;
     blp::EventHandler *d_eventProcessor;
     AppConfig *d_config;
+    ChainManager *d_chainManager;
+    blp::Identity d_identity;
 
   public:
     Application(blp::Session *session,
             IAuthorizer *authorizer,
             ISubscriber *subscriber,
             blp::EventHandler *eventProcessor,
-            AppConfig *config);
+            AppConfig *config,
+            ChainManager *chainManager = 0);
 
     void run();
+
+    // Refresh the option chains of the chain manager, if any, once run()
+    // has subscribed, and return false if a chain could not be retrieved.
+    bool refreshChains();
 };
 
 inline Application::Application(blp::Session *session,
         IAuthorizer *authorizer,
         ISubscriber *subscriber,
         blp::EventHandler *eventProcessor,
-        AppConfig *config)
+        AppConfig *config,
+        ChainManager *chainManager)
     : d_session(session)
     , d_authorizer(authorizer)
     , d_subscriber(subscriber)
     , d_eventProcessor(eventProcessor)
     , d_config(config)
+    , d_chainManager(chainManager)
 {
 }
 
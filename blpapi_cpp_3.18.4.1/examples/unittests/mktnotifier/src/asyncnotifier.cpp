@@ -0,0 +1,303 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "asyncnotifier.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+// How long the writer sleeps when it finds the ring empty.
+const std::chrono::microseconds k_IDLE_SLEEP(50);
+
+const char SINK_STDOUT[] = "stdout";
+const char SINK_FILE[] = "file:";
+const char SINK_BINARY[] = "binary:";
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+template <class TYPE>
+void appendBytes(std::string *out, const TYPE& value)
+{
+    out->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <class TYPE>
+bool readBytes(TYPE *value, std::istream& stream)
+{
+    return static_cast<bool>(
+            stream.read(reinterpret_cast<char *>(value), sizeof(*value)));
+}
+
+std::string print(const blp::Message& msg)
+{
+    std::ostringstream stream;
+    msg.print(stream);
+    return stream.str();
+}
+}
+
+AsyncNotifier::Config::Config()
+    : d_sink(e_STDOUT)
+    , d_policy(e_BLOCK)
+    , d_capacity(8192)
+    , d_batchSize(256)
+    , d_flushInterval(1000)
+{
+}
+
+AsyncNotifier::AsyncNotifier(const Config& config)
+    : d_config(config)
+    , d_file(stdout)
+    , d_ring(config.d_capacity)
+    , d_written(0)
+    , d_dropped(0)
+    , d_blocked(0)
+    , d_flushes(0)
+    , d_totalLatency(0)
+    , d_maxLatency(0)
+    , d_stopping(false)
+{
+    if (config.d_capacity < 1 || config.d_batchSize < 1) {
+        throw std::invalid_argument(
+                "the ring and the batches must hold a record");
+    }
+    if (config.d_sink != e_STDOUT) {
+        d_file = std::fopen(
+                config.d_path.c_str(), config.d_sink == e_BINARY ? "wb" : "w");
+        if (!d_file) {
+            throw std::runtime_error("cannot open " + config.d_path);
+        }
+    }
+    d_writer = std::thread([this]() { run(); });
+}
+
+AsyncNotifier::~AsyncNotifier()
+{
+    d_stopping.store(true, std::memory_order_release);
+    d_writer.join();
+    if (d_file != stdout) {
+        std::fclose(d_file);
+    }
+}
+
+void AsyncNotifier::push(const Record& record)
+{
+    if (d_ring.tryPush(record)) {
+        return;
+    }
+    if (d_config.d_policy == e_DROP) {
+        d_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    d_blocked.fetch_add(1, std::memory_order_relaxed);
+    do {
+        std::this_thread::yield();
+    } while (!d_ring.tryPush(record));
+}
+
+void AsyncNotifier::logSessionState(const blp::Message& msg)
+{
+    Record record;
+    record.d_type = Record::e_SESSION_STATE;
+    record.d_time = now();
+    record.d_value = 0;
+    record.d_text = print(msg);
+    push(record);
+}
+
+void AsyncNotifier::logSubscriptionState(const blp::Message& msg)
+{
+    Record record;
+    record.d_type = Record::e_SUBSCRIPTION_STATE;
+    record.d_time = now();
+    record.d_value = 0;
+    record.d_text = print(msg);
+    push(record);
+}
+
+void AsyncNotifier::sendToTerminal(double value)
+{
+    Record record;
+    record.d_type = Record::e_VALUE;
+    record.d_time = now();
+    record.d_value = value;
+    push(record);
+}
+
+void AsyncNotifier::sendStrategyValue(
+        const std::string& strategy, double value)
+{
+    Record record;
+    record.d_type = Record::e_STRATEGY_VALUE;
+    record.d_time = now();
+    record.d_value = value;
+    record.d_text = strategy;
+    push(record);
+}
+
+void AsyncNotifier::append(std::string *batch, const Record& record) const
+{
+    if (d_config.d_sink == e_BINARY) {
+        appendBytes(batch, static_cast<uint8_t>(record.d_type));
+        appendBytes(batch, record.d_time);
+        appendBytes(batch, record.d_value);
+        appendBytes(batch, static_cast<uint32_t>(record.d_text.size()));
+        batch->append(record.d_text);
+        return;
+    }
+
+    // Format as the Notifier does.
+    std::ostringstream stream;
+    switch (record.d_type) {
+    case Record::e_VALUE:
+        stream << "VALUE = " << record.d_value << '\n';
+        break;
+    case Record::e_STRATEGY_VALUE:
+        stream << record.d_text << " = " << record.d_value << '\n';
+        break;
+    case Record::e_SESSION_STATE:
+        stream << "Logging Session state with:\n" << record.d_text << '\n';
+        break;
+    case Record::e_SUBSCRIPTION_STATE:
+        stream << "Logging Subscription state with:\n"
+               << record.d_text << '\n';
+        break;
+    }
+    batch->append(stream.str());
+}
+
+void AsyncNotifier::run()
+{
+    const int64_t interval
+            = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    d_config.d_flushInterval)
+                      .count();
+    Record record;
+    std::string batch;
+    size_t records = 0;
+    int64_t first = 0; // time of the first record popped into the batch
+    int64_t earliest = 0; // time of the oldest record in the batch
+    int64_t sumOfDelays = 0; // of the records in the batch, from `first`
+    for (;;) {
+        const bool stopping = d_stopping.load(std::memory_order_acquire);
+        if (d_ring.tryPop(&record)) {
+            append(&batch, record);
+            if (records == 0) {
+                first = earliest = record.d_time;
+            }
+            else if (record.d_time < earliest) {
+                earliest = record.d_time;
+            }
+            sumOfDelays += record.d_time - first;
+            if (++records < d_config.d_batchSize) {
+                continue;
+            }
+        }
+        else if (records == 0) {
+            // The ring is empty, or its oldest record is still being
+            // pushed, in which case the size is not 0.
+            if (stopping && d_ring.size() == 0) {
+                return;
+            }
+            std::this_thread::sleep_for(k_IDLE_SLEEP);
+            continue;
+        }
+        else if (!stopping && now() - earliest < interval) {
+            std::this_thread::sleep_for(k_IDLE_SLEEP);
+            continue;
+        }
+
+        std::fwrite(batch.data(), 1, batch.size(), d_file);
+        std::fflush(d_file);
+        const int64_t written = now();
+        d_totalLatency.fetch_add(
+                static_cast<int64_t>(records) * (written - first)
+                        - sumOfDelays,
+                std::memory_order_relaxed);
+        const int64_t latency = written - earliest;
+        if (latency > d_maxLatency.load(std::memory_order_relaxed)) {
+            d_maxLatency.store(latency, std::memory_order_relaxed);
+        }
+        d_flushes.fetch_add(1, std::memory_order_relaxed);
+        d_written.fetch_add(records, std::memory_order_release);
+        batch.clear();
+        records = 0;
+        sumOfDelays = 0;
+    }
+}
+
+AsyncNotifier::Statistics AsyncNotifier::statistics() const
+{
+    Statistics result;
+    result.d_written = d_written.load(std::memory_order_acquire);
+    result.d_dropped = d_dropped.load(std::memory_order_relaxed);
+    result.d_blocked = d_blocked.load(std::memory_order_relaxed);
+    result.d_flushes = d_flushes.load(std::memory_order_relaxed);
+    result.d_totalLatency = d_totalLatency.load(std::memory_order_relaxed);
+    result.d_maxLatency = d_maxLatency.load(std::memory_order_relaxed);
+    return result;
+}
+
+bool AsyncNotifier::parseSink(Config *config, const std::string& spec)
+{
+    if (spec == SINK_STDOUT) {
+        config->d_sink = e_STDOUT;
+        config->d_path.clear();
+        return true;
+    }
+    const size_t fileLength = std::strlen(SINK_FILE);
+    const size_t binaryLength = std::strlen(SINK_BINARY);
+    if (spec.compare(0, fileLength, SINK_FILE) == 0
+            && spec.size() > fileLength) {
+        config->d_sink = e_FILE;
+        config->d_path = spec.substr(fileLength);
+        return true;
+    }
+    if (spec.compare(0, binaryLength, SINK_BINARY) == 0
+            && spec.size() > binaryLength) {
+        config->d_sink = e_BINARY;
+        config->d_path = spec.substr(binaryLength);
+        return true;
+    }
+    return false;
+}
+
+bool AsyncNotifier::read(Record *record, std::istream& stream)
+{
+    uint8_t type;
+    uint32_t length;
+    if (!readBytes(&type, stream) || !readBytes(&record->d_time, stream)
+            || !readBytes(&record->d_value, stream)
+            || !readBytes(&length, stream)
+            || type > Record::e_SUBSCRIPTION_STATE) {
+        return false;
+    }
+    record->d_type = static_cast<Record::Type>(type);
+    record->d_text.resize(length);
+    return length == 0
+            || static_cast<bool>(stream.read(&record->d_text[0], length));
+}
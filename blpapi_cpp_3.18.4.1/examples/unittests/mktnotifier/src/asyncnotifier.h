@@ -0,0 +1,153 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _ASYNCNOTIFIER_H_
+#define _ASYNCNOTIFIER_H_
+
+#include <blpapi_message.h>
+
+#include "mpscring.h"
+#include "notifier.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <string>
+#include <thread>
+
+namespace blp = BloombergLP::blpapi;
+
+// AsyncNotifier is a Notifier that takes the writing, and the flush after
+// every line, off the threads delivering data. Each call only stamps a
+// Record with the time and pushes it onto a lock-free ring, which any
+// number of threads may do at once. A background writer pops the records,
+// formats a batch of them, and writes and flushes the batch once it holds
+// `d_batchSize` records, or its oldest record has waited `d_flushInterval`.
+//
+// Records are written to standard output or to a file as the Notifier
+// prints them, or to a file in the binary layout read back by `read`. The
+// status messages, which are rare and cannot be kept past the callback
+// that delivered them, are printed to text on the calling thread.
+//
+// A record that finds the ring full is dropped and counted, or the caller
+// waits for room, as configured. The latency counters measure the time
+// from the call to the write of the batch holding the record.
+class AsyncNotifier : public INotifier {
+  public:
+    enum Sink {
+        e_STDOUT, // text to standard output
+        e_FILE, // text to `d_path`
+        e_BINARY // binary records to `d_path`
+    };
+
+    enum Policy {
+        e_DROP, // drop a record that finds the ring full
+        e_BLOCK // wait for the writer to make room
+    };
+
+    struct Config {
+        Sink d_sink;
+        std::string d_path; // file written by the file and binary sinks
+        Policy d_policy;
+        size_t d_capacity; // records in the ring
+        size_t d_batchSize; // records written at most per flush
+        std::chrono::microseconds d_flushInterval; // longest a record waits
+
+        Config();
+    };
+
+    struct Record {
+        enum Type {
+            e_VALUE,
+            e_STRATEGY_VALUE,
+            e_SESSION_STATE,
+            e_SUBSCRIPTION_STATE
+        };
+
+        Type d_type;
+        int64_t d_time; // steady clock time of the call, in nanoseconds
+        double d_value;
+        std::string d_text; // strategy name, or printed status message
+    };
+
+    struct Statistics {
+        size_t d_written; // records written and flushed
+        size_t d_dropped; // records dropped as the ring was full
+        size_t d_blocked; // calls that waited for room in the ring
+        size_t d_flushes; // batches written
+        int64_t d_totalLatency; // over the records written, nanoseconds
+        int64_t d_maxLatency; // nanoseconds
+    };
+
+  private:
+    Config d_config;
+    std::FILE *d_file;
+    MpscRing<Record> d_ring;
+    std::atomic<size_t> d_written;
+    std::atomic<size_t> d_dropped;
+    std::atomic<size_t> d_blocked;
+    std::atomic<size_t> d_flushes;
+    std::atomic<int64_t> d_totalLatency;
+    std::atomic<int64_t> d_maxLatency;
+    std::atomic<bool> d_stopping;
+    std::thread d_writer;
+
+    AsyncNotifier(const AsyncNotifier&);
+    AsyncNotifier& operator=(const AsyncNotifier&);
+
+    void push(const Record& record);
+    void append(std::string *batch, const Record& record) const;
+    void run();
+
+  public:
+    // Create a notifier writing to the sink of `config` and start its
+    // writer. Throw std::invalid_argument if `config` is not valid, and
+    // std::runtime_error if its file cannot be opened.
+    explicit AsyncNotifier(const Config& config = Config());
+
+    // Stop the writer once it has written the records already pushed.
+    virtual ~AsyncNotifier();
+
+    virtual void logSessionState(const blp::Message& msg);
+
+    virtual void logSubscriptionState(const blp::Message& msg);
+
+    virtual void sendToTerminal(double value);
+
+    virtual void sendStrategyValue(const std::string& strategy, double value);
+
+    // Return the counters of the notifier, which may be mutually
+    // inconsistent while records are being pushed or written.
+    Statistics statistics() const;
+
+    // Load into `config` the sink given by `spec`, one of "stdout",
+    // "file:<path>" and "binary:<path>", and return true, or return false
+    // if `spec` is none of these.
+    static bool parseSink(Config *config, const std::string& spec);
+
+    // Load into `record` the next record written by the binary sink to
+    // `stream` and return true, or return false at the end of `stream` or
+    // if the record is truncated.
+    static bool read(Record *record, std::istream& stream);
+};
+
+#endif
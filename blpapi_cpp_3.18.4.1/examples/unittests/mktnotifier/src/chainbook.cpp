@@ -0,0 +1,188 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "chainbook.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+double Tick::*const FIELDS[] = { &Tick::d_bid,
+    &Tick::d_ask,
+    &Tick::d_lastPrice,
+    &Tick::d_impliedVol,
+    &Tick::d_bidSize,
+    &Tick::d_askSize,
+    &Tick::d_lastSize };
+
+// Load into `date` the date `text`, as MM/DD/YY, as YYYYMMDD and return
+// true, or return false if `text` is not in that form.
+bool parseDate(int *date, const std::string& text)
+{
+    if (text.size() != 8 || text[2] != '/' || text[5] != '/') {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (i != 2 && i != 5 && (text[i] < '0' || text[i] > '9')) {
+            return false;
+        }
+    }
+    const int month = std::atoi(text.substr(0, 2).c_str());
+    const int day = std::atoi(text.substr(3, 2).c_str());
+    const int year = 2000 + std::atoi(text.substr(6, 2).c_str());
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    *date = (year * 100 + month) * 100 + day;
+    return true;
+}
+}
+
+bool ChainKey::operator<(const ChainKey& other) const
+{
+    if (d_underlying != other.d_underlying) {
+        return d_underlying < other.d_underlying;
+    }
+    if (d_expiry != other.d_expiry) {
+        return d_expiry < other.d_expiry;
+    }
+    if (d_strike != other.d_strike) {
+        return d_strike < other.d_strike;
+    }
+    return !d_isCall && other.d_isCall;
+}
+
+bool ChainKey::parse(ChainKey *key, const std::string& ticker)
+{
+    // The underlying, then the expiry, the type and strike, and the
+    // yellow key, separated by spaces.
+    std::istringstream stream(ticker);
+    std::vector<std::string> words;
+    std::string word;
+    while (stream >> word) {
+        words.push_back(word);
+    }
+    const size_t n = words.size();
+    if (n < 4) {
+        return false;
+    }
+    const std::string& option = words[n - 2];
+    if (option.size() < 2 || (option[0] != 'C' && option[0] != 'P')) {
+        return false;
+    }
+    char *end;
+    const double strike = std::strtod(option.c_str() + 1, &end);
+    if (*end || !(strike > 0.0) || !std::isfinite(strike)) {
+        return false;
+    }
+    int expiry;
+    if (!parseDate(&expiry, words[n - 3])) {
+        return false;
+    }
+
+    key->d_underlying = words[0];
+    for (size_t i = 1; i < n - 3; ++i) {
+        key->d_underlying += ' ' + words[i];
+    }
+    key->d_expiry = expiry;
+    key->d_strike = strike;
+    key->d_isCall = option[0] == 'C';
+    return true;
+}
+
+ChainBook::ChainBook() { }
+
+bool ChainBook::add(const std::string& topic, const ChainKey& key)
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    if (d_keys.count(topic) || d_quotes.count(key)) {
+        return false;
+    }
+    ChainQuote& quote = d_quotes[key];
+    quote.d_key = key;
+    quote.d_topic = topic;
+    d_keys[topic] = key;
+    return true;
+}
+
+void ChainBook::remove(const std::string& topic)
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    std::unordered_map<std::string, ChainKey>::iterator it
+            = d_keys.find(topic);
+    if (it == d_keys.end()) {
+        return;
+    }
+    d_quotes.erase(it->second);
+    d_keys.erase(it);
+}
+
+bool ChainBook::update(const std::string& topic, const Tick& tick)
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    std::unordered_map<std::string, ChainKey>::const_iterator it
+            = d_keys.find(topic);
+    if (it == d_keys.end()) {
+        return false;
+    }
+    Tick& quote = d_quotes[it->second].d_tick;
+    for (size_t f = 0; f < sizeof FIELDS / sizeof *FIELDS; ++f) {
+        if (!std::isnan(tick.*FIELDS[f])) {
+            quote.*FIELDS[f] = tick.*FIELDS[f];
+        }
+    }
+    return true;
+}
+
+bool ChainBook::find(ChainQuote *quote, const ChainKey& key) const
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    std::map<ChainKey, ChainQuote>::const_iterator it = d_quotes.find(key);
+    if (it == d_quotes.end()) {
+        return false;
+    }
+    *quote = it->second;
+    return true;
+}
+
+void ChainBook::chain(
+        std::vector<ChainQuote> *quotes, const std::string& underlying) const
+{
+    quotes->clear();
+    ChainKey first;
+    first.d_underlying = underlying;
+    first.d_expiry = 0;
+    first.d_strike = 0.0;
+    first.d_isCall = false;
+    std::lock_guard<std::mutex> lock(d_mutex);
+    for (std::map<ChainKey, ChainQuote>::const_iterator it
+            = d_quotes.lower_bound(first);
+            it != d_quotes.end() && it->first.d_underlying == underlying;
+            ++it) {
+        quotes->push_back(it->second);
+    }
+}
+
+size_t ChainBook::size() const
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    return d_quotes.size();
+}
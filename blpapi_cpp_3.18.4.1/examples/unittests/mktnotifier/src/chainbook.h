@@ -0,0 +1,134 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _CHAINBOOK_H_
+#define _CHAINBOOK_H_
+
+#include "computeengine.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ChainKey identifies an option in the chains of a ChainBook: its
+// underlying, expiry date, strike and type.
+struct ChainKey {
+    std::string d_underlying; // as in the ticker, for example "IBM US"
+    int d_expiry; // as YYYYMMDD
+    double d_strike;
+    bool d_isCall;
+
+    bool operator<(const ChainKey& other) const;
+
+    // Load into `key` the option `ticker`, as the members of an OPT_CHAIN
+    // are given, for example "IBM US 11/18/22 P45 Equity", and return
+    // true, or return false if `ticker` is not an option in that form.
+    static bool parse(ChainKey *key, const std::string& ticker);
+};
+
+// ChainQuote is an option of a ChainBook, the topic it is subscribed as
+// and the latest value of each field of its ticks, NaN for the fields that
+// have not ticked.
+struct ChainQuote {
+    ChainKey d_key;
+    std::string d_topic;
+    Tick d_tick;
+};
+
+// ChainBook is a live book of option chains, ordered by underlying,
+// expiry, strike and type, put first. Options are added and removed as
+// chains are subscribed to, and updated with the ticks of their topics,
+// which may be delivered on other threads.
+class ChainBook {
+  private:
+    mutable std::mutex d_mutex;
+    std::map<ChainKey, ChainQuote> d_quotes;
+    std::unordered_map<std::string, ChainKey> d_keys; // by topic
+
+    ChainBook(const ChainBook&);
+    ChainBook& operator=(const ChainBook&);
+
+  public:
+    ChainBook();
+
+    // Add the option `key`, subscribed as `topic`, with no quote, and
+    // return true, or return false if the book already has `topic` or
+    // `key`.
+    bool add(const std::string& topic, const ChainKey& key);
+
+    // Remove the option subscribed as `topic`, if any.
+    void remove(const std::string& topic);
+
+    // Merge the fields of `tick` into the quote of the option subscribed
+    // as `topic`, and return true, or return false if the book has no
+    // such option.
+    bool update(const std::string& topic, const Tick& tick);
+
+    // Load into `quote` the option `key` and return true, or return false
+    // if the book does not have it.
+    bool find(ChainQuote *quote, const ChainKey& key) const;
+
+    // Load into `quotes` the options on `underlying`, in the order of the
+    // book.
+    void chain(std::vector<ChainQuote> *quotes,
+            const std::string& underlying) const;
+
+    size_t size() const;
+};
+
+// ChainBookEngine is a compute engine that keeps a ChainBook live: it
+// updates the book with every tick before handing the tick on to the
+// engine it wraps.
+class ChainBookEngine : public IComputeEngine {
+  private:
+    ChainBook *d_book;
+    IComputeEngine *d_engine;
+
+  public:
+    ChainBookEngine(ChainBook *book, IComputeEngine *engine)
+        : d_book(book)
+        , d_engine(engine)
+    {
+    }
+
+    virtual double someVeryComplexComputation(double lastValue)
+    {
+        return d_engine->someVeryComplexComputation(lastValue);
+    }
+
+    virtual bool processTick(const char *topic, const Tick& tick)
+    {
+        d_book->update(topic, tick);
+        return d_engine->processTick(topic, tick);
+    }
+
+    virtual bool processTimedTick(const char *topic,
+            const Tick& tick,
+            LatencyRecorder *recorder,
+            const TickTimes& times)
+    {
+        d_book->update(topic, tick);
+        return d_engine->processTimedTick(topic, tick, recorder, times);
+    }
+};
+
+#endif
@@ -0,0 +1,175 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "chainmanager.h"
+
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// Move to `batch` at most `count` topics from the front of `queue`.
+void take(std::vector<std::string> *batch,
+        std::set<std::string> *queue,
+        size_t count)
+{
+    while (count-- > 0 && !queue->empty()) {
+        batch->push_back(*queue->begin());
+        queue->erase(queue->begin());
+    }
+}
+}
+
+ChainManager::Config::Config()
+    : d_service("//blp/mktdata")
+    , d_prefix("/ticker/")
+    , d_batchSize(100)
+    , d_interval(250)
+{
+}
+
+ChainManager::ChainManager(ISubscriber *subscriber,
+        IChainRequester *requester,
+        ChainBook *book,
+        const Config& config)
+    : d_subscriber(subscriber)
+    , d_requester(requester)
+    , d_book(book)
+    , d_config(config)
+    , d_nextBatch()
+{
+    if (config.d_batchSize < 1) {
+        throw std::invalid_argument("a batch must hold a topic");
+    }
+}
+
+void ChainManager::addChain(const std::string& security)
+{
+    d_chains[security];
+}
+
+bool ChainManager::refresh(const blp::Identity& identity)
+{
+    bool rc = true;
+    for (std::map<std::string, std::set<std::string> >::const_iterator it
+            = d_chains.begin();
+            it != d_chains.end();
+            ++it) {
+        std::vector<std::string> members;
+        if (!d_requester->request(&members, it->first, identity)) {
+            rc = false;
+            continue;
+        }
+        setChain(it->first, members);
+    }
+    sendAll(identity);
+    return rc;
+}
+
+size_t ChainManager::setChain(
+        const std::string& security, const std::vector<std::string>& members)
+{
+    std::set<std::string>& topics = d_chains[security];
+    std::map<std::string, ChainKey> latest;
+    for (size_t i = 0; i < members.size(); ++i) {
+        ChainKey key;
+        if (ChainKey::parse(&key, members[i])) {
+            latest[d_config.d_prefix + members[i]] = key;
+        }
+    }
+
+    size_t changes = 0;
+    for (std::set<std::string>::iterator it = topics.begin();
+            it != topics.end();) {
+        if (latest.count(*it)) {
+            ++it;
+            continue;
+        }
+        d_book->remove(*it);
+        if (!d_toSubscribe.erase(*it)) {
+            d_toUnsubscribe.insert(*it);
+        }
+        ++changes;
+        topics.erase(it++);
+    }
+    for (std::map<std::string, ChainKey>::const_iterator it = latest.begin();
+            it != latest.end();
+            ++it) {
+        if (topics.count(it->first) || !d_book->add(it->first, it->second)) {
+            continue;
+        }
+        if (!d_toUnsubscribe.erase(it->first)) {
+            d_toSubscribe.insert(it->first);
+        }
+        ++changes;
+        topics.insert(it->first);
+    }
+    return changes;
+}
+
+size_t ChainManager::sendBatch(
+        const blp::Identity& identity, Clock::time_point now)
+{
+    if (now < d_nextBatch
+            || (d_toSubscribe.empty() && d_toUnsubscribe.empty())) {
+        return 0;
+    }
+    std::vector<std::string> unsubscribes;
+    take(&unsubscribes, &d_toUnsubscribe, d_config.d_batchSize);
+    std::vector<std::string> subscribes;
+    take(&subscribes,
+            &d_toSubscribe,
+            d_config.d_batchSize - unsubscribes.size());
+
+    if (!unsubscribes.empty()) {
+        d_subscriber->unsubscribe(unsubscribes);
+    }
+    if (!subscribes.empty()) {
+        d_subscriber->subscribe(d_config.d_service,
+                subscribes,
+                d_config.d_fields,
+                d_config.d_options,
+                identity);
+    }
+    d_nextBatch = now + d_config.d_interval;
+    return unsubscribes.size() + subscribes.size();
+}
+
+void ChainManager::sendAll(const blp::Identity& identity)
+{
+    while (!d_toSubscribe.empty() || !d_toUnsubscribe.empty()) {
+        const Clock::time_point now = Clock::now();
+        if (now < d_nextBatch) {
+            std::this_thread::sleep_until(d_nextBatch);
+            continue;
+        }
+        sendBatch(identity, now);
+    }
+}
+
+std::vector<std::string> ChainManager::members(
+        const std::string& security) const
+{
+    std::map<std::string, std::set<std::string> >::const_iterator it
+            = d_chains.find(security);
+    if (it == d_chains.end()) {
+        return std::vector<std::string>();
+    }
+    return std::vector<std::string>(it->second.begin(), it->second.end());
+}
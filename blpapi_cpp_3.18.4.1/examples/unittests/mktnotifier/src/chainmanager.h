@@ -0,0 +1,120 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _CHAINMANAGER_H_
+#define _CHAINMANAGER_H_
+
+#include <blpapi_identity.h>
+
+#include "chainbook.h"
+#include "chainrequester.h"
+#include "subscriber.h"
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+// ChainManager keeps subscriptions to every option in one or more chains,
+// and the options in a ChainBook.
+//
+// A refresh requests the members of each chain and diffs them with those
+// it had: options that are new, such as new listings or the strikes of a
+// new expiry after a roll, are added to the book and queued to be
+// subscribed to, and options that are gone are removed from the book and
+// queued to be unsubscribed from. A change that undoes one still queued
+// cancels it. The queued changes are then sent in batches of at most
+// `d_batchSize` topics, one batch every `d_interval`, so a chain of
+// thousands of options does not flood the session, and unsubscriptions go
+// first to make room for the subscriptions.
+//
+// A ChainManager must only be used from one thread. The book may be read,
+// and updated with ticks, from others.
+class ChainManager {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Config {
+        std::string d_service; // for example "//blp/mktdata"
+        std::string d_prefix; // of the topic of each option, "/ticker/"
+        std::vector<std::string> d_fields;
+        std::vector<std::string> d_options;
+        size_t d_batchSize; // topics per batch
+        std::chrono::milliseconds d_interval; // between batches
+
+        Config();
+    };
+
+  private:
+    ISubscriber *d_subscriber;
+    IChainRequester *d_requester;
+    ChainBook *d_book;
+    Config d_config;
+    std::map<std::string, std::set<std::string> > d_chains; // topics
+    std::set<std::string> d_toSubscribe;
+    std::set<std::string> d_toUnsubscribe;
+    Clock::time_point d_nextBatch;
+
+    ChainManager(const ChainManager&);
+    ChainManager& operator=(const ChainManager&);
+
+  public:
+    // Create a manager subscribing with `subscriber` to the chains
+    // retrieved with `requester`, keeping the options in `book`. Throw
+    // std::invalid_argument if the batches of `config` are empty.
+    ChainManager(ISubscriber *subscriber,
+            IChainRequester *requester,
+            ChainBook *book,
+            const Config& config);
+
+    // Add the chain of `security`, for example "IBM US Equity", with no
+    // members until the next refresh.
+    void addChain(const std::string& security);
+
+    // Request the members of every chain, apply the changes to each and
+    // send them with sendAll(). Return false if a chain could not be
+    // retrieved, in which case it is left as it was.
+    bool refresh(const blp::Identity& identity);
+
+    // Diff the chain of `security` with `members`, the tickers of its
+    // options, and queue the changes. Members that are not options are
+    // ignored. Return the number of topics queued or cancelled.
+    size_t setChain(const std::string& security,
+            const std::vector<std::string>& members);
+
+    // Send the next batch of queued changes if it is due at `now`, and
+    // return the number of topics in it.
+    size_t sendBatch(const blp::Identity& identity, Clock::time_point now);
+
+    // Send every queued change, waiting between batches.
+    void sendAll(const blp::Identity& identity);
+
+    size_t numToSubscribe() const { return d_toSubscribe.size(); }
+
+    size_t numToUnsubscribe() const { return d_toUnsubscribe.size(); }
+
+    // Return the topics of the options in the chain of `security`.
+    std::vector<std::string> members(const std::string& security) const;
+};
+
+#endif
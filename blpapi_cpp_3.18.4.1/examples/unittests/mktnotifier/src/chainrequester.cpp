@@ -0,0 +1,105 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "chainrequester.h"
+
+#include <blpapi_element.h>
+#include <blpapi_event.h>
+#include <blpapi_message.h>
+#include <blpapi_name.h>
+#include <blpapi_request.h>
+#include <time.h>
+
+namespace blp = BloombergLP::blpapi;
+
+namespace {
+const char REFDATA_SERVICE[] = "//blp/refdata";
+blp::Name REFERENCE_DATA_REQUEST("ReferenceDataRequest");
+blp::Name SECURITIES("securities");
+blp::Name FIELDS("fields");
+blp::Name SECURITY_DATA("securityData");
+blp::Name SECURITY_ERROR("securityError");
+blp::Name RESPONSE_ERROR("responseError");
+blp::Name FIELD_DATA("fieldData");
+blp::Name OPT_CHAIN("OPT_CHAIN");
+blp::Name SECURITY_DESCRIPTION("Security Description");
+}
+
+bool ChainRequester::request(std::vector<std::string> *members,
+        const std::string& security,
+        const blp::Identity& identity)
+{
+    members->clear();
+    if (!d_session->openService(REFDATA_SERVICE)) {
+        return false;
+    }
+    blp::Service service = d_session->getService(REFDATA_SERVICE);
+    blp::Request request = service.createRequest(
+            REFERENCE_DATA_REQUEST.string());
+    request.append(SECURITIES, security.c_str());
+    request.append(FIELDS, OPT_CHAIN.string());
+
+    blp::EventQueue queue;
+    d_session->sendRequest(request, identity, blp::CorrelationId(), &queue);
+
+    time_t startTime = time(0);
+    const int WAIT_TIME_SECONDS = 30;
+    while (true) {
+        blp::Event event = queue.nextEvent(WAIT_TIME_SECONDS * 1000);
+        if (event.eventType() == blp::Event::REQUEST_STATUS) {
+            return false;
+        }
+        if (event.eventType() == blp::Event::RESPONSE
+                || event.eventType() == blp::Event::PARTIAL_RESPONSE) {
+            blp::MessageIterator msgIter(event);
+            while (msgIter.next()) {
+                blp::Message msg = msgIter.message();
+                if (msg.hasElement(RESPONSE_ERROR)) {
+                    return false;
+                }
+                blp::Element securityData = msg.getElement(SECURITY_DATA);
+                for (size_t i = 0; i < securityData.numValues(); ++i) {
+                    blp::Element data = securityData.getValueAsElement(i);
+                    if (data.hasElement(SECURITY_ERROR)) {
+                        return false;
+                    }
+                    blp::Element fieldData = data.getElement(FIELD_DATA);
+                    if (!fieldData.hasElement(OPT_CHAIN)) {
+                        continue;
+                    }
+                    blp::Element chain = fieldData.getElement(OPT_CHAIN);
+                    for (size_t j = 0; j < chain.numValues(); ++j) {
+                        members->push_back(
+                                chain.getValueAsElement(j).getElementAsString(
+                                        SECURITY_DESCRIPTION));
+                    }
+                }
+            }
+            if (event.eventType() == blp::Event::RESPONSE) {
+                return true;
+            }
+        }
+
+        time_t endTime = time(0);
+        if (endTime - startTime > WAIT_TIME_SECONDS) {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _CHAINREQUESTER_H_
+#define _CHAINREQUESTER_H_
+
+#include <blpapi_identity.h>
+#include <blpapi_session.h>
+
+#include <string>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+class IChainRequester {
+  public:
+    // Load into `members` the tickers of the options in the chain of
+    // `security` and return true, or return false if the chain could not
+    // be retrieved.
+    virtual bool request(std::vector<std::string> *members,
+            const std::string& security,
+            const blp::Identity& identity)
+            = 0;
+
+    virtual ~IChainRequester() { }
+};
+
+// ChainRequester retrieves option chains as the OPT_CHAIN field of a
+// reference data request, waiting for the response.
+class ChainRequester : public IChainRequester {
+  private:
+    blp::Session *d_session;
+
+  public:
+    ChainRequester(blp::Session *session)
+        : d_session(session)
+    {
+    }
+
+    virtual bool request(std::vector<std::string> *members,
+            const std::string& security,
+            const blp::Identity& identity);
+};
+
+#endif
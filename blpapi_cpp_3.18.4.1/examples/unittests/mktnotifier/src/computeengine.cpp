@@ -19,3 +19,21 @@
  */
 
 #include "computeengine.h"
+
+#include "latencyrecorder.h"
+
+bool IComputeEngine::processTimedTick(const char *topic,
+        const Tick& tick,
+        LatencyRecorder *recorder,
+        const TickTimes& times)
+{
+    if (!processTick(topic, tick)) {
+        return false;
+    }
+    const blp::TimePoint done = LatencyRecorder::now();
+    recorder->record(LatencyRecorder::e_COMPUTE, times.d_handed, done);
+    if (times.d_timed) {
+        recorder->record(LatencyRecorder::e_TOTAL, times.d_received, done);
+    }
+    return true;
+}
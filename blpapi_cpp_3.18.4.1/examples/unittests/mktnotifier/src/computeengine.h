@@ -21,9 +21,49 @@
 #ifndef _COMPUTEENGINE_H_
 #define _COMPUTEENGINE_H_
 
+#include <limits>
+
+class LatencyRecorder;
+struct TickTimes;
+
+// Tick holds the fields of one market data update that a compute engine
+// prices from. A field that is not in the update is NaN.
+struct Tick {
+    double d_bid;
+    double d_ask;
+    double d_lastPrice;
+    double d_impliedVol; // IVOL_MID, in percent
+    double d_bidSize; // BID_SIZE
+    double d_askSize; // ASK_SIZE
+    double d_lastSize; // SIZE_LAST_TRADE
+
+    Tick();
+};
+
 class IComputeEngine {
   public:
     virtual double someVeryComplexComputation(double lastValue) = 0;
+
+    // Hand `tick`, an update of `topic`, to the engine and return true if
+    // the engine takes it, or return false to have the caller compute on
+    // the LAST_PRICE of the update with someVeryComplexComputation().
+    virtual bool processTick(
+            const char * /* topic */, const Tick& /* tick */)
+    {
+        return false;
+    }
+
+    // Hand `tick` to the engine as processTick() does, and if the engine
+    // takes it, record into `recorder` the compute and total latencies of
+    // the tick, from `times`, once the engine is done with it, and return
+    // true. An engine that computes on its own threads records them, and
+    // the notify latency, from there. By default the engine is done when
+    // processTick() returns.
+    virtual bool processTimedTick(const char *topic,
+            const Tick& tick,
+            LatencyRecorder *recorder,
+            const TickTimes& times);
+
     virtual ~IComputeEngine() { }
 };
 
@@ -35,4 +75,15 @@ class ComputeEngine : public IComputeEngine {
     }
 };
 
+inline Tick::Tick()
+    : d_bid(std::numeric_limits<double>::quiet_NaN())
+    , d_ask(std::numeric_limits<double>::quiet_NaN())
+    , d_lastPrice(std::numeric_limits<double>::quiet_NaN())
+    , d_impliedVol(std::numeric_limits<double>::quiet_NaN())
+    , d_bidSize(std::numeric_limits<double>::quiet_NaN())
+    , d_askSize(std::numeric_limits<double>::quiet_NaN())
+    , d_lastSize(std::numeric_limits<double>::quiet_NaN())
+{
+}
+
 #endif
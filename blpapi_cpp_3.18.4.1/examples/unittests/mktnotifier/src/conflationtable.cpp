@@ -0,0 +1,142 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "conflationtable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+double Tick::*const FIELDS[] = { &Tick::d_bid,
+    &Tick::d_ask,
+    &Tick::d_lastPrice,
+    &Tick::d_impliedVol,
+    &Tick::d_bidSize,
+    &Tick::d_askSize,
+    &Tick::d_lastSize };
+}
+
+ConflationTable::Slot::Slot()
+    : d_sequence(0)
+    , d_loaded(0)
+    , d_queued(false)
+{
+    for (int f = 0; f < k_NUM_FIELDS; ++f) {
+        d_fields[f].store(std::numeric_limits<double>::quiet_NaN());
+    }
+}
+
+bool ConflationTable::Entry::operator<(const Entry& other) const
+{
+    return d_hash < other.d_hash;
+}
+
+size_t ConflationTable::hashOf(const char *topic)
+{
+    // FNV-1a, so a topic hashes the same whichever string holds it.
+    size_t hash = 2166136261u;
+    for (const char *c = topic; *c; ++c) {
+        hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+    }
+    return hash;
+}
+
+ConflationTable::ConflationTable(
+        const std::vector<std::string>& topics, size_t slots)
+    : d_slots(std::max(topics.size(), slots))
+{
+    for (size_t i = 0; i < topics.size(); ++i) {
+        const Entry entry = { hashOf(topics[i].c_str()), topics[i], i };
+        d_entries.push_back(entry);
+    }
+    std::sort(d_entries.begin(), d_entries.end());
+}
+
+int ConflationTable::find(const char *topic, size_t hash) const
+{
+    Entry key;
+    key.d_hash = hash;
+    std::vector<Entry>::const_iterator it
+            = std::lower_bound(d_entries.begin(), d_entries.end(), key);
+    for (; it != d_entries.end() && it->d_hash == hash; ++it) {
+        if (!std::strcmp(it->d_topic.c_str(), topic)) {
+            return static_cast<int>(it->d_slot);
+        }
+    }
+    return -1;
+}
+
+bool ConflationTable::store(bool *conflated, int slot, const Tick& tick)
+{
+    Slot& s = d_slots[slot];
+    const unsigned sequence = s.d_sequence.load(std::memory_order_relaxed);
+
+    // Once the reader has loaded the slot, its fields start afresh, so the
+    // reader is not given fields it has already processed again, unless
+    // it loads the slot while this store is under way.
+    const bool fresh
+            = s.d_loaded.load(std::memory_order_acquire) == sequence;
+    *conflated = !fresh;
+
+    s.d_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int f = 0; f < k_NUM_FIELDS; ++f) {
+        const double value = tick.*FIELDS[f];
+        if (fresh || !std::isnan(value)) {
+            s.d_fields[f].store(value, std::memory_order_relaxed);
+        }
+    }
+    s.d_sequence.store(sequence + 2, std::memory_order_release);
+
+    return !s.d_queued.exchange(true, std::memory_order_acq_rel);
+}
+
+void ConflationTable::unqueue(int slot)
+{
+    // Acquiring the last store that queued the slot makes the fields it
+    // stored visible to a load that follows.
+    d_slots[slot].d_queued.exchange(false, std::memory_order_acq_rel);
+}
+
+bool ConflationTable::load(Tick *tick, int slot)
+{
+    Slot& s = d_slots[slot];
+    unsigned sequence;
+    for (;;) {
+        sequence = s.d_sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            continue;
+        }
+        for (int f = 0; f < k_NUM_FIELDS; ++f) {
+            tick->*FIELDS[f] = s.d_fields[f].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.d_sequence.load(std::memory_order_relaxed) == sequence) {
+            break;
+        }
+    }
+    if (sequence == s.d_loaded.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    s.d_loaded.store(sequence, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,102 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _CONFLATIONTABLE_H_
+#define _CONFLATIONTABLE_H_
+
+#include "computeengine.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// ConflationTable holds the latest tick of each of a fixed set of slots,
+// for one writer thread, which stores ticks as they arrive, and one reader
+// thread per topic, which loads the newest snapshot when it gets to it
+// instead of every tick in between.
+//
+// Each slot is a sequence lock: the writer makes the sequence number odd
+// while it writes the fields and even again once done, and the reader
+// retries a load that saw an odd or changed number, so neither ever
+// blocks. The ticks stored since the reader last loaded a slot are merged
+// field by field, so a snapshot has the newest value of every field that
+// ticked. A slot also records whether it is queued for its reader, so
+// the writer queues a topic once however many ticks arrive before the
+// reader gets to it.
+class ConflationTable {
+  private:
+    enum { k_NUM_FIELDS = 7 };
+
+    struct Slot {
+        std::atomic<unsigned> d_sequence; // odd while being written
+        std::atomic<unsigned> d_loaded; // sequence last loaded
+        std::atomic<bool> d_queued;
+        std::atomic<double> d_fields[k_NUM_FIELDS];
+
+        Slot();
+    };
+
+    struct Entry {
+        size_t d_hash;
+        std::string d_topic;
+        size_t d_slot;
+
+        bool operator<(const Entry& other) const;
+    };
+
+    std::vector<Entry> d_entries; // sorted by hash
+    std::vector<Slot> d_slots;
+
+    ConflationTable(const ConflationTable&);
+    ConflationTable& operator=(const ConflationTable&);
+
+  public:
+    // Return the hash of `topic` used to look it up.
+    static size_t hashOf(const char *topic);
+
+    // Create a table with a slot for each of `topics`, slot i for topic i,
+    // and further slots, found by no topic, up to `slots` in all.
+    explicit ConflationTable(
+            const std::vector<std::string>& topics, size_t slots = 0);
+
+    // Return the slot of `topic`, whose hash is `hash`, or -1 if it has
+    // none.
+    int find(const char *topic, size_t hash) const;
+
+    // Merge `tick` into `slot`, load into `conflated` whether it was merged
+    // into ticks that have not been loaded yet, and return true if the
+    // slot must now be queued for its reader. Must only be called by the
+    // writer.
+    bool store(bool *conflated, int slot, const Tick& tick);
+
+    // Mark `slot` as no longer queued, so the ticks stored from now on
+    // queue it again. Must be called by the writer if it fails to queue
+    // the slot, and by the reader once it takes the slot from its queue.
+    void unqueue(int slot);
+
+    // Load into `tick` the newest snapshot of `slot` and return true, or
+    // return false if there has been no tick since the last load. Must
+    // only be called by the reader of `slot`, after unqueue().
+    bool load(Tick *tick, int slot);
+
+    size_t size() const { return d_slots.size(); }
+};
+
+#endif
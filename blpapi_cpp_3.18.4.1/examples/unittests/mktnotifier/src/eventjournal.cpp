@@ -0,0 +1,299 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "eventjournal.h"
+
+#include <blpapi_correlationid.h>
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_message.h>
+#include <blpapi_types.h>
+
+#include <cmath>
+#include <cstdio>
+#include <istream>
+#include <stdexcept>
+
+namespace {
+template <class TYPE>
+void appendBytes(std::string *out, const TYPE& value)
+{
+    out->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void appendString(std::string *out, const std::string& value)
+{
+    appendBytes(out, static_cast<uint32_t>(value.size()));
+    out->append(value);
+}
+
+template <class TYPE>
+bool readBytes(TYPE *value, std::istream& stream)
+{
+    return static_cast<bool>(
+            stream.read(reinterpret_cast<char *>(value), sizeof(*value)));
+}
+
+bool readString(std::string *value, std::istream& stream)
+{
+    uint32_t length;
+    if (!readBytes(&length, stream)) {
+        return false;
+    }
+    value->resize(length);
+    return length == 0 || static_cast<bool>(stream.read(&(*value)[0], length));
+}
+
+void appendQuoted(std::string *out, const char *value)
+{
+    out->push_back('"');
+    for (const char *c = value; *c; ++c) {
+        switch (*c) {
+        case '"':
+            out->append("\\\"");
+            break;
+        case '\\':
+            out->append("\\\\");
+            break;
+        case '\n':
+            out->append("\\n");
+            break;
+        case '\t':
+            out->append("\\t");
+            break;
+        default:
+            if (static_cast<unsigned char>(*c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof escaped, "\\u%04x", *c);
+                out->append(escaped);
+            }
+            else {
+                out->push_back(*c);
+            }
+        }
+    }
+    out->push_back('"');
+}
+
+// Append to `out` the JSON of the value at `index` of the scalar
+// `element`, and return true, or return false if it has no JSON form.
+bool appendScalar(std::string *out, const blp::Element& element, size_t index)
+{
+    if (element.isNullValue(index)) {
+        return false;
+    }
+    char number[32];
+    switch (element.datatype()) {
+    case blp::DataType::BOOL:
+        out->append(element.getValueAsBool(index) ? "true" : "false");
+        return true;
+    case blp::DataType::BYTE:
+    case blp::DataType::INT32:
+    case blp::DataType::INT64:
+        std::snprintf(number,
+                sizeof number,
+                "%lld",
+                static_cast<long long>(element.getValueAsInt64(index)));
+        out->append(number);
+        return true;
+    case blp::DataType::FLOAT32:
+    case blp::DataType::FLOAT64: {
+        const double value = element.getValueAsFloat64(index);
+        if (!std::isfinite(value)) {
+            return false;
+        }
+        std::snprintf(number, sizeof number, "%.17g", value);
+        out->append(number);
+        return true;
+    }
+    default:
+        // Strings, enumerations, dates and times are quoted in the form
+        // the formatter parses.
+        appendQuoted(out, element.getValueAsString(index));
+        return true;
+    }
+}
+
+void appendObject(std::string *out, const blp::Element& element)
+{
+    out->push_back('{');
+    bool first = true;
+    for (size_t i = 0; i < element.numElements(); ++i) {
+        const blp::Element field = element.getElement(i);
+        if (field.isNull()) {
+            continue;
+        }
+        std::string value;
+        EventJournal::toJson(&value, field);
+        if (value.empty()) {
+            continue;
+        }
+        if (!first) {
+            out->push_back(',');
+        }
+        first = false;
+        appendQuoted(out, field.name().string());
+        out->push_back(':');
+        out->append(value);
+    }
+    out->push_back('}');
+}
+}
+
+EventJournal::EventJournal(const std::string& path,
+        blp::EventHandler *handler,
+        const TopicRegistry *registry)
+    : d_handler(handler)
+    , d_registry(registry)
+    , d_file(std::fopen(path.c_str(), "ab"))
+    , d_start(blp::HighResolutionClock::now())
+    , d_events(0)
+{
+    if (!d_file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+}
+
+EventJournal::~EventJournal() { std::fclose(d_file); }
+
+bool EventJournal::processEvent(
+        const blp::Event& event, blp::Session *session)
+{
+    const blp::TimePoint captured = blp::HighResolutionClock::now();
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        Record record;
+        record.d_event = d_events++;
+        record.d_eventType = event.eventType();
+        d_buffer.clear();
+        blp::MessageIterator msgIter(event);
+        while (msgIter.next()) {
+            blp::Message msg = msgIter.message();
+            blp::TimePoint received;
+            if (msg.timeReceived(&received) != 0) {
+                received = captured;
+            }
+            record.d_time = blp::TimePointUtil::nanosecondsBetween(
+                    d_start, received);
+
+            record.d_correlationType = Record::e_NONE;
+            record.d_correlationId = 0;
+            record.d_topic.clear();
+            if (msg.numCorrelationIds() > 0) {
+                const blp::CorrelationId cid = msg.correlationId();
+                if (cid.valueType() == blp::CorrelationId::POINTER_VALUE
+                        && cid.asPointer()) {
+                    record.d_correlationType = Record::e_TOPIC;
+                    record.d_topic = static_cast<const char *>(
+                            cid.asPointer());
+                }
+                else if (cid.valueType() == blp::CorrelationId::INT_VALUE
+                        || cid.valueType()
+                                == blp::CorrelationId::AUTOGEN_VALUE) {
+                    record.d_correlationType = Record::e_INT;
+                    record.d_correlationId = cid.asInteger();
+                }
+            }
+            const int id = d_registry ? d_registry->idOf(msg) : -1;
+            if (id >= 0) {
+                if (d_journaled.size() <= static_cast<size_t>(id)) {
+                    d_journaled.resize(id + 1, false);
+                }
+                if (!d_journaled[id]) {
+                    d_journaled[id] = true;
+                    Record topic = record;
+                    topic.d_eventType = Record::k_TOPIC_RECORD;
+                    topic.d_topic = d_registry->topic(id);
+                    append(&d_buffer, topic);
+                }
+            }
+
+            record.d_messageType = msg.messageType().string();
+            record.d_content.clear();
+            toJson(&record.d_content, msg.asElement());
+            append(&d_buffer, record);
+        }
+        std::fwrite(d_buffer.data(), 1, d_buffer.size(), d_file);
+        std::fflush(d_file);
+    }
+    return d_handler ? d_handler->processEvent(event, session) : true;
+}
+
+uint64_t EventJournal::numEvents() const
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    return d_events;
+}
+
+void EventJournal::toJson(std::string *out, const blp::Element& element)
+{
+    if (element.isArray()) {
+        out->push_back('[');
+        for (size_t i = 0; i < element.numValues(); ++i) {
+            if (i > 0) {
+                out->push_back(',');
+            }
+            if (element.isComplexType()) {
+                appendObject(out, element.getValueAsElement(i));
+            }
+            else if (!appendScalar(out, element, i)) {
+                out->append("null");
+            }
+        }
+        out->push_back(']');
+    }
+    else if (element.isComplexType()) {
+        appendObject(out, element);
+    }
+    else {
+        appendScalar(out, element, 0);
+    }
+}
+
+void EventJournal::append(std::string *out, const Record& record)
+{
+    appendBytes(out, record.d_event);
+    appendBytes(out, static_cast<int32_t>(record.d_eventType));
+    appendBytes(out, record.d_time);
+    appendBytes(out, static_cast<uint8_t>(record.d_correlationType));
+    appendBytes(out, record.d_correlationId);
+    appendString(out, record.d_topic);
+    appendString(out, record.d_messageType);
+    appendString(out, record.d_content);
+}
+
+bool EventJournal::read(Record *record, std::istream& stream)
+{
+    int32_t eventType;
+    uint8_t correlationType;
+    if (!readBytes(&record->d_event, stream) || !readBytes(&eventType, stream)
+            || !readBytes(&record->d_time, stream)
+            || !readBytes(&correlationType, stream)
+            || !readBytes(&record->d_correlationId, stream)
+            || correlationType > Record::e_TOPIC
+            || !readString(&record->d_topic, stream)
+            || !readString(&record->d_messageType, stream)
+            || !readString(&record->d_content, stream)) {
+        return false;
+    }
+    record->d_eventType = eventType;
+    record->d_correlationType
+            = static_cast<Record::CorrelationType>(correlationType);
+    return true;
+}
@@ -0,0 +1,124 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _EVENTJOURNAL_H_
+#define _EVENTJOURNAL_H_
+
+#include <blpapi_element.h>
+#include <blpapi_event.h>
+#include <blpapi_session.h>
+#include <blpapi_timepoint.h>
+
+#include "topicregistry.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+// EventJournal is an event handler that captures every event it receives
+// to an append-only binary journal before handing it on to another event
+// handler, so bursts seen live can be replayed offline by a
+// JournalReplayer.
+//
+// Each message of an event is a record of the event type, its sequence
+// number in the capture, the message type, the first correlation id, the
+// time the session received it, and its content in the JSON accepted by
+// blp::test::MessageFormatter::formatMessageJson. A correlation id
+// pointing at a topic is journaled as the topic. An integer correlation id
+// handed out by a TopicRegistry is journaled as the integer, preceded the
+// first time it appears by a topic record of the id and its topic, so a
+// replay can register the topics it sees without knowing the order they
+// were registered in. Times are in nanoseconds from the start of the
+// capture, and are taken from blp::Message::timeReceived where the session
+// records receive times, or from the clock as the event is captured
+// otherwise.
+//
+// Capturing formats and writes on the thread delivering the event.
+class EventJournal : public blp::EventHandler {
+  public:
+    struct Record {
+        enum {
+            // The event type of a topic record, which maps the integer
+            // `d_correlationId` to `d_topic` for the records that follow.
+            k_TOPIC_RECORD = -1
+        };
+
+        enum CorrelationType {
+            e_NONE,
+            e_INT, // `d_correlationId`
+            e_TOPIC // `d_topic`
+        };
+
+        uint64_t d_event; // the sequence number of the event
+        int d_eventType;
+        int64_t d_time;
+        CorrelationType d_correlationType;
+        int64_t d_correlationId;
+        std::string d_topic;
+        std::string d_messageType;
+        std::string d_content;
+    };
+
+  private:
+    blp::EventHandler *d_handler;
+    const TopicRegistry *d_registry;
+    std::vector<bool> d_journaled; // by id, the topic record is written
+    std::FILE *d_file;
+    blp::TimePoint d_start;
+    uint64_t d_events;
+    mutable std::mutex d_mutex;
+    std::string d_buffer;
+
+    EventJournal(const EventJournal&);
+    EventJournal& operator=(const EventJournal&);
+
+  public:
+    // Create a journal appending to the file at `path` and handing the
+    // events on to `handler`, unless it is null, with the topics of the
+    // ids of `registry`, unless it is null. Throw std::runtime_error if the
+    // file cannot be opened.
+    EventJournal(const std::string& path,
+            blp::EventHandler *handler,
+            const TopicRegistry *registry = 0);
+
+    virtual ~EventJournal();
+
+    virtual bool processEvent(const blp::Event& event, blp::Session *session);
+
+    // Return the number of events captured.
+    uint64_t numEvents() const;
+
+    // Append to `out` the JSON of the value of `element`.
+    static void toJson(std::string *out, const blp::Element& element);
+
+    // Append `record` to `out` in the journal layout.
+    static void append(std::string *out, const Record& record);
+
+    // Load into `record` the next record of the journal `stream`. Return
+    // false at the end of the journal or if it is corrupt.
+    static bool read(Record *record, std::istream& stream);
+};
+
+#endif
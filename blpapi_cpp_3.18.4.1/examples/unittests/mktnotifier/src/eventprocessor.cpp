@@ -20,10 +20,65 @@
 
 #include "eventprocessor.h"
 
+#include <blpapi_correlationid.h>
 #include <blpapi_message.h>
 
+#include <cmath>
+
 namespace blp = BloombergLP::blpapi;
 
+const char *EventProcessor::topicOf(const blp::Message& msg)
+{
+    const blp::CorrelationId cid = msg.correlationId();
+    if (cid.valueType() != blp::CorrelationId::POINTER_VALUE
+            || !cid.asPointer()) {
+        return "";
+    }
+    return static_cast<const char *>(cid.asPointer());
+}
+
+void EventProcessor::processTick(INotifier *notifier,
+        IComputeEngine *computeEngine,
+        const char *topic,
+        const Tick& tick,
+        LatencyRecorder *recorder,
+        const TickTimes& times)
+{
+    if (!recorder) {
+        if (!computeEngine->processTick(topic, tick)
+                && !std::isnan(tick.d_lastPrice)) {
+            double result = computeEngine->someVeryComplexComputation(
+                    tick.d_lastPrice);
+            notifier->sendToTerminal(result);
+        }
+        return;
+    }
+    // An engine that takes the tick times it until it is done with it.
+    TickTimes handed = times;
+    handed.d_handed = LatencyRecorder::now();
+    if (computeEngine->processTimedTick(topic, tick, recorder, handed)) {
+        return;
+    }
+    blp::TimePoint done;
+    if (std::isnan(tick.d_lastPrice)) {
+        done = LatencyRecorder::now();
+        recorder->record(LatencyRecorder::e_COMPUTE, handed.d_handed, done);
+    }
+    else {
+        double result = computeEngine->someVeryComplexComputation(
+                tick.d_lastPrice);
+        const blp::TimePoint computed = LatencyRecorder::now();
+        recorder->record(
+                LatencyRecorder::e_COMPUTE, handed.d_handed, computed);
+        notifier->sendToTerminal(result);
+        done = LatencyRecorder::now();
+        recorder->record(LatencyRecorder::e_NOTIFY, computed, done);
+    }
+    if (times.d_timed) {
+        recorder->record(LatencyRecorder::e_TOTAL, times.d_received, done);
+    }
+}
+
 bool EventProcessor::processEvent(
         const blp::Event& event, blp::Session *session)
 {
@@ -37,14 +92,49 @@ bool EventProcessor::processEvent(
         case blp::Event::SUBSCRIPTION_STATUS:
             d_notifier->logSubscriptionState(msg);
             break;
-        case blp::Event::SUBSCRIPTION_DATA:
-            if (msg.hasElement("LAST_PRICE")) {
-                double lastPrice = msg.getElementAsFloat64("LAST_PRICE");
-                double result = d_computeEngine->someVeryComplexComputation(
-                        lastPrice);
-                d_notifier->sendToTerminal(result);
+        case blp::Event::SUBSCRIPTION_DATA: {
+            // Without receive times, recorded only if the session options
+            // ask for them, ticks are timed from here.
+            TickTimes times;
+            blp::TimePoint handled;
+            if (d_recorder) {
+                handled = LatencyRecorder::now();
+                times.d_timed = msg.timeReceived(&times.d_received) == 0;
+                if (times.d_timed) {
+                    d_recorder->record(LatencyRecorder::e_WIRE,
+                            times.d_received,
+                            handled);
+                }
+            }
+            Tick tick;
+            const char *topic;
+            const int id = d_registry ? d_registry->idOf(msg) : -1;
+            if (id >= 0) {
+                d_registry->update(&tick, id, msg);
+                topic = d_registry->topic(id);
             }
+            else {
+                d_fieldPlan.decode(&tick, msg);
+                topic = topicOf(msg);
+            }
+            if (d_store) {
+                d_store->append(id, topic, tick);
+            }
+            if (!d_recorder) {
+                processTick(d_notifier, d_computeEngine, topic, tick);
+                break;
+            }
+            d_recorder->record(LatencyRecorder::e_DECODE,
+                    handled,
+                    LatencyRecorder::now());
+            processTick(d_notifier,
+                    d_computeEngine,
+                    topic,
+                    tick,
+                    d_recorder,
+                    times);
             break;
+        }
         default:
             return true;
         }
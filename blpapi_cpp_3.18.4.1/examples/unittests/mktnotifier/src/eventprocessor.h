@@ -25,7 +25,14 @@
 #include <blpapi_session.h>
 
 #include "computeengine.h"
+#include "fieldplan.h"
+#include "latencyrecorder.h"
 #include "notifier.h"
+#include "tickstore.h"
+#include "topicregistry.h"
+
+#include <string>
+#include <vector>
 
 namespace blp = BloombergLP::blpapi;
 
@@ -33,18 +40,86 @@ class EventProcessor : public blp::EventHandler {
   private:
     INotifier *d_notifier;
     IComputeEngine *d_computeEngine;
+    FieldPlan d_fieldPlan;
+    TopicRegistry *d_registry;
+    LatencyRecorder *d_recorder;
+    TickStore *d_store;
 
   public:
     EventProcessor(INotifier *notifier, IComputeEngine *computeEngine);
     EventProcessor();
 
+    // Create a processor decoding only `fields`, the fields subscribed to.
+    EventProcessor(INotifier *notifier,
+            IComputeEngine *computeEngine,
+            const std::vector<std::string>& fields);
+
+    // Create a processor that decodes the updates of the topics in
+    // `registry` with their own plans, and records their state there.
+    EventProcessor(INotifier *notifier,
+            IComputeEngine *computeEngine,
+            TopicRegistry *registry);
+
     virtual bool processEvent(const blp::Event& event, blp::Session *session);
+
+    // Time each tick through its stages into `recorder`, or, if it is
+    // null, stop timing.
+    void setLatencyRecorder(LatencyRecorder *recorder)
+    {
+        d_recorder = recorder;
+    }
+
+    // Append each tick decoded to `store`, or, if it is null, stop. The
+    // store is only appended to by the thread delivering events.
+    void setTickStore(TickStore *store) { d_store = store; }
+
+    // Return the topic `msg` is an update of, as given to the subscriber,
+    // or an empty string if its correlation id does not carry one.
+    static const char *topicOf(const blp::Message& msg);
+
+    // Hand `tick`, an update of `topic`, to `computeEngine`, and if it does
+    // not take it, send the computation on its LAST_PRICE, if any, to
+    // `notifier`. Unless `recorder` is null, time the tick into it until
+    // it is computed and notified, in total from the receive time in
+    // `times`, if set.
+    static void processTick(INotifier *notifier,
+            IComputeEngine *computeEngine,
+            const char *topic,
+            const Tick& tick,
+            LatencyRecorder *recorder = 0,
+            const TickTimes& times = TickTimes());
 };
 
 inline EventProcessor::EventProcessor(
         INotifier *notifier, IComputeEngine *computeEngine)
     : d_notifier(notifier)
     , d_computeEngine(computeEngine)
+    , d_registry(0)
+    , d_recorder(0)
+    , d_store(0)
+{
+}
+
+inline EventProcessor::EventProcessor(INotifier *notifier,
+        IComputeEngine *computeEngine,
+        const std::vector<std::string>& fields)
+    : d_notifier(notifier)
+    , d_computeEngine(computeEngine)
+    , d_fieldPlan(fields)
+    , d_registry(0)
+    , d_recorder(0)
+    , d_store(0)
+{
+}
+
+inline EventProcessor::EventProcessor(INotifier *notifier,
+        IComputeEngine *computeEngine,
+        TopicRegistry *registry)
+    : d_notifier(notifier)
+    , d_computeEngine(computeEngine)
+    , d_registry(registry)
+    , d_recorder(0)
+    , d_store(0)
 {
 }
 
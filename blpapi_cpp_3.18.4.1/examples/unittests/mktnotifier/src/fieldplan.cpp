@@ -0,0 +1,110 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "fieldplan.h"
+
+#include <blpapi_element.h>
+
+namespace {
+const blp::Name BID("BID");
+const blp::Name ASK("ASK");
+const blp::Name LAST_PRICE("LAST_PRICE");
+const blp::Name IVOL_MID("IVOL_MID");
+const blp::Name BID_SIZE("BID_SIZE");
+const blp::Name ASK_SIZE("ASK_SIZE");
+const blp::Name SIZE_LAST_TRADE("SIZE_LAST_TRADE");
+
+// Return the slot of Tick that holds the field `name`, or 0 if there is
+// none.
+double Tick::*slotOf(const blp::Name& name)
+{
+    if (name == BID) {
+        return &Tick::d_bid;
+    }
+    if (name == ASK) {
+        return &Tick::d_ask;
+    }
+    if (name == LAST_PRICE) {
+        return &Tick::d_lastPrice;
+    }
+    if (name == IVOL_MID) {
+        return &Tick::d_impliedVol;
+    }
+    if (name == BID_SIZE) {
+        return &Tick::d_bidSize;
+    }
+    if (name == ASK_SIZE) {
+        return &Tick::d_askSize;
+    }
+    if (name == SIZE_LAST_TRADE) {
+        return &Tick::d_lastSize;
+    }
+    return 0;
+}
+}
+
+FieldPlan::FieldPlan()
+{
+    add(BID);
+    add(ASK);
+    add(LAST_PRICE);
+    add(IVOL_MID);
+    add(BID_SIZE);
+    add(ASK_SIZE);
+    add(SIZE_LAST_TRADE);
+}
+
+FieldPlan::FieldPlan(const std::vector<std::string>& fields)
+{
+    for (size_t i = 0; i < fields.size(); ++i) {
+        add(blp::Name(fields[i].c_str()));
+    }
+    add(LAST_PRICE);
+}
+
+void FieldPlan::add(const blp::Name& name)
+{
+    double Tick::*slot = slotOf(name);
+    if (!slot) {
+        return;
+    }
+    for (size_t i = 0; i < d_entries.size(); ++i) {
+        if (d_entries[i].d_slot == slot) {
+            return;
+        }
+    }
+    const Entry entry = { name, slot };
+    d_entries.push_back(entry);
+}
+
+void FieldPlan::decode(Tick *tick, const blp::Message& msg) const
+{
+    // Market data messages carry dozens to hundreds of fields, of which a
+    // plan decodes a handful, so each planned field is looked up by name
+    // rather than every field of the message scanned.
+    const blp::Element fields = msg.asElement();
+    blp::Element field;
+    for (size_t i = 0; i < d_entries.size(); ++i) {
+        if (fields.getElement(&field, d_entries[i].d_name) == 0
+                && !field.isNull()) {
+            tick->*d_entries[i].d_slot = field.getValueAsFloat64();
+        }
+    }
+}
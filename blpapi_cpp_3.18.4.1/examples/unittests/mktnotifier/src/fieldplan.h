@@ -0,0 +1,67 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _FIELDPLAN_H_
+#define _FIELDPLAN_H_
+
+#include <blpapi_message.h>
+#include <blpapi_name.h>
+
+#include "computeengine.h"
+
+#include <string>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+// FieldPlan decodes the fields of a market data message into a Tick. It is
+// built once from the subscribed fields, each of which is interned as a
+// blp::Name and bound to its slot in Tick, so a message is decoded by
+// looking up each planned field by its interned name, however many other
+// fields the message carries, rather than by string lookups. Subscribed
+// fields that Tick has no slot for are not decoded, and LAST_PRICE is
+// always decoded.
+class FieldPlan {
+  private:
+    struct Entry {
+        blp::Name d_name;
+        double Tick::*d_slot;
+    };
+
+    std::vector<Entry> d_entries;
+
+    void add(const blp::Name& name);
+
+  public:
+    // Create a plan decoding every field Tick has a slot for.
+    FieldPlan();
+
+    // Create a plan decoding `fields`, the fields subscribed to.
+    explicit FieldPlan(const std::vector<std::string>& fields);
+
+    // Load into `tick` the planned fields of `msg`. Fields that are not in
+    // `msg`, or are null, are left unchanged.
+    void decode(Tick *tick, const blp::Message& msg) const;
+
+    // Return the number of fields decoded.
+    size_t size() const { return d_entries.size(); }
+};
+
+#endif
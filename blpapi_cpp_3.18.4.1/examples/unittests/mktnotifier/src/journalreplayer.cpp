@@ -0,0 +1,134 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "journalreplayer.h"
+
+#include "eventjournal.h"
+
+#include <blpapi_correlationid.h>
+#include <blpapi_exception.h>
+#include <blpapi_messageformatter.h>
+#include <blpapi_name.h>
+#include <blpapi_testutil.h>
+
+#include <chrono>
+#include <thread>
+
+namespace blptst = blp::test;
+
+JournalReplayer::JournalReplayer(const blp::Service& service)
+    : d_service(service)
+    , d_messages(0)
+    , d_skipped(0)
+{
+}
+
+size_t JournalReplayer::load(std::istream& stream)
+{
+    const size_t first = d_events.size();
+    EventJournal::Record record;
+    bool started = false;
+    uint64_t event = 0;
+    while (EventJournal::read(&record, stream)) {
+        if (record.d_eventType == EventJournal::Record::k_TOPIC_RECORD) {
+            std::map<std::string, int64_t>::const_iterator it
+                    = d_replayIds.find(record.d_topic);
+            if (it == d_replayIds.end()) {
+                it = d_replayIds
+                             .insert(std::make_pair(record.d_topic,
+                                     static_cast<int64_t>(
+                                             d_registered.size())))
+                             .first;
+                d_registered.push_back(record.d_topic);
+            }
+            d_ids[record.d_correlationId] = it->second;
+            continue;
+        }
+        if (!started || record.d_event != event) {
+            Entry entry;
+            entry.d_time = record.d_time;
+            entry.d_event = blptst::TestUtil::createEvent(
+                    static_cast<blp::Event::EventType>(record.d_eventType));
+            d_events.push_back(entry);
+            started = true;
+            event = record.d_event;
+        }
+
+        blptst::MessageProperties properties;
+        if (record.d_correlationType == EventJournal::Record::e_TOPIC) {
+            const std::string& topic = *d_topics.insert(record.d_topic).first;
+            properties.setCorrelationId(blp::CorrelationId(
+                    const_cast<char *>(topic.c_str())));
+        }
+        else if (record.d_correlationType == EventJournal::Record::e_INT) {
+            const std::map<int64_t, int64_t>::const_iterator it
+                    = d_ids.find(record.d_correlationId);
+            properties.setCorrelationId(blp::CorrelationId(
+                    it == d_ids.end() ? record.d_correlationId
+                                      : it->second));
+        }
+
+        try {
+            const blp::Name messageType(record.d_messageType.c_str());
+            const blp::SchemaElementDefinition definition
+                    = d_service.hasEventDefinition(messageType)
+                    ? d_service.getEventDefinition(messageType)
+                    : blptst::TestUtil::getAdminMessageDefinition(
+                            messageType);
+            blptst::MessageFormatter formatter
+                    = blptst::TestUtil::appendMessage(
+                            d_events.back().d_event, definition, properties);
+            if (!record.d_content.empty()) {
+                formatter.formatMessageJson(record.d_content.c_str());
+            }
+            ++d_messages;
+        } catch (blp::Exception&) {
+            ++d_skipped;
+        }
+    }
+    return d_events.size() - first;
+}
+
+JournalReplayer::Statistics JournalReplayer::replay(
+        blp::EventHandler *handler, Timing timing, blp::Session *session) const
+{
+    const std::chrono::steady_clock::time_point start
+            = std::chrono::steady_clock::now();
+    // The offset of each event from the first, with no gap where the
+    // journal goes back in time, as where captures were appended.
+    int64_t offset = 0;
+    for (size_t i = 0; i < d_events.size(); ++i) {
+        if (timing == e_ORIGINAL) {
+            if (i > 0 && d_events[i].d_time > d_events[i - 1].d_time) {
+                offset += d_events[i].d_time - d_events[i - 1].d_time;
+            }
+            std::this_thread::sleep_until(
+                    start + std::chrono::nanoseconds(offset));
+        }
+        handler->processEvent(d_events[i].d_event, session);
+    }
+    Statistics statistics;
+    statistics.d_events = d_events.size();
+    statistics.d_elapsed
+            = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start)
+                      .count();
+    return statistics;
+}
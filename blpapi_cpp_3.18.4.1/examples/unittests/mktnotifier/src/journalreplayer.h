@@ -0,0 +1,112 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _JOURNALREPLAYER_H_
+#define _JOURNALREPLAYER_H_
+
+#include <blpapi_event.h>
+#include <blpapi_service.h>
+#include <blpapi_session.h>
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+// JournalReplayer rebuilds the events captured by an EventJournal with
+// blp::test::TestUtil and feeds them to an event handler, such as an
+// EventProcessor or a PipelineProcessor, so its throughput and latency can
+// be measured without a session.
+//
+// Subscription data messages are formatted from the event definitions of
+// the service they were captured from, and status and admin messages from
+// the definitions TestUtil has for them; a message with neither is
+// skipped. A message captured with a topic as its correlation id is
+// replayed with a pointer to the same topic, and one captured with an
+// integer with the same integer, unless the journal has a topic record for
+// it. The topics of those records are given ids of their own, in the order
+// they first appear, which `topics` returns for the caller to register in
+// the same order, and their messages are replayed with those ids. Journals
+// appended to by several captures, whose ids differ, replay as one.
+//
+// The events are rebuilt as they are loaded, so replaying only times the
+// handler, and may be done any number of times.
+class JournalReplayer {
+  public:
+    enum Timing {
+        e_AS_FAST_AS_POSSIBLE,
+        e_ORIGINAL // events are spaced as they were received
+    };
+
+    struct Statistics {
+        uint64_t d_events; // events handed to the handler
+        int64_t d_elapsed; // nanoseconds the replay took
+    };
+
+  private:
+    struct Entry {
+        int64_t d_time; // of the first message, from the capture start
+        blp::Event d_event;
+    };
+
+    blp::Service d_service;
+    std::vector<Entry> d_events;
+    std::set<std::string> d_topics; // pointed to by correlation ids
+    std::vector<std::string> d_registered; // by replay id
+    std::map<std::string, int64_t> d_replayIds; // by topic
+    std::map<int64_t, int64_t> d_ids; // replay ids of captured ids
+    uint64_t d_messages;
+    uint64_t d_skipped;
+
+  public:
+    // Create a replayer formatting subscription data with the event
+    // definitions of `service`.
+    explicit JournalReplayer(const blp::Service& service);
+
+    // Rebuild the events of the journal `stream`, after those already
+    // loaded, and return the number of events rebuilt. Stop at the end of
+    // the journal or at the first corrupt record.
+    size_t load(std::istream& stream);
+
+    // Hand every event loaded to `handler` in order, with `session`, and
+    // return how long that took. With e_ORIGINAL timing, wait before each
+    // event for as long after the previous one as it was received.
+    Statistics replay(blp::EventHandler *handler,
+            Timing timing = e_AS_FAST_AS_POSSIBLE,
+            blp::Session *session = 0) const;
+
+    size_t numEvents() const { return d_events.size(); }
+
+    // Return the topics of the topic records loaded, in the order of the
+    // ids they are replayed with, from 0.
+    const std::vector<std::string>& topics() const { return d_registered; }
+
+    // Return the number of messages rebuilt.
+    uint64_t numMessages() const { return d_messages; }
+
+    // Return the number of messages skipped for want of a definition.
+    uint64_t numSkipped() const { return d_skipped; }
+};
+
+#endif
@@ -0,0 +1,112 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "latencyhistogram.h"
+
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+int LatencyHistogram::bucketOf(int64_t nanoseconds)
+{
+    const uint64_t value = nanoseconds < 0 ? 0 : nanoseconds;
+    if (value < 2 * k_SUB_BUCKETS) {
+        return static_cast<int>(value);
+    }
+    int bit = 63;
+    while (!(value >> bit)) {
+        --bit;
+    }
+    if (bit > k_MAX_BIT) {
+        return k_NUM_BUCKETS - 1;
+    }
+    // Keep the top k_SUB_BITS + 1 bits of the value.
+    const int shift = bit - k_SUB_BITS;
+    return (shift + 1) * k_SUB_BUCKETS + static_cast<int>(value >> shift)
+            - k_SUB_BUCKETS;
+}
+
+int64_t LatencyHistogram::highestIn(int bucket)
+{
+    if (bucket < 2 * k_SUB_BUCKETS) {
+        return bucket;
+    }
+    const int shift = bucket / k_SUB_BUCKETS - 1;
+    const int64_t mantissa = bucket % k_SUB_BUCKETS + k_SUB_BUCKETS;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t nanoseconds)
+{
+    if (nanoseconds < 0) {
+        nanoseconds = 0;
+    }
+    d_buckets[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    d_count.fetch_add(1, std::memory_order_relaxed);
+    d_total.fetch_add(nanoseconds, std::memory_order_relaxed);
+    int64_t max = d_max.load(std::memory_order_relaxed);
+    while (nanoseconds > max
+            && !d_max.compare_exchange_weak(
+                    max, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+int64_t LatencyHistogram::percentile(double percentile) const
+{
+    const uint64_t count = this->count();
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100 * count));
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int b = 0; b < k_NUM_BUCKETS; ++b) {
+        seen += d_buckets[b].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            const int64_t highest = highestIn(b);
+            return highest < max() ? highest : max();
+        }
+    }
+    return max();
+}
+
+double LatencyHistogram::mean() const
+{
+    const uint64_t count = this->count();
+    return count == 0
+            ? 0.0
+            : static_cast<double>(d_total.load(std::memory_order_relaxed))
+                    / count;
+}
+
+void LatencyHistogram::reset()
+{
+    for (int b = 0; b < k_NUM_BUCKETS; ++b) {
+        d_buckets[b].store(0, std::memory_order_relaxed);
+    }
+    d_count.store(0, std::memory_order_relaxed);
+    d_total.store(0, std::memory_order_relaxed);
+    d_max.store(0, std::memory_order_relaxed);
+}
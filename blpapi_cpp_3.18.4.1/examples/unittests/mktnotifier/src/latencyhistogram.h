@@ -0,0 +1,77 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _LATENCYHISTOGRAM_H_
+#define _LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <cstdint>
+
+// LatencyHistogram counts latencies in nanoseconds in log-linear buckets,
+// as an HDR histogram does: values below 128 each have a bucket, and each
+// power of two above is split into 64 buckets, so a bucket is within 1.6%
+// of any value in it, below 2^41 ns, about 36 minutes, beyond which values
+// are counted in the last bucket. Recording is a few relaxed atomic
+// increments, so any number of threads may record at once, with no lock.
+class LatencyHistogram {
+  private:
+    enum {
+        k_SUB_BITS = 6,
+        k_SUB_BUCKETS = 1 << k_SUB_BITS,
+        k_MAX_BIT = 40, // highest bit of a value with a bucket
+        k_NUM_BUCKETS = (k_MAX_BIT - k_SUB_BITS + 2) * k_SUB_BUCKETS
+    };
+
+    std::atomic<uint64_t> d_buckets[k_NUM_BUCKETS];
+    std::atomic<uint64_t> d_count;
+    std::atomic<int64_t> d_total;
+    std::atomic<int64_t> d_max;
+
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+
+  public:
+    LatencyHistogram();
+
+    // Return the bucket of `nanoseconds`.
+    static int bucketOf(int64_t nanoseconds);
+
+    // Return the highest value counted in `bucket`.
+    static int64_t highestIn(int bucket);
+
+    // Count `nanoseconds`, or 0 if it is negative.
+    void record(int64_t nanoseconds);
+
+    // Return the latency `percentile` percent of the values counted are at
+    // or below, to the precision of its bucket, or 0 if none are counted.
+    int64_t percentile(double percentile) const;
+
+    uint64_t count() const { return d_count.load(std::memory_order_relaxed); }
+
+    // Return the mean of the values counted, or 0 if none are.
+    double mean() const;
+
+    int64_t max() const { return d_max.load(std::memory_order_relaxed); }
+
+    // Forget every value counted. Values recorded meanwhile may be lost.
+    void reset();
+};
+
+#endif
@@ -0,0 +1,141 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "latencyrecorder.h"
+
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+namespace {
+const char *const STAGE_NAMES[] = {
+    "wire", "decode", "queue", "compute", "notify", "total"
+};
+
+const double PERCENTILES[] = { 50, 90, 99, 99.9 };
+}
+
+LatencyRecorder::LatencyRecorder()
+    : d_stopping(false)
+{
+}
+
+LatencyRecorder::~LatencyRecorder() { stopDumping(); }
+
+const char *LatencyRecorder::nameOf(Stage stage)
+{
+    return STAGE_NAMES[stage];
+}
+
+void LatencyRecorder::record(
+        Stage stage, const blp::TimePoint& start, const blp::TimePoint& end)
+{
+    d_histograms[stage].record(
+            blp::TimePointUtil::nanosecondsBetween(start, end));
+}
+
+void LatencyRecorder::record(Stage stage, long long nanoseconds)
+{
+    d_histograms[stage].record(nanoseconds);
+}
+
+const LatencyHistogram& LatencyRecorder::histogram(Stage stage) const
+{
+    return d_histograms[stage];
+}
+
+void LatencyRecorder::dump(std::ostream& stream) const
+{
+    const std::ios::fmtflags flags = stream.flags();
+    const std::streamsize precision = stream.precision();
+    stream << std::fixed << std::setprecision(1);
+    stream << std::left << std::setw(8) << "stage" << std::right
+           << std::setw(12) << "count" << std::setw(10) << "mean";
+    for (size_t p = 0; p < sizeof PERCENTILES / sizeof *PERCENTILES; ++p) {
+        std::ostringstream label;
+        label << 'p' << PERCENTILES[p];
+        stream << std::setw(10) << label.str();
+    }
+    stream << std::setw(10) << "max" << " (us)\n";
+    for (int s = 0; s < k_NUM_STAGES; ++s) {
+        const LatencyHistogram& histogram = d_histograms[s];
+        if (histogram.count() == 0) {
+            continue;
+        }
+        stream << std::left << std::setw(8) << STAGE_NAMES[s] << std::right
+               << std::setw(12) << histogram.count() << std::setw(10)
+               << histogram.mean() / 1000;
+        for (size_t p = 0; p < sizeof PERCENTILES / sizeof *PERCENTILES;
+                ++p) {
+            stream << std::setw(10)
+                   << histogram.percentile(PERCENTILES[p]) / 1000.0;
+        }
+        stream << std::setw(10) << histogram.max() / 1000.0 << '\n';
+    }
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+bool LatencyRecorder::dumpTo(const std::string& path) const
+{
+    std::ofstream file(path.c_str(), std::ios::app);
+    if (!file) {
+        return false;
+    }
+    const std::time_t now = std::time(0);
+    char stamp[32];
+    std::strftime(stamp,
+            sizeof stamp,
+            "%Y-%m-%d %H:%M:%S",
+            std::localtime(&now));
+    file << "# " << stamp << '\n';
+    dump(file);
+    file << '\n';
+    return static_cast<bool>(file.flush());
+}
+
+void LatencyRecorder::startDumping(
+        const std::string& path, std::chrono::seconds interval)
+{
+    stopDumping();
+    d_stopping = false;
+    d_dumper = std::thread([this, path, interval]() {
+        std::unique_lock<std::mutex> lock(d_mutex);
+        while (!d_condition.wait_for(
+                lock, interval, [this]() { return d_stopping; })) {
+            dumpTo(path);
+        }
+    });
+}
+
+void LatencyRecorder::stopDumping()
+{
+    if (!d_dumper.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_stopping = true;
+    }
+    d_condition.notify_all();
+    d_dumper.join();
+}
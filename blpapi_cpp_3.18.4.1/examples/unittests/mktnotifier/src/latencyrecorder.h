@@ -0,0 +1,122 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _LATENCYRECORDER_H_
+#define _LATENCYRECORDER_H_
+
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_timepoint.h>
+
+#include "latencyhistogram.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace blp = BloombergLP::blpapi;
+
+// LatencyRecorder keeps a LatencyHistogram for each stage a tick goes
+// through, timed with blp::HighResolutionClock, from the time the session
+// received its message, which it records only if asked to by
+// blp::SessionOptions::setRecordSubscriptionDataReceiveTimes. Any thread
+// may record. The percentiles of every stage may be dumped on demand, and
+// appended to a file at an interval by a background thread.
+class LatencyRecorder {
+  public:
+    enum Stage {
+        e_WIRE, // from receipt by the session to the event handler
+        e_DECODE, // decoding the message into a tick
+        e_QUEUE, // waiting in a pipeline ring for a worker
+        e_COMPUTE, // from the hand-off to the compute engine to its result
+        e_NOTIFY, // in the notifier
+        e_TOTAL, // from receipt by the session to the notifier returning
+        k_NUM_STAGES
+    };
+
+  private:
+    LatencyHistogram d_histograms[k_NUM_STAGES];
+    std::thread d_dumper;
+    std::mutex d_mutex;
+    std::condition_variable d_condition;
+    bool d_stopping;
+
+    LatencyRecorder(const LatencyRecorder&);
+    LatencyRecorder& operator=(const LatencyRecorder&);
+
+  public:
+    LatencyRecorder();
+
+    // Stop dumping.
+    ~LatencyRecorder();
+
+    // Return the name of `stage` as dumped.
+    static const char *nameOf(Stage stage);
+
+    static blp::TimePoint now() { return blp::HighResolutionClock::now(); }
+
+    // Record that `stage` took from `start` to `end`.
+    void record(Stage stage,
+            const blp::TimePoint& start,
+            const blp::TimePoint& end);
+
+    // Record that `stage` took `nanoseconds`.
+    void record(Stage stage, long long nanoseconds);
+
+    const LatencyHistogram& histogram(Stage stage) const;
+
+    // Write the count, mean, 50th, 90th, 99th and 99.9th percentiles and
+    // maximum of each stage that has recorded anything, in microseconds,
+    // to `stream`.
+    void dump(std::ostream& stream) const;
+
+    // Append a timestamped dump to the file at `path`. Return false if the
+    // file cannot be written.
+    bool dumpTo(const std::string& path) const;
+
+    // Start appending a dump to the file at `path` every `interval`.
+    void startDumping(const std::string& path, std::chrono::seconds interval);
+
+    // Stop dumping at an interval, if started, once the dump under way, if
+    // any, is written.
+    void stopDumping();
+};
+
+// TickTimes holds the times a tick is timed from: when the session received
+// its message, if it recorded it, and when the tick, decoded, was handed to
+// the compute engine.
+struct TickTimes {
+    blp::TimePoint d_received;
+    blp::TimePoint d_handed;
+    bool d_timed; // `d_received` is set
+
+    TickTimes();
+};
+
+inline TickTimes::TickTimes()
+    : d_received()
+    , d_handed()
+    , d_timed(false)
+{
+}
+
+#endif
@@ -23,17 +23,37 @@
 
 #include "appconfig.h"
 #include "application.h"
+#include "asyncnotifier.h"
 #include "authorizer.h"
+#include "chainbook.h"
+#include "chainmanager.h"
+#include "chainrequester.h"
 #include "computeengine.h"
+#include "eventjournal.h"
 #include "eventprocessor.h"
+#include "latencyrecorder.h"
 #include "notifier.h"
+#include "pipelineprocessor.h"
+#include "pricingengine.h"
 #include "subscriber.h"
+#include "tickstore.h"
 #include "tokengenerator.h"
+#include "topicregistry.h"
 
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <string>
 
 namespace blp = BloombergLP::blpapi;
 
+namespace {
+// The most option topics the chains may ever subscribe to, rolls included.
+// Ids are not reused, so the subscriber skips the members of a chain once
+// the registry is full.
+const size_t k_MAX_CHAIN_TOPICS = 50000;
+}
+
 int main(int argc, char **argv)
 {
     // Initialize config based on command line options
@@ -43,24 +63,120 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    Notifier notifier;
-    ComputeEngine computeEngine;
-    EventProcessor eventProcessor(&notifier, &computeEngine);
+    std::vector<Strategy> strategies(config.d_strategies.size());
+    for (size_t i = 0; i < strategies.size(); ++i) {
+        if (!Strategy::parse(&strategies[i], config.d_strategies[i])) {
+            std::cout << "Invalid strategy: " << config.d_strategies[i]
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    // Write notifications off the threads delivering data.
+    AsyncNotifier::Config notifierConfig;
+    if (!AsyncNotifier::parseSink(&notifierConfig, config.d_sink)) {
+        std::cout << "Invalid sink: " << config.d_sink << std::endl;
+        return 1;
+    }
+    notifierConfig.d_policy = config.d_dropNotifications
+            ? AsyncNotifier::e_DROP
+            : AsyncNotifier::e_BLOCK;
+    AsyncNotifier notifier(notifierConfig);
+    PricingEngine pricingEngine(&notifier, strategies);
+
+    // Keep the options of the chains subscribed to in a live book.
+    ChainBook chainBook;
+    ChainBookEngine chainBookEngine(&chainBook, &pricingEngine);
+    IComputeEngine *computeEngine = &pricingEngine;
+    if (!config.d_chains.empty()) {
+        computeEngine = &chainBookEngine;
+    }
+
+    // Register the topics given up front. The members of the chains are
+    // registered as they are subscribed to, and the processors are sized
+    // for the capacity of the registry, so they know those too.
+    TopicRegistry registry(config.d_topics.size()
+            + (config.d_chains.empty() ? 0 : k_MAX_CHAIN_TOPICS));
+    for (size_t i = 0; i < config.d_topics.size(); ++i) {
+        registry.add(config.d_topics[i], config.d_fields);
+    }
+    // Time each tick through its stages, if asked to.
+    LatencyRecorder latencyRecorder;
+    LatencyRecorder *recorder = 0;
+    if (!config.d_latencyPath.empty()) {
+        recorder = &latencyRecorder;
+        latencyRecorder.startDumping(config.d_latencyPath,
+                std::chrono::seconds(config.d_latencyInterval));
+    }
+
+    // Keep every tick in per-day segments, if asked to.
+    std::unique_ptr<TickStore> tickStore;
+    if (!config.d_storeDirectory.empty()) {
+        TickStore::Config storeConfig;
+        storeConfig.d_directory = config.d_storeDirectory;
+        tickStore.reset(new TickStore(storeConfig));
+    }
+
+    EventProcessor eventProcessor(&notifier, computeEngine, &registry);
+    eventProcessor.setLatencyRecorder(recorder);
+    eventProcessor.setTickStore(tickStore.get());
+    blp::EventHandler *eventHandler = &eventProcessor;
+
+    // Unless asked not to, process data off the dispatcher thread.
+    std::unique_ptr<PipelineProcessor> pipelineProcessor;
+    if (config.d_shards > 0) {
+        PipelineProcessor::Config pipelineConfig;
+        pipelineConfig.d_shards = config.d_shards;
+        pipelineConfig.d_firstCpu = config.d_firstCpu;
+        pipelineConfig.d_registry = &registry;
+        pipelineConfig.d_recorder = recorder;
+        pipelineConfig.d_store = tickStore.get();
+        pipelineProcessor.reset(new PipelineProcessor(&notifier,
+                computeEngine,
+                config.d_fields,
+                pipelineConfig));
+        eventHandler = pipelineProcessor.get();
+    }
+
+    // Capture the events to a journal on their way in, if asked to.
+    std::unique_ptr<EventJournal> journal;
+    if (!config.d_capturePath.empty()) {
+        journal.reset(new EventJournal(
+                config.d_capturePath, eventHandler, &registry));
+        eventHandler = journal.get();
+    }
+
     blp::SessionOptions sessionOptions;
     for (size_t i = 0; i < config.d_hosts.size(); ++i) {
         sessionOptions.setServerAddress(
                 config.d_hosts[i].c_str(), config.d_port, i);
     }
     sessionOptions.setAuthenticationOptions(config.d_authOptions.c_str());
+    sessionOptions.setRecordSubscriptionDataReceiveTimes(recorder != 0);
 
-    blp::Session session(sessionOptions, &eventProcessor);
+    blp::Session session(sessionOptions, eventHandler);
     TokenGenerator tokenGenerator(&session);
 
     Authorizer authorizer(&session, &tokenGenerator);
-    Subscriber subscriber(&session);
+    Subscriber subscriber(&session, &registry);
 
-    Application app(
-            &session, &authorizer, &subscriber, &eventProcessor, &config);
+    ChainRequester chainRequester(&session);
+    ChainManager::Config chainConfig;
+    chainConfig.d_service = config.d_service;
+    chainConfig.d_fields = config.d_fields;
+    chainConfig.d_options = config.d_options;
+    ChainManager chainManager(
+            &subscriber, &chainRequester, &chainBook, chainConfig);
+    for (size_t i = 0; i < config.d_chains.size(); ++i) {
+        chainManager.addChain(config.d_chains[i]);
+    }
+
+    Application app(&session,
+            &authorizer,
+            &subscriber,
+            eventHandler,
+            &config,
+            config.d_chains.empty() ? 0 : &chainManager);
 
     try {
         app.run();
@@ -68,10 +184,47 @@ int main(int argc, char **argv)
         std::cerr << "Library Exception" << e.description() << std::endl;
     }
 
-    // wait for enter key to exit application
-    std::cout << "Press ENTER to quit" << std::endl;
-    char dummy[2];
-    std::cin.getline(dummy, 2);
+    // Refresh the chains, to pick up rolls and new listings, and dump the
+    // latencies on demand, until asked to quit.
+    const bool chains = !config.d_chains.empty();
+    for (;;) {
+        if (chains) {
+            std::cout << "Enter r to refresh the option chains" << std::endl;
+        }
+        if (recorder) {
+            std::cout << "Enter l to print the latencies" << std::endl;
+        }
+        std::cout << "Press ENTER to quit" << std::endl;
+        std::string line;
+        if (!std::getline(std::cin, line)) {
+            break;
+        }
+        if (chains && line == "r") {
+            try {
+                if (!app.refreshChains()) {
+                    std::cerr << "Failed to retrieve an option chain."
+                              << std::endl;
+                }
+            } catch (blp::Exception& e) {
+                std::cerr << "Library Exception" << e.description()
+                          << std::endl;
+            }
+        } else if (recorder && line == "l") {
+            recorder->dump(std::cout);
+        } else {
+            break;
+        }
+    }
+
+    if (tickStore && tickStore->numDropped() > 0) {
+        std::cerr << "Tick store dropped " << tickStore->numDropped()
+                  << " ticks" << std::endl;
+    }
+
+    if (recorder) {
+        latencyRecorder.stopDumping();
+        latencyRecorder.dumpTo(config.d_latencyPath);
+    }
 
     return 0;
 }
@@ -0,0 +1,144 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _MPSCRING_H_
+#define _MPSCRING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// MpscRing is a fixed capacity, lock-free queue for any number of producer
+// threads and one consumer thread. Each slot carries a sequence number
+// that tells whether it is free for the producer claiming that position or
+// full for the consumer, so producers only contend on claiming a position,
+// a push to a full ring and a pop from an empty one fail at once, and no
+// thread ever waits on a lock held by another.
+template <class TYPE>
+class MpscRing {
+  private:
+    enum { k_CACHE_LINE = 64 };
+
+    struct Slot {
+        std::atomic<size_t> d_sequence;
+        TYPE d_value;
+    };
+
+    std::vector<Slot> d_slots;
+    size_t d_mask;
+    char d_pad0[k_CACHE_LINE];
+    std::atomic<size_t> d_tail; // next position to claim, by producers
+    char d_pad1[k_CACHE_LINE];
+    std::atomic<size_t> d_head; // next position to pop, by the consumer
+    char d_pad2[k_CACHE_LINE];
+
+    MpscRing(const MpscRing&);
+    MpscRing& operator=(const MpscRing&);
+
+  public:
+    // Create a ring holding at least `capacity` values, rounded up to a
+    // power of two of at least two.
+    explicit MpscRing(size_t capacity);
+
+    // Append `value` and return true, or return false if the ring is full.
+    bool tryPush(const TYPE& value);
+
+    // Move into `value` the oldest value and remove it, and return true,
+    // or return false if the ring is empty, or its oldest value is still
+    // being pushed. Must only be called by the consumer.
+    bool tryPop(TYPE *value);
+
+    // Return the number of values pushed and not yet popped, which may be
+    // stale by the time it is read.
+    size_t size() const;
+
+    size_t capacity() const { return d_slots.size(); }
+};
+
+template <class TYPE>
+MpscRing<TYPE>::MpscRing(size_t capacity)
+    : d_tail(0)
+    , d_head(0)
+{
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+    std::vector<Slot> slots(size);
+    d_slots.swap(slots);
+    d_mask = size - 1;
+    for (size_t i = 0; i < size; ++i) {
+        d_slots[i].d_sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <class TYPE>
+bool MpscRing<TYPE>::tryPush(const TYPE& value)
+{
+    size_t position = d_tail.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = d_slots[position & d_mask];
+        const size_t sequence
+                = slot.d_sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t lag = static_cast<std::ptrdiff_t>(sequence)
+                - static_cast<std::ptrdiff_t>(position);
+        if (lag == 0) {
+            if (d_tail.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed)) {
+                slot.d_value = value;
+                slot.d_sequence.store(
+                        position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (lag < 0) {
+            // The slot still holds the value pushed a lap ago.
+            return false;
+        }
+        else {
+            position = d_tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <class TYPE>
+bool MpscRing<TYPE>::tryPop(TYPE *value)
+{
+    const size_t position = d_head.load(std::memory_order_relaxed);
+    Slot& slot = d_slots[position & d_mask];
+    if (slot.d_sequence.load(std::memory_order_acquire) != position + 1) {
+        return false;
+    }
+    *value = std::move(slot.d_value);
+    slot.d_sequence.store(position + d_mask + 1, std::memory_order_release);
+    d_head.store(position + 1, std::memory_order_relaxed);
+    return true;
+}
+
+template <class TYPE>
+size_t MpscRing<TYPE>::size() const
+{
+    const size_t head = d_head.load(std::memory_order_relaxed);
+    const size_t tail = d_tail.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+}
+
+#endif
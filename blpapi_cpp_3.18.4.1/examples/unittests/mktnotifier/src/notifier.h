@@ -23,6 +23,7 @@
 
 #include <blpapi_message.h>
 #include <iostream>
+#include <string>
 
 namespace blp = BloombergLP::blpapi;
 
@@ -34,6 +35,14 @@ class INotifier {
 
     virtual void sendToTerminal(double value) = 0;
 
+    // Deliver `value`, the latest value of the strategy named `strategy`,
+    // to terminal. By default only the value is sent.
+    virtual void sendStrategyValue(
+            const std::string& /* strategy */, double value)
+    {
+        sendToTerminal(value);
+    }
+
     virtual ~INotifier() { }
 };
 
@@ -59,6 +68,11 @@ class Notifier : public INotifier {
     {
         std::cout << "VALUE = " << value << std::endl;
     }
+
+    virtual void sendStrategyValue(const std::string& strategy, double value)
+    {
+        std::cout << strategy << " = " << value << std::endl;
+    }
 };
 
 #endif
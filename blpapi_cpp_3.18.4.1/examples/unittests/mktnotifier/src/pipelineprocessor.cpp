@@ -0,0 +1,318 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "pipelineprocessor.h"
+
+#include "eventprocessor.h"
+
+#include <blpapi_message.h>
+#include <blpapi_names.h>
+
+#include <chrono>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace blp = BloombergLP::blpapi;
+
+namespace {
+// The number of times an idle worker polls its ring before it starts to
+// sleep between polls.
+const int k_SPINS = 1000;
+const std::chrono::microseconds k_IDLE_SLEEP(50);
+
+// The shard of a registered topic that has not ticked yet.
+const size_t k_NO_SHARD = static_cast<size_t>(-1);
+
+// Pin the calling thread to `cpu`, where supported.
+void pinToCpu(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#else
+    (void)cpu;
+#endif
+}
+}
+
+PipelineProcessor::Config::Config()
+    : d_shards(2)
+    , d_capacity(4096)
+    , d_firstCpu(-1)
+    , d_registry(0)
+    , d_recorder(0)
+    , d_store(0)
+{
+}
+
+PipelineProcessor::Shard::Shard(size_t capacity)
+    : d_ring(capacity)
+    , d_pushed(0)
+    , d_dropped(0)
+    , d_processed(0)
+    , d_conflated(0)
+{
+}
+
+PipelineProcessor::PipelineProcessor(INotifier *notifier,
+        IComputeEngine *computeEngine,
+        const std::vector<std::string>& fields,
+        const Config& config)
+    : d_notifier(notifier)
+    , d_computeEngine(computeEngine)
+    , d_fieldPlan(fields)
+    , d_registry(config.d_registry)
+    , d_recorder(config.d_recorder)
+    , d_store(config.d_store)
+    , d_conflationTable(d_registry ? d_registry->topics() : config.d_topics,
+              d_registry ? d_registry->capacity() : 0)
+    , d_conflating(false)
+    , d_stopping(false)
+{
+    if (config.d_shards < 1 || config.d_capacity < 1) {
+        throw std::invalid_argument(
+                "at least one shard with room for a tick is needed");
+    }
+    for (int i = 0; i < config.d_shards; ++i) {
+        d_shards.push_back(
+                std::unique_ptr<Shard>(new Shard(config.d_capacity)));
+    }
+    if (d_registry) {
+        // The slot of each topic in the table is its id, and its shard is
+        // looked up once its first tick arrives, as it may not have been
+        // registered yet.
+        d_shardOfId.resize(d_registry->capacity(), k_NO_SHARD);
+    }
+    for (int i = 0; i < config.d_shards; ++i) {
+        Shard *shard = d_shards[i].get();
+        const int cpu = config.d_firstCpu < 0 ? -1 : config.d_firstCpu + i;
+        shard->d_worker = std::thread([this, shard, cpu]() {
+            if (cpu >= 0) {
+                pinToCpu(cpu);
+            }
+            run(shard);
+        });
+    }
+}
+
+PipelineProcessor::~PipelineProcessor()
+{
+    d_stopping.store(true, std::memory_order_release);
+    for (size_t i = 0; i < d_shards.size(); ++i) {
+        d_shards[i]->d_worker.join();
+    }
+}
+
+size_t PipelineProcessor::shardOf(const char *topic) const
+{
+    return ConflationTable::hashOf(topic) % d_shards.size();
+}
+
+void PipelineProcessor::push(Shard *shard, const TickRecord& record)
+{
+    if (shard->d_ring.tryPush(record)) {
+        shard->d_pushed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    shard->d_dropped.fetch_add(1, std::memory_order_relaxed);
+    if (record.d_slot >= 0) {
+        // The snapshot stays in the table and is queued by the next tick.
+        d_conflationTable.unqueue(record.d_slot);
+    }
+}
+
+bool PipelineProcessor::processEvent(
+        const blp::Event& event, blp::Session *session)
+{
+    blp::MessageIterator msgIter(event);
+    while (msgIter.next()) {
+        blp::Message msg = msgIter.message();
+        switch (event.eventType()) {
+        case blp::Event::SESSION_STATUS:
+            d_notifier->logSessionState(msg);
+            break;
+        case blp::Event::SUBSCRIPTION_STATUS:
+            d_notifier->logSubscriptionState(msg);
+            break;
+        case blp::Event::SUBSCRIPTION_DATA: {
+            TickRecord record;
+            record.d_slot = -1;
+            record.d_timed = false;
+            blp::TimePoint handled;
+            if (d_recorder) {
+                handled = LatencyRecorder::now();
+                record.d_timed = msg.timeReceived(&record.d_received) == 0;
+                if (record.d_timed) {
+                    d_recorder->record(LatencyRecorder::e_WIRE,
+                            record.d_received,
+                            handled);
+                }
+            }
+            const int id = d_registry ? d_registry->idOf(msg) : -1;
+            if (id >= 0) {
+                d_registry->update(&record.d_tick, id, msg);
+                record.d_topic = d_registry->topic(id);
+            }
+            else {
+                record.d_topic = EventProcessor::topicOf(msg);
+                d_fieldPlan.decode(&record.d_tick, msg);
+            }
+            if (d_store) {
+                // Every tick is stored, conflated or not.
+                d_store->append(id, record.d_topic, record.d_tick);
+            }
+            if (d_recorder) {
+                record.d_pushed = LatencyRecorder::now();
+                d_recorder->record(
+                        LatencyRecorder::e_DECODE, handled, record.d_pushed);
+            }
+            const bool conflating
+                    = d_conflating.load(std::memory_order_relaxed);
+            Shard *shard;
+            if (id >= 0) {
+                size_t& shardOfId = d_shardOfId[id];
+                if (shardOfId == k_NO_SHARD) {
+                    shardOfId = shardOf(record.d_topic);
+                }
+                shard = d_shards[shardOfId].get();
+                if (conflating) {
+                    record.d_slot = id;
+                }
+            }
+            else {
+                const size_t hash = ConflationTable::hashOf(record.d_topic);
+                shard = d_shards[hash % d_shards.size()].get();
+                if (conflating) {
+                    record.d_slot
+                            = d_conflationTable.find(record.d_topic, hash);
+                }
+            }
+            if (record.d_slot >= 0) {
+                bool conflated;
+                const bool queue = d_conflationTable.store(
+                        &conflated, record.d_slot, record.d_tick);
+                if (conflated) {
+                    shard->d_conflated.fetch_add(
+                            1, std::memory_order_relaxed);
+                }
+                if (!queue) {
+                    break;
+                }
+            }
+            push(shard, record);
+            break;
+        }
+        case blp::Event::ADMIN:
+            if (msg.messageType() == blp::Names::slowConsumerWarning()) {
+                d_conflating.store(true);
+            }
+            else if (msg.messageType()
+                    == blp::Names::slowConsumerWarningCleared()) {
+                d_conflating.store(false);
+            }
+            break;
+        default:
+            return true;
+        }
+    }
+    return true;
+}
+
+void PipelineProcessor::run(Shard *shard)
+{
+    TickRecord record;
+    int idle = 0;
+    for (;;) {
+        if (shard->d_ring.tryPop(&record)) {
+            idle = 0;
+            if (record.d_slot >= 0) {
+                d_conflationTable.unqueue(record.d_slot);
+                if (!d_conflationTable.load(&record.d_tick, record.d_slot)) {
+                    // A snapshot already processed, queued again by a tick
+                    // stored while it was being loaded.
+                    shard->d_processed.fetch_add(
+                            1, std::memory_order_release);
+                    continue;
+                }
+            }
+            if (d_recorder) {
+                d_recorder->record(LatencyRecorder::e_QUEUE,
+                        record.d_pushed,
+                        LatencyRecorder::now());
+            }
+            TickTimes times;
+            times.d_received = record.d_received;
+            times.d_timed = record.d_timed;
+            EventProcessor::processTick(d_notifier,
+                    d_computeEngine,
+                    record.d_topic,
+                    record.d_tick,
+                    d_recorder,
+                    times);
+            shard->d_processed.fetch_add(1, std::memory_order_release);
+            continue;
+        }
+        if (d_stopping.load(std::memory_order_acquire)) {
+            // The dispatcher has stopped pushing, so an empty ring stays
+            // empty.
+            if (shard->d_ring.size() == 0) {
+                return;
+            }
+            continue;
+        }
+        if (idle < k_SPINS) {
+            ++idle;
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(k_IDLE_SLEEP);
+        }
+    }
+}
+
+PipelineProcessor::ShardStatistics PipelineProcessor::statistics(
+        size_t shard) const
+{
+    const Shard& s = *d_shards[shard];
+    ShardStatistics result;
+    result.d_depth = s.d_ring.size();
+    result.d_pushed = s.d_pushed.load(std::memory_order_relaxed);
+    result.d_dropped = s.d_dropped.load(std::memory_order_relaxed);
+    result.d_processed = s.d_processed.load(std::memory_order_acquire);
+    result.d_conflated = s.d_conflated.load(std::memory_order_relaxed);
+    return result;
+}
+
+void PipelineProcessor::waitIdle() const
+{
+    for (size_t i = 0; i < d_shards.size(); ++i) {
+        const Shard& shard = *d_shards[i];
+        while (shard.d_processed.load(std::memory_order_acquire)
+                != shard.d_pushed.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(k_IDLE_SLEEP);
+        }
+    }
+}
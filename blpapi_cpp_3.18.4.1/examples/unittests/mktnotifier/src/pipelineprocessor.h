@@ -0,0 +1,166 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _PIPELINEPROCESSOR_H_
+#define _PIPELINEPROCESSOR_H_
+
+#include <blpapi_event.h>
+#include <blpapi_session.h>
+
+#include "computeengine.h"
+#include "conflationtable.h"
+#include "fieldplan.h"
+#include "latencyrecorder.h"
+#include "notifier.h"
+#include "spscring.h"
+#include "tickstore.h"
+#include "topicregistry.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+// PipelineProcessor is an EventProcessor that keeps the compute engine
+// and the notifier off the blpapi dispatcher thread, so a slow notifier
+// does not hold up the session and cause SlowConsumerWarning and DataLoss.
+//
+// The dispatcher thread only decodes each subscription data message into
+// a TickRecord and pushes it onto the ring of one of N shards, chosen by
+// a hash of its topic, so the ticks of a topic stay in order. Each shard
+// has one worker thread, optionally pinned to a CPU, that pops its ring
+// and hands the ticks to the compute engine and the notifier as the
+// EventProcessor does. A tick that finds its ring full is dropped and
+// counted. Session and subscription status messages are still logged on
+// the dispatcher thread.
+//
+// Given a TopicRegistry, the updates of its topics are decoded with their
+// own plans and recorded in the registry, and every topic it has room for
+// may be conflated, including those registered after the processor is
+// created, such as the members of an option chain. Their shard and
+// conflation slot are then found from their id by an array index instead
+// of by hashing the topic.
+//
+// Given a TickStore, the dispatcher thread appends every tick it decodes
+// to it, before any is conflated, so the store has a single producer
+// however many shards there are.
+//
+// With more than one shard the compute engine and the notifier are called
+// from several threads at once.
+class PipelineProcessor : public blp::EventHandler {
+  public:
+    struct Config {
+        int d_shards; // worker threads, one ring each
+        size_t d_capacity; // ticks per ring
+        int d_firstCpu; // CPU the first worker is pinned to, -1 for none
+        std::vector<std::string> d_topics; // conflated, with no registry
+        TopicRegistry *d_registry; // topics looked up by id, or null
+        LatencyRecorder *d_recorder; // times the ticks, or null
+        TickStore *d_store; // appended the ticks decoded, or null
+
+        Config();
+    };
+
+    struct ShardStatistics {
+        size_t d_depth; // ticks waiting in the ring
+        size_t d_pushed; // ticks pushed onto the ring
+        size_t d_dropped; // ticks dropped as the ring was full
+        size_t d_processed; // ticks handed to the compute engine
+        size_t d_conflated; // ticks merged into an unprocessed snapshot
+    };
+
+  private:
+    // TickRecord is the compact form of a tick passed from the dispatcher
+    // thread to a worker. The topic is the one the subscriber correlated
+    // the subscription with, which outlives the session. A conflated tick
+    // is passed as the slot of its topic instead, and `d_slot` is -1 for
+    // any other. Timed ticks carry the time the session received them, if
+    // it was recorded, and the time they were pushed.
+    struct TickRecord {
+        const char *d_topic;
+        int d_slot;
+        Tick d_tick;
+        bool d_timed; // `d_received` is set
+        blp::TimePoint d_received;
+        blp::TimePoint d_pushed;
+    };
+
+    struct Shard {
+        SpscRing<TickRecord> d_ring;
+        std::atomic<size_t> d_pushed;
+        std::atomic<size_t> d_dropped;
+        std::atomic<size_t> d_processed;
+        std::atomic<size_t> d_conflated;
+        std::thread d_worker;
+
+        explicit Shard(size_t capacity);
+    };
+
+    INotifier *d_notifier;
+    IComputeEngine *d_computeEngine;
+    FieldPlan d_fieldPlan;
+    TopicRegistry *d_registry;
+    LatencyRecorder *d_recorder;
+    TickStore *d_store;
+    std::vector<size_t> d_shardOfId; // by id, set on the first tick
+    std::vector<std::unique_ptr<Shard> > d_shards;
+    ConflationTable d_conflationTable;
+    std::atomic<bool> d_conflating;
+    std::atomic<bool> d_stopping;
+
+    PipelineProcessor(const PipelineProcessor&);
+    PipelineProcessor& operator=(const PipelineProcessor&);
+
+    void push(Shard *shard, const TickRecord& record);
+    void run(Shard *shard);
+
+  public:
+    // Create a processor decoding `fields`, the fields subscribed to, and
+    // start its workers.
+    PipelineProcessor(INotifier *notifier,
+            IComputeEngine *computeEngine,
+            const std::vector<std::string>& fields,
+            const Config& config = Config());
+
+    // Stop the workers once they have processed the ticks already pushed.
+    virtual ~PipelineProcessor();
+
+    virtual bool processEvent(const blp::Event& event, blp::Session *session);
+
+    // Return the shard of the ticks of `topic`.
+    size_t shardOf(const char *topic) const;
+
+    size_t numShards() const { return d_shards.size(); }
+
+    // Return true if ticks are being conflated.
+    bool isConflating() const { return d_conflating.load(); }
+
+    // Return the counters of `shard`. The counters of a shard that is
+    // being pushed to or processed may be mutually inconsistent.
+    ShardStatistics statistics(size_t shard) const;
+
+    // Block until every tick pushed so far has been processed.
+    void waitIdle() const;
+};
+
+#endif
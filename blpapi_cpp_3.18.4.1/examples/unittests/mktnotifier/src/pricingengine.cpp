@@ -0,0 +1,345 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "pricingengine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+double normalCdf(double x) { return 0.5 * std::erfc(-x / std::sqrt(2.0)); }
+
+// Return the Black-Scholes value of one option of `leg` at `spot`, with
+// volatility `vol` and rate `rate`.
+double blackScholes(
+        const StrategyLeg& leg, double spot, double vol, double rate)
+{
+    const double sign = leg.d_isCall ? 1.0 : -1.0;
+    if (leg.d_expiry <= 0.0) {
+        return std::max(sign * (spot - leg.d_strike), 0.0);
+    }
+    const double stdDev = vol * std::sqrt(leg.d_expiry);
+    const double discount = std::exp(-rate * leg.d_expiry);
+    const double d1 = (std::log(spot / leg.d_strike)
+                              + (rate + 0.5 * vol * vol) * leg.d_expiry)
+            / stdDev;
+    const double d2 = d1 - stdDev;
+    return sign
+            * (spot * normalCdf(sign * d1)
+                    - leg.d_strike * discount * normalCdf(sign * d2));
+}
+
+// Load into `value` the number in `text` and return true, or return false
+// if `text` is not a number.
+bool parseNumber(double *value, const std::string& text)
+{
+    const char *begin = text.c_str();
+    char *end;
+    *value = std::strtod(begin, &end);
+    return end != begin && *end == '\0' && std::isfinite(*value);
+}
+}
+
+bool Strategy::parse(Strategy *strategy, const std::string& spec)
+{
+    const std::string::size_type equals = spec.find('=');
+    if (equals == 0 || equals == std::string::npos) {
+        return false;
+    }
+    Strategy result;
+    result.d_name = spec.substr(0, equals);
+
+    std::istringstream legs(spec.substr(equals + 1));
+    std::string text;
+    while (std::getline(legs, text, ';')) {
+        std::istringstream fields(text);
+        std::vector<std::string> field;
+        std::string value;
+        while (std::getline(fields, value, ',')) {
+            field.push_back(value);
+        }
+        StrategyLeg leg;
+        if (field.size() != 5 || field[0].empty()
+                || (field[1] != "C" && field[1] != "P")
+                || !parseNumber(&leg.d_strike, field[2])
+                || !parseNumber(&leg.d_expiry, field[3])
+                || !parseNumber(&leg.d_quantity, field[4])
+                || !(leg.d_strike > 0.0)) {
+            return false;
+        }
+        leg.d_topic = field[0];
+        leg.d_isCall = field[1] == "C";
+        result.d_legs.push_back(leg);
+    }
+    if (result.d_legs.empty()) {
+        return false;
+    }
+    *strategy = result;
+    return true;
+}
+
+PricingEngine::Config::Config()
+    : d_threads(2)
+    , d_rate(0.0)
+    , d_vol(0.0)
+{
+}
+
+PricingEngine::Quote::Quote()
+    : d_bid(std::numeric_limits<double>::quiet_NaN())
+    , d_ask(std::numeric_limits<double>::quiet_NaN())
+    , d_lastPrice(std::numeric_limits<double>::quiet_NaN())
+    , d_vol(std::numeric_limits<double>::quiet_NaN())
+{
+}
+
+PricingEngine::PricingEngine(INotifier *notifier,
+        const std::vector<Strategy>& strategies,
+        const Config& config)
+    : d_notifier(notifier)
+    , d_config(config)
+    , d_strategies(strategies)
+    , d_legQuotes(strategies.size())
+    , d_states(strategies.size(), e_IDLE)
+    , d_timings(strategies.size())
+    , d_running(0)
+    , d_stopping(false)
+{
+    if (config.d_threads < 1) {
+        throw std::invalid_argument("at least one worker thread is needed");
+    }
+
+    // Each topic is given the index of its quote, and each strategy is
+    // registered once with every topic it depends on.
+    for (std::size_t i = 0; i < d_strategies.size(); ++i) {
+        const std::vector<StrategyLeg>& legs = d_strategies[i].d_legs;
+        for (std::size_t j = 0; j < legs.size(); ++j) {
+            const char *topic = legs[j].d_topic.c_str();
+            TopicMap::iterator it = d_topics.find(topic);
+            if (it == d_topics.end()) {
+                it = d_topics.insert(std::make_pair(topic, d_quotes.size()))
+                             .first;
+                d_quotes.push_back(Quote());
+                d_dependents.push_back(std::vector<std::size_t>());
+            }
+            d_legQuotes[i].push_back(it->second);
+            std::vector<std::size_t>& dependents = d_dependents[it->second];
+            if (dependents.empty() || dependents.back() != i) {
+                dependents.push_back(i);
+            }
+        }
+    }
+
+    for (int i = 0; i < config.d_threads; ++i) {
+        d_workers.push_back(std::thread(&PricingEngine::run, this));
+    }
+}
+
+PricingEngine::~PricingEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_stopping = true;
+    }
+    d_work.notify_all();
+    for (std::size_t i = 0; i < d_workers.size(); ++i) {
+        d_workers[i].join();
+    }
+}
+
+bool PricingEngine::queue(std::size_t strategy, const Timing& timing)
+{
+    switch (d_states[strategy]) {
+    case e_IDLE:
+        d_states[strategy] = e_QUEUED;
+        d_timings[strategy] = timing;
+        d_queue.push_back(strategy);
+        return true;
+    case e_RUNNING:
+        // The worker valuing it read the quotes before this tick, so it is
+        // queued again once that worker is done.
+        d_states[strategy] = e_RUNNING_STALE;
+        d_timings[strategy] = timing;
+        return false;
+    default:
+        return false;
+    }
+}
+
+bool PricingEngine::processTick(const char *topic, const Tick& tick)
+{
+    Timing timing;
+    timing.d_recorder = 0;
+    return update(topic, tick, timing);
+}
+
+bool PricingEngine::processTimedTick(const char *topic,
+        const Tick& tick,
+        LatencyRecorder *recorder,
+        const TickTimes& times)
+{
+    Timing timing;
+    timing.d_recorder = recorder;
+    timing.d_times = times;
+    return update(topic, tick, timing);
+}
+
+bool PricingEngine::update(
+        const char *topic, const Tick& tick, const Timing& timing)
+{
+    const TopicMap::const_iterator it = d_topics.find(topic);
+    if (it == d_topics.end()) {
+        return false;
+    }
+
+    std::size_t queued = 0;
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        Quote& quote = d_quotes[it->second];
+        if (!std::isnan(tick.d_bid)) {
+            quote.d_bid = tick.d_bid;
+        }
+        if (!std::isnan(tick.d_ask)) {
+            quote.d_ask = tick.d_ask;
+        }
+        if (!std::isnan(tick.d_lastPrice)) {
+            quote.d_lastPrice = tick.d_lastPrice;
+        }
+        if (!std::isnan(tick.d_impliedVol)) {
+            quote.d_vol = tick.d_impliedVol / 100.0;
+        }
+        const std::vector<std::size_t>& dependents = d_dependents[it->second];
+        for (std::size_t i = 0; i < dependents.size(); ++i) {
+            if (queue(dependents[i], timing)) {
+                ++queued;
+            }
+        }
+    }
+    // A strategy already queued is picked up by the worker woken for it.
+    for (std::size_t i = 0; i < queued; ++i) {
+        d_work.notify_one();
+    }
+    return true;
+}
+
+bool PricingEngine::value(double *value,
+        std::size_t strategy,
+        const std::vector<Quote>& legQuotes) const
+{
+    const std::vector<StrategyLeg>& legs = d_strategies[strategy].d_legs;
+    double sum = 0.0;
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        const Quote& quote = legQuotes[i];
+        const double spot = quote.d_bid > 0.0 && quote.d_ask > 0.0
+                ? 0.5 * (quote.d_bid + quote.d_ask)
+                : quote.d_lastPrice;
+        const double vol = std::isnan(quote.d_vol) ? d_config.d_vol
+                                                   : quote.d_vol;
+        if (!(spot > 0.0) || !(vol > 0.0)) {
+            return false;
+        }
+        sum += legs[i].d_quantity
+                * blackScholes(legs[i], spot, vol, d_config.d_rate);
+    }
+    *value = sum;
+    return true;
+}
+
+void PricingEngine::run()
+{
+    std::vector<Quote> legQuotes;
+    std::unique_lock<std::mutex> lock(d_mutex);
+    for (;;) {
+        while (!d_stopping && d_queue.empty()) {
+            d_work.wait(lock);
+        }
+        if (d_stopping) {
+            return;
+        }
+        const std::size_t strategy = d_queue.front();
+        d_queue.pop_front();
+        d_states[strategy] = e_RUNNING;
+        const Timing timing = d_timings[strategy];
+        ++d_running;
+
+        // The quotes are copied so the strategy is valued with the lock
+        // released and ticks keep coming in.
+        const std::vector<std::size_t>& quotes = d_legQuotes[strategy];
+        legQuotes.clear();
+        for (std::size_t i = 0; i < quotes.size(); ++i) {
+            legQuotes.push_back(d_quotes[quotes[i]]);
+        }
+        lock.unlock();
+
+        double result;
+        if (value(&result, strategy, legQuotes)) {
+            LatencyRecorder *const recorder = timing.d_recorder;
+            blp::TimePoint computed;
+            if (recorder) {
+                computed = LatencyRecorder::now();
+                recorder->record(LatencyRecorder::e_COMPUTE,
+                        timing.d_times.d_handed,
+                        computed);
+            }
+            {
+                std::lock_guard<std::mutex> notifierLock(d_notifierMutex);
+                d_notifier->sendStrategyValue(
+                        d_strategies[strategy].d_name, result);
+            }
+            if (recorder) {
+                const blp::TimePoint notified = LatencyRecorder::now();
+                recorder->record(
+                        LatencyRecorder::e_NOTIFY, computed, notified);
+                if (timing.d_times.d_timed) {
+                    recorder->record(LatencyRecorder::e_TOTAL,
+                            timing.d_times.d_received,
+                            notified);
+                }
+            }
+        }
+
+        lock.lock();
+        --d_running;
+        if (d_states[strategy] == e_RUNNING_STALE) {
+            // Queued again with the times of the tick that made it stale.
+            d_states[strategy] = e_QUEUED;
+            d_queue.push_back(strategy);
+            d_work.notify_one();
+        }
+        else {
+            d_states[strategy] = e_IDLE;
+        }
+        if (d_running == 0 && d_queue.empty()) {
+            d_idle.notify_all();
+        }
+    }
+}
+
+void PricingEngine::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(d_mutex);
+    while (d_running > 0 || !d_queue.empty()) {
+        d_idle.wait(lock);
+    }
+}
@@ -0,0 +1,182 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _PRICINGENGINE_H_
+#define _PRICINGENGINE_H_
+
+#include "computeengine.h"
+#include "latencyrecorder.h"
+#include "notifier.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// StrategyLeg is a quantity of European options on the underlying
+// subscribed to as `d_topic`.
+struct StrategyLeg {
+    std::string d_topic;
+    bool d_isCall;
+    double d_strike;
+    double d_expiry; // in years
+    double d_quantity; // negative when short
+};
+
+// Strategy is a named set of legs, valued as the sum of its legs, which
+// may be on different underlyings.
+struct Strategy {
+    std::string d_name;
+    std::vector<StrategyLeg> d_legs;
+
+    // Load into `strategy` the strategy described by `spec`, of the form
+    //     <name>=<leg>[;<leg>...]
+    // where each leg is
+    //     <topic>,<C|P>,<strike>,<expiry in years>,<quantity>
+    // and return true, or return false if `spec` is malformed.
+    static bool parse(Strategy *strategy, const std::string& spec);
+};
+
+// PricingEngine values a registry of option strategies live, from the BID,
+// ASK, LAST_PRICE and IVOL_MID ticks of their underlyings, and sends each
+// new value to the notifier.
+//
+// A tick only updates the quote of its topic and queues the strategies
+// that depend on that topic, so processTick() returns without pricing.
+// The queued strategies are priced by a pool of worker threads from the
+// latest quotes. A strategy is queued at most once, so a burst of ticks
+// is priced once, and is never priced by two workers at a time, so its
+// values are sent in order. Ticks of topics no strategy depends on are
+// left to someVeryComplexComputation().
+//
+// The spot of an underlying is its BID/ASK mid, or its LAST_PRICE until
+// both sides have ticked, and its vol is its IVOL_MID, or the configured
+// vol until IVOL_MID has ticked. A strategy is not valued until every leg
+// has a spot and a vol.
+//
+// A timed tick that queues a strategy is queued with its times, and once
+// the worker valuing the strategy has a value, it records the compute
+// latency of the tick up to the value, which includes the wait for a
+// worker, and its notify and total latencies once the value is sent. The
+// ticks priced along with it are not timed.
+class PricingEngine : public ComputeEngine {
+  public:
+    struct Config {
+        int d_threads; // worker threads
+        double d_rate; // continuously compounded
+        double d_vol; // vol before IVOL_MID ticks, 0 to wait for it
+
+        Config();
+    };
+
+  private:
+    struct Quote {
+        double d_bid;
+        double d_ask;
+        double d_lastPrice;
+        double d_vol;
+
+        Quote();
+    };
+
+    enum State { e_IDLE, e_QUEUED, e_RUNNING, e_RUNNING_STALE };
+
+    // The times of the tick that queued a strategy, recorded into
+    // `d_recorder` unless it is null.
+    struct Timing {
+        LatencyRecorder *d_recorder;
+        TickTimes d_times;
+    };
+
+    // Orders the leg topics, which d_strategies owns, by name, so a tick
+    // is looked up by its topic without copying it.
+    struct TopicLess {
+        bool operator()(const char *lhs, const char *rhs) const
+        {
+            return std::strcmp(lhs, rhs) < 0;
+        }
+    };
+
+    typedef std::map<const char *, std::size_t, TopicLess> TopicMap;
+
+    INotifier *d_notifier;
+    Config d_config;
+    std::vector<Strategy> d_strategies;
+    std::vector<std::vector<std::size_t> > d_legQuotes;
+    TopicMap d_topics;
+    std::vector<std::vector<std::size_t> > d_dependents;
+
+    std::mutex d_mutex;
+    std::condition_variable d_work;
+    std::condition_variable d_idle;
+    std::vector<Quote> d_quotes;
+    std::vector<State> d_states;
+    std::vector<Timing> d_timings;
+    std::deque<std::size_t> d_queue;
+    std::size_t d_running;
+    bool d_stopping;
+    std::vector<std::thread> d_workers;
+
+    std::mutex d_notifierMutex;
+
+    PricingEngine(const PricingEngine&);
+    PricingEngine& operator=(const PricingEngine&);
+
+    // Queue `strategy` to be valued from the latest quotes, timed from
+    // `timing` unless it is already queued, and return true if it was
+    // newly added to the queue.
+    bool queue(std::size_t strategy, const Timing& timing);
+
+    // Merge `tick` into the quote of `topic` and queue the strategies that
+    // depend on it, timed from `timing`, and return true, or return false
+    // if no strategy depends on `topic`.
+    bool update(const char *topic, const Tick& tick, const Timing& timing);
+    bool value(double *value,
+            std::size_t strategy,
+            const std::vector<Quote>& quotes) const;
+    void run();
+
+  public:
+    // Create an engine valuing `strategies` and sending their values to
+    // `notifier`, which must outlive it.
+    PricingEngine(INotifier *notifier,
+            const std::vector<Strategy>& strategies,
+            const Config& config = Config());
+
+    // Stop the workers, dropping the strategies still queued.
+    virtual ~PricingEngine();
+
+    virtual bool processTick(const char *topic, const Tick& tick);
+
+    virtual bool processTimedTick(const char *topic,
+            const Tick& tick,
+            LatencyRecorder *recorder,
+            const TickTimes& times);
+
+    // Block until every strategy queued so far has been valued.
+    void waitIdle();
+};
+
+#endif
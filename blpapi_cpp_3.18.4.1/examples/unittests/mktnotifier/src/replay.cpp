@@ -0,0 +1,169 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <blpapi_exception.h>
+#include <blpapi_testutil.h>
+
+#include "asyncnotifier.h"
+#include "computeengine.h"
+#include "eventprocessor.h"
+#include "journalreplayer.h"
+#include "latencyrecorder.h"
+#include "pipelineprocessor.h"
+#include "topicregistry.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+namespace {
+const char USAGE[]
+        = "Replay a journal captured by mktnotifier -capture.\n\n"
+          "Usage:\n"
+          "\t-journal <path>        journal to replay\n"
+          "\t-schema <path>         XML schema of the service captured\n"
+          "\t[-f    <field>]        field subscribed to (default: "
+          "LAST_PRICE)\n"
+          "\t[-timing <timing>]     fast, or original to space the events\n"
+          "\t\t                        as received (default: fast)\n"
+          "\t[-shards <n>]          worker threads processing data, 0 for\n"
+          "\t\t                        the replaying thread (default: 0)\n"
+          "\t[-sink <sink>]         where notifications are written, one\n"
+          "\t\tof stdout, file:<path> or binary:<path> (default: "
+          "file:/dev/null)\n"
+          "\n";
+}
+
+int main(int argc, char **argv)
+{
+    std::string journalPath;
+    std::string schemaPath;
+    std::vector<std::string> fields;
+    JournalReplayer::Timing timing = JournalReplayer::e_AS_FAST_AS_POSSIBLE;
+    int shards = 0;
+    std::string sink = "file:/dev/null";
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-journal") && i + 1 < argc) {
+            journalPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "-schema") && i + 1 < argc) {
+            schemaPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "-f") && i + 1 < argc) {
+            fields.push_back(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-timing") && i + 1 < argc) {
+            ++i;
+            if (!std::strcmp(argv[i], "original")) {
+                timing = JournalReplayer::e_ORIGINAL;
+            } else if (std::strcmp(argv[i], "fast")) {
+                std::cout << USAGE;
+                return 1;
+            }
+        } else if (!std::strcmp(argv[i], "-shards") && i + 1 < argc) {
+            shards = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-sink") && i + 1 < argc) {
+            sink = argv[++i];
+        } else {
+            std::cout << USAGE;
+            return 1;
+        }
+    }
+    if (journalPath.empty() || schemaPath.empty()) {
+        std::cout << USAGE;
+        return 1;
+    }
+    if (fields.empty()) {
+        fields.push_back("LAST_PRICE");
+    }
+
+    std::ifstream schema(schemaPath.c_str());
+    std::ifstream journal(journalPath.c_str(), std::ios::binary);
+    if (!schema || !journal) {
+        std::cerr << "Cannot open the journal or the schema" << std::endl;
+        return 1;
+    }
+
+    AsyncNotifier::Config notifierConfig;
+    if (!AsyncNotifier::parseSink(&notifierConfig, sink)) {
+        std::cout << "Invalid sink: " << sink << std::endl;
+        return 1;
+    }
+    AsyncNotifier notifier(notifierConfig);
+    ComputeEngine computeEngine;
+    LatencyRecorder recorder;
+
+    try {
+        JournalReplayer replayer(
+                blp::test::TestUtil::deserializeService(schema));
+        replayer.load(journal);
+
+        // Register the topics of the journal in the order of the ids the
+        // replayer gives them.
+        const std::vector<std::string>& topics = replayer.topics();
+        TopicRegistry registry(topics.size());
+        for (size_t i = 0; i < topics.size(); ++i) {
+            registry.add(topics[i], fields);
+        }
+        EventProcessor eventProcessor(&notifier, &computeEngine, &registry);
+        eventProcessor.setLatencyRecorder(&recorder);
+        blp::EventHandler *eventHandler = &eventProcessor;
+        std::unique_ptr<PipelineProcessor> pipelineProcessor;
+        if (shards > 0) {
+            PipelineProcessor::Config pipelineConfig;
+            pipelineConfig.d_shards = shards;
+            pipelineConfig.d_registry = &registry;
+            pipelineConfig.d_recorder = &recorder;
+            pipelineProcessor.reset(new PipelineProcessor(
+                    &notifier, &computeEngine, fields, pipelineConfig));
+            eventHandler = pipelineProcessor.get();
+        }
+
+        // The replay returns once the events are handed over, which for a
+        // pipeline is before its workers have processed them, so the run
+        // is timed until they have.
+        const std::chrono::steady_clock::time_point start
+                = std::chrono::steady_clock::now();
+        const JournalReplayer::Statistics statistics
+                = replayer.replay(eventHandler, timing);
+        if (pipelineProcessor) {
+            pipelineProcessor->waitIdle();
+        }
+        const double seconds
+                = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                          .count();
+        std::cout << statistics.d_events << " events, "
+                  << replayer.numMessages() << " messages ("
+                  << replayer.numSkipped() << " skipped) in " << seconds
+                  << "s: " << replayer.numMessages() / seconds
+                  << " messages/s" << std::endl;
+    } catch (blp::Exception& e) {
+        std::cerr << "Library Exception" << e.description() << std::endl;
+        return 1;
+    }
+    recorder.dump(std::cout);
+
+    return 0;
+}
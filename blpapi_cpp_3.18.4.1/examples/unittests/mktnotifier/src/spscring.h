@@ -0,0 +1,116 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _SPSCRING_H_
+#define _SPSCRING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// SpscRing is a fixed capacity, lock-free queue for exactly one producer
+// thread and one consumer thread. The producer only writes the tail and
+// the consumer only writes the head, each on its own cache line, so
+// neither ever waits for the other: a push to a full ring and a pop from
+// an empty one fail at once.
+template <class TYPE>
+class SpscRing {
+  private:
+    enum { k_CACHE_LINE = 64 };
+
+    std::vector<TYPE> d_slots;
+    size_t d_mask;
+    char d_pad0[k_CACHE_LINE];
+    std::atomic<size_t> d_head; // next slot to pop, written by the consumer
+    char d_pad1[k_CACHE_LINE];
+    std::atomic<size_t> d_tail; // next slot to push, written by the producer
+    char d_pad2[k_CACHE_LINE];
+
+    SpscRing(const SpscRing&);
+    SpscRing& operator=(const SpscRing&);
+
+  public:
+    // Create a ring holding at least `capacity` values, rounded up to a
+    // power of two.
+    explicit SpscRing(size_t capacity);
+
+    // Append `value` and return true, or return false if the ring is full.
+    // Must only be called by the producer.
+    bool tryPush(const TYPE& value);
+
+    // Load into `value` the oldest value and remove it, and return true,
+    // or return false if the ring is empty. Must only be called by the
+    // consumer.
+    bool tryPop(TYPE *value);
+
+    // Return the number of values in the ring, which may be stale by the
+    // time it is read if called from neither the producer nor the
+    // consumer.
+    size_t size() const;
+
+    size_t capacity() const { return d_slots.size(); }
+};
+
+template <class TYPE>
+SpscRing<TYPE>::SpscRing(size_t capacity)
+    : d_head(0)
+    , d_tail(0)
+{
+    size_t size = 1;
+    while (size < capacity) {
+        size *= 2;
+    }
+    d_slots.resize(size);
+    d_mask = size - 1;
+}
+
+template <class TYPE>
+bool SpscRing<TYPE>::tryPush(const TYPE& value)
+{
+    const size_t tail = d_tail.load(std::memory_order_relaxed);
+    if (tail - d_head.load(std::memory_order_acquire) == d_slots.size()) {
+        return false;
+    }
+    d_slots[tail & d_mask] = value;
+    d_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <class TYPE>
+bool SpscRing<TYPE>::tryPop(TYPE *value)
+{
+    const size_t head = d_head.load(std::memory_order_relaxed);
+    if (head == d_tail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    *value = d_slots[head & d_mask];
+    d_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+template <class TYPE>
+size_t SpscRing<TYPE>::size() const
+{
+    const size_t head = d_head.load(std::memory_order_acquire);
+    const size_t tail = d_tail.load(std::memory_order_acquire);
+    return tail - head;
+}
+
+#endif
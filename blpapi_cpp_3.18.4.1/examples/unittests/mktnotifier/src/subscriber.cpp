@@ -20,6 +20,9 @@
 
 #include "subscriber.h"
 
+#include <iostream>
+#include <stdexcept>
+
 namespace blp = BloombergLP::blpapi;
 
 void Subscriber::subscribe(const std::string& service,
@@ -29,13 +32,42 @@ void Subscriber::subscribe(const std::string& service,
         const blp::Identity& identity)
 {
     blp::SubscriptionList subscriptions;
+    size_t skipped = 0;
     for (size_t i = 0; i < topics.size(); ++i) {
+        int id;
+        try {
+            id = d_registry->add(topics[i], fields);
+        }
+        catch (const std::length_error&) {
+            ++skipped;
+            continue;
+        }
         std::string topic(service + topics[i]);
-        subscriptions.add(topic.c_str(),
-                fields,
-                options,
-                blp::CorrelationId((char *)topics[i].c_str()));
+        subscriptions.add(
+                topic.c_str(), fields, options, blp::CorrelationId(id));
+    }
+    if (skipped > 0) {
+        d_skipped += skipped;
+        std::cerr << "Topic registry full, skipped " << skipped
+                  << " topics" << std::endl;
+    }
+
+    if (subscriptions.size() > 0) {
+        d_session->subscribe(subscriptions, identity);
     }
+}
 
-    d_session->subscribe(subscriptions, identity);
+void Subscriber::unsubscribe(const std::vector<std::string>& topics)
+{
+    blp::SubscriptionList subscriptions;
+    for (size_t i = 0; i < topics.size(); ++i) {
+        const int id = d_registry->find(topics[i]);
+        if (id >= 0) {
+            subscriptions.add(blp::CorrelationId(id));
+        }
+    }
+
+    if (subscriptions.size() > 0) {
+        d_session->unsubscribe(subscriptions);
+    }
 }
@@ -25,6 +25,8 @@
 #include <blpapi_session.h>
 #include <blpapi_subscriptionlist.h>
 
+#include "topicregistry.h"
+
 namespace blp = BloombergLP::blpapi;
 
 class ISubscriber {
@@ -36,16 +38,28 @@ class ISubscriber {
             const blp::Identity& identity)
             = 0;
 
+    // Cancel the subscriptions to `topics`. By default nothing is done.
+    virtual void unsubscribe(const std::vector<std::string>& /* topics */)
+    {
+    }
+
     virtual ~ISubscriber() { }
 };
 
+// Subscriber subscribes to topics with the ids `registry` hands out for
+// them as their correlation ids. Once the registry is full, the topics it
+// has no room for are skipped and counted rather than subscribed to.
 class Subscriber : public ISubscriber {
   private:
     blp::Session *d_session;
+    TopicRegistry *d_registry;
+    size_t d_skipped;
 
   public:
-    Subscriber(blp::Session *session)
+    Subscriber(blp::Session *session, TopicRegistry *registry)
         : d_session(session)
+        , d_registry(registry)
+        , d_skipped(0)
     {
     }
 
@@ -54,6 +68,11 @@ class Subscriber : public ISubscriber {
             const std::vector<std::string>& fields,
             const std::vector<std::string>& options,
             const blp::Identity& identity);
+
+    virtual void unsubscribe(const std::vector<std::string>& topics);
+
+    // Return the number of topics skipped as the registry was full.
+    size_t skipped() const { return d_skipped; }
 };
 
 #endif
@@ -0,0 +1,551 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "tickstore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char MAGIC[8] = { 'M', 'K', 'T', 'T', 'I', 'C', 'K', 'S' };
+const int64_t k_NANOSECONDS_PER_SECOND = 1000000000;
+const int64_t k_NANOSECONDS_PER_DAY
+        = TickSegment::k_SECONDS_PER_DAY * k_NANOSECONDS_PER_SECOND;
+const uint32_t k_NO_ID = ~uint32_t(0);
+
+// Return `offset` rounded up to a cache line.
+uint64_t align(uint64_t offset) { return (offset + 63) & ~uint64_t(63); }
+
+// Set the offsets of the arrays of a segment of `capacity` rows and
+// `maxTopics` topics in `header`, and return the size of its file.
+uint64_t layOut(
+        TickSegment::Header *header, uint64_t capacity, uint64_t maxTopics)
+{
+    uint64_t offset = TickSegment::k_HEADER_SIZE;
+    header->d_timeOffset = offset;
+    offset = align(offset + capacity * sizeof(int64_t));
+    header->d_topicOffset = offset;
+    offset = align(offset + capacity * sizeof(uint32_t));
+    for (int c = 0; c < TickSegment::k_NUM_COLUMNS; ++c) {
+        header->d_columnOffsets[c] = offset;
+        offset = align(offset + capacity * sizeof(double));
+    }
+    header->d_topicTableOffset = offset;
+    offset = align(offset + maxTopics * TickSegment::k_TOPIC_SIZE);
+    header->d_indexOffset = offset;
+    return offset + TickSegment::k_SECONDS_PER_DAY * sizeof(uint64_t);
+}
+
+// Return true if `header` is that of a segment whose arrays fit in `size`
+// bytes.
+bool isValid(const TickSegment::Header& header, uint64_t size)
+{
+    if (size < TickSegment::k_HEADER_SIZE
+            || std::memcmp(header.d_magic, MAGIC, sizeof MAGIC)
+            || header.d_version != TickSegment::k_VERSION) {
+        return false;
+    }
+    TickSegment::Header expected;
+    const uint64_t expectedSize
+            = layOut(&expected, header.d_capacity, header.d_maxTopics);
+    return expectedSize <= size
+            && header.d_indexOffset == expected.d_indexOffset
+            && header.d_rows.load(std::memory_order_relaxed)
+            <= header.d_capacity
+            && header.d_topics.load(std::memory_order_relaxed)
+            <= header.d_maxTopics;
+}
+
+template <class TYPE>
+TYPE *arrayAt(char *base, uint64_t offset)
+{
+    return reinterpret_cast<TYPE *>(base + offset);
+}
+
+template <class TYPE>
+const TYPE *arrayAt(const char *base, uint64_t offset)
+{
+    return reinterpret_cast<const TYPE *>(base + offset);
+}
+}
+
+double Tick::*TickSegment::fieldOf(Column column)
+{
+    static double Tick::*const FIELDS[] = { &Tick::d_bid,
+        &Tick::d_ask,
+        &Tick::d_lastPrice,
+        &Tick::d_impliedVol,
+        &Tick::d_bidSize,
+        &Tick::d_askSize,
+        &Tick::d_lastSize };
+    return FIELDS[column];
+}
+
+std::string TickSegment::pathOf(
+        const std::string& directory, int date, int part)
+{
+    char name[32];
+    if (part == 0) {
+        std::snprintf(name, sizeof name, "ticks-%08d.seg", date);
+    }
+    else {
+        std::snprintf(name, sizeof name, "ticks-%08d-%d.seg", date, part);
+    }
+    if (directory.empty()) {
+        return name;
+    }
+    return directory[directory.size() - 1] == '/' ? directory + name
+                                                   : directory + "/" + name;
+}
+
+void TickSegment::dayOf(int *date, int64_t *dayStart, int64_t time)
+{
+    int64_t days = time / k_NANOSECONDS_PER_DAY;
+    if (time % k_NANOSECONDS_PER_DAY < 0) {
+        --days;
+    }
+    *dayStart = days * k_NANOSECONDS_PER_DAY;
+    const std::time_t seconds
+            = static_cast<std::time_t>(days * k_SECONDS_PER_DAY);
+    std::tm tm;
+#ifdef _WIN32
+    gmtime_s(&tm, &seconds);
+#else
+    gmtime_r(&seconds, &tm);
+#endif
+    *date = ((tm.tm_year + 1900) * 100 + tm.tm_mon + 1) * 100 + tm.tm_mday;
+}
+
+TickStore::Config::Config()
+    : d_directory(".")
+    , d_capacity(size_t(1) << 23)
+    , d_maxTopics(65536)
+{
+}
+
+TickStore::TickStore(const Config& config)
+    : d_config(config)
+    , d_fd(-1)
+    , d_base(0)
+    , d_size(0)
+    , d_header(0)
+    , d_part(0)
+    , d_lastTime(0)
+    , d_dropped(0)
+{
+    if (!open(now())) {
+        throw std::runtime_error("cannot open a tick segment in "
+                + config.d_directory);
+    }
+}
+
+TickStore::~TickStore() { close(); }
+
+int64_t TickStore::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+}
+
+bool TickStore::open(int64_t time)
+{
+    int date;
+    int64_t dayStart;
+    TickSegment::dayOf(&date, &dayStart, time);
+
+    // Carry on with the latest segment of the day.
+    int part = 0;
+#ifndef _WIN32
+    struct stat status;
+    while (::stat(TickSegment::pathOf(d_config.d_directory, date, part + 1)
+                           .c_str(),
+                   &status)
+            == 0) {
+        ++part;
+    }
+#endif
+    return open(date, dayStart, part);
+}
+
+bool TickStore::open(int date, int64_t dayStart, int part)
+{
+#ifdef _WIN32
+    (void)date;
+    (void)dayStart;
+    (void)part;
+    return false;
+#else
+    const std::string path
+            = TickSegment::pathOf(d_config.d_directory, date, part);
+    d_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat status;
+    if (d_fd < 0 || fstat(d_fd, &status) != 0) {
+        close();
+        return false;
+    }
+
+    TickSegment::Header layout;
+    uint64_t size = status.st_size;
+    const bool created = size == 0;
+    if (created) {
+        size = layOut(&layout, d_config.d_capacity, d_config.d_maxTopics);
+        if (ftruncate(d_fd, size) != 0) {
+            close();
+            return false;
+        }
+    }
+    void *base = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, d_fd, 0);
+    if (base == MAP_FAILED) {
+        close();
+        return false;
+    }
+    d_base = static_cast<char *>(base);
+    d_size = size;
+    d_header = reinterpret_cast<TickSegment::Header *>(d_base);
+
+    if (created) {
+        // The file is all zeros, so the counts start at 0. The magic is
+        // written last, so a reader does not take a segment being set up
+        // for one.
+        TickSegment::Header& header = *d_header;
+        header.d_version = TickSegment::k_VERSION;
+        header.d_date = date;
+        header.d_dayStart = dayStart;
+        header.d_capacity = d_config.d_capacity;
+        header.d_maxTopics = d_config.d_maxTopics;
+        layOut(&header, header.d_capacity, header.d_maxTopics);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header.d_magic, MAGIC, sizeof MAGIC);
+    }
+    else if (!isValid(*d_header, size) || d_header->d_date != date) {
+        close();
+        return false;
+    }
+
+    // Carry on from where a previous writer of the segment left off.
+    d_part = part;
+    d_idsOfRegistryIds.assign(d_idsOfRegistryIds.size(), k_NO_ID);
+    d_topicIds.clear();
+    const uint64_t topics = d_header->d_topics.load(std::memory_order_acquire);
+    for (uint64_t id = 0; id < topics; ++id) {
+        d_topicIds[arrayAt<char>(d_base, d_header->d_topicTableOffset)
+                + id * TickSegment::k_TOPIC_SIZE]
+                = static_cast<uint32_t>(id);
+    }
+    const uint64_t rows = d_header->d_rows.load(std::memory_order_acquire);
+    d_lastTime = rows == 0
+            ? dayStart
+            : arrayAt<int64_t>(d_base, d_header->d_timeOffset)[rows - 1];
+    return true;
+#endif
+}
+
+void TickStore::close()
+{
+#ifndef _WIN32
+    if (d_base) {
+        munmap(d_base, d_size);
+    }
+    if (d_fd >= 0) {
+        ::close(d_fd);
+    }
+#endif
+    d_fd = -1;
+    d_base = 0;
+    d_size = 0;
+    d_header = 0;
+}
+
+std::string TickStore::path() const
+{
+    return d_header ? TickSegment::pathOf(
+                   d_config.d_directory, d_header->d_date, d_part)
+                    : std::string();
+}
+
+int TickStore::topicIdOf(uint32_t *id, int registryId, const char *topic)
+{
+    if (registryId >= 0
+            && static_cast<size_t>(registryId) < d_idsOfRegistryIds.size()
+            && d_idsOfRegistryIds[registryId] != k_NO_ID) {
+        *id = d_idsOfRegistryIds[registryId];
+        return 0;
+    }
+
+    // Only the first tick of a topic in a segment, or one of a topic that
+    // is not registered, looks it up by name.
+    std::unordered_map<std::string, uint32_t>::const_iterator it
+            = d_topicIds.find(topic);
+    if (it != d_topicIds.end()) {
+        *id = it->second;
+    }
+    else {
+        TickSegment::Header& header = *d_header;
+        const uint64_t topics
+                = header.d_topics.load(std::memory_order_relaxed);
+        const size_t length = std::strlen(topic);
+        if (length >= TickSegment::k_TOPIC_SIZE) {
+            return -1;
+        }
+        if (topics == header.d_maxTopics) {
+            return 1;
+        }
+        *id = static_cast<uint32_t>(topics);
+        std::memcpy(arrayAt<char>(d_base, header.d_topicTableOffset)
+                        + topics * TickSegment::k_TOPIC_SIZE,
+                topic,
+                length + 1);
+        header.d_topics.store(topics + 1, std::memory_order_release);
+        d_topicIds[topic] = *id;
+    }
+    if (registryId >= 0) {
+        if (static_cast<size_t>(registryId) >= d_idsOfRegistryIds.size()) {
+            d_idsOfRegistryIds.resize(registryId + 1, k_NO_ID);
+        }
+        d_idsOfRegistryIds[registryId] = *id;
+    }
+    return 0;
+}
+
+bool TickStore::append(int registryId, const char *topic, const Tick& tick)
+{
+    return append(registryId, topic, tick, now());
+}
+
+bool TickStore::append(const char *topic, const Tick& tick, int64_t time)
+{
+    return append(-1, topic, tick, time);
+}
+
+bool TickStore::append(
+        int registryId, const char *topic, const Tick& tick, int64_t time)
+{
+    if (!d_header || time < d_header->d_dayStart
+            || time >= d_header->d_dayStart + k_NANOSECONDS_PER_DAY) {
+        close();
+        if (!open(time)) {
+            ++d_dropped;
+            return false;
+        }
+    }
+    if (time < d_lastTime) {
+        time = d_lastTime;
+    }
+
+    // Start a new segment of the day once this one is full.
+    uint32_t id;
+    int rc = d_header->d_rows.load(std::memory_order_relaxed)
+                    == d_header->d_capacity
+            ? 1
+            : topicIdOf(&id, registryId, topic);
+    if (rc == 1) {
+        const int date = d_header->d_date;
+        const int64_t dayStart = d_header->d_dayStart;
+        const int64_t lastTime = d_lastTime;
+        const int part = d_part + 1;
+        close();
+        if (!open(date, dayStart, part)) {
+            ++d_dropped;
+            return false;
+        }
+        d_lastTime = std::max(d_lastTime, lastTime);
+        rc = topicIdOf(&id, registryId, topic);
+    }
+    if (rc != 0) {
+        ++d_dropped;
+        return false;
+    }
+    TickSegment::Header& header = *d_header;
+    const uint64_t row = header.d_rows.load(std::memory_order_relaxed);
+
+    arrayAt<int64_t>(d_base, header.d_timeOffset)[row] = time;
+    arrayAt<uint32_t>(d_base, header.d_topicOffset)[row] = id;
+    for (int c = 0; c < TickSegment::k_NUM_COLUMNS; ++c) {
+        const TickSegment::Column column = static_cast<TickSegment::Column>(c);
+        arrayAt<double>(d_base, header.d_columnOffsets[c])[row]
+                = tick.*TickSegment::fieldOf(column);
+    }
+
+    // Index every second up to that of this row that has none yet.
+    const int64_t second
+            = (time - header.d_dayStart) / k_NANOSECONDS_PER_SECOND;
+    int64_t indexed
+            = header.d_indexedSeconds.load(std::memory_order_relaxed);
+    uint64_t *index = arrayAt<uint64_t>(d_base, header.d_indexOffset);
+    for (; indexed <= second; ++indexed) {
+        index[indexed] = row;
+    }
+
+    header.d_rows.store(row + 1, std::memory_order_release);
+    header.d_indexedSeconds.store(indexed, std::memory_order_release);
+    d_lastTime = time;
+    return true;
+}
+
+TickStoreReader::TickStoreReader(const std::string& path)
+    : d_fd(-1)
+    , d_base(0)
+    , d_size(0)
+    , d_header(0)
+{
+#ifdef _WIN32
+    throw std::runtime_error("cannot map " + path);
+#else
+    d_fd = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (d_fd < 0 || fstat(d_fd, &status) != 0
+            || static_cast<uint64_t>(status.st_size)
+                    < TickSegment::k_HEADER_SIZE) {
+        if (d_fd >= 0) {
+            ::close(d_fd);
+        }
+        throw std::runtime_error("cannot map " + path);
+    }
+    void *base = mmap(0, status.st_size, PROT_READ, MAP_SHARED, d_fd, 0);
+    if (base == MAP_FAILED) {
+        ::close(d_fd);
+        throw std::runtime_error("cannot map " + path);
+    }
+    d_base = static_cast<const char *>(base);
+    d_size = status.st_size;
+    d_header = reinterpret_cast<const TickSegment::Header *>(d_base);
+    if (!isValid(*d_header, d_size)) {
+        munmap(const_cast<char *>(d_base), d_size);
+        ::close(d_fd);
+        throw std::runtime_error(path + " is not a tick segment");
+    }
+#endif
+}
+
+TickStoreReader::~TickStoreReader()
+{
+#ifndef _WIN32
+    munmap(const_cast<char *>(d_base), d_size);
+    ::close(d_fd);
+#endif
+}
+
+size_t TickStoreReader::size() const
+{
+    return d_header->d_rows.load(std::memory_order_acquire);
+}
+
+const int64_t *TickStoreReader::times() const
+{
+    return arrayAt<int64_t>(d_base, d_header->d_timeOffset);
+}
+
+const uint32_t *TickStoreReader::topicIds() const
+{
+    return arrayAt<uint32_t>(d_base, d_header->d_topicOffset);
+}
+
+const double *TickStoreReader::column(TickSegment::Column column) const
+{
+    return arrayAt<double>(d_base, d_header->d_columnOffsets[column]);
+}
+
+void TickStoreReader::load(Tick *tick, size_t row) const
+{
+    for (int c = 0; c < TickSegment::k_NUM_COLUMNS; ++c) {
+        const TickSegment::Column col = static_cast<TickSegment::Column>(c);
+        tick->*TickSegment::fieldOf(col) = column(col)[row];
+    }
+}
+
+size_t TickStoreReader::numTopics() const
+{
+    return d_header->d_topics.load(std::memory_order_acquire);
+}
+
+const char *TickStoreReader::topic(uint32_t id) const
+{
+    return arrayAt<char>(d_base, d_header->d_topicTableOffset)
+            + static_cast<size_t>(id) * TickSegment::k_TOPIC_SIZE;
+}
+
+int TickStoreReader::findTopic(const std::string& topic) const
+{
+    const size_t topics = numTopics();
+    for (size_t id = 0; id < topics; ++id) {
+        if (topic == this->topic(static_cast<uint32_t>(id))) {
+            return static_cast<int>(id);
+        }
+    }
+    return -1;
+}
+
+size_t TickStoreReader::lowerBound(int64_t time) const
+{
+    // Load the index count first, so the rows it indexes are published.
+    const int64_t indexed
+            = d_header->d_indexedSeconds.load(std::memory_order_acquire);
+    const size_t rows = size();
+    const uint64_t *index
+            = arrayAt<uint64_t>(d_base, d_header->d_indexOffset);
+    const int64_t second = time < d_header->d_dayStart
+            ? -1
+            : (time - d_header->d_dayStart) / k_NANOSECONDS_PER_SECOND;
+
+    // The first row of the second of `time` and that of the next bound it.
+    size_t first = 0;
+    if (second >= 0 && second < indexed) {
+        first = index[second];
+    }
+    else if (second >= indexed && indexed > 0) {
+        first = index[indexed - 1];
+    }
+    size_t last = rows;
+    if (second + 1 < indexed) {
+        last = index[second + 1];
+    }
+    const int64_t *times = this->times();
+    return std::lower_bound(times + first, times + last, time) - times;
+}
+
+void TickStoreReader::snapshot(std::vector<Tick> *ticks, size_t end) const
+{
+    ticks->assign(numTopics(), Tick());
+    end = std::min(end, size());
+    const uint32_t *ids = topicIds();
+    for (int c = 0; c < TickSegment::k_NUM_COLUMNS; ++c) {
+        const TickSegment::Column col = static_cast<TickSegment::Column>(c);
+        double Tick::*field = TickSegment::fieldOf(col);
+        const double *values = column(col);
+        for (size_t row = 0; row < end; ++row) {
+            if (!std::isnan(values[row])) {
+                (*ticks)[ids[row]].*field = values[row];
+            }
+        }
+    }
+}
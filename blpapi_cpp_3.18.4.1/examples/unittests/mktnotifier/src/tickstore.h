@@ -0,0 +1,235 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _TICKSTORE_H_
+#define _TICKSTORE_H_
+
+#include "computeengine.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// TickSegment describes a file a TickStore writes the ticks of one UTC day
+// to, "ticks-YYYYMMDD.seg" in its directory, then "ticks-YYYYMMDD-1.seg"
+// and so on once each fills up. The file is created at its full size, as
+// a header followed by fixed arrays, so it is mapped once and never moves:
+//
+// - the columns, one entry per row: the time in nanoseconds since the
+//   epoch, the topic id, then each field of Tick as a double, NaN where
+//   the tick did not update the field;
+// - the topic table, one NUL-terminated name per topic id;
+// - the timestamp index, the first row of each second of the day.
+//
+// The rows are in time order. The counts in the header are published
+// with release stores after what they count is written, so a reader in
+// another process that loads them with acquire loads sees complete rows.
+class TickSegment {
+  public:
+    enum Column {
+        e_BID,
+        e_ASK,
+        e_LAST_PRICE,
+        e_IMPLIED_VOL,
+        e_BID_SIZE,
+        e_ASK_SIZE,
+        e_LAST_SIZE,
+        k_NUM_COLUMNS
+    };
+
+    enum {
+        k_VERSION = 1,
+        k_HEADER_SIZE = 4096,
+        k_TOPIC_SIZE = 128, // bytes per topic name, with its NUL
+        k_SECONDS_PER_DAY = 86400
+    };
+
+    struct Header {
+        char d_magic[8];
+        uint32_t d_version;
+        int32_t d_date; // YYYYMMDD
+        int64_t d_dayStart; // nanoseconds since the epoch
+        uint64_t d_capacity; // rows
+        uint64_t d_maxTopics;
+        uint64_t d_timeOffset; // int64_t per row
+        uint64_t d_topicOffset; // uint32_t per row
+        uint64_t d_columnOffsets[k_NUM_COLUMNS]; // double per row
+        uint64_t d_topicTableOffset; // k_TOPIC_SIZE per topic
+        uint64_t d_indexOffset; // uint64_t per second of the day
+        std::atomic<uint64_t> d_rows; // rows published
+        std::atomic<uint64_t> d_topics; // topics published
+        std::atomic<int64_t> d_indexedSeconds; // index entries published
+    };
+
+    // Return the slot of Tick that holds `column`.
+    static double Tick::*fieldOf(Column column);
+
+    // Return the path of the segment of `date`, as YYYYMMDD, in
+    // `directory`, or that of its `part`th continuation.
+    static std::string pathOf(
+            const std::string& directory, int date, int part = 0);
+
+    // Load into `date` and `dayStart` the UTC day of `time`, in
+    // nanoseconds since the epoch, as YYYYMMDD and the time it starts.
+    static void dayOf(int *date, int64_t *dayStart, int64_t time);
+};
+
+// TickStore appends the decoded ticks of subscription data to per-day
+// TickSegment files, so they outlive the process and may be read, without
+// copying, by TickStoreReaders in other processes while they are written.
+//
+// A TickStore has a single producer: one thread appends, and appending
+// never locks. A tick is appended to the latest segment of its day, which
+// is created or carried on with as needed; one timed before the last one
+// appended to its segment is stored at the time of that one, so the rows
+// stay in time order. A tick that finds the rows or the topic table of
+// its segment full is appended to a new segment of the day. A tick whose
+// topic name is too long, or for which no segment can be opened, is
+// dropped and counted.
+//
+// Topics are looked up by their TopicRegistry id, so appending a tick of a
+// registered topic does not hash or copy its name.
+//
+// Segment files are created at their full size, and take disk space only
+// as rows are written where the file system supports sparse files.
+class TickStore {
+  public:
+    struct Config {
+        std::string d_directory;
+        size_t d_capacity; // rows per segment
+        size_t d_maxTopics; // topics per segment
+
+        Config();
+    };
+
+  private:
+    Config d_config;
+    int d_fd;
+    char *d_base;
+    size_t d_size;
+    TickSegment::Header *d_header;
+    int d_part;
+    std::unordered_map<std::string, uint32_t> d_topicIds;
+    std::vector<uint32_t> d_idsOfRegistryIds; // segment id by registry id
+    int64_t d_lastTime;
+    std::atomic<uint64_t> d_dropped;
+
+    TickStore(const TickStore&);
+    TickStore& operator=(const TickStore&);
+
+    bool open(int64_t time);
+    bool open(int date, int64_t dayStart, int part);
+    void close();
+
+    // Load into `id` the segment id of `topic`, of registry id
+    // `registryId` or -1, adding it to the topic table if need be, and
+    // return 0, or return 1 if the topic table is full and -1 if the name
+    // does not fit.
+    int topicIdOf(uint32_t *id, int registryId, const char *topic);
+
+  public:
+    // Create a store writing to `config.d_directory`, and open or create
+    // the segment of today. Throw std::runtime_error if it cannot be.
+    explicit TickStore(const Config& config);
+
+    ~TickStore();
+
+    // Return the time now, in nanoseconds since the epoch.
+    static int64_t now();
+
+    // Append `tick`, an update of `topic`, of id `registryId` in the
+    // TopicRegistry or -1 if it is not registered, at `time`, in
+    // nanoseconds since the epoch, to the segment of its day, and return
+    // true, or return false if it is dropped.
+    bool append(
+            int registryId, const char *topic, const Tick& tick, int64_t time);
+
+    // Append `tick`, an update of `topic`, of id `registryId` or -1, now.
+    bool append(int registryId, const char *topic, const Tick& tick);
+
+    // Append `tick`, an update of `topic` that is not registered, at
+    // `time`.
+    bool append(const char *topic, const Tick& tick, int64_t time);
+
+    // Return the number of ticks dropped. It may be called from any
+    // thread.
+    uint64_t numDropped() const
+    {
+        return d_dropped.load(std::memory_order_relaxed);
+    }
+
+    // Return the path of the segment being written, or an empty string if
+    // there is none.
+    std::string path() const;
+};
+
+// TickStoreReader maps a TickSegment read-only, and reads the rows and
+// topics published so far straight from the mapping.
+class TickStoreReader {
+  private:
+    int d_fd;
+    const char *d_base;
+    size_t d_size;
+    const TickSegment::Header *d_header;
+
+    TickStoreReader(const TickStoreReader&);
+    TickStoreReader& operator=(const TickStoreReader&);
+
+  public:
+    // Map the segment at `path`. Throw std::runtime_error if it cannot be
+    // mapped or is not a segment.
+    explicit TickStoreReader(const std::string& path);
+
+    ~TickStoreReader();
+
+    int date() const { return d_header->d_date; }
+
+    // Return the number of rows published.
+    size_t size() const;
+
+    const int64_t *times() const;
+    const uint32_t *topicIds() const;
+    const double *column(TickSegment::Column column) const;
+
+    // Load into `tick` the fields of `row`.
+    void load(Tick *tick, size_t row) const;
+
+    // Return the number of topics published.
+    size_t numTopics() const;
+
+    const char *topic(uint32_t id) const;
+
+    // Return the id of `topic`, or -1 if it has no rows.
+    int findTopic(const std::string& topic) const;
+
+    // Return the first row at or after `time`, in nanoseconds since the
+    // epoch, or size() if there is none.
+    size_t lowerBound(int64_t time) const;
+
+    // Load into `ticks`, by topic id, the latest value of each field of
+    // each topic in the rows before `end`, such as a snapshot of a chain
+    // at the time of row `end`.
+    void snapshot(std::vector<Tick> *ticks, size_t end) const;
+};
+
+#endif
@@ -0,0 +1,110 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "topicregistry.h"
+
+#include <blpapi_correlationid.h>
+
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+double Tick::*const FIELDS[] = { &Tick::d_bid,
+    &Tick::d_ask,
+    &Tick::d_lastPrice,
+    &Tick::d_impliedVol,
+    &Tick::d_bidSize,
+    &Tick::d_askSize,
+    &Tick::d_lastSize };
+}
+
+TopicRegistry::TopicRegistry(size_t capacity)
+    : d_capacity(capacity)
+    , d_size(0)
+    , d_topics(capacity)
+    , d_plans(capacity)
+    , d_lastValues(capacity)
+    , d_statistics(capacity, TopicStatistics())
+{
+}
+
+int TopicRegistry::add(
+        const std::string& topic, const std::vector<std::string>& fields)
+{
+    const int existing = find(topic);
+    if (existing >= 0) {
+        return existing;
+    }
+    const size_t id = d_size.load(std::memory_order_relaxed);
+    if (id == d_capacity) {
+        throw std::length_error("the topic registry is full");
+    }
+    d_topics[id] = topic;
+    d_plans[id] = FieldPlan(fields);
+    d_ids[topic] = static_cast<int>(id);
+    d_size.store(id + 1, std::memory_order_release);
+    return static_cast<int>(id);
+}
+
+int TopicRegistry::find(const std::string& topic) const
+{
+    std::unordered_map<std::string, int>::const_iterator it
+            = d_ids.find(topic);
+    return it == d_ids.end() ? -1 : it->second;
+}
+
+int TopicRegistry::idOf(const blp::Message& msg) const
+{
+    const blp::CorrelationId cid = msg.correlationId();
+    if (cid.valueType() != blp::CorrelationId::INT_VALUE) {
+        return -1;
+    }
+    const long long value = cid.asInteger();
+    if (value < 0 || static_cast<size_t>(value) >= size()) {
+        return -1;
+    }
+    return static_cast<int>(value);
+}
+
+void TopicRegistry::update(Tick *tick, int id, const blp::Message& msg)
+{
+    d_plans[id].decode(tick, msg);
+    Tick& last = d_lastValues[id];
+    TopicStatistics& statistics = d_statistics[id];
+    uint64_t fields = 0;
+    for (size_t f = 0; f < sizeof FIELDS / sizeof *FIELDS; ++f) {
+        const double value = tick->*FIELDS[f];
+        if (!std::isnan(value)) {
+            last.*FIELDS[f] = value;
+            ++fields;
+        }
+    }
+    ++statistics.d_ticks;
+    statistics.d_fields += fields;
+    if (fields == 0) {
+        ++statistics.d_emptyTicks;
+    }
+}
+
+std::vector<std::string> TopicRegistry::topics() const
+{
+    return std::vector<std::string>(
+            d_topics.begin(), d_topics.begin() + size());
+}
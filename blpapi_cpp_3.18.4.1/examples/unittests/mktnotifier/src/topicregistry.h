@@ -0,0 +1,116 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _TOPICREGISTRY_H_
+#define _TOPICREGISTRY_H_
+
+#include <blpapi_message.h>
+
+#include "computeengine.h"
+#include "fieldplan.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+// TopicRegistry hands out the correlation ids of subscriptions as dense
+// integers, 0 for the first topic registered, 1 for the next, and so on,
+// and keeps the state of each topic in arrays indexed by its id: the
+// FieldPlan decoding its messages, the latest value of each field, the
+// sequence number of its latest tick and its counters. Going from a
+// message to the state of its topic costs one array index, rather than a
+// string or hash lookup, and the topics are owned by the registry rather
+// than by the caller of the Subscriber.
+//
+// The arrays are sized for a fixed number of topics up front, so a topic
+// may be registered while the ticks of others are being decoded. The
+// state of a topic must only be updated and read by the thread its
+// messages are delivered on.
+class TopicRegistry {
+  public:
+    struct TopicStatistics {
+        uint64_t d_ticks; // ticks decoded
+        uint64_t d_emptyTicks; // ticks with none of the planned fields
+        uint64_t d_fields; // fields decoded
+    };
+
+  private:
+    size_t d_capacity;
+    std::atomic<size_t> d_size;
+    std::unordered_map<std::string, int> d_ids; // used to register only
+    std::vector<std::string> d_topics;
+    std::vector<FieldPlan> d_plans;
+    std::vector<Tick> d_lastValues;
+    std::vector<TopicStatistics> d_statistics;
+
+    TopicRegistry(const TopicRegistry&);
+    TopicRegistry& operator=(const TopicRegistry&);
+
+  public:
+    // Create a registry with room for `capacity` topics.
+    explicit TopicRegistry(size_t capacity);
+
+    // Register `topic`, subscribed with `fields`, and return its id, or
+    // return the id it already has. Throw std::length_error if the
+    // registry is full.
+    int add(const std::string& topic, const std::vector<std::string>& fields);
+
+    // Return the id of `topic`, or -1 if it is not registered.
+    int find(const std::string& topic) const;
+
+    // Return the id of the topic `msg` is an update of, or -1 if its
+    // correlation id is not one handed out by this registry.
+    int idOf(const blp::Message& msg) const;
+
+    // Load into `tick` the planned fields of `msg`, an update of the topic
+    // with `id`, merge them into the latest values of the topic and count
+    // the tick.
+    void update(Tick *tick, int id, const blp::Message& msg);
+
+    // Return the topic with `id`, which is valid for the lifetime of the
+    // registry.
+    const char *topic(int id) const { return d_topics[id].c_str(); }
+
+    // Return the latest value of each field of the topic with `id`, NaN
+    // for the fields that have not ticked.
+    const Tick& lastValues(int id) const { return d_lastValues[id]; }
+
+    // Return the sequence number of the latest tick of the topic with
+    // `id`, 0 before its first.
+    uint64_t sequence(int id) const { return d_statistics[id].d_ticks; }
+
+    const TopicStatistics& statistics(int id) const
+    {
+        return d_statistics[id];
+    }
+
+    // Return the registered topics, in the order of their ids.
+    std::vector<std::string> topics() const;
+
+    size_t size() const { return d_size.load(std::memory_order_acquire); }
+
+    size_t capacity() const { return d_capacity; }
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include <authorizer.h>
 #include <eventprocessor.h>
 #include <mockSession.h>
+#include <mockSubscriber.h>
 #include <subscriber.h>
 
 #include <blpapi_session.h>
@@ -45,16 +46,6 @@ class MockAuthorizer : public IAuthorizer {
                     blp::EventQueue *queue));
 };
 
-class MockSubscriber : public ISubscriber {
-  public:
-    MOCK_METHOD5(subscribe,
-            void(const std::string& service,
-                    const std::vector<std::string>& topics,
-                    const std::vector<std::string>& fields,
-                    const std::vector<std::string>& options,
-                    const blp::Identity& identity));
-};
-
 class MockEventProcessor : public blp::EventHandler {
   public:
     MOCK_METHOD2(processEvent,
@@ -0,0 +1,217 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include <asyncnotifier.h>
+
+namespace {
+// Block until `notifier` has written or dropped `count` records.
+void waitFor(const AsyncNotifier& notifier, size_t count)
+{
+    for (;;) {
+        const AsyncNotifier::Statistics statistics = notifier.statistics();
+        if (statistics.d_written + statistics.d_dropped >= count) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// Send `count` values from each of `threads` threads to `notifier`.
+void sendFromThreads(INotifier *notifier, int threads, int count)
+{
+    std::vector<std::thread> senders;
+    for (int t = 0; t < threads; ++t) {
+        senders.push_back(std::thread([notifier, count]() {
+            for (int i = 0; i < count; ++i) {
+                notifier->sendToTerminal(i);
+            }
+        }));
+    }
+    for (size_t t = 0; t < senders.size(); ++t) {
+        senders[t].join();
+    }
+}
+}
+
+//
+// Concern:
+// Verify that the file sink writes the lines the Notifier prints, in the
+// order sent, in batches no larger than configured, and that the latency
+// counters cover the records written.
+//
+// Plan:
+// 1. Create a notifier writing a file in batches of two.
+// 2. Send three values and a strategy value, and wait for them to be
+//    written.
+// 3. Expect the records written in at least two flushes, with a mean
+//    latency no larger than the maximum.
+// 4. Destroy the notifier and expect the lines in the file.
+//
+TEST(AsyncNotifierTest, FileSinkWritesLines)
+{
+    AsyncNotifier::Config config;
+    config.d_sink = AsyncNotifier::e_FILE;
+    config.d_path = ::testing::TempDir() + "asyncnotifier.txt";
+    config.d_batchSize = 2;
+    {
+        AsyncNotifier notifier(config);
+        notifier.sendToTerminal(1.5);
+        notifier.sendToTerminal(-3);
+        notifier.sendStrategyValue("spread", 0.25);
+        notifier.sendToTerminal(100.125);
+        waitFor(notifier, 4);
+
+        const AsyncNotifier::Statistics statistics = notifier.statistics();
+        EXPECT_EQ(4u, statistics.d_written);
+        EXPECT_EQ(0u, statistics.d_dropped);
+        EXPECT_LE(2u, statistics.d_flushes);
+        EXPECT_LE(0, statistics.d_totalLatency);
+        EXPECT_LE(statistics.d_totalLatency / 4, statistics.d_maxLatency);
+    }
+
+    std::ifstream file(config.d_path.c_str());
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    ASSERT_EQ(4u, lines.size());
+    EXPECT_EQ("VALUE = 1.5", lines[0]);
+    EXPECT_EQ("VALUE = -3", lines[1]);
+    EXPECT_EQ("spread = 0.25", lines[2]);
+    EXPECT_EQ("VALUE = 100.125", lines[3]);
+}
+
+//
+// Concern:
+// Verify that the records written by the binary sink are read back as
+// sent, and that the records still in the ring are written when the
+// notifier is destroyed.
+//
+// Plan:
+// 1. Create a notifier writing binary records with a long flush interval.
+// 2. Send a value and two strategy values, and destroy the notifier.
+// 3. Read the file back, and expect the records in order, with their
+//    times not decreasing, and nothing after them.
+//
+TEST(AsyncNotifierTest, BinarySinkRoundTrips)
+{
+    AsyncNotifier::Config config;
+    config.d_sink = AsyncNotifier::e_BINARY;
+    config.d_path = ::testing::TempDir() + "asyncnotifier.bin";
+    config.d_flushInterval = std::chrono::seconds(60);
+    {
+        AsyncNotifier notifier(config);
+        notifier.sendToTerminal(42.5);
+        notifier.sendStrategyValue("IBM straddle", 7.25);
+        notifier.sendStrategyValue("", -1);
+    }
+
+    std::ifstream file(config.d_path.c_str(), std::ios::binary);
+    AsyncNotifier::Record records[3];
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(AsyncNotifier::read(&records[i], file)) << i;
+    }
+    AsyncNotifier::Record extra;
+    EXPECT_FALSE(AsyncNotifier::read(&extra, file));
+
+    EXPECT_EQ(AsyncNotifier::Record::e_VALUE, records[0].d_type);
+    EXPECT_EQ(42.5, records[0].d_value);
+    EXPECT_EQ("", records[0].d_text);
+    EXPECT_EQ(AsyncNotifier::Record::e_STRATEGY_VALUE, records[1].d_type);
+    EXPECT_EQ(7.25, records[1].d_value);
+    EXPECT_EQ("IBM straddle", records[1].d_text);
+    EXPECT_EQ(AsyncNotifier::Record::e_STRATEGY_VALUE, records[2].d_type);
+    EXPECT_EQ(-1, records[2].d_value);
+    EXPECT_EQ("", records[2].d_text);
+    EXPECT_LE(records[0].d_time, records[1].d_time);
+    EXPECT_LE(records[1].d_time, records[2].d_time);
+}
+
+//
+// Concern:
+// Verify that under the drop policy every record sent from several
+// threads is either written or counted as dropped, and that under the
+// block policy none is dropped.
+//
+// Plan:
+// 1. Create a notifier with a tiny ring and the drop policy, send values
+//    from four threads, and expect the written and dropped records to add
+//    up to those sent, and no call to have waited.
+// 2. Do the same under the block policy, and expect every record to be
+//    written.
+//
+TEST(AsyncNotifierTest, BackpressurePolicies)
+{
+    const int threads = 4;
+    const int count = 5000;
+    AsyncNotifier::Config config;
+    config.d_sink = AsyncNotifier::e_FILE;
+    config.d_path = ::testing::TempDir() + "asyncnotifier.txt";
+    config.d_capacity = 2;
+
+    config.d_policy = AsyncNotifier::e_DROP;
+    {
+        AsyncNotifier notifier(config);
+        sendFromThreads(&notifier, threads, count);
+        waitFor(notifier, threads * count);
+        const AsyncNotifier::Statistics statistics = notifier.statistics();
+        EXPECT_EQ(size_t(threads * count),
+                statistics.d_written + statistics.d_dropped);
+        EXPECT_EQ(0u, statistics.d_blocked);
+    }
+
+    config.d_policy = AsyncNotifier::e_BLOCK;
+    {
+        AsyncNotifier notifier(config);
+        sendFromThreads(&notifier, threads, count);
+        waitFor(notifier, threads * count);
+        const AsyncNotifier::Statistics statistics = notifier.statistics();
+        EXPECT_EQ(size_t(threads * count), statistics.d_written);
+        EXPECT_EQ(0u, statistics.d_dropped);
+    }
+}
+
+//
+// Concern:
+// Verify that sinks are parsed from their command line form.
+//
+TEST(AsyncNotifierTest, ParsesSinks)
+{
+    AsyncNotifier::Config config;
+    EXPECT_TRUE(AsyncNotifier::parseSink(&config, "file:/tmp/values.txt"));
+    EXPECT_EQ(AsyncNotifier::e_FILE, config.d_sink);
+    EXPECT_EQ("/tmp/values.txt", config.d_path);
+    EXPECT_TRUE(AsyncNotifier::parseSink(&config, "binary:values.bin"));
+    EXPECT_EQ(AsyncNotifier::e_BINARY, config.d_sink);
+    EXPECT_EQ("values.bin", config.d_path);
+    EXPECT_TRUE(AsyncNotifier::parseSink(&config, "stdout"));
+    EXPECT_EQ(AsyncNotifier::e_STDOUT, config.d_sink);
+    EXPECT_FALSE(AsyncNotifier::parseSink(&config, "file:"));
+    EXPECT_FALSE(AsyncNotifier::parseSink(&config, "stderr"));
+}
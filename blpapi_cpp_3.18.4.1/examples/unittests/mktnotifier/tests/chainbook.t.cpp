@@ -0,0 +1,158 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chainbook.h>
+#include <mockComputeEngine.h>
+
+using namespace testing;
+
+namespace {
+ChainKey key(const char *underlying, int expiry, double strike, bool isCall)
+{
+    ChainKey result;
+    result.d_underlying = underlying;
+    result.d_expiry = expiry;
+    result.d_strike = strike;
+    result.d_isCall = isCall;
+    return result;
+}
+}
+
+//
+// Concern:
+// Verify that option tickers, as OPT_CHAIN gives them, are parsed into
+// their underlying, expiry, strike and type, and that other tickers are
+// not.
+//
+TEST(ChainBookTest, ParsesOptionTickers)
+{
+    ChainKey parsed;
+    ASSERT_TRUE(ChainKey::parse(&parsed, "IBM US 11/18/22 P45 Equity"));
+    EXPECT_EQ("IBM US", parsed.d_underlying);
+    EXPECT_EQ(20221118, parsed.d_expiry);
+    EXPECT_EQ(45.0, parsed.d_strike);
+    EXPECT_FALSE(parsed.d_isCall);
+
+    ASSERT_TRUE(ChainKey::parse(&parsed, "BRK/B US 01/17/25 C412.5 Equity"));
+    EXPECT_EQ("BRK/B US", parsed.d_underlying);
+    EXPECT_EQ(20250117, parsed.d_expiry);
+    EXPECT_EQ(412.5, parsed.d_strike);
+    EXPECT_TRUE(parsed.d_isCall);
+
+    EXPECT_FALSE(ChainKey::parse(&parsed, "IBM US Equity"));
+    EXPECT_FALSE(ChainKey::parse(&parsed, "IBM US 11/18/22 X45 Equity"));
+    EXPECT_FALSE(ChainKey::parse(&parsed, "IBM US 11/18/22 P45x Equity"));
+    EXPECT_FALSE(ChainKey::parse(&parsed, "IBM US 13/18/22 P45 Equity"));
+    EXPECT_FALSE(ChainKey::parse(&parsed, "IBM US 2022-11-18 P45 Equity"));
+}
+
+//
+// Concern:
+// Verify that the book keeps one quote per option, merges the ticks of
+// its topic into it, and lists a chain by expiry, strike and type.
+//
+// Plan:
+// 1. Add the options of two underlyings out of order, and expect a
+//    duplicate topic or option to be refused.
+// 2. Update an option with a bid, then an ask, and expect both in its
+//    quote, and a tick of an unknown topic to be refused.
+// 3. Expect the chain of one underlying in order, puts before calls.
+// 4. Remove an option and expect it gone from the book and the chain.
+//
+TEST(ChainBookTest, KeepsQuotesByOption)
+{
+    ChainBook book;
+    EXPECT_TRUE(book.add("/ticker/IBM US 12/16/22 C150 Equity",
+            key("IBM US", 20221216, 150, true)));
+    EXPECT_TRUE(book.add("/ticker/IBM US 11/18/22 C150 Equity",
+            key("IBM US", 20221118, 150, true)));
+    EXPECT_TRUE(book.add("/ticker/IBM US 11/18/22 P150 Equity",
+            key("IBM US", 20221118, 150, false)));
+    EXPECT_TRUE(book.add("/ticker/IBM US 11/18/22 P140 Equity",
+            key("IBM US", 20221118, 140, false)));
+    EXPECT_TRUE(book.add("/ticker/AAPL US 11/18/22 P140 Equity",
+            key("AAPL US", 20221118, 140, false)));
+    EXPECT_FALSE(book.add("/ticker/IBM US 11/18/22 P140 Equity",
+            key("IBM US", 20221118, 145, false)));
+    EXPECT_FALSE(book.add("/ticker/IBM2 US 11/18/22 P140 Equity",
+            key("IBM US", 20221118, 140, false)));
+    EXPECT_EQ(5u, book.size());
+
+    Tick tick;
+    tick.d_bid = 3.5;
+    EXPECT_TRUE(book.update("/ticker/IBM US 11/18/22 P150 Equity", tick));
+    tick = Tick();
+    tick.d_ask = 3.75;
+    EXPECT_TRUE(book.update("/ticker/IBM US 11/18/22 P150 Equity", tick));
+    EXPECT_FALSE(book.update("/ticker/IBM US Equity", tick));
+
+    ChainQuote quote;
+    ASSERT_TRUE(book.find(&quote, key("IBM US", 20221118, 150, false)));
+    EXPECT_EQ("/ticker/IBM US 11/18/22 P150 Equity", quote.d_topic);
+    EXPECT_EQ(3.5, quote.d_tick.d_bid);
+    EXPECT_EQ(3.75, quote.d_tick.d_ask);
+    EXPECT_TRUE(std::isnan(quote.d_tick.d_lastPrice));
+
+    std::vector<ChainQuote> chain;
+    book.chain(&chain, "IBM US");
+    ASSERT_EQ(4u, chain.size());
+    EXPECT_EQ("/ticker/IBM US 11/18/22 P140 Equity", chain[0].d_topic);
+    EXPECT_EQ("/ticker/IBM US 11/18/22 P150 Equity", chain[1].d_topic);
+    EXPECT_EQ("/ticker/IBM US 11/18/22 C150 Equity", chain[2].d_topic);
+    EXPECT_EQ("/ticker/IBM US 12/16/22 C150 Equity", chain[3].d_topic);
+
+    book.remove("/ticker/IBM US 11/18/22 P150 Equity");
+    EXPECT_FALSE(book.find(&quote, key("IBM US", 20221118, 150, false)));
+    book.chain(&chain, "IBM US");
+    EXPECT_EQ(3u, chain.size());
+    EXPECT_EQ(4u, book.size());
+}
+
+//
+// Concern:
+// Verify that the ChainBookEngine updates the book with every tick and
+// hands it on to the engine it wraps.
+//
+TEST(ChainBookTest, EngineUpdatesBook)
+{
+    ChainBook book;
+    book.add("/ticker/IBM US 11/18/22 P150 Equity",
+            key("IBM US", 20221118, 150, false));
+    MockComputeEngine engine;
+    ChainBookEngine chainBookEngine(&book, &engine);
+
+    EXPECT_CALL(engine, someVeryComplexComputation(2.0)).WillOnce(Return(4.0));
+    EXPECT_EQ(4.0, chainBookEngine.someVeryComplexComputation(2.0));
+
+    Tick tick;
+    tick.d_lastPrice = 3.6;
+    EXPECT_FALSE(chainBookEngine.processTick(
+            "/ticker/IBM US 11/18/22 P150 Equity", tick));
+    ChainQuote quote;
+    ASSERT_TRUE(book.find(&quote, key("IBM US", 20221118, 150, false)));
+    EXPECT_EQ(3.6, quote.d_tick.d_lastPrice);
+}
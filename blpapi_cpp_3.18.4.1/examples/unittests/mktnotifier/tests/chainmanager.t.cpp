@@ -0,0 +1,284 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <blpapi_identity.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chainbook.h>
+#include <chainmanager.h>
+#include <mockSubscriber.h>
+
+using namespace testing;
+
+namespace blp = BloombergLP::blpapi;
+
+namespace {
+class MockChainRequester : public IChainRequester {
+  public:
+    MOCK_METHOD3(request,
+            bool(std::vector<std::string> *members,
+                    const std::string& security,
+                    const blp::Identity& identity));
+};
+
+// Return the tickers of the calls and puts of IBM expiring on `expiry`,
+// as MM/DD/YY, at each of `strikes`.
+std::vector<std::string> options(const char *expiry,
+        const std::vector<int>& strikes)
+{
+    std::vector<std::string> result;
+    for (size_t i = 0; i < strikes.size(); ++i) {
+        for (int type = 0; type < 2; ++type) {
+            result.push_back(std::string("IBM US ") + expiry
+                    + (type == 0 ? " C" : " P")
+                    + std::to_string(strikes[i]) + " Equity");
+        }
+    }
+    return result;
+}
+
+std::vector<int> strikes(int first, int count)
+{
+    std::vector<int> result;
+    for (int i = 0; i < count; ++i) {
+        result.push_back(first + 5 * i);
+    }
+    return result;
+}
+
+ChainManager::Config batchesOf(size_t batchSize)
+{
+    ChainManager::Config config;
+    config.d_fields.push_back("BID");
+    config.d_fields.push_back("ASK");
+    config.d_batchSize = batchSize;
+    config.d_interval = std::chrono::milliseconds(100);
+    return config;
+}
+}
+
+//
+// Concern:
+// Verify that a new chain is subscribed to in batches no larger than
+// configured, no sooner than the interval apart, and that its options are
+// added to the book, ignoring members that are not options.
+//
+// Plan:
+// 1. Set a chain of 10 options and a ticker that is not an option, with
+//    batches of 4.
+// 2. Send batches at times 0, 50ms, 100ms and 200ms, and expect batches
+//    of 4, none, 4 and 2 topics, each subscribed with the configured
+//    fields.
+// 3. Expect nothing more to send, and the 10 options in the book.
+//
+TEST(ChainManagerTest, SubscribesInPacedBatches)
+{
+    MockSubscriber subscriber;
+    MockChainRequester requester;
+    ChainBook book;
+    ChainManager manager(&subscriber, &requester, &book, batchesOf(4));
+
+    std::vector<std::string> members = options("11/18/22", strikes(140, 5));
+    members.push_back("IBM US Equity");
+    EXPECT_EQ(10u, manager.setChain("IBM US Equity", members));
+    EXPECT_EQ(10u, manager.numToSubscribe());
+    EXPECT_EQ(10u, book.size());
+
+    std::vector<std::string> sent;
+    EXPECT_CALL(subscriber,
+            subscribe("//blp/mktdata", SizeIs(4), SizeIs(2), _, _))
+            .Times(2)
+            .WillRepeatedly(Invoke([&sent](const std::string&,
+                                           const std::vector<std::string>& t,
+                                           const std::vector<std::string>&,
+                                           const std::vector<std::string>&,
+                                           const blp::Identity&) {
+                sent.insert(sent.end(), t.begin(), t.end());
+            }));
+    EXPECT_CALL(subscriber,
+            subscribe("//blp/mktdata", SizeIs(2), SizeIs(2), _, _))
+            .WillOnce(Invoke([&sent](const std::string&,
+                                     const std::vector<std::string>& t,
+                                     const std::vector<std::string>&,
+                                     const std::vector<std::string>&,
+                                     const blp::Identity&) {
+                sent.insert(sent.end(), t.begin(), t.end());
+            }));
+    EXPECT_CALL(subscriber, unsubscribe(_)).Times(0);
+
+    const blp::Identity identity;
+    const ChainManager::Clock::time_point start
+            = ChainManager::Clock::now();
+    EXPECT_EQ(4u, manager.sendBatch(identity, start));
+    EXPECT_EQ(0u,
+            manager.sendBatch(
+                    identity, start + std::chrono::milliseconds(50)));
+    EXPECT_EQ(4u,
+            manager.sendBatch(
+                    identity, start + std::chrono::milliseconds(100)));
+    EXPECT_EQ(2u,
+            manager.sendBatch(
+                    identity, start + std::chrono::milliseconds(200)));
+    EXPECT_EQ(0u,
+            manager.sendBatch(
+                    identity, start + std::chrono::milliseconds(300)));
+    EXPECT_EQ(0u, manager.numToSubscribe());
+
+    EXPECT_EQ(10u, sent.size());
+    EXPECT_EQ(manager.members("IBM US Equity"), sent);
+    EXPECT_EQ("/ticker/IBM US 11/18/22 C140 Equity", sent[0]);
+}
+
+//
+// Concern:
+// Verify that on a roll only the changes to a chain are sent, the options
+// gone first, and that changes undone before they are sent cancel out.
+//
+// Plan:
+// 1. Set and send a chain of two expiries.
+// 2. Set the chain with the first expiry gone, a new expiry listed and a
+//    strike added to the second expiry, and expect the expired options
+//    queued to be unsubscribed from and the new ones to be subscribed to.
+// 3. Set the chain back to one with the first expiry, and without the new
+//    expiry, and expect nothing left to send but the added strike.
+// 4. Send everything and expect one subscription of the added strike.
+//
+TEST(ChainManagerTest, SendsOnlyChanges)
+{
+    MockSubscriber subscriber;
+    MockChainRequester requester;
+    ChainBook book;
+    ChainManager manager(&subscriber, &requester, &book, batchesOf(100));
+    const blp::Identity identity;
+
+    std::vector<std::string> november = options("11/18/22", strikes(140, 3));
+    std::vector<std::string> december = options("12/16/22", strikes(140, 3));
+    std::vector<std::string> members = november;
+    members.insert(members.end(), december.begin(), december.end());
+    manager.setChain("IBM US Equity", members);
+    EXPECT_CALL(subscriber, subscribe(_, SizeIs(12), _, _, _));
+    manager.sendAll(identity);
+    Mock::VerifyAndClearExpectations(&subscriber);
+
+    const std::vector<std::string> january
+            = options("01/20/23", strikes(140, 3));
+    const std::vector<std::string> added
+            = options("12/16/22", strikes(155, 1));
+    members = december;
+    members.insert(members.end(), added.begin(), added.end());
+    members.insert(members.end(), january.begin(), january.end());
+    EXPECT_EQ(6u + 2u + 6u, manager.setChain("IBM US Equity", members));
+    EXPECT_EQ(6u, manager.numToUnsubscribe());
+    EXPECT_EQ(8u, manager.numToSubscribe());
+    EXPECT_EQ(14u, book.size());
+
+    members = november;
+    members.insert(members.end(), december.begin(), december.end());
+    members.insert(members.end(), added.begin(), added.end());
+    EXPECT_EQ(6u + 6u, manager.setChain("IBM US Equity", members));
+    EXPECT_EQ(0u, manager.numToUnsubscribe());
+    EXPECT_EQ(2u, manager.numToSubscribe());
+    EXPECT_EQ(14u, book.size());
+
+    EXPECT_CALL(subscriber, unsubscribe(_)).Times(0);
+    EXPECT_CALL(subscriber,
+            subscribe(_,
+                    ElementsAre("/ticker/IBM US 12/16/22 C155 Equity",
+                            "/ticker/IBM US 12/16/22 P155 Equity"),
+                    _,
+                    _,
+                    _));
+    manager.sendAll(identity);
+}
+
+//
+// Concern:
+// Verify that a refresh requests every chain, unsubscribes from the
+// options gone before subscribing to the new ones in the same batch, and
+// leaves a chain that cannot be retrieved as it was.
+//
+// Plan:
+// 1. Add two chains, and refresh with both retrieved.
+// 2. Refresh with one option of the first chain replaced, and the second
+//    chain failing, and expect the removed option to be unsubscribed from
+//    before the new one is subscribed to, and the second chain kept.
+//
+TEST(ChainManagerTest, RefreshesChains)
+{
+    MockSubscriber subscriber;
+    MockChainRequester requester;
+    ChainBook book;
+    ChainManager manager(&subscriber, &requester, &book, batchesOf(100));
+    manager.addChain("IBM US Equity");
+    manager.addChain("MSFT US Equity");
+    const blp::Identity identity;
+
+    const std::vector<std::string> ibm = options("11/18/22", strikes(140, 1));
+    std::vector<std::string> msft(1, "MSFT US 11/18/22 C300 Equity");
+    EXPECT_CALL(requester, request(_, "IBM US Equity", _))
+            .WillOnce(DoAll(SetArgPointee<0>(ibm), Return(true)));
+    EXPECT_CALL(requester, request(_, "MSFT US Equity", _))
+            .WillOnce(DoAll(SetArgPointee<0>(msft), Return(true)));
+    EXPECT_CALL(subscriber, subscribe(_, SizeIs(3), _, _, _));
+    EXPECT_TRUE(manager.refresh(identity));
+    Mock::VerifyAndClearExpectations(&subscriber);
+    Mock::VerifyAndClearExpectations(&requester);
+
+    std::vector<std::string> rolled(1, ibm[0]);
+    rolled.push_back("IBM US 11/18/22 P145 Equity");
+    EXPECT_CALL(requester, request(_, "IBM US Equity", _))
+            .WillOnce(DoAll(SetArgPointee<0>(rolled), Return(true)));
+    EXPECT_CALL(requester, request(_, "MSFT US Equity", _))
+            .WillOnce(Return(false));
+    {
+        InSequence sequence;
+        EXPECT_CALL(subscriber,
+                unsubscribe(ElementsAre("/ticker/" + ibm[1])));
+        EXPECT_CALL(subscriber,
+                subscribe(_,
+                        ElementsAre("/ticker/IBM US 11/18/22 P145 Equity"),
+                        _,
+                        _,
+                        _));
+    }
+    EXPECT_FALSE(manager.refresh(identity));
+    EXPECT_EQ(1u, manager.members("MSFT US Equity").size());
+    EXPECT_EQ(3u, book.size());
+}
+
+//
+// Concern:
+// Verify that empty batches are refused.
+//
+TEST(ChainManagerTest, InvalidConfigThrows)
+{
+    MockSubscriber subscriber;
+    MockChainRequester requester;
+    ChainBook book;
+    EXPECT_THROW(ChainManager(&subscriber, &requester, &book, batchesOf(0)),
+            std::invalid_argument);
+}
@@ -0,0 +1,196 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include <conflationtable.h>
+
+namespace {
+std::vector<std::string> topics()
+{
+    std::vector<std::string> result;
+    result.push_back("/ticker/IBM US Equity");
+    result.push_back("/ticker/MSFT US Equity");
+    return result;
+}
+}
+
+//
+// Concern:
+// Verify that topics are found by name, whichever string holds them.
+//
+TEST(ConflationTableTest, FindsTopics)
+{
+    const ConflationTable table(topics());
+    EXPECT_EQ(2u, table.size());
+    const std::string ibm("/ticker/IBM US Equity");
+    const std::string msft("/ticker/MSFT US Equity");
+    const int ibmSlot
+            = table.find(ibm.c_str(), ConflationTable::hashOf(ibm.c_str()));
+    const int msftSlot = table.find(
+            msft.c_str(), ConflationTable::hashOf(msft.c_str()));
+    EXPECT_LE(0, ibmSlot);
+    EXPECT_LE(0, msftSlot);
+    EXPECT_NE(ibmSlot, msftSlot);
+    EXPECT_EQ(-1, table.find("/ticker/AAPL US Equity",
+                          ConflationTable::hashOf("/ticker/AAPL US Equity")));
+}
+
+//
+// Concern:
+// Verify that a table can have more slots than topics, for topics that
+// are registered later and looked up by slot.
+//
+TEST(ConflationTableTest, ReservesSlots)
+{
+    ConflationTable table(topics(), 5);
+    EXPECT_EQ(5u, table.size());
+    const std::string msft("/ticker/MSFT US Equity");
+    EXPECT_EQ(1,
+            table.find(msft.c_str(), ConflationTable::hashOf(msft.c_str())));
+
+    Tick tick;
+    tick.d_lastPrice = 42.0;
+    bool conflated;
+    EXPECT_TRUE(table.store(&conflated, 4, tick));
+    table.unqueue(4);
+    Tick loaded;
+    ASSERT_TRUE(table.load(&loaded, 4));
+    EXPECT_EQ(42.0, loaded.d_lastPrice);
+    EXPECT_EQ(2u, ConflationTable(topics(), 1).size());
+}
+
+//
+// Concern:
+// Verify that ticks stored before a load are merged into one snapshot,
+// queued once, and that a load starts the next snapshot afresh.
+//
+// Plan:
+// 1. Store a bid, then an ask, then a new bid, and expect only the first
+//    store to ask for the slot to be queued, and the later ones to be
+//    counted as conflated.
+// 2. Load the slot and expect the newest bid and the ask.
+// 3. Expect a second load to find nothing new.
+// 4. Store a last price and expect it to be queued, not conflated, and to
+//    load without the earlier bid and ask.
+//
+TEST(ConflationTableTest, MergesTicksUntilLoaded)
+{
+    ConflationTable table(topics());
+    bool conflated;
+    Tick tick;
+    tick.d_bid = 99.0;
+    EXPECT_TRUE(table.store(&conflated, 0, tick));
+    EXPECT_FALSE(conflated);
+    tick = Tick();
+    tick.d_ask = 101.0;
+    EXPECT_FALSE(table.store(&conflated, 0, tick));
+    EXPECT_TRUE(conflated);
+    tick = Tick();
+    tick.d_bid = 99.5;
+    EXPECT_FALSE(table.store(&conflated, 0, tick));
+    EXPECT_TRUE(conflated);
+
+    table.unqueue(0);
+    Tick snapshot;
+    ASSERT_TRUE(table.load(&snapshot, 0));
+    EXPECT_EQ(99.5, snapshot.d_bid);
+    EXPECT_EQ(101.0, snapshot.d_ask);
+    EXPECT_TRUE(std::isnan(snapshot.d_lastPrice));
+    EXPECT_FALSE(table.load(&snapshot, 0));
+    EXPECT_FALSE(table.load(&snapshot, 1));
+
+    tick = Tick();
+    tick.d_lastPrice = 100.0;
+    EXPECT_TRUE(table.store(&conflated, 0, tick));
+    EXPECT_FALSE(conflated);
+    table.unqueue(0);
+    ASSERT_TRUE(table.load(&snapshot, 0));
+    EXPECT_EQ(100.0, snapshot.d_lastPrice);
+    EXPECT_TRUE(std::isnan(snapshot.d_bid));
+    EXPECT_TRUE(std::isnan(snapshot.d_ask));
+}
+
+//
+// Concern:
+// Verify that a reader loading while the writer stores sees consistent
+// snapshots, with prices that never go back, and ends on the last one.
+//
+// Plan:
+// 1. Store increasing bids with asks one above from one thread, queueing
+//    the slot through a flag as a ring would.
+// 2. Load from another thread whenever the slot is queued, and expect
+//    every snapshot to have its ask one above its bid, and bids never to
+//    decrease.
+// 3. Expect the last snapshot loaded to be the last stored.
+//
+TEST(ConflationTableTest, ConcurrentLoadsAreConsistent)
+{
+    ConflationTable table(topics());
+    const int k_TICKS = 200000;
+    std::atomic<int> queued(0);
+    std::atomic<bool> done(false);
+    int inconsistent = 0;
+    int backwards = 0;
+    double last = -1.0;
+
+    std::thread reader([&]() {
+        for (;;) {
+            const bool finished = done.load();
+            if (queued.load() > 0) {
+                queued.fetch_sub(1);
+                table.unqueue(0);
+                Tick snapshot;
+                if (table.load(&snapshot, 0)) {
+                    if (snapshot.d_ask != snapshot.d_bid + 1.0) {
+                        ++inconsistent;
+                    }
+                    if (snapshot.d_bid < last) {
+                        ++backwards;
+                    }
+                    last = snapshot.d_bid;
+                }
+            }
+            else if (finished) {
+                return;
+            }
+        }
+    });
+
+    for (int i = 0; i < k_TICKS; ++i) {
+        Tick tick;
+        tick.d_bid = i;
+        tick.d_ask = i + 1.0;
+        bool conflated;
+        if (table.store(&conflated, 0, tick)) {
+            queued.fetch_add(1);
+        }
+    }
+    done.store(true);
+    reader.join();
+
+    EXPECT_EQ(0, inconsistent);
+    EXPECT_EQ(0, backwards);
+    EXPECT_EQ(k_TICKS - 1.0, last);
+}
@@ -0,0 +1,221 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_messageformatter.h>
+#include <blpapi_testutil.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <testSchemas.h>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <eventjournal.h>
+#include <eventprocessor.h>
+#include <journalreplayer.h>
+#include <topicregistry.h>
+#include <mockComputeEngine.h>
+#include <mockNotifier.h>
+
+namespace blp = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name SESSION_STARTED("SessionStarted");
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+const char TOPIC[] = "/ticker/IBM US Equity";
+}
+
+//
+// Concern:
+// Verify that records read back from a journal as they were appended, and
+// that a truncated record is not read.
+//
+TEST(EventJournalTest, ReadsRecordsBack)
+{
+    EventJournal::Record record;
+    record.d_event = 7;
+    record.d_eventType = blp::Event::SUBSCRIPTION_DATA;
+    record.d_time = 123456789;
+    record.d_correlationType = EventJournal::Record::e_TOPIC;
+    record.d_correlationId = 0;
+    record.d_topic = TOPIC;
+    record.d_messageType = "MarketDataEvents";
+    record.d_content = "{\"LAST_PRICE\":142.8}";
+    std::string journal;
+    EventJournal::append(&journal, record);
+    record.d_event = 8;
+    record.d_correlationType = EventJournal::Record::e_INT;
+    record.d_correlationId = 42;
+    record.d_topic.clear();
+    record.d_content.clear();
+    EventJournal::append(&journal, record);
+
+    std::istringstream stream(journal);
+    EventJournal::Record read;
+    ASSERT_TRUE(EventJournal::read(&read, stream));
+    EXPECT_EQ(7u, read.d_event);
+    EXPECT_EQ(blp::Event::SUBSCRIPTION_DATA, read.d_eventType);
+    EXPECT_EQ(123456789, read.d_time);
+    EXPECT_EQ(EventJournal::Record::e_TOPIC, read.d_correlationType);
+    EXPECT_EQ(TOPIC, read.d_topic);
+    EXPECT_EQ("MarketDataEvents", read.d_messageType);
+    EXPECT_EQ("{\"LAST_PRICE\":142.8}", read.d_content);
+    ASSERT_TRUE(EventJournal::read(&read, stream));
+    EXPECT_EQ(8u, read.d_event);
+    EXPECT_EQ(EventJournal::Record::e_INT, read.d_correlationType);
+    EXPECT_EQ(42, read.d_correlationId);
+    EXPECT_TRUE(read.d_content.empty());
+    EXPECT_FALSE(EventJournal::read(&read, stream));
+
+    std::istringstream truncated(journal.substr(0, journal.size() - 1));
+    ASSERT_TRUE(EventJournal::read(&read, truncated));
+    EXPECT_FALSE(EventJournal::read(&read, truncated));
+}
+
+//
+// Concern:
+// Verify that events captured to a journal are replayed to an
+// EventProcessor as they were received.
+//
+// Plan:
+// 1. Capture a SessionStarted event and a MarketDataEvents event with a
+//    LAST_PRICE, correlated with a topic, to a journal.
+// 2. Load the journal into a replayer, and expect two events of one
+//    message each.
+// 3. Replay it to an EventProcessor, and expect the session state to be
+//    logged and the computation on the LAST_PRICE to be notified.
+//
+TEST(EventJournalTest, ReplaysCapturedEvents)
+{
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+    const std::string path = testing::TempDir() + "eventjournal.t.bin";
+    std::remove(path.c_str());
+    {
+        EventJournal journal(path, 0);
+
+        blp::Event status
+                = blptst::TestUtil::createEvent(blp::Event::SESSION_STATUS);
+        blptst::TestUtil::appendMessage(status,
+                blptst::TestUtil::getAdminMessageDefinition(SESSION_STARTED));
+        journal.processEvent(status, 0);
+
+        std::string topic = TOPIC;
+        blptst::MessageProperties properties;
+        properties.setCorrelationId(blp::CorrelationId(&topic[0]));
+        blp::Event data
+                = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+        blptst::MessageFormatter formatter
+                = blptst::TestUtil::appendMessage(data,
+                        service.getEventDefinition(MKTDATA_EVENTS),
+                        properties);
+        formatter.formatMessageJson("{\"LAST_PRICE\": 142.80}");
+        journal.processEvent(data, 0);
+        EXPECT_EQ(2u, journal.numEvents());
+    }
+
+    JournalReplayer replayer(service);
+    std::ifstream stream(path.c_str(), std::ios::binary);
+    ASSERT_EQ(2u, replayer.load(stream));
+    EXPECT_EQ(2u, replayer.numMessages());
+    EXPECT_EQ(0u, replayer.numSkipped());
+
+    MockNotifier notifier;
+    MockComputeEngine computeEngine;
+    EventProcessor eventProcessor(&notifier, &computeEngine);
+    EXPECT_CALL(notifier, logSessionState(testing::_));
+    EXPECT_CALL(computeEngine, someVeryComplexComputation(142.80))
+            .WillOnce(testing::Return(285.60));
+    EXPECT_CALL(notifier, sendToTerminal(285.60));
+
+    const JournalReplayer::Statistics statistics
+            = replayer.replay(&eventProcessor);
+    EXPECT_EQ(2u, statistics.d_events);
+    std::remove(path.c_str());
+}
+
+//
+// Concern:
+// Verify that the topics of registry ids are journaled with the ticks, so
+// a replay registers them without being told the order they were
+// registered in.
+//
+// Plan:
+// 1. Register IBM and then MSFT, and capture two ticks of MSFT correlated
+//    with its id, 1.
+// 2. Load the journal, and expect one message per tick, and MSFT as the
+//    only topic, with id 0.
+// 3. Replay it to an EventProcessor on a registry of the topics of the
+//    replayer, and expect both ticks counted against MSFT.
+//
+TEST(EventJournalTest, JournalsTopicsOfIds)
+{
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+    const std::string path = testing::TempDir() + "eventjournal.t.ids.bin";
+    std::remove(path.c_str());
+    const std::vector<std::string> fields(1, "LAST_PRICE");
+    {
+        TopicRegistry captured(2);
+        captured.add(TOPIC, fields);
+        const int id = captured.add("/ticker/MSFT US Equity", fields);
+        EventJournal journal(path, 0, &captured);
+
+        blptst::MessageProperties properties;
+        properties.setCorrelationId(blp::CorrelationId(id + 0LL));
+        for (int i = 0; i < 2; ++i) {
+            blp::Event data = blptst::TestUtil::createEvent(
+                    blp::Event::SUBSCRIPTION_DATA);
+            blptst::MessageFormatter formatter
+                    = blptst::TestUtil::appendMessage(data,
+                            service.getEventDefinition(MKTDATA_EVENTS),
+                            properties);
+            formatter.formatMessageJson("{\"LAST_PRICE\": 280.5}");
+            journal.processEvent(data, 0);
+        }
+    }
+
+    JournalReplayer replayer(service);
+    std::ifstream stream(path.c_str(), std::ios::binary);
+    ASSERT_EQ(2u, replayer.load(stream));
+    EXPECT_EQ(2u, replayer.numMessages());
+    ASSERT_EQ(1u, replayer.topics().size());
+    EXPECT_EQ("/ticker/MSFT US Equity", replayer.topics()[0]);
+
+    TopicRegistry registry(1);
+    registry.add(replayer.topics()[0], fields);
+    MockNotifier notifier;
+    MockComputeEngine computeEngine;
+    EXPECT_CALL(computeEngine, someVeryComplexComputation(280.5))
+            .Times(2)
+            .WillRepeatedly(testing::Return(561.0));
+    EXPECT_CALL(notifier, sendToTerminal(561.0)).Times(2);
+    EventProcessor eventProcessor(&notifier, &computeEngine, &registry);
+    replayer.replay(&eventProcessor);
+    EXPECT_EQ(2u, registry.sequence(0));
+    std::remove(path.c_str());
+}
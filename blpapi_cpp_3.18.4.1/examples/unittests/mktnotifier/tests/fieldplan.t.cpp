@@ -0,0 +1,117 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <blpapi_event.h>
+#include <blpapi_messageformatter.h>
+#include <blpapi_testutil.h>
+
+#include <cmath>
+#include <sstream>
+#include <testSchemas.h>
+
+#include "gtest/gtest.h"
+
+#include <fieldplan.h>
+
+namespace blp = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+
+// Return a MarketDataEvents event holding one message with `content`.
+blp::Event marketDataEvent(const char *content)
+{
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+    blp::Event event
+            = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::MessageFormatter formatter = blptst::TestUtil::appendMessage(
+            event, service.getEventDefinition(MKTDATA_EVENTS));
+    formatter.formatMessageJson(content);
+    return event;
+}
+}
+
+//
+// Concern:
+// Verify that a plan decodes the subscribed fields Tick has slots for, and
+// LAST_PRICE, and no others.
+//
+// Plan:
+// 1. Build a plan for BID and VOLUME, and expect it to decode BID and
+//    LAST_PRICE.
+// 2. Decode a message with LAST_PRICE, BID, VOLUME and IVOL_MID, and
+//    expect BID and LAST_PRICE to be set, and ASK and IVOL_MID to be left
+//    unset.
+//
+TEST(FieldPlanTest, DecodesSubscribedFields)
+{
+    std::vector<std::string> fields;
+    fields.push_back("BID");
+    fields.push_back("VOLUME");
+    const FieldPlan plan(fields);
+    EXPECT_EQ(2u, plan.size());
+
+    blp::Event event = marketDataEvent("{"
+                                       "\"LAST_PRICE\": 142.80,"
+                                       "\"BID\": 142.70,"
+                                       "\"VOLUME\": 1000,"
+                                       "\"IVOL_MID\": 25.0"
+                                       "}");
+    blp::MessageIterator msgIter(event);
+    ASSERT_TRUE(msgIter.next());
+    Tick tick;
+    plan.decode(&tick, msgIter.message());
+    EXPECT_EQ(142.70, tick.d_bid);
+    EXPECT_EQ(142.80, tick.d_lastPrice);
+    EXPECT_TRUE(std::isnan(tick.d_ask));
+    EXPECT_TRUE(std::isnan(tick.d_impliedVol));
+}
+
+//
+// Concern:
+// Verify that the default plan decodes every field Tick has a slot for.
+//
+TEST(FieldPlanTest, DefaultPlanDecodesAllFields)
+{
+    const FieldPlan plan;
+    EXPECT_EQ(7u, plan.size());
+
+    blp::Event event = marketDataEvent("{"
+                                       "\"BID\": 99.0,"
+                                       "\"ASK\": 101.0,"
+                                       "\"IVOL_MID\": 20.0,"
+                                       "\"BID_SIZE\": 30,"
+                                       "\"ASK_SIZE\": 40,"
+                                       "\"SIZE_LAST_TRADE\": 5"
+                                       "}");
+    blp::MessageIterator msgIter(event);
+    ASSERT_TRUE(msgIter.next());
+    Tick tick;
+    plan.decode(&tick, msgIter.message());
+    EXPECT_EQ(99.0, tick.d_bid);
+    EXPECT_EQ(101.0, tick.d_ask);
+    EXPECT_EQ(20.0, tick.d_impliedVol);
+    EXPECT_EQ(30.0, tick.d_bidSize);
+    EXPECT_EQ(40.0, tick.d_askSize);
+    EXPECT_EQ(5.0, tick.d_lastSize);
+    EXPECT_TRUE(std::isnan(tick.d_lastPrice));
+}
@@ -0,0 +1,116 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include <latencyhistogram.h>
+#include <latencyrecorder.h>
+
+//
+// Concern:
+// Verify that every value falls in a bucket whose highest value is within
+// 1/64 of it, and that buckets follow each other with no gap.
+//
+TEST(LatencyHistogramTest, BucketsAreContiguousAndPrecise)
+{
+    EXPECT_EQ(0, LatencyHistogram::bucketOf(-5));
+    for (int64_t v = 0; v < 128; ++v) {
+        EXPECT_EQ(v, LatencyHistogram::bucketOf(v));
+        EXPECT_EQ(v, LatencyHistogram::highestIn(static_cast<int>(v)));
+    }
+    int64_t lowest = 0;
+    for (int b = 0; b < 1000; ++b) {
+        const int64_t highest = LatencyHistogram::highestIn(b);
+        EXPECT_EQ(b, LatencyHistogram::bucketOf(lowest));
+        EXPECT_EQ(b, LatencyHistogram::bucketOf(highest));
+        EXPECT_LE(highest - lowest, lowest / 64);
+        lowest = highest + 1;
+    }
+}
+
+//
+// Concern:
+// Verify that percentiles are read from the recorded distribution.
+//
+// Plan:
+// 1. Record the latencies 1 to 10000 nanoseconds once each.
+// 2. Expect the count, mean and maximum to be exact, and each percentile
+//    to be within the precision of a bucket.
+// 3. Reset, and expect the histogram to be empty.
+//
+TEST(LatencyHistogramTest, ComputesPercentiles)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.percentile(50));
+    for (int64_t v = 1; v <= 10000; ++v) {
+        histogram.record(v);
+    }
+    EXPECT_EQ(10000u, histogram.count());
+    EXPECT_DOUBLE_EQ(5000.5, histogram.mean());
+    EXPECT_EQ(10000, histogram.max());
+    EXPECT_NEAR(5000, histogram.percentile(50), 5000 / 64);
+    EXPECT_NEAR(9900, histogram.percentile(99), 9900 / 64);
+    EXPECT_NEAR(9990, histogram.percentile(99.9), 9990 / 64);
+    EXPECT_EQ(10000, histogram.percentile(100));
+
+    histogram.reset();
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0, histogram.max());
+}
+
+//
+// Concern:
+// Verify that the recorder dumps only the stages it recorded, to a stream
+// and appended to a file.
+//
+TEST(LatencyRecorderTest, DumpsRecordedStages)
+{
+    LatencyRecorder recorder;
+    recorder.record(LatencyRecorder::e_DECODE, 2000);
+    recorder.record(LatencyRecorder::e_TOTAL, 40000);
+    EXPECT_EQ(1u, recorder.histogram(LatencyRecorder::e_DECODE).count());
+    EXPECT_EQ(0u, recorder.histogram(LatencyRecorder::e_QUEUE).count());
+
+    std::ostringstream stream;
+    recorder.dump(stream);
+    EXPECT_NE(std::string::npos, stream.str().find("p99.9"));
+    EXPECT_NE(std::string::npos, stream.str().find("decode"));
+    EXPECT_NE(std::string::npos, stream.str().find("total"));
+    EXPECT_EQ(std::string::npos, stream.str().find("queue"));
+    EXPECT_NE(std::string::npos, stream.str().find("40.0"));
+
+    const std::string path = testing::TempDir() + "latencyrecorder.t.txt";
+    std::remove(path.c_str());
+    ASSERT_TRUE(recorder.dumpTo(path));
+    ASSERT_TRUE(recorder.dumpTo(path));
+    std::ifstream file(path.c_str());
+    std::string line;
+    int stamps = 0;
+    while (std::getline(file, line)) {
+        stamps += line.compare(0, 2, "# ") == 0;
+    }
+    EXPECT_EQ(2, stamps);
+    std::remove(path.c_str());
+}
@@ -33,6 +33,7 @@ class MockNotifier : public INotifier {
     MOCK_METHOD1(logSessionState, void(const blp::Message&));
     MOCK_METHOD1(logSubscriptionState, void(const blp::Message&));
     MOCK_METHOD1(sendToTerminal, void(double));
+    MOCK_METHOD2(sendStrategyValue, void(const std::string&, double));
 };
 
 #endif
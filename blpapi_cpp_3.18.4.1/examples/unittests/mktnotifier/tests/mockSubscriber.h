@@ -0,0 +1,42 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _MOCK_SUBSCRIBER_
+#define _MOCK_SUBSCRIBER_
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <subscriber.h>
+
+namespace blp = BloombergLP::blpapi;
+
+class MockSubscriber : public ISubscriber {
+  public:
+    MOCK_METHOD5(subscribe,
+            void(const std::string& service,
+                    const std::vector<std::string>& topics,
+                    const std::vector<std::string>& fields,
+                    const std::vector<std::string>& options,
+                    const blp::Identity& identity));
+    MOCK_METHOD1(unsubscribe, void(const std::vector<std::string>& topics));
+};
+
+#endif
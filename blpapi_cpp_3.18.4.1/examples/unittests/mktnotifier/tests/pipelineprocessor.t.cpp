@@ -0,0 +1,432 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_messageformatter.h>
+#include <blpapi_testutil.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <testSchemas.h>
+#include <thread>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <mockNotifier.h>
+#include <mockSession.h>
+#include <pipelineprocessor.h>
+
+namespace blp = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+const blp::Name SESSION_STARTED("SessionStarted");
+const blp::Name SLOW_CONSUMER_WARNING("SlowConsumerWarning");
+const blp::Name SLOW_CONSUMER_WARNING_CLEARED("SlowConsumerWarningCleared");
+const char *const TOPICS[] = { "/ticker/IBM US Equity",
+    "/ticker/MSFT US Equity",
+    "/ticker/AAPL US Equity" };
+
+// RecordingComputeEngine takes every tick and records the last prices of
+// each topic in the order it is given them. It can be held, so that ticks
+// back up in the rings.
+class RecordingComputeEngine : public IComputeEngine {
+  private:
+    std::mutex d_mutex;
+    std::map<std::string, std::vector<double> > d_prices;
+    std::atomic<bool> d_held;
+    std::atomic<int> d_calls;
+
+  public:
+    RecordingComputeEngine()
+        : d_held(false)
+        , d_calls(0)
+    {
+    }
+
+    virtual double someVeryComplexComputation(double lastValue)
+    {
+        return lastValue;
+    }
+
+    virtual bool processTick(const char *topic, const Tick& tick)
+    {
+        ++d_calls;
+        while (d_held.load()) {
+            std::this_thread::yield();
+        }
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_prices[topic].push_back(tick.d_lastPrice);
+        return true;
+    }
+
+    void hold(bool held) { d_held.store(held); }
+
+    // Return the number of ticks given so far, including one held.
+    int calls() const { return d_calls.load(); }
+
+    std::vector<double> prices(const std::string& topic)
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        return d_prices[topic];
+    }
+};
+
+// Append to `event` a MarketDataEvents message correlated with `cid`
+// with `lastPrice`.
+void appendTick(
+        blp::Event *event, const blp::CorrelationId& cid, double lastPrice)
+{
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+    blptst::MessageProperties properties;
+    properties.setCorrelationId(cid);
+    blptst::MessageFormatter formatter = blptst::TestUtil::appendMessage(
+            *event, service.getEventDefinition(MKTDATA_EVENTS), properties);
+    std::ostringstream content;
+    content << "{\"LAST_PRICE\": " << lastPrice << "}";
+    formatter.formatMessageJson(content.str().c_str());
+}
+
+// Append to `event` a MarketDataEvents message for `topic` with
+// `lastPrice`.
+void appendTick(blp::Event *event, const char *topic, double lastPrice)
+{
+    appendTick(event, blp::CorrelationId((char *)topic), lastPrice);
+}
+
+// Return an admin event holding one message of type `messageType`.
+blp::Event adminEvent(const blp::Name& messageType)
+{
+    blp::Event event = blptst::TestUtil::createEvent(blp::Event::ADMIN);
+    blptst::TestUtil::appendMessage(event,
+            blptst::TestUtil::getAdminMessageDefinition(messageType));
+    return event;
+}
+}
+
+//
+// Concern:
+// Verify that every tick reaches the compute engine, in order per topic,
+// with the ticks of one topic all on one shard.
+//
+// Plan:
+// 1. Create a processor with three shards.
+// 2. Process events interleaving ticks of three topics, with increasing
+//    last prices.
+// 3. Wait for the workers and expect each topic to have been given all its
+//    ticks in order, and the counters to add up with nothing dropped.
+//
+TEST(PipelineProcessorTest, KeepsTopicOrder)
+{
+    MockSession session;
+    MockNotifier notifier;
+    RecordingComputeEngine computeEngine;
+    PipelineProcessor::Config config;
+    config.d_shards = 3;
+    PipelineProcessor processor(&notifier,
+            &computeEngine,
+            std::vector<std::string>(1, "LAST_PRICE"),
+            config);
+
+    const int k_EVENTS = 20;
+    const int k_TICKS = 10;
+    for (int e = 0; e < k_EVENTS; ++e) {
+        blp::Event event
+                = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+        for (int i = 0; i < k_TICKS; ++i) {
+            appendTick(&event, TOPICS[i % 3], e * k_TICKS + i);
+        }
+        processor.processEvent(event, &session);
+    }
+    processor.waitIdle();
+
+    for (int t = 0; t < 3; ++t) {
+        std::vector<double> expected;
+        for (int k = 0; k < k_EVENTS * k_TICKS; ++k) {
+            if (k % k_TICKS % 3 == t) {
+                expected.push_back(k);
+            }
+        }
+        EXPECT_EQ(expected, computeEngine.prices(TOPICS[t])) << TOPICS[t];
+        EXPECT_EQ(processor.shardOf(TOPICS[t]),
+                processor.shardOf(std::string(TOPICS[t]).c_str()));
+    }
+
+    size_t processed = 0;
+    for (size_t s = 0; s < processor.numShards(); ++s) {
+        const PipelineProcessor::ShardStatistics stats
+                = processor.statistics(s);
+        EXPECT_EQ(0u, stats.d_depth);
+        EXPECT_EQ(0u, stats.d_dropped);
+        EXPECT_EQ(stats.d_pushed, stats.d_processed);
+        processed += stats.d_processed;
+    }
+    EXPECT_EQ(size_t(k_EVENTS * k_TICKS), processed);
+}
+
+//
+// Concern:
+// Verify that the updates of registered topics are looked up by id, and
+// reach the compute engine in order under the registered topic, on the
+// shard of the topic.
+//
+// Plan:
+// 1. Register three topics and create a processor with three shards on
+//    the registry.
+// 2. Process an event interleaving ticks correlated with the ids of the
+//    topics, with increasing last prices.
+// 3. Wait for the workers and expect each topic to have been given all its
+//    ticks in order, and the registry to have counted them.
+//
+TEST(PipelineProcessorTest, LooksUpRegisteredTopicsById)
+{
+    MockSession session;
+    MockNotifier notifier;
+    RecordingComputeEngine computeEngine;
+    const std::vector<std::string> fields(1, "LAST_PRICE");
+    TopicRegistry registry(3);
+    for (int t = 0; t < 3; ++t) {
+        registry.add(TOPICS[t], fields);
+    }
+    PipelineProcessor::Config config;
+    config.d_shards = 3;
+    config.d_registry = &registry;
+    PipelineProcessor processor(&notifier, &computeEngine, fields, config);
+
+    const int k_TICKS = 30;
+    blp::Event event
+            = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    for (int i = 0; i < k_TICKS; ++i) {
+        appendTick(&event, blp::CorrelationId(i % 3 + 0LL), i);
+    }
+    processor.processEvent(event, &session);
+    processor.waitIdle();
+
+    for (int t = 0; t < 3; ++t) {
+        std::vector<double> expected;
+        for (int i = t; i < k_TICKS; i += 3) {
+            expected.push_back(i);
+        }
+        EXPECT_EQ(expected, computeEngine.prices(TOPICS[t])) << TOPICS[t];
+        EXPECT_EQ(size_t(k_TICKS / 3), registry.sequence(t));
+        EXPECT_EQ(k_TICKS - 3 + t, registry.lastValues(t).d_lastPrice);
+    }
+}
+
+//
+// Concern:
+// Verify that ticks that find their ring full are dropped and counted,
+// and that the ticks pushed are still processed.
+//
+// Plan:
+// 1. Create a processor with one shard and a ring of four ticks, and hold
+//    the compute engine.
+// 2. Process an event of twenty ticks, and expect at most five to have
+//    been pushed, the one held and a full ring, and the rest dropped.
+// 3. Release the compute engine and expect the pushed ticks to be
+//    processed, the oldest first.
+//
+TEST(PipelineProcessorTest, CountsDrops)
+{
+    MockSession session;
+    MockNotifier notifier;
+    RecordingComputeEngine computeEngine;
+    computeEngine.hold(true);
+    PipelineProcessor::Config config;
+    config.d_shards = 1;
+    config.d_capacity = 4;
+    PipelineProcessor processor(&notifier,
+            &computeEngine,
+            std::vector<std::string>(1, "LAST_PRICE"),
+            config);
+
+    const int k_TICKS = 20;
+    blp::Event event
+            = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    for (int i = 0; i < k_TICKS; ++i) {
+        appendTick(&event, TOPICS[0], i);
+    }
+    processor.processEvent(event, &session);
+
+    PipelineProcessor::ShardStatistics stats = processor.statistics(0);
+    EXPECT_LE(stats.d_pushed, 5u);
+    EXPECT_EQ(size_t(k_TICKS), stats.d_pushed + stats.d_dropped);
+
+    computeEngine.hold(false);
+    processor.waitIdle();
+    stats = processor.statistics(0);
+    EXPECT_EQ(stats.d_pushed, stats.d_processed);
+    EXPECT_EQ(0u, stats.d_depth);
+    const std::vector<double> prices = computeEngine.prices(TOPICS[0]);
+    ASSERT_EQ(stats.d_pushed, prices.size());
+    for (size_t i = 0; i < prices.size(); ++i) {
+        EXPECT_EQ(double(i), prices[i]);
+    }
+}
+
+//
+// Concern:
+// Verify that session status messages are still logged, on the
+// dispatcher thread.
+//
+TEST(PipelineProcessorTest, LogsSessionState)
+{
+    MockSession session;
+    MockNotifier notifier;
+    RecordingComputeEngine computeEngine;
+    PipelineProcessor processor(
+            &notifier, &computeEngine, std::vector<std::string>());
+
+    blp::Event event
+            = blptst::TestUtil::createEvent(blp::Event::SESSION_STATUS);
+    blptst::TestUtil::appendMessage(event,
+            blptst::TestUtil::getAdminMessageDefinition(SESSION_STARTED));
+    EXPECT_CALL(notifier, logSessionState(testing::_));
+    processor.processEvent(event, &session);
+}
+
+//
+// Concern:
+// Verify that ticks of the configured topics are conflated to their
+// latest value between SlowConsumerWarning and SlowConsumerWarningCleared,
+// and that other topics are not.
+//
+// Plan:
+// 1. Create a processor with one shard, conflating IBM only, and hold the
+//    compute engine.
+// 2. Process a SlowConsumerWarning, then ticks of IBM and MSFT, the first
+//    of which keeps the worker busy.
+// 3. Release the compute engine, and expect IBM to have been given the
+//    first tick and then only the last, with the ticks in between counted
+//    as conflated, and MSFT to have been given every tick.
+// 4. Process a SlowConsumerWarningCleared, and expect the next ticks of
+//    IBM to be given one by one.
+//
+TEST(PipelineProcessorTest, ConflatesUnderSlowConsumerWarning)
+{
+    MockSession session;
+    MockNotifier notifier;
+    RecordingComputeEngine computeEngine;
+    computeEngine.hold(true);
+    PipelineProcessor::Config config;
+    config.d_shards = 1;
+    config.d_topics.push_back(TOPICS[0]);
+    PipelineProcessor processor(&notifier,
+            &computeEngine,
+            std::vector<std::string>(1, "LAST_PRICE"),
+            config);
+
+    processor.processEvent(adminEvent(SLOW_CONSUMER_WARNING), &session);
+    EXPECT_TRUE(processor.isConflating());
+
+    const int k_TICKS = 10;
+    blp::Event event
+            = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    appendTick(&event, TOPICS[0], 0.0);
+    processor.processEvent(event, &session);
+    while (computeEngine.calls() == 0) {
+        std::this_thread::yield();
+    }
+    event = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    for (int i = 1; i < k_TICKS; ++i) {
+        appendTick(&event, TOPICS[0], i);
+        appendTick(&event, TOPICS[1], i);
+    }
+    processor.processEvent(event, &session);
+    computeEngine.hold(false);
+    processor.waitIdle();
+
+    std::vector<double> expected;
+    expected.push_back(0.0);
+    expected.push_back(k_TICKS - 1.0);
+    EXPECT_EQ(expected, computeEngine.prices(TOPICS[0]));
+    EXPECT_EQ(size_t(k_TICKS - 1), computeEngine.prices(TOPICS[1]).size());
+    EXPECT_EQ(size_t(k_TICKS - 2), processor.statistics(0).d_conflated);
+
+    processor.processEvent(
+            adminEvent(SLOW_CONSUMER_WARNING_CLEARED), &session);
+    EXPECT_FALSE(processor.isConflating());
+    event = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    appendTick(&event, TOPICS[0], 20.0);
+    appendTick(&event, TOPICS[0], 21.0);
+    processor.processEvent(event, &session);
+    processor.waitIdle();
+    expected.push_back(20.0);
+    expected.push_back(21.0);
+    EXPECT_EQ(expected, computeEngine.prices(TOPICS[0]));
+}
+
+//
+// Concern:
+// Verify that a topic registered after the processor is created, as the
+// members of an option chain are, is conflated and kept on one shard like
+// the topics registered before.
+//
+// Plan:
+// 1. Create a processor with two shards on an empty registry with room
+//    for two topics, then register IBM, and hold the compute engine.
+// 2. Process a SlowConsumerWarning and ticks of IBM correlated with its
+//    id, the first of which keeps the worker busy.
+// 3. Release the compute engine, and expect IBM to have been given the
+//    first tick and then only the last.
+//
+TEST(PipelineProcessorTest, ConflatesTopicsRegisteredLater)
+{
+    MockSession session;
+    MockNotifier notifier;
+    RecordingComputeEngine computeEngine;
+    computeEngine.hold(true);
+    const std::vector<std::string> fields(1, "LAST_PRICE");
+    TopicRegistry registry(2);
+    PipelineProcessor::Config config;
+    config.d_shards = 2;
+    config.d_registry = &registry;
+    PipelineProcessor processor(&notifier, &computeEngine, fields, config);
+    const int id = registry.add(TOPICS[0], fields);
+
+    processor.processEvent(adminEvent(SLOW_CONSUMER_WARNING), &session);
+    const int k_TICKS = 10;
+    blp::Event event
+            = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    appendTick(&event, blp::CorrelationId(id + 0LL), 0.0);
+    processor.processEvent(event, &session);
+    while (computeEngine.calls() == 0) {
+        std::this_thread::yield();
+    }
+    event = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    for (int i = 1; i < k_TICKS; ++i) {
+        appendTick(&event, blp::CorrelationId(id + 0LL), i);
+    }
+    processor.processEvent(event, &session);
+    computeEngine.hold(false);
+    processor.waitIdle();
+
+    std::vector<double> expected;
+    expected.push_back(0.0);
+    expected.push_back(k_TICKS - 1.0);
+    EXPECT_EQ(expected, computeEngine.prices(TOPICS[0]));
+    EXPECT_EQ(size_t(k_TICKS), registry.sequence(id));
+}
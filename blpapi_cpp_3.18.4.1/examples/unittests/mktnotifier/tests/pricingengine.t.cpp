@@ -0,0 +1,266 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_messageformatter.h>
+#include <blpapi_testutil.h>
+
+#include <sstream>
+#include <testSchemas.h>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <eventprocessor.h>
+#include <mockNotifier.h>
+#include <mockSession.h>
+#include <pricingengine.h>
+
+namespace blp = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+const char IBM[] = "/ticker/IBM US Equity";
+const char MSFT[] = "/ticker/MSFT US Equity";
+
+// Black-Scholes values, with no rate, of the 1y 100 call at a spot of 100
+// and a vol of 20%, and of the 6m 300 put at a spot of 300 and a vol of
+// 30%.
+const double k_IBM_CALL = 7.965567455405804;
+const double k_MSFT_PUT = 25.341007986968407;
+
+std::vector<Strategy> strategies()
+{
+    std::vector<Strategy> result(2);
+    EXPECT_TRUE(Strategy::parse(
+            &result[0], "call=/ticker/IBM US Equity,C,100,1,1"));
+    EXPECT_TRUE(Strategy::parse(&result[1],
+            "pair=/ticker/IBM US Equity,C,100,1,1;"
+            "/ticker/MSFT US Equity,P,300,0.5,-2"));
+    return result;
+}
+}
+
+//
+// Concern:
+// Verify that a tick reprices only the strategies that depend on its
+// topic, from the mid and implied vol, and that ticks of other topics are
+// left to the caller.
+//
+// Plan:
+// 1. Register a strategy on IBM, and one on IBM and MSFT.
+// 2. Tick IBM with a bid, ask and implied vol, and expect only the IBM
+//    strategy to be valued, as MSFT has no quote yet.
+// 3. Tick MSFT with a last price and implied vol, and expect only the
+//    pair to be valued.
+// 4. Expect a tick of a topic no strategy depends on not to be taken.
+//
+TEST(PricingEngineTest, RepricesDependentStrategies)
+{
+    MockNotifier notifier;
+    PricingEngine engine(&notifier, strategies());
+
+    Tick ibm;
+    ibm.d_bid = 99.0;
+    ibm.d_ask = 101.0;
+    ibm.d_impliedVol = 20.0;
+    EXPECT_CALL(notifier,
+            sendStrategyValue("call", testing::DoubleNear(k_IBM_CALL, 1e-9)));
+    EXPECT_TRUE(engine.processTick(IBM, ibm));
+    engine.waitIdle();
+    testing::Mock::VerifyAndClearExpectations(&notifier);
+
+    Tick msft;
+    msft.d_lastPrice = 300.0;
+    msft.d_impliedVol = 30.0;
+    EXPECT_CALL(notifier,
+            sendStrategyValue("pair",
+                    testing::DoubleNear(k_IBM_CALL - 2.0 * k_MSFT_PUT, 1e-9)));
+    EXPECT_TRUE(engine.processTick(MSFT, msft));
+    engine.waitIdle();
+    testing::Mock::VerifyAndClearExpectations(&notifier);
+
+    EXPECT_FALSE(engine.processTick("/ticker/AAPL US Equity", ibm));
+}
+
+//
+// Concern:
+// Verify that a burst of ticks is priced at most once per tick, in order,
+// and that the last value sent is from the last tick.
+//
+// Plan:
+// 1. Tick IBM many times, with four workers pricing, ending on the
+//    quote of the first test.
+// 2. Expect the last value sent for the strategy to be the value on that
+//    quote, and no more values than ticks.
+//
+TEST(PricingEngineTest, ConflatesBursts)
+{
+    MockNotifier notifier;
+    PricingEngine::Config config;
+    config.d_threads = 4;
+    PricingEngine engine(&notifier, strategies(), config);
+
+    const int k_TICKS = 10000;
+    int values = 0;
+    double last = 0.0;
+    EXPECT_CALL(notifier, sendStrategyValue("call", testing::_))
+            .WillRepeatedly(testing::DoAll(
+                    testing::SaveArg<1>(&last),
+                    testing::InvokeWithoutArgs([&values]() { ++values; })));
+    for (int i = 0; i < k_TICKS; ++i) {
+        Tick tick;
+        tick.d_bid = 90.0 + i % 10;
+        tick.d_ask = 101.0;
+        tick.d_impliedVol = 20.0;
+        engine.processTick(IBM, tick);
+    }
+    Tick tick;
+    tick.d_bid = 99.0;
+    engine.processTick(IBM, tick);
+    engine.waitIdle();
+
+    EXPECT_NEAR(k_IBM_CALL, last, 1e-9);
+    EXPECT_GE(k_TICKS + 1, values);
+}
+
+//
+// Concern:
+// Verify that the event processor hands BID, ASK and IVOL_MID updates to
+// the engine by topic, and does not send them to terminal.
+//
+// Plan:
+// 1. Create a MarketDataEvents message correlated with the IBM topic, as
+//    the subscriber does, with a bid, ask and implied vol.
+// 2. Expect the strategy on IBM to be valued, and nothing to be sent to
+//    terminal.
+//
+TEST(PricingEngineTest, EventProcessorFeedsTicks)
+{
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+    const blp::SchemaElementDefinition schemaDef
+            = service.getEventDefinition(MKTDATA_EVENTS);
+
+    blp::Event event
+            = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::MessageProperties properties;
+    properties.setCorrelationId(blp::CorrelationId((char *)IBM));
+    blptst::MessageFormatter formatter
+            = blptst::TestUtil::appendMessage(event, schemaDef, properties);
+    formatter.formatMessageJson("{"
+                                "\"BID\": 99.0,"
+                                "\"ASK\": 101.0,"
+                                "\"IVOL_MID\": 20.0"
+                                "}");
+
+    MockSession session;
+    MockNotifier notifier;
+    PricingEngine engine(&notifier, strategies());
+    EventProcessor eventProcessor(&notifier, &engine);
+
+    EXPECT_CALL(notifier,
+            sendStrategyValue("call", testing::DoubleNear(k_IBM_CALL, 1e-9)));
+    EXPECT_CALL(notifier, sendToTerminal(testing::_)).Times(0);
+    eventProcessor.processEvent(event, &session);
+    engine.waitIdle();
+}
+
+//
+// Concern:
+// Verify that a timed tick is timed on the worker that values the strategy
+// it queues, through to the value being sent, and not on the hand-off.
+//
+// Plan:
+// 1. Hand the engine an IBM tick through EventProcessor::processTick with
+//    a recorder and a receive time.
+// 2. Expect one compute, notify and total latency once the strategy is
+//    valued, and the total to cover the compute and notify latencies.
+// 3. Hand it an AAPL tick, which no strategy depends on, and expect it to
+//    be computed, sent to terminal and timed by the caller.
+//
+TEST(PricingEngineTest, TimesTicksToTheirValue)
+{
+    MockNotifier notifier;
+    PricingEngine engine(&notifier, strategies());
+    LatencyRecorder recorder;
+
+    Tick tick;
+    tick.d_bid = 99.0;
+    tick.d_ask = 101.0;
+    tick.d_impliedVol = 20.0;
+    TickTimes times;
+    times.d_received = LatencyRecorder::now();
+    times.d_timed = true;
+    EXPECT_CALL(notifier, sendStrategyValue("call", testing::_));
+    EventProcessor::processTick(
+            &notifier, &engine, IBM, tick, &recorder, times);
+    engine.waitIdle();
+
+    const LatencyHistogram& compute
+            = recorder.histogram(LatencyRecorder::e_COMPUTE);
+    const LatencyHistogram& notify
+            = recorder.histogram(LatencyRecorder::e_NOTIFY);
+    const LatencyHistogram& total
+            = recorder.histogram(LatencyRecorder::e_TOTAL);
+    EXPECT_EQ(1u, compute.count());
+    EXPECT_EQ(1u, notify.count());
+    ASSERT_EQ(1u, total.count());
+    EXPECT_GE(total.max(), compute.max() + notify.max());
+
+    tick.d_lastPrice = 150.0;
+    EXPECT_CALL(notifier, sendToTerminal(testing::_));
+    EventProcessor::processTick(&notifier,
+            &engine,
+            "/ticker/AAPL US Equity",
+            tick,
+            &recorder,
+            times);
+    EXPECT_EQ(2u, compute.count());
+    EXPECT_EQ(2u, notify.count());
+    EXPECT_EQ(2u, total.count());
+}
+
+//
+// Concern:
+// Verify that malformed strategies are rejected.
+//
+TEST(PricingEngineTest, ParseRejectsMalformedStrategies)
+{
+    Strategy strategy;
+    EXPECT_FALSE(Strategy::parse(&strategy, "call"));
+    EXPECT_FALSE(Strategy::parse(&strategy, "=/ticker/A,C,100,1,1"));
+    EXPECT_FALSE(Strategy::parse(&strategy, "call="));
+    EXPECT_FALSE(Strategy::parse(&strategy, "call=/ticker/A,C,100,1"));
+    EXPECT_FALSE(Strategy::parse(&strategy, "call=/ticker/A,X,100,1,1"));
+    EXPECT_FALSE(Strategy::parse(&strategy, "call=/ticker/A,C,abc,1,1"));
+    EXPECT_FALSE(Strategy::parse(&strategy, "call=/ticker/A,C,-5,1,1"));
+
+    ASSERT_TRUE(Strategy::parse(&strategy, "call=/ticker/A,P,100,0.5,-3"));
+    EXPECT_EQ("call", strategy.d_name);
+    ASSERT_EQ(1u, strategy.d_legs.size());
+    EXPECT_EQ("/ticker/A", strategy.d_legs[0].d_topic);
+    EXPECT_FALSE(strategy.d_legs[0].d_isCall);
+    EXPECT_EQ(100.0, strategy.d_legs[0].d_strike);
+    EXPECT_EQ(0.5, strategy.d_legs[0].d_expiry);
+    EXPECT_EQ(-3.0, strategy.d_legs[0].d_quantity);
+}
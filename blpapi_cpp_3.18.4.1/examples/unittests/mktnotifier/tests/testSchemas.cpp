@@ -196,6 +196,18 @@ const char *k_mktdataSchema("<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\
             <description>Volume</description>\
             <alternateId>458753</alternateId>\
          </element>\
+         <element name=\"IVOL_MID\" type=\"Float64\" id=\"5\" minOccurs=\"0\" maxOccurs=\"1\">\
+            <description>Implied Volatility Using Mid Price</description>\
+         </element>\
+         <element name=\"BID_SIZE\" type=\"Int64\" id=\"6\" minOccurs=\"0\" maxOccurs=\"1\">\
+            <description>Bid Size</description>\
+         </element>\
+         <element name=\"ASK_SIZE\" type=\"Int64\" id=\"7\" minOccurs=\"0\" maxOccurs=\"1\">\
+            <description>Ask Size</description>\
+         </element>\
+         <element name=\"SIZE_LAST_TRADE\" type=\"Int64\" id=\"8\" minOccurs=\"0\" maxOccurs=\"1\">\
+            <description>Size of Last Trade</description>\
+         </element>\
       </sequenceType>\
    </schema>\
 </ServiceDefinition>");
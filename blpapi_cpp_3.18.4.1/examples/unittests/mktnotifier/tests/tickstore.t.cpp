@@ -0,0 +1,267 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include <tickstore.h>
+
+namespace {
+// 2022-11-18 00:00:00 UTC, in nanoseconds since the epoch.
+const int64_t k_DAY_START = 1668729600LL * 1000000000;
+const int64_t k_SECOND = 1000000000;
+const int k_DATE = 20221118;
+
+class TickStoreTest : public testing::Test {
+  protected:
+    TickStore::Config d_config;
+
+  public:
+    virtual void SetUp()
+    {
+        d_config.d_directory = testing::TempDir();
+        d_config.d_capacity = 16;
+        d_config.d_maxTopics = 4;
+        removeSegments();
+    }
+
+    virtual void TearDown() { removeSegments(); }
+
+    void removeSegments()
+    {
+        int today;
+        int64_t dayStart;
+        TickSegment::dayOf(&today, &dayStart, TickStore::now());
+        const int dates[] = { k_DATE, k_DATE + 1, today };
+        for (size_t i = 0; i < sizeof dates / sizeof *dates; ++i) {
+            for (int part = 0; part < 4; ++part) {
+                std::remove(path(dates[i], part).c_str());
+            }
+        }
+    }
+
+    std::string path(int date, int part = 0) const
+    {
+        return TickSegment::pathOf(d_config.d_directory, date, part);
+    }
+};
+}
+
+//
+// Concern:
+// Verify that the day of a time is its UTC date.
+//
+TEST_F(TickStoreTest, FindsTheDayOfATime)
+{
+    int date;
+    int64_t dayStart;
+    TickSegment::dayOf(&date, &dayStart, k_DAY_START + 23 * 3600 * k_SECOND);
+    EXPECT_EQ(k_DATE, date);
+    EXPECT_EQ(k_DAY_START, dayStart);
+    TickSegment::dayOf(&date, &dayStart, k_DAY_START - 1);
+    EXPECT_EQ(20221117, date);
+    EXPECT_EQ(k_DAY_START - 24 * 3600 * k_SECOND, dayStart);
+}
+
+//
+// Concern:
+// Verify that a reader maps the ticks appended, and finds them by topic
+// and time.
+//
+// Plan:
+// 1. Append ticks of two topics within a day, the last timed before the
+//    one ahead of it.
+// 2. Map the segment, and expect the rows, topics and columns appended,
+//    with the last row at the time of the one ahead of it.
+// 3. Expect lowerBound to find the first row at or after a time.
+// 4. Expect a snapshot to hold the latest value of each field of each
+//    topic, up to the row given.
+//
+TEST_F(TickStoreTest, ReadsAppendedTicks)
+{
+    TickStore store(d_config);
+    Tick tick;
+    tick.d_bid = 1.0;
+    tick.d_ask = 2.0;
+    EXPECT_TRUE(store.append("IBM", tick, k_DAY_START + 3 * k_SECOND / 2));
+    tick = Tick();
+    tick.d_lastPrice = 3.0;
+    tick.d_lastSize = 100;
+    EXPECT_TRUE(store.append("MSFT", tick, k_DAY_START + 16 * k_SECOND / 10));
+    tick = Tick();
+    tick.d_bid = 1.5;
+    EXPECT_TRUE(store.append("IBM", tick, k_DAY_START + 32 * k_SECOND / 10));
+    tick = Tick();
+    tick.d_askSize = 7;
+    EXPECT_TRUE(store.append("IBM", tick, k_DAY_START + 31 * k_SECOND / 10));
+
+    const TickStoreReader reader(path(k_DATE));
+    EXPECT_EQ(k_DATE, reader.date());
+    ASSERT_EQ(4u, reader.size());
+    ASSERT_EQ(2u, reader.numTopics());
+    EXPECT_STREQ("IBM", reader.topic(0));
+    EXPECT_EQ(1, reader.findTopic("MSFT"));
+    EXPECT_EQ(-1, reader.findTopic("AAPL"));
+    EXPECT_EQ(0u, reader.topicIds()[2]);
+    EXPECT_EQ(reader.times()[2], reader.times()[3]);
+    EXPECT_EQ(100, reader.column(TickSegment::e_LAST_SIZE)[1]);
+    EXPECT_TRUE(std::isnan(reader.column(TickSegment::e_BID)[1]));
+    Tick loaded;
+    reader.load(&loaded, 3);
+    EXPECT_EQ(7, loaded.d_askSize);
+    EXPECT_TRUE(std::isnan(loaded.d_bid));
+
+    EXPECT_EQ(0u, reader.lowerBound(k_DAY_START - k_SECOND));
+    EXPECT_EQ(0u, reader.lowerBound(k_DAY_START));
+    EXPECT_EQ(1u, reader.lowerBound(k_DAY_START + 155 * k_SECOND / 100));
+    EXPECT_EQ(2u, reader.lowerBound(k_DAY_START + 2 * k_SECOND));
+    EXPECT_EQ(2u, reader.lowerBound(k_DAY_START + 32 * k_SECOND / 10));
+    EXPECT_EQ(4u, reader.lowerBound(k_DAY_START + 4 * k_SECOND));
+
+    std::vector<Tick> ticks;
+    reader.snapshot(&ticks, reader.size());
+    ASSERT_EQ(2u, ticks.size());
+    EXPECT_EQ(1.5, ticks[0].d_bid);
+    EXPECT_EQ(2.0, ticks[0].d_ask);
+    EXPECT_EQ(7, ticks[0].d_askSize);
+    EXPECT_EQ(3.0, ticks[1].d_lastPrice);
+    reader.snapshot(&ticks, 1);
+    EXPECT_EQ(1.0, ticks[0].d_bid);
+    EXPECT_TRUE(std::isnan(ticks[1].d_lastPrice));
+}
+
+//
+// Concern:
+// Verify that a store carries on with the latest segment of the day,
+// starts a new segment of the day when one fills up, drops ticks whose
+// topic does not fit the topic table, and starts a segment for the next
+// day.
+//
+// Plan:
+// 1. Append two ticks with a store, and one with a new store, and expect
+//    the topic to keep its id.
+// 2. Expect a tick of a topic too long for the topic table to be dropped.
+// 3. Append a tick past the capacity of the segment, and expect it in a
+//    new segment of the day, with the time of the last row kept.
+// 4. Fill the topic table of that segment, append a tick of another
+//    topic, and expect it in a third segment.
+// 5. Expect a new store to carry on with the third segment.
+// 6. Append a tick of the next day, and expect it in a segment of its
+//    own.
+//
+TEST_F(TickStoreTest, ContinuesAndRollsSegments)
+{
+    d_config.d_capacity = 3;
+    d_config.d_maxTopics = 2;
+    Tick tick;
+    tick.d_lastPrice = 1.0;
+    {
+        TickStore store(d_config);
+        EXPECT_TRUE(store.append("IBM", tick, k_DAY_START + k_SECOND));
+        EXPECT_TRUE(store.append("MSFT", tick, k_DAY_START + 2 * k_SECOND));
+    }
+    TickStore store(d_config);
+    EXPECT_FALSE(store.append(
+            std::string(TickSegment::k_TOPIC_SIZE, 'X').c_str(),
+            tick,
+            k_DAY_START + 3 * k_SECOND));
+    EXPECT_TRUE(store.append("IBM", tick, k_DAY_START + 4 * k_SECOND));
+    EXPECT_EQ(1u, store.numDropped());
+    {
+        const TickStoreReader reader(path(k_DATE));
+        ASSERT_EQ(3u, reader.size());
+        EXPECT_EQ(2u, reader.numTopics());
+        EXPECT_EQ(0u, reader.topicIds()[2]);
+    }
+
+    EXPECT_TRUE(store.append("MSFT", tick, k_DAY_START + 3 * k_SECOND));
+    EXPECT_EQ(path(k_DATE, 1), store.path());
+    {
+        const TickStoreReader reader(path(k_DATE, 1));
+        ASSERT_EQ(1u, reader.size());
+        EXPECT_STREQ("MSFT", reader.topic(0));
+        EXPECT_EQ(k_DAY_START + 4 * k_SECOND, reader.times()[0]);
+    }
+
+    EXPECT_TRUE(store.append("A", tick, k_DAY_START + 5 * k_SECOND));
+    EXPECT_EQ(path(k_DATE, 1), store.path());
+    EXPECT_TRUE(store.append("B", tick, k_DAY_START + 6 * k_SECOND));
+    EXPECT_EQ(path(k_DATE, 2), store.path());
+    EXPECT_EQ(1u, store.numDropped());
+
+    {
+        TickStore next(d_config);
+        EXPECT_TRUE(next.append("IBM", tick, k_DAY_START + 7 * k_SECOND));
+        EXPECT_EQ(path(k_DATE, 2), next.path());
+    }
+
+    EXPECT_TRUE(store.append("IBM", tick, k_DAY_START + 24 * 3600 * k_SECOND));
+    const TickStoreReader reader(path(k_DATE + 1));
+    EXPECT_EQ(1u, reader.size());
+    EXPECT_THROW(TickStoreReader(path(k_DATE + 2)), std::runtime_error);
+}
+
+//
+// Concern:
+// Verify that ticks of registered topics are stored under the topic
+// table id of their name, looked up by their registry id.
+//
+// Plan:
+// 1. Append ticks of two topics by registry id, and one of a topic that is
+//    not registered.
+// 2. Expect each name in the topic table once, and each row to refer to
+//    the id of its topic.
+// 3. Fill the segment, and expect the registry ids to be mapped afresh in
+//    the next one.
+//
+TEST_F(TickStoreTest, LooksUpRegisteredTopicsById)
+{
+    d_config.d_capacity = 4;
+    TickStore store(d_config);
+    Tick tick;
+    tick.d_bid = 1.0;
+    EXPECT_TRUE(store.append(7, "IBM", tick, k_DAY_START + k_SECOND));
+    EXPECT_TRUE(store.append(2, "MSFT", tick, k_DAY_START + k_SECOND));
+    EXPECT_TRUE(store.append("AAPL", tick, k_DAY_START + k_SECOND));
+    EXPECT_TRUE(store.append(7, "IBM", tick, k_DAY_START + 2 * k_SECOND));
+    {
+        const TickStoreReader reader(path(k_DATE));
+        ASSERT_EQ(4u, reader.size());
+        ASSERT_EQ(3u, reader.numTopics());
+        EXPECT_STREQ("IBM", reader.topic(0));
+        EXPECT_STREQ("MSFT", reader.topic(1));
+        EXPECT_STREQ("AAPL", reader.topic(2));
+        EXPECT_EQ(1u, reader.topicIds()[1]);
+        EXPECT_EQ(0u, reader.topicIds()[3]);
+    }
+
+    EXPECT_TRUE(store.append(2, "MSFT", tick, k_DAY_START + 3 * k_SECOND));
+    EXPECT_TRUE(store.append(7, "IBM", tick, k_DAY_START + 3 * k_SECOND));
+    const TickStoreReader reader(path(k_DATE, 1));
+    ASSERT_EQ(2u, reader.size());
+    EXPECT_STREQ("MSFT", reader.topic(0));
+    EXPECT_STREQ("IBM", reader.topic(1));
+    EXPECT_EQ(1u, reader.topicIds()[1]);
+}
@@ -0,0 +1,172 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_messageformatter.h>
+#include <blpapi_testutil.h>
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <testSchemas.h>
+
+#include "gtest/gtest.h"
+
+#include <topicregistry.h>
+
+namespace blp = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+
+// Return a MarketDataEvents event holding one message correlated with
+// `cid` with `content`.
+blp::Event marketDataEvent(const blp::CorrelationId& cid, const char *content)
+{
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+    blp::Event event
+            = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::MessageProperties properties;
+    properties.setCorrelationId(cid);
+    blptst::MessageFormatter formatter = blptst::TestUtil::appendMessage(
+            event, service.getEventDefinition(MKTDATA_EVENTS), properties);
+    formatter.formatMessageJson(content);
+    return event;
+}
+
+// Return the first message of `event`.
+blp::Message firstMessage(const blp::Event& event)
+{
+    blp::MessageIterator msgIter(event);
+    msgIter.next();
+    return msgIter.message();
+}
+}
+
+//
+// Concern:
+// Verify that topics are given dense ids in the order registered, once
+// each, and that the registry refuses topics beyond its capacity.
+//
+// Plan:
+// 1. Register three topics in a registry for three, and expect ids 0, 1
+//    and 2, found again by name.
+// 2. Register the second topic again, and expect its id and no new topic.
+// 3. Expect a fourth topic to throw std::length_error.
+//
+TEST(TopicRegistryTest, HandsOutDenseIds)
+{
+    const std::vector<std::string> fields(1, "LAST_PRICE");
+    TopicRegistry registry(3);
+    EXPECT_EQ(0, registry.add("/ticker/IBM US Equity", fields));
+    EXPECT_EQ(1, registry.add("/ticker/MSFT US Equity", fields));
+    EXPECT_EQ(2, registry.add("/ticker/AAPL US Equity", fields));
+    EXPECT_EQ(1, registry.add("/ticker/MSFT US Equity", fields));
+    EXPECT_EQ(3u, registry.size());
+    EXPECT_EQ(1, registry.find("/ticker/MSFT US Equity"));
+    EXPECT_EQ(-1, registry.find("/ticker/GOOG US Equity"));
+    EXPECT_STREQ("/ticker/AAPL US Equity", registry.topic(2));
+
+    const std::vector<std::string> topics = registry.topics();
+    ASSERT_EQ(3u, topics.size());
+    EXPECT_EQ("/ticker/IBM US Equity", topics[0]);
+    EXPECT_EQ("/ticker/MSFT US Equity", topics[1]);
+
+    EXPECT_THROW(registry.add("/ticker/GOOG US Equity", fields),
+            std::length_error);
+}
+
+//
+// Concern:
+// Verify that only messages correlated with a registered id are found,
+// and that updates are decoded with the plan of their topic and merged
+// into its latest values and counters.
+//
+// Plan:
+// 1. Register a topic subscribed to BID and another to LAST_PRICE only.
+// 2. Expect the ids of messages correlated with 1, with an unregistered
+//    integer and with a pointer.
+// 3. Update the first topic with a tick of BID and LAST_PRICE, then one
+//    of ASK, which it has no plan for, then one of LAST_PRICE, and expect
+//    the decoded ticks, the latest values, sequence and counters.
+// 4. Update the second topic with BID and LAST_PRICE, and expect only the
+//    LAST_PRICE.
+//
+TEST(TopicRegistryTest, RecordsTopicState)
+{
+    TopicRegistry registry(4);
+    registry.add("/ticker/IBM US Equity", std::vector<std::string>(1, "BID"));
+    registry.add("/ticker/MSFT US Equity",
+            std::vector<std::string>(1, "LAST_PRICE"));
+
+    const blp::Event other
+            = marketDataEvent(blp::CorrelationId(1), "{\"BID\": 1.0}");
+    EXPECT_EQ(1, registry.idOf(firstMessage(other)));
+    const blp::Event unregistered
+            = marketDataEvent(blp::CorrelationId(2), "{\"BID\": 1.0}");
+    EXPECT_EQ(-1, registry.idOf(firstMessage(unregistered)));
+    const blp::Event pointer = marketDataEvent(
+            blp::CorrelationId((void *)"/ticker/IBM US Equity"),
+            "{\"BID\": 1.0}");
+    EXPECT_EQ(-1, registry.idOf(firstMessage(pointer)));
+
+    const blp::CorrelationId ibm(0LL);
+    Tick tick;
+    registry.update(&tick,
+            0,
+            firstMessage(marketDataEvent(
+                    ibm, "{\"BID\": 142.5, \"LAST_PRICE\": 142.75}")));
+    EXPECT_EQ(142.5, tick.d_bid);
+    EXPECT_EQ(142.75, tick.d_lastPrice);
+
+    tick = Tick();
+    registry.update(
+            &tick, 0, firstMessage(marketDataEvent(ibm, "{\"ASK\": 143}")));
+    EXPECT_TRUE(std::isnan(tick.d_ask));
+
+    tick = Tick();
+    registry.update(&tick,
+            0,
+            firstMessage(marketDataEvent(ibm, "{\"LAST_PRICE\": 143.25}")));
+    EXPECT_TRUE(std::isnan(tick.d_bid));
+    EXPECT_EQ(143.25, tick.d_lastPrice);
+
+    EXPECT_EQ(142.5, registry.lastValues(0).d_bid);
+    EXPECT_TRUE(std::isnan(registry.lastValues(0).d_ask));
+    EXPECT_EQ(143.25, registry.lastValues(0).d_lastPrice);
+    EXPECT_EQ(3u, registry.sequence(0));
+    EXPECT_EQ(3u, registry.statistics(0).d_ticks);
+    EXPECT_EQ(1u, registry.statistics(0).d_emptyTicks);
+    EXPECT_EQ(3u, registry.statistics(0).d_fields);
+
+    tick = Tick();
+    registry.update(&tick,
+            1,
+            firstMessage(marketDataEvent(blp::CorrelationId(1),
+                    "{\"BID\": 50.5, \"LAST_PRICE\": 51}")));
+    EXPECT_TRUE(std::isnan(tick.d_bid));
+    EXPECT_EQ(51, tick.d_lastPrice);
+    EXPECT_TRUE(std::isnan(registry.lastValues(1).d_bid));
+    EXPECT_EQ(1u, registry.sequence(1));
+    EXPECT_EQ(0u, registry.sequence(2));
+}
@@ -0,0 +1,348 @@
+/* Copyright 2021, Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_testutil.h>
+
+#include <util/events/SessionRouter.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+
+namespace blp = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name SUBSCRIPTION_STARTED("SubscriptionStarted");
+
+// 'TestSession' stands in for a session: the router only needs its event
+// handler interface, and passes the session through to the handlers.
+class TestSession {
+  public:
+    class EventHandler {
+      public:
+        virtual ~EventHandler() {}
+
+        virtual bool processEvent(
+                const blp::Event& event, TestSession *session)
+                = 0;
+    };
+};
+
+using Router = BloombergLP::SessionRouter<TestSession>;
+using Cids = std::vector<blp::CorrelationId>;
+
+// Return a SUBSCRIPTION_STATUS event of one 'SubscriptionStarted' message
+// per correlation id in the specified 'cids'.
+blp::Event subscriptionEvent(const Cids& cids)
+{
+    blp::Event event
+            = blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_STATUS);
+    const blp::SchemaElementDefinition schema
+            = blptst::TestUtil::getAdminMessageDefinition(
+                    SUBSCRIPTION_STARTED);
+    for (const blp::CorrelationId& cid : cids) {
+        blptst::MessageProperties properties;
+        properties.setCorrelationId(cid);
+        blptst::TestUtil::appendMessage(event, schema, properties);
+    }
+    return event;
+}
+
+// Return an automatically generated correlation id of the specified
+// 'value', as a session hands out.
+blp::CorrelationId autogenCid(long long value)
+{
+    blpapi_CorrelationId_t cid;
+    std::memset(&cid, 0, sizeof cid);
+    cid.size = sizeof cid;
+    cid.valueType = blp::CorrelationId::AUTOGEN_VALUE;
+    cid.value.intValue = value;
+    return blp::CorrelationId(cid);
+}
+
+// Return a handler appending the correlation id of each message it is
+// called for to the specified 'seen'.
+Router::MessageHandler recordInto(Cids *seen)
+{
+    return [seen](TestSession *, const blp::Event&, const blp::Message& msg) {
+        seen->push_back(msg.correlationId());
+    };
+}
+
+// 'CoutCapture' redirects 'std::cout' to a string while in scope.
+class CoutCapture {
+    std::ostringstream d_stream;
+    std::streambuf *d_original;
+
+  public:
+    CoutCapture()
+        : d_original(std::cout.rdbuf(d_stream.rdbuf()))
+    {
+    }
+
+    ~CoutCapture() { std::cout.rdbuf(d_original); }
+
+    std::string str() const { return d_stream.str(); }
+};
+}
+
+//
+// Concern:
+// Verify that messages reach the handlers of their integer correlation
+// ids, whether the ids registered are dense enough to be held in an array
+// or spread out so that they are hashed.
+//
+// Plan:
+// 1. Register handlers for the dense ids 1 to 10, and dispatch messages of
+//    ids 3, 10 and 11, and of id 3 of another class.
+// 2. Expect the handlers of ids 3 and 10 to be called, once each.
+// 3. Register handlers for ids far apart, including negative ones, and
+//    expect their messages to reach them, and those of ids between them
+//    to reach none.
+//
+TEST(SessionRouterTest, DispatchesDenseAndSparseIntegerCids)
+{
+    Router router;
+    TestSession session;
+    Cids seen;
+    for (long long id = 1; id <= 10; ++id) {
+        router.registerMessageHandler(
+                blp::CorrelationId(id), recordInto(&seen));
+    }
+    EXPECT_TRUE(router.processEvent(subscriptionEvent(Cids{
+                                            blp::CorrelationId(3),
+                                            blp::CorrelationId(10),
+                                            blp::CorrelationId(11),
+                                            blp::CorrelationId(3, 1) }),
+            &session));
+    ASSERT_EQ(2u, seen.size());
+    EXPECT_EQ(blp::CorrelationId(3), seen[0]);
+    EXPECT_EQ(blp::CorrelationId(10), seen[1]);
+
+    const long long sparse[] = { -5, 1000000, 1LL << 40 };
+    for (long long id : sparse) {
+        router.registerMessageHandler(
+                blp::CorrelationId(id), recordInto(&seen));
+    }
+    seen.clear();
+    EXPECT_TRUE(router.processEvent(subscriptionEvent(Cids{
+                                            blp::CorrelationId(1LL << 40),
+                                            blp::CorrelationId(500000),
+                                            blp::CorrelationId(-5),
+                                            blp::CorrelationId(7),
+                                            blp::CorrelationId(1000000) }),
+            &session));
+    ASSERT_EQ(4u, seen.size());
+    EXPECT_EQ(blp::CorrelationId(1LL << 40), seen[0]);
+    EXPECT_EQ(blp::CorrelationId(-5), seen[1]);
+    EXPECT_EQ(blp::CorrelationId(7), seen[2]);
+    EXPECT_EQ(blp::CorrelationId(1000000), seen[3]);
+}
+
+//
+// Concern:
+// Verify that messages reach the handlers of pointer and automatically
+// generated correlation ids, and that these are not mistaken for integer
+// ids of the same value.
+//
+// Plan:
+// 1. Register handlers for two pointer ids, an autogen id of value 3, and
+//    the integer id 3.
+// 2. Dispatch a message of each, and of an unregistered pointer and
+//    autogen id, and expect each registered one to reach its own handler.
+// 3. Deregister the autogen id, and expect its messages to reach none.
+//
+TEST(SessionRouterTest, DispatchesPointerAndAutogenCids)
+{
+    Router router;
+    TestSession session;
+    int first = 0;
+    int second = 0;
+    int unregistered = 0;
+    Cids pointers;
+    Cids autogens;
+    Cids integers;
+    router.registerMessageHandler(
+            blp::CorrelationId(&first), recordInto(&pointers));
+    router.registerMessageHandler(
+            blp::CorrelationId(&second), recordInto(&pointers));
+    router.registerMessageHandler(autogenCid(3), recordInto(&autogens));
+    router.registerMessageHandler(
+            blp::CorrelationId(3), recordInto(&integers));
+
+    const Cids cids{ blp::CorrelationId(&second),
+        autogenCid(3),
+        blp::CorrelationId(&unregistered),
+        blp::CorrelationId(3),
+        autogenCid(4),
+        blp::CorrelationId(&first) };
+    EXPECT_TRUE(router.processEvent(subscriptionEvent(cids), &session));
+    ASSERT_EQ(2u, pointers.size());
+    EXPECT_EQ(blp::CorrelationId(&second), pointers[0]);
+    EXPECT_EQ(blp::CorrelationId(&first), pointers[1]);
+    ASSERT_EQ(1u, autogens.size());
+    EXPECT_EQ(blp::CorrelationId::AUTOGEN_VALUE, autogens[0].valueType());
+    ASSERT_EQ(1u, integers.size());
+    EXPECT_EQ(blp::CorrelationId::INT_VALUE, integers[0].valueType());
+
+    router.deregisterMessageHandler(autogenCid(3));
+    EXPECT_TRUE(router.processEvent(subscriptionEvent(cids), &session));
+    EXPECT_EQ(1u, autogens.size());
+    EXPECT_EQ(4u, pointers.size());
+}
+
+//
+// Concern:
+// Verify that a handler may register and deregister handlers, itself
+// included, while it is being called, and that an event is dispatched to
+// the handlers registered when its dispatch started.
+//
+// Plan:
+// 1. Register a handler for id 1 that deregisters itself and registers a
+//    handler for id 2.
+// 2. Dispatch an event with messages of ids 1 and 2, and expect only the
+//    first handler to be called.
+// 3. Dispatch it again, and expect only the handler for id 2 to be called.
+//
+TEST(SessionRouterTest, RegistersFromInsideAHandler)
+{
+    Router router;
+    TestSession session;
+    Cids first;
+    Cids second;
+    router.registerMessageHandler(blp::CorrelationId(1),
+            [&](TestSession *,
+                    const blp::Event&,
+                    const blp::Message& msg) {
+                first.push_back(msg.correlationId());
+                router.deregisterMessageHandler(blp::CorrelationId(1));
+                router.registerMessageHandler(
+                        blp::CorrelationId(2), recordInto(&second));
+            });
+
+    const blp::Event event = subscriptionEvent(
+            Cids{ blp::CorrelationId(1), blp::CorrelationId(2) });
+    EXPECT_TRUE(router.processEvent(event, &session));
+    EXPECT_EQ(1u, first.size());
+    EXPECT_TRUE(second.empty());
+
+    EXPECT_TRUE(router.processEvent(event, &session));
+    EXPECT_EQ(1u, first.size());
+    ASSERT_EQ(1u, second.size());
+    EXPECT_EQ(blp::CorrelationId(2), second[0]);
+}
+
+//
+// Concern:
+// Verify that handlers may be registered and deregistered from another
+// thread while events are dispatched, without a handler that stays
+// registered missing a message.
+//
+// Plan:
+// 1. Register a handler for id 1 counting its messages.
+// 2. Dispatch events of ids 1 and 2 on one thread, while another thread
+//    registers and deregisters handlers for id 2 and for ids far enough
+//    apart to move the integer ids between the array and the hash table.
+// 3. Expect the handler for id 1 to be called once per event.
+//
+TEST(SessionRouterTest, RegistersWhileDispatching)
+{
+    const int k_EVENTS = 2000;
+    Router router;
+    TestSession session;
+    std::atomic<int> count(0);
+    router.registerMessageHandler(blp::CorrelationId(1),
+            [&count](TestSession *, const blp::Event&, const blp::Message&) {
+                ++count;
+            });
+
+    const blp::Event event = subscriptionEvent(
+            Cids{ blp::CorrelationId(1), blp::CorrelationId(2) });
+    std::atomic<bool> done(false);
+    std::thread registrar([&router, &done] {
+        const Router::MessageHandler ignore
+                = [](TestSession *, const blp::Event&, const blp::Message&) {
+                  };
+        for (long long i = 0; !done.load(); ++i) {
+            const blp::CorrelationId cid(i % 2 ? 2 : 1LL << 40);
+            router.registerMessageHandler(cid, ignore);
+            router.deregisterMessageHandler(cid);
+        }
+    });
+    for (int i = 0; i < k_EVENTS; ++i) {
+        EXPECT_TRUE(router.processEvent(event, &session));
+    }
+    done = true;
+    registrar.join();
+    EXPECT_EQ(k_EVENTS, count.load());
+}
+
+//
+// Concern:
+// Verify that events are printed to 'std::cout' only once asked to.
+//
+// Plan:
+// 1. Dispatch an event, and expect nothing printed.
+// 2. Turn printing on, dispatch it again, and expect its message printed.
+// 3. Turn printing off, and expect nothing printed.
+//
+TEST(SessionRouterTest, PrintsEventsWhenAsked)
+{
+    Router router;
+    TestSession session;
+    const blp::Event event
+            = subscriptionEvent(Cids{ blp::CorrelationId(1) });
+    {
+        CoutCapture capture;
+        EXPECT_TRUE(router.processEvent(event, &session));
+        EXPECT_EQ("", capture.str());
+    }
+    router.setPrintEvents(true);
+    {
+        CoutCapture capture;
+        EXPECT_TRUE(router.processEvent(event, &session));
+        EXPECT_THAT(capture.str(), HasSubstr("SubscriptionStarted"));
+    }
+    router.setPrintEvents(false);
+    {
+        CoutCapture capture;
+        EXPECT_TRUE(router.processEvent(event, &session));
+        EXPECT_EQ("", capture.str());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // The following line must be executed to initialize Google Mock (and
+    // Google Test) before running the tests.
+    ::testing::InitGoogleMock(&argc, argv);
+    return RUN_ALL_TESTS();
+}
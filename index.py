@@ -1,11 +1,10 @@
-import QuantLib as ql
 import numpy as np
 from flask import Flask, render_template, request
 from scipy.stats import norm
 from datetime import datetime
 from datetime import date
-from dateutil.parser import parse
 import bloom_api
+import bspricer
 from numpy import array
 from statistics import mean
 
@@ -16,6 +15,7 @@ app.add_url_rule('/Blackscholes_bloomberg_strikecall',view_func=bloom_api.Bloom_
 app.add_url_rule('/Blackscholes_bloomberg_bid_ask',view_func=bloom_api.Bloom_bid_ask_api, methods=['GET','POST'])
 app.add_url_rule('/Blackscholes_table_refresh',view_func=bloom_api.Bloom_refresh_api, methods=['GET','POST'])
 app.add_url_rule('/Blackscholes_bloomberg_Get_interest_rate',view_func=bloom_api.Bloom_get_interestrate, methods=['GET','POST'])
+app.add_url_rule('/Blackscholes_vol_surface',view_func=bloom_api.Bloom_surface_api, methods=['GET','POST'])
 
 
 @app.route('/Blackscholes_model')
@@ -24,6 +24,13 @@ def index():
     
 N = norm.cdf
 dt = date.today()
+#Chebyshev interpolants of the American legs of each ticker, so dragging the custom spot reprices without new finite difference solves
+#and the incremental pricer of each ticker on top of them, so a refresh that moves the spot by a few ticks is a Taylor update of the last valuation
+Chebyshev_pricers,Incremental_pricers={},{}
+#the scenario ladder of a strategy: 41 spots from -20% to +20%, 21 vols from -10 to +10 vol points and 5 horizons in days
+Ladder_spot_shifts=np.linspace(-0.2, 0.2, 41)
+Ladder_vol_shifts=np.linspace(-0.1, 0.1, 21)
+Ladder_horizon_days=np.array([0, 7, 30, 60, 90], dtype=np.float64)
 @app.route('/Blackscholes_model_form', methods=['GET','POST'])
 
 #main function
@@ -61,77 +68,36 @@ def BS_data():
     print("Dividend:", Dividend_array)   
     print("Dividend date:", Dividend_date_array) 
     
-#Todays date in Quantlib format
-    today_date_result=[]
-    for i in range(len(Maturity)):
-        date=datetime.strftime(dt, '%#d')
-        month=datetime.strftime(dt, '%#m')
-        year=datetime.strftime(dt, '%Y')
-        today_date=[]
-        today_date=[int(date)]
-        today_date.append(int(month))
-        today_date.append(int(year))
-        today_date_result.append(today_date)
-#print("Today's date", today_date_result)
-    
-    Maturity_date,Maturity_date_list=[],[]
-#for loop for converting the matrutiry into the quantlib maturity date format
-    for i in range(len(Maturity)):
-        datetime_str = Maturity[i]
-        new_datetime_str = datetime_str.replace("/", "-" )
-        datetime_object = datetime.strptime(new_datetime_str, '%m-%d-%y').date()
-        date=datetime.strftime(datetime_object, '%#d')
-        month=datetime.strftime(datetime_object, '%#m')
-        year=datetime.strftime(datetime_object, '%Y')
-        Maturity_date=[int(date)]
-        Maturity_date.append(int(month))
-        Maturity_date.append(int(year))
-        Maturity_date_list.append(Maturity_date)
-#print("Maturity_date :", Maturity_date_list)
-    
-    Matched_div_date,Updated_Matched_div_date=[],[]
-#for loop for converting the Dividend_date into the quantlib Dividend_date format
-    for i in range(len(Maturity)):
-        Matched_div_date=[]
-        for j in range(len(Dividend_date_array)):
-            date1 = parse(Maturity[i])
-            date2 = parse(Dividend_date_array[j])
-            if(date2 <= date1):
-                datetime_str=Dividend_date_array[j]
-                datetime_object = datetime.strptime(datetime_str, '%d-%m-%Y').date()
-                date=datetime.strftime(datetime_object, '%#d')
-                month=datetime.strftime(datetime_object, '%#m')
-                year=datetime.strftime(datetime_object, '%Y')
-                Dividend_date_list=[int(date)]
-                Dividend_date_list.append(int(month))
-                Dividend_date_list.append(int(year))
-                Matched_div_date.append([Dividend_date_list,Dividend_array[j]])
-        Updated_Matched_div_date.insert(i,Matched_div_date)
-#print('Updated_Matched_div_date',Updated_Matched_div_date)
-    
-#if divdates are less than maturity dates so the array will be empty to repalce the empty array with below hardcoded code
-    Empty_div_date=[today_date,0]
-    for i in Updated_Matched_div_date:
-        if(len(i)==0):
-            i.append(Empty_div_date)
-    print('Final Div with divdates',Updated_Matched_div_date)
-    
-#list for combining the entire data into one list except the divdate with dividend
-    combine_pricer_list_result=[]
-    combine_pricer_list= [today_date_result, Maturity_date_list, Spotprice, Strikeprice,Volatility, Interestrate, Option_data_zone, Option_type_data]
-    #print("combine_pricer_list:",combine_pricer_list)
-    
-#for loop for seperating the sublist into seperate lists according to the Quantlib foramt
-    for i in range(len(Maturity_date_list)):
-        value=list(list(list(list(list(list(list(list(list(zip(*combine_pricer_list)))))))))[i])
-        combine_pricer_list_result.append(value)
-#print("combine_pricer_list_result :", combine_pricer_list_result)
-
-#for loop appending the dividend with divdate list into the main list at required position using insert funciton
-    for i in range(len(combine_pricer_list_result)):
-        combine_pricer_list_result[i].insert(6,Updated_Matched_div_date[i])
-            
-    print(combine_pricer_list_result)
+#the valuation date is today, and when it moves the interpolants and last valuations of every ticker are dropped, as their expiries are year fractions from the old date
+    global dt
+    if date.today() != dt:
+        dt = date.today()
+        for i in Chebyshev_pricers:
+            Chebyshev_pricers[i].clear()
+            Incremental_pricers[i].clear()
+    
+#expiries and dividend ex-dates are parsed once into year fractions (Actual/365) from today, as the native pricer takes them
+    Maturity_dates=[datetime.strptime(i.replace("/", "-"), '%m-%d-%y').date() for i in Maturity]
+    Dividend_dates=[datetime.strptime(i, '%d-%m-%Y').date() for i in Dividend_date_array]
+    Expiry_legs=np.array([(i - dt).days for i in Maturity_dates], dtype=np.float64)/365.0
+    Div_times=np.array([(i - dt).days for i in Dividend_dates], dtype=np.float64)/365.0
+    Div_amounts=np.array(Dividend_array, dtype=np.float64)
+
+#the dividends of every leg are the ones still to be paid, after today and no later than its maturity, laid out flat leg after leg with the offsets of each leg
+    Div_mask=(Div_times[None, :] > 0) & (Div_times[None, :] <= Expiry_legs[:, None])
+    Div_offsets=np.concatenate(([0], np.cumsum(Div_mask.sum(axis=1)))).astype(np.int64)
+    Div_times_legs=np.broadcast_to(Div_times, Div_mask.shape)[Div_mask]
+    Div_amounts_legs=np.broadcast_to(Div_amounts, Div_mask.shape)[Div_mask]
+    print('Dividend offsets',Div_offsets)
+
+#contiguous arrays of every leg field, which the native pricer copies once per call
+    Spot_legs=np.array(Spotprice, dtype=np.float64)
+    Strike_legs=np.array(Strikeprice, dtype=np.float64)
+    Vol_legs=np.array(Volatility, dtype=np.float64)
+    Rate_legs=np.array(Interestrate, dtype=np.float64)
+    Is_A_legs=np.array(Option_data_zone, dtype=bool)
+    Is_c_legs=np.array(Option_type_data, dtype=bool)
+    Vol_array=Volatility
     
 #---------------------From here coding for the option strategy display structure----------------------
 # Function which initializes the monthsMap
@@ -303,56 +269,34 @@ def BS_data():
     
     
 #By declaring the function_return_result list and other lists before for loop helps to capture the values returning by the function inside the foor loop
-    function_return_result, function_return_result_1, Vol_array, Vol_array_1,Prices,Prices_1,Vega,Delta=[],[],[],[],[],[],[],[]
+    function_return_result,Prices,Vega,Delta=[],[],[],[]
     Adj_Bid, Adj_Ask, Adj_Bid_vol, Adj_Ask_vol=[],[],[],[]
     Our_Adj_Bid,Our_Adj_Ask=0,0
     Final_our_option_price=0
     Sum_of_vega=0
     
-    for i in combine_pricer_list_result:
-        for j in i:
-            v_d=(i[0])
-            e_d=(i[1])
-            u_p=(i[2])
-            s_p=(i[3])
-            vl=(i[4])
-            r_f=(i[5])
-            div=(i[6])
-            Is_A=(i[7])
-            Is_c=(i[8])
-        Vol_array.append(i[4])
-        
-        function_return_result.append(get_option_price(v_d , e_d , u_p, s_p, vl , r_f, div, Is_A, Is_c))
-        function_return_result_1.append(get_option_price_1(v_d , e_d , u_p, s_p, vl , r_f, div, Is_A, Is_c))
-      
-#function_return_result contains first options price followed by Delta and gamma
+#pricing all the legs of the strategy in one native call, which writes the price and greeks of every leg into the rows of Greeks with the GIL released
+#the incremental pricer of a ticker locks its last valuations, so requests for the same ticker take turns while other tickers price in parallel
+#legs that moved a little since the last valuation are Taylor updates, the others are read off the interpolants of the ticker
+#and a leg outside them is solved directly while its interpolant is rebuilt in the background
+    if Ticker[0] not in Incremental_pricers:
+        Chebyshev_pricers[Ticker[0]]=bspricer.ChebyshevPricer()
+        Incremental_pricers[Ticker[0]]=bspricer.IncrementalPricer(Chebyshev_pricers[Ticker[0]])
+    Greeks=np.empty((6, len(Spot_legs)))
+    Repriced_legs=Incremental_pricers[Ticker[0]].price_legs_into(Greeks, Spot_legs, Strike_legs, Vol_legs, Rate_legs, Expiry_legs, Is_A_legs, Is_c_legs, Div_offsets, Div_times_legs, Div_amounts_legs)
+    print('Legs repriced in full', Repriced_legs, Incremental_pricers[Ticker[0]].statistics())
+    
+#function_return_result contains first options price followed by Delta, gamma, vega, theta and rho
+    Leg_greeks=np.round(Greeks.T, 3)
+    function_return_result=Leg_greeks.tolist()
+    Prices=Leg_greeks[:, 0].tolist()
+    Delta=Leg_greeks[:, 1].tolist()
+    Vega=Leg_greeks[:, 3].tolist()
     print(function_return_result)
-
-#appending the options_prices of first function into Prices list
-    for i in function_return_result:
-        Prices.append(i[0])
-        Delta.append(i[1])
-    
-#appending the options_prices of second function into Prices_1 list
-    for i in function_return_result_1:
-        Prices_1.append(float(i))
-    
-#makeing the Vol_array values increase by 1% and store them in Vol_array_1 list
-    for i in Vol_array:
-        i=i+(0.01*i)
-        Vol_array_1.append(float("{0:.4f}".format(i)))
-    
-#Formula of Vega which is (P1-P2)/(V1-V2) and appending the vega and (option_price * multiple) to function_return_result list
-    for i in range(len(Prices)):
-        vega= (Prices[i]- Prices_1[i])/(Vol_array[i]-Vol_array_1[i])
-        Vega.append(float("{0:.3f}".format(vega)))
-        function_return_result[i].append(Vega[i])
         
     print("Multiple",Multiple)
     print("Prices", Prices)
-    #print("Prices_1", Prices_1)
     print("Vol_array", Vol_array)
-    #print("Vol_array_1", Vol_array_1)
     print("Vega", Vega)
     print('delta', Delta)
     print("option_prices_with_vega", function_return_result)
@@ -393,13 +337,19 @@ def BS_data():
 
 #for calculating the adjusted_bid_price, adjusted_ask_price using the Delta
 #formula =>Delta= (Market_Bid-finding_bid)/(Market_spot-Current_spot)
-#formula =>Vega = (Current_option_price-Market_bid_price)/(Current_option_vol-finding_vol)
+#the adjusted vols are the implied vols of the adjusted prices, solved for all the legs in one native call
+#formula =>Vega = (Current_option_price-Market_bid_price)/(Current_option_vol-finding_vol) is only the fallback for a quote that does not converge
     print("...........Adjusted_values..............")
     for i in range(len(Market_Bid_price)):
         Adj_Bid.append(float("{0:.3f}".format(Market_Bid_price[i] - Delta[i]*(Market_spot[0]-Spotprice[0]))))
         Adj_Ask.append(float("{0:.3f}".format(Market_Ask_price[i] - Delta[i]*(Market_spot[0]-Spotprice[0]))))
-        Adj_Bid_vol.append(float("{0:.3f}".format((Vol_array[i] - ((Prices[i] - Adj_Bid[i])/Vega[i])  )*100)))
-        Adj_Ask_vol.append(float("{0:.3f}".format((Vol_array[i] - ((Prices[i] - Adj_Ask[i])/Vega[i])  )*100))) 
+    Quotes=np.array([Adj_Bid, Adj_Ask])
+    Implied=np.empty(Quotes.shape)
+    Converged=np.empty(Quotes.shape, dtype=bool)
+    bspricer.implied_vols_into(Implied, Converged, Quotes, Spot_legs, Strike_legs, Vol_legs, Rate_legs, Expiry_legs, Is_A_legs, Is_c_legs, Div_offsets, Div_times_legs, Div_amounts_legs)
+    with np.errstate(divide='ignore', invalid='ignore'):
+        Fallback=Vol_legs - (np.array(Prices) - Quotes)/np.array(Vega)
+    Adj_Bid_vol, Adj_Ask_vol=np.round(np.where(Converged, Implied, Fallback)*100, 3).tolist()
 
     print('Adj_Bid',Adj_Bid)
     print('Adj_Ask',Adj_Ask)
@@ -441,122 +391,19 @@ def BS_data():
         Display_strategy= Display_strategy
     
     print(Display_strategy)
+
+#spot x vol x time P&L ladder of the strategy, valued on all cores in one native call into a dense (horizons, vols, spots) array
+#the P&L is against the value today at the current spot and vol, the centre of the first horizon
+#the vol shifts that would take the lowest vol leg below one vol point are dropped rather than floored, so every row returned is the shift it is labelled with
+    Vol_shifts=Ladder_vol_shifts[(Ladder_vol_shifts >= 0.01 - Vol_legs.min()) | (Ladder_vol_shifts == 0)]
+    Ladder=np.empty((len(Ladder_horizon_days), len(Vol_shifts), len(Ladder_spot_shifts)))
+    bspricer.scenario_ladder_into(Ladder, np.array(Multiple, dtype=np.float64), Ladder_spot_shifts, Vol_shifts, Ladder_horizon_days/365.0, Spot_legs, Strike_legs, Vol_legs, Rate_legs, Expiry_legs, Is_A_legs, Is_c_legs, Div_offsets, Div_times_legs, Div_amounts_legs)
+    Scenario_ladder=np.round(Ladder - Ladder[0, np.argmin(np.abs(Vol_shifts)), len(Ladder_spot_shifts)//2], 2).tolist()
     
     return {'Display_strategy':Display_strategy, 'display_options_data':option_price_value_result, 'Adj_Bid':Adj_Bid, 'Adj_Ask':Adj_Ask,'Adj_Bid_vol':Adj_Bid_vol,
-            'Adj_Ask_vol':Adj_Ask_vol,'Sum_vol_array':Sum_vol_array, 'Sum_of_vega':Sum_of_vega, 'Sum_Adj_Bid_vol':Sum_Adj_Bid_vol, 'Sum_Adj_Ask_vol':Sum_Adj_Ask_vol, 'Our_Adj_Bid':Our_Adj_Bid,'Our_Adj_Ask': Our_Adj_Ask, 'Final_our_option_price':Final_our_option_price  }
-
-
-
-def get_option_price(valuation_date, expiry_date, underlying_price, strike_price, volatility, risk_free_rate, dividends, is_american ,is_call ):
-    new_value= 0
-    div_dates= []
-    div_values= []
-    for div in dividends:
-            date = div[0]
-            value = div[1]
-            div_values.append(value)
-            div_dates.append(ql.Date(*date))
-
-#Reformat dates from list into QL date format
-    valuation_date = ql.Date(*valuation_date)
-    expiry_date = ql.Date(*expiry_date)
-    ql.Settings.instance().setEvaluationDate(valuation_date)
-    day_count = ql.Actual365Fixed()
-    calendar = ql.UnitedStates()
-
-#Reformat prices and rates from list into QL format
-    underlying_price = ql.QuoteHandle(ql.SimpleQuote(underlying_price))
-    risk_free_rate = ql.YieldTermStructureHandle(ql.FlatForward(valuation_date, risk_free_rate, day_count))
-    volatility = ql.BlackVolTermStructureHandle(ql.BlackConstantVol(valuation_date, calendar, volatility, day_count))
-
-    if is_call:
-        payoff = ql.PlainVanillaPayoff(ql.Option.Call, strike_price)
-    else:
-        payoff = ql.PlainVanillaPayoff(ql.Option.Put, strike_price)
-    if is_american:
-        exercise = ql.AmericanExercise(valuation_date, expiry_date)
-    else:
-        exercise = ql.EuropeanExercise(expiry_date)
-    option = ql.DividendVanillaOption(payoff, exercise, div_dates, div_values)
-
-#Black Scholes process
-    process = ql.BlackScholesProcess(underlying_price,risk_free_rate,volatility)
-
-#Create option's pricing engine
-    precision_steps = 1000
-    engine = ql.FdBlackScholesVanillaEngine(process, precision_steps, precision_steps - 1)
-    option.setPricingEngine(engine)
-
-#Price the option
-    new_value="{0:.3f}".format(option.NPV())
-    
-    Delta="{0:.3f}".format(option.delta())
-    Gamma="{0:.3f}".format(option.gamma())
-    Greeks =[]
-#Greeks.append(volatility)
-    Greeks.append(float(new_value))
-    Greeks.append(float(Delta))
-    Greeks.append(float(Gamma))
-
-    return Greeks
-
-
-
-def get_option_price_1(valuation_date, expiry_date, underlying_price, strike_price, volatility, risk_free_rate, dividends, is_american ,is_call ):
-    new_value= 0
-    div_dates = []
-    div_values = []
-    volatility= volatility +(0.01*volatility)
-    
-    for div in dividends:
-            date = div[0]
-            value = div[1]
-            div_values.append(value)
-            div_dates.append(ql.Date(*date))
-
-#Reformat dates from list into QL date format
-    valuation_date = ql.Date(*valuation_date)
-    expiry_date = ql.Date(*expiry_date)
-    ql.Settings.instance().setEvaluationDate(valuation_date)
-    day_count = ql.Actual365Fixed()
-    calendar = ql.UnitedStates()
-
-#Reformat prices and rates from list into QL format
-    underlying_price = ql.QuoteHandle(ql.SimpleQuote(underlying_price))
-    risk_free_rate = ql.YieldTermStructureHandle(ql.FlatForward(valuation_date, risk_free_rate, day_count))
-    volatility = ql.BlackVolTermStructureHandle(ql.BlackConstantVol(valuation_date, calendar, volatility, day_count))
-
-#Create option
-    if is_call:
-        payoff = ql.PlainVanillaPayoff(ql.Option.Call, strike_price)
-    else:
-        payoff = ql.PlainVanillaPayoff(ql.Option.Put, strike_price)
-    if is_american:
-        exercise = ql.AmericanExercise(valuation_date, expiry_date)
-    else:
-        exercise = ql.EuropeanExercise(expiry_date)
-    option = ql.DividendVanillaOption(payoff, exercise, div_dates, div_values)
-
-#Black Scholes process
-    process = ql.BlackScholesProcess(underlying_price, risk_free_rate,volatility)
-
-#Create option's pricing engine
-    precision_steps = 1000
-    engine = ql.FdBlackScholesVanillaEngine(process, precision_steps, precision_steps - 1)
-    option.setPricingEngine(engine)
-
-#Price the option
-    new_value="{0:.3f}".format(option.NPV())
-#print("Delta:", option.delta())
-#print("gamma:", option.gamma())
-    
-    Delta=option.delta()
-    Gamma=option.gamma()
-    Greeks =[]
-    Greeks.append(Delta)
-    Greeks.append(Gamma)
+            'Adj_Ask_vol':Adj_Ask_vol,'Sum_vol_array':Sum_vol_array, 'Sum_of_vega':Sum_of_vega, 'Sum_Adj_Bid_vol':Sum_Adj_Bid_vol, 'Sum_Adj_Ask_vol':Sum_Adj_Ask_vol, 'Our_Adj_Bid':Our_Adj_Bid,'Our_Adj_Ask': Our_Adj_Ask, 'Final_our_option_price':Final_our_option_price,
+            'Scenario_ladder':Scenario_ladder, 'Ladder_spot_shifts':Ladder_spot_shifts.tolist(), 'Ladder_vol_shifts':Vol_shifts.tolist(), 'Ladder_horizon_days':Ladder_horizon_days.tolist()  }
 
-    return new_value
 
 
 app.run(port=4004,  host='0.0.0.0', debug=True)
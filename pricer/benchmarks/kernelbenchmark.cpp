@@ -0,0 +1,216 @@
+// Throughput of the European kernels specialized by payoff against the
+// generic kernel, of the kernels with and without a yield, of the analytic
+// engine with and without discrete dividends, and of the finite difference
+// rollback specialized by type, exercise and dividend mode against the
+// generic rollback. Run with an optional number of options:
+//     pricerbenchmarks [options]
+
+#include <analyticengine.h>
+#include <europeankernel.h>
+#include <fdengine.h>
+#include <legbatch.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace pricer;
+
+namespace {
+
+const int k_REPEATS = 20;
+const int k_FD_REPEATS = 3;
+const std::size_t k_MAX_FD_LEGS = 512; // each leg takes a full solve
+
+// Options laid out as the kernel expects, calls first, then puts.
+struct Batch {
+    std::vector<double> d_spot, d_strike, d_vol, d_rate, d_yield, d_expiry;
+    std::vector<char> d_isCall;
+    std::vector<double> d_out[8];
+
+    explicit Batch(std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            d_spot.push_back(100.0);
+            d_strike.push_back(60.0 + 0.8 * (i % 101));
+            d_vol.push_back(0.1 + 0.005 * (i % 77));
+            d_rate.push_back(0.03);
+            d_yield.push_back(0.0);
+            d_expiry.push_back(0.02 + 0.01 * (i % 199));
+            d_isCall.push_back(i < n / 2);
+        }
+        for (int m = 0; m < 8; ++m) {
+            d_out[m].assign(n, 0.0);
+        }
+    }
+
+    // Price the options in [begin, end) with the kernel for `payoff`, with
+    // the yields if `withYield`.
+    void price(std::size_t begin,
+            std::size_t end,
+            EuropeanKernel::Isa isa,
+            EuropeanKernel::Payoff payoff,
+            bool withYield)
+    {
+        const EuropeanInputs inputs = { &d_spot[begin], &d_strike[begin],
+            &d_vol[begin], &d_rate[begin],
+            withYield ? &d_yield[begin] : 0, &d_expiry[begin],
+            &d_isCall[begin], end - begin };
+        const EuropeanOutputs outputs = { &d_out[0][begin],
+            &d_out[1][begin], &d_out[2][begin], &d_out[3][begin],
+            &d_out[4][begin], &d_out[5][begin], &d_out[6][begin],
+            &d_out[7][begin] };
+        EuropeanKernel::price(outputs,
+                inputs,
+                EuropeanKernel::e_BLACK_SCHOLES,
+                isa,
+                payoff);
+    }
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void report(const char *name, std::size_t n, double best)
+{
+    std::printf("%-40s %8.1f M options/s\n", name, n / best * 1e-6);
+}
+
+void reportSolves(const char *name, std::size_t n, double best)
+{
+    std::printf("%-40s %8.0f legs/s\n", name, n / best);
+}
+
+} // close unnamed namespace
+
+int main(int argc, char **argv)
+{
+    const std::size_t n = argc > 1 ? std::strtoul(argv[1], 0, 10) : 1 << 16;
+    if (n < 2) {
+        std::fprintf(stderr, "usage: %s [options >= 2]\n", argv[0]);
+        return 1;
+    }
+    Batch batch(n);
+    const std::size_t half = n / 2;
+
+    for (int isa = EuropeanKernel::e_SCALAR; isa <= EuropeanKernel::bestIsa();
+            ++isa) {
+        const EuropeanKernel::Isa which = EuropeanKernel::Isa(isa);
+        std::printf("%s, %lu options\n",
+                EuropeanKernel::isaName(which),
+                static_cast<unsigned long>(n));
+
+        // On the same options with no yield, the generic kernel reads the
+        // payoff of every option and the specialized kernels price the
+        // calls and the puts as two groups. The generic kernel is then
+        // timed carrying a zero yield, which the others skip.
+        double generic = 1e30;
+        double specialized = 1e30;
+        double withYield = 1e30;
+        for (int r = 0; r < k_REPEATS; ++r) {
+            Clock::time_point start = Clock::now();
+            batch.price(0, n, which, EuropeanKernel::e_MIXED, false);
+            generic = std::min(generic, seconds(start));
+
+            start = Clock::now();
+            batch.price(0, half, which, EuropeanKernel::e_CALLS, false);
+            batch.price(half, n, which, EuropeanKernel::e_PUTS, false);
+            specialized = std::min(specialized, seconds(start));
+
+            start = Clock::now();
+            batch.price(0, n, which, EuropeanKernel::e_MIXED, true);
+            withYield = std::min(withYield, seconds(start));
+        }
+        report("  generic kernel", n, generic);
+        report("  specialized kernels", n, specialized);
+        report("  generic kernel with a zero yield", n, withYield);
+    }
+
+    // The engine prices legs without dividends on their own spot, and the
+    // others on the escrowed spot.
+    LegBatch plain;
+    LegBatch dividends;
+    const std::vector<double> times(1, 0.01);
+    const std::vector<double> amounts(1, 0.5);
+    for (std::size_t i = 0; i < n; ++i) {
+        plain.addLeg(batch.d_spot[i],
+                batch.d_strike[i],
+                batch.d_vol[i],
+                batch.d_rate[i],
+                batch.d_expiry[i],
+                batch.d_isCall[i] != 0,
+                false);
+        dividends.addLeg(batch.d_spot[i],
+                batch.d_strike[i],
+                batch.d_vol[i],
+                batch.d_rate[i],
+                batch.d_expiry[i],
+                batch.d_isCall[i] != 0,
+                false,
+                times,
+                amounts);
+    }
+    const AnalyticEngine engine;
+    PricingResults results;
+    results.resize(n);
+    std::vector<char> priced;
+    double withoutDividends = 1e30;
+    double withDividends = 1e30;
+    for (int r = 0; r < k_REPEATS; ++r) {
+        Clock::time_point start = Clock::now();
+        engine.price(results.outputs(), &priced, plain);
+        withoutDividends = std::min(withoutDividends, seconds(start));
+
+        start = Clock::now();
+        engine.price(results.outputs(), &priced, dividends);
+        withDividends = std::min(withDividends, seconds(start));
+    }
+    std::printf("analytic engine, %lu legs\n", static_cast<unsigned long>(n));
+    report("  no dividends", n, withoutDividends);
+    report("  discrete dividends", n, withDividends);
+
+    // The same legs, of every type, exercise and dividend mode, are solved
+    // by finite differences with the generic and the specialized rollback.
+    LegBatch fdLegs;
+    const std::size_t fdCount = std::min(n, k_MAX_FD_LEGS);
+    std::vector<std::size_t> indices;
+    for (std::size_t i = 0; i < fdCount; ++i) {
+        fdLegs.addLeg(batch.d_spot[i],
+                batch.d_strike[i],
+                batch.d_vol[i],
+                batch.d_rate[i],
+                batch.d_expiry[i],
+                i % 2 == 0,
+                i % 4 < 2,
+                i % 8 < 4 ? times : std::vector<double>(),
+                i % 8 < 4 ? amounts : std::vector<double>());
+        indices.push_back(i);
+    }
+    FdEngine::Config genericConfig;
+    genericConfig.d_specialized = false;
+    const FdEngine genericEngine(genericConfig);
+    const FdEngine specializedEngine;
+    results.resize(fdCount);
+    double genericRollback = 1e30;
+    double specializedRollback = 1e30;
+    for (int r = 0; r < k_FD_REPEATS; ++r) {
+        Clock::time_point start = Clock::now();
+        genericEngine.price(results.outputs(), fdLegs, indices);
+        genericRollback = std::min(genericRollback, seconds(start));
+
+        start = Clock::now();
+        specializedEngine.price(results.outputs(), fdLegs, indices);
+        specializedRollback = std::min(specializedRollback, seconds(start));
+    }
+    std::printf("finite difference engine, %lu legs\n",
+            static_cast<unsigned long>(fdCount));
+    reportSolves("  generic rollback", fdCount, genericRollback);
+    reportSolves("  specialized rollbacks", fdCount, specializedRollback);
+    return 0;
+}
@@ -0,0 +1,943 @@
+#include <batchpricer.h>
+#include <chebyshevpricer.h>
+#include <discountcurve.h>
+#include <europeankernel.h>
+#include <forwardengine.h>
+#include <impliedvolsolver.h>
+#include <incrementalpricer.h>
+#include <legbatch.h>
+#include <scenarioengine.h>
+#include <volsurface.h>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace {
+
+typedef std::vector<double> Doubles;
+
+// Inputs of another type or layout are converted by pybind11, and loadLegs
+// then copies every input once into the LegBatch the pricers take. Outputs
+// are never converted, so the results land in the caller's buffer or the
+// call fails.
+typedef py::array_t<double, py::array::c_style | py::array::forcecast>
+        DoubleArray;
+typedef py::array_t<bool, py::array::c_style | py::array::forcecast>
+        BoolArray;
+typedef py::array_t<std::int64_t, py::array::c_style | py::array::forcecast>
+        OffsetArray;
+typedef py::array_t<double, py::array::c_style> DoubleBuffer;
+typedef py::array_t<bool, py::array::c_style> BoolBuffer;
+
+void loadLegs(pricer::LegBatch *legs,
+        const DoubleArray& spot,
+        const DoubleArray& strike,
+        const DoubleArray& vol,
+        const DoubleArray& rate,
+        const DoubleArray& expiry,
+        const BoolArray& isAmerican,
+        const BoolArray& isCall,
+        const OffsetArray& dividendOffsets,
+        const DoubleArray& dividendTimes,
+        const DoubleArray& dividendAmounts)
+{
+    const py::ssize_t n = spot.size();
+    if (strike.size() != n || vol.size() != n || rate.size() != n
+            || expiry.size() != n || isAmerican.size() != n
+            || isCall.size() != n || dividendOffsets.size() != n + 1
+            || dividendTimes.size() != dividendAmounts.size()) {
+        throw std::invalid_argument("leg arrays differ in length");
+    }
+    const std::int64_t *offsets = dividendOffsets.data();
+    for (py::ssize_t i = 0; i < n; ++i) {
+        if (offsets[i + 1] < offsets[i]) {
+            throw std::invalid_argument(
+                    "dividend offsets are not increasing");
+        }
+    }
+    if (offsets[0] != 0 || offsets[n] != dividendTimes.size()) {
+        throw std::invalid_argument(
+                "dividend offsets do not cover the dividends");
+    }
+
+    legs->d_spot.assign(spot.data(), spot.data() + n);
+    legs->d_strike.assign(strike.data(), strike.data() + n);
+    legs->d_vol.assign(vol.data(), vol.data() + n);
+    legs->d_rate.assign(rate.data(), rate.data() + n);
+    legs->d_expiry.assign(expiry.data(), expiry.data() + n);
+    legs->d_isAmerican.assign(isAmerican.data(), isAmerican.data() + n);
+    legs->d_isCall.assign(isCall.data(), isCall.data() + n);
+    legs->d_dividendOffsets.assign(offsets, offsets + n + 1);
+    legs->d_dividendTimes.assign(dividendTimes.data(),
+            dividendTimes.data() + dividendTimes.size());
+    legs->d_dividendAmounts.assign(dividendAmounts.data(),
+            dividendAmounts.data() + dividendAmounts.size());
+}
+
+void makeLegs(pricer::LegBatch *legs,
+        const Doubles& spot,
+        const Doubles& strike,
+        const Doubles& vol,
+        const Doubles& rate,
+        const Doubles& expiry,
+        const std::vector<bool>& isAmerican,
+        const std::vector<bool>& isCall,
+        const std::vector<Doubles>& dividendTimes,
+        const std::vector<Doubles>& dividendAmounts)
+{
+    const std::size_t n = spot.size();
+    if (strike.size() != n || vol.size() != n || rate.size() != n
+            || expiry.size() != n || isAmerican.size() != n
+            || isCall.size() != n || dividendTimes.size() != n
+            || dividendAmounts.size() != n) {
+        throw std::invalid_argument("leg arrays differ in length");
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+        legs->addLeg(spot[i],
+                strike[i],
+                vol[i],
+                rate[i],
+                expiry[i],
+                isCall[i],
+                isAmerican[i],
+                dividendTimes[i],
+                dividendAmounts[i]);
+    }
+}
+
+py::dict priceLegs(const Doubles& spot,
+        const Doubles& strike,
+        const Doubles& vol,
+        const Doubles& rate,
+        const Doubles& expiry,
+        const std::vector<bool>& isAmerican,
+        const std::vector<bool>& isCall,
+        const std::vector<Doubles>& dividendTimes,
+        const std::vector<Doubles>& dividendAmounts)
+{
+    pricer::LegBatch legs;
+    makeLegs(&legs,
+            spot,
+            strike,
+            vol,
+            rate,
+            expiry,
+            isAmerican,
+            isCall,
+            dividendTimes,
+            dividendAmounts);
+
+    pricer::PricingResults results;
+    {
+        py::gil_scoped_release release;
+        pricer::BatchPricer().price(&results, legs);
+    }
+
+    py::dict out;
+    out["price"] = results.d_price;
+    out["delta"] = results.d_delta;
+    out["gamma"] = results.d_gamma;
+    out["vega"] = results.d_vega;
+    out["theta"] = results.d_theta;
+    out["rho"] = results.d_rho;
+    return out;
+}
+
+py::dict impliedVols(const Doubles& price,
+        const Doubles& spot,
+        const Doubles& strike,
+        const Doubles& vol,
+        const Doubles& rate,
+        const Doubles& expiry,
+        const std::vector<bool>& isAmerican,
+        const std::vector<bool>& isCall,
+        const std::vector<Doubles>& dividendTimes,
+        const std::vector<Doubles>& dividendAmounts)
+{
+    pricer::LegBatch legs;
+    makeLegs(&legs,
+            spot,
+            strike,
+            vol,
+            rate,
+            expiry,
+            isAmerican,
+            isCall,
+            dividendTimes,
+            dividendAmounts);
+
+    pricer::ImpliedVols vols;
+    {
+        py::gil_scoped_release release;
+        pricer::ImpliedVolSolver().solve(&vols, legs, price);
+    }
+
+    py::dict out;
+    out["vol"] = vols.d_vol;
+    out["converged"] = std::vector<bool>(
+            vols.d_converged.begin(), vols.d_converged.end());
+    out["iterations"] = vols.d_iterations;
+    return out;
+}
+
+void priceLegsInto(DoubleBuffer greeks,
+        const DoubleArray& spot,
+        const DoubleArray& strike,
+        const DoubleArray& vol,
+        const DoubleArray& rate,
+        const DoubleArray& expiry,
+        const BoolArray& isAmerican,
+        const BoolArray& isCall,
+        const OffsetArray& dividendOffsets,
+        const DoubleArray& dividendTimes,
+        const DoubleArray& dividendAmounts)
+{
+    pricer::LegBatch legs;
+    loadLegs(&legs,
+            spot,
+            strike,
+            vol,
+            rate,
+            expiry,
+            isAmerican,
+            isCall,
+            dividendOffsets,
+            dividendTimes,
+            dividendAmounts);
+
+    const py::ssize_t n = legs.size();
+    if (greeks.ndim() != 2 || greeks.shape(0) != 6 || greeks.shape(1) != n) {
+        throw std::invalid_argument("greeks must have shape (6, legs)");
+    }
+    double *out = greeks.mutable_data();
+    const pricer::PricingOutputs outputs = { out, out + n, out + 2 * n,
+        out + 3 * n, out + 4 * n, out + 5 * n };
+
+    py::gil_scoped_release release;
+    pricer::BatchPricer().price(outputs, legs);
+}
+
+void impliedVolsInto(DoubleBuffer vols,
+        BoolBuffer converged,
+        const DoubleArray& price,
+        const DoubleArray& spot,
+        const DoubleArray& strike,
+        const DoubleArray& vol,
+        const DoubleArray& rate,
+        const DoubleArray& expiry,
+        const BoolArray& isAmerican,
+        const BoolArray& isCall,
+        const OffsetArray& dividendOffsets,
+        const DoubleArray& dividendTimes,
+        const DoubleArray& dividendAmounts)
+{
+    pricer::LegBatch legs;
+    loadLegs(&legs,
+            spot,
+            strike,
+            vol,
+            rate,
+            expiry,
+            isAmerican,
+            isCall,
+            dividendOffsets,
+            dividendTimes,
+            dividendAmounts);
+
+    // Each row of `price` is one set of quotes on the legs, such as the
+    // bids and the asks.
+    const py::ssize_t n = legs.size();
+    if (price.ndim() != 2 || price.shape(1) != n || vols.ndim() != 2
+            || vols.shape(0) != price.shape(0) || vols.shape(1) != n
+            || converged.ndim() != 2
+            || converged.shape(0) != price.shape(0)
+            || converged.shape(1) != n) {
+        throw std::invalid_argument(
+                "prices and outputs must have shape (rows, legs)");
+    }
+    const py::ssize_t rows = price.shape(0);
+    const double *quotes = price.data();
+    double *out = vols.mutable_data();
+    // A NumPy bool is one byte holding 0 or 1, as the char flags are.
+    char *flags = reinterpret_cast<char *>(converged.mutable_data());
+
+    py::gil_scoped_release release;
+    const pricer::ImpliedVolSolver solver;
+    for (py::ssize_t row = 0; row < rows; ++row) {
+        const pricer::ImpliedVolOutputs outputs = { out + row * n,
+            flags + row * n, 0 };
+        solver.solve(outputs, legs, quotes + row * n);
+    }
+}
+
+void scenarioLadderInto(DoubleBuffer values,
+        const DoubleArray& quantity,
+        const DoubleArray& spotShifts,
+        const DoubleArray& volShifts,
+        const DoubleArray& horizons,
+        const DoubleArray& spot,
+        const DoubleArray& strike,
+        const DoubleArray& vol,
+        const DoubleArray& rate,
+        const DoubleArray& expiry,
+        const BoolArray& isAmerican,
+        const BoolArray& isCall,
+        const OffsetArray& dividendOffsets,
+        const DoubleArray& dividendTimes,
+        const DoubleArray& dividendAmounts)
+{
+    pricer::LegBatch legs;
+    loadLegs(&legs,
+            spot,
+            strike,
+            vol,
+            rate,
+            expiry,
+            isAmerican,
+            isCall,
+            dividendOffsets,
+            dividendTimes,
+            dividendAmounts);
+
+    pricer::ScenarioGrid grid;
+    grid.d_spotShifts.assign(spotShifts.data(),
+            spotShifts.data() + spotShifts.size());
+    grid.d_volShifts.assign(volShifts.data(),
+            volShifts.data() + volShifts.size());
+    grid.d_horizons.assign(horizons.data(),
+            horizons.data() + horizons.size());
+    if (values.ndim() != 3 || values.shape(0) != horizons.size()
+            || values.shape(1) != volShifts.size()
+            || values.shape(2) != spotShifts.size()) {
+        throw std::invalid_argument(
+                "values must have shape (horizons, vol shifts, spot shifts)");
+    }
+    const Doubles quantities(quantity.data(),
+            quantity.data() + quantity.size());
+    double *out = values.mutable_data();
+
+    py::gil_scoped_release release;
+    pricer::ScenarioEngine().value(out, legs, quantities, grid);
+}
+
+std::size_t chebyshevPriceInto(pricer::ChebyshevPricer *chebyshev,
+        DoubleBuffer greeks,
+        const DoubleArray& spot,
+        const DoubleArray& strike,
+        const DoubleArray& vol,
+        const DoubleArray& rate,
+        const DoubleArray& expiry,
+        const BoolArray& isAmerican,
+        const BoolArray& isCall,
+        const OffsetArray& dividendOffsets,
+        const DoubleArray& dividendTimes,
+        const DoubleArray& dividendAmounts)
+{
+    pricer::LegBatch legs;
+    loadLegs(&legs,
+            spot,
+            strike,
+            vol,
+            rate,
+            expiry,
+            isAmerican,
+            isCall,
+            dividendOffsets,
+            dividendTimes,
+            dividendAmounts);
+
+    const py::ssize_t n = legs.size();
+    if (greeks.ndim() != 2 || greeks.shape(0) != 6 || greeks.shape(1) != n) {
+        throw std::invalid_argument("greeks must have shape (6, legs)");
+    }
+    double *out = greeks.mutable_data();
+    const pricer::PricingOutputs outputs = { out, out + n, out + 2 * n,
+        out + 3 * n, out + 4 * n, out + 5 * n };
+
+    py::gil_scoped_release release;
+    return chebyshev->price(outputs, legs);
+}
+
+void chebyshevPrepare(pricer::ChebyshevPricer *chebyshev,
+        const DoubleArray& spot,
+        const DoubleArray& strike,
+        const DoubleArray& vol,
+        const DoubleArray& rate,
+        const DoubleArray& expiry,
+        const BoolArray& isAmerican,
+        const BoolArray& isCall,
+        const OffsetArray& dividendOffsets,
+        const DoubleArray& dividendTimes,
+        const DoubleArray& dividendAmounts)
+{
+    pricer::LegBatch legs;
+    loadLegs(&legs,
+            spot,
+            strike,
+            vol,
+            rate,
+            expiry,
+            isAmerican,
+            isCall,
+            dividendOffsets,
+            dividendTimes,
+            dividendAmounts);
+
+    py::gil_scoped_release release;
+    chebyshev->prepare(legs);
+}
+
+pricer::IncrementalPricer *makeIncrementalPricer(
+        pricer::ChebyshevPricer *surfaces,
+        double spotMove,
+        double volMove,
+        double rateMove,
+        double tolerance)
+{
+    pricer::IncrementalPricer::Config config;
+    config.d_spotMove = spotMove;
+    config.d_volMove = volMove;
+    config.d_rateMove = rateMove;
+    config.d_tolerance = tolerance;
+    return new pricer::IncrementalPricer(config, surfaces);
+}
+
+std::size_t incrementalPriceInto(pricer::IncrementalPricer *incremental,
+        DoubleBuffer greeks,
+        const DoubleArray& spot,
+        const DoubleArray& strike,
+        const DoubleArray& vol,
+        const DoubleArray& rate,
+        const DoubleArray& expiry,
+        const BoolArray& isAmerican,
+        const BoolArray& isCall,
+        const OffsetArray& dividendOffsets,
+        const DoubleArray& dividendTimes,
+        const DoubleArray& dividendAmounts)
+{
+    pricer::LegBatch legs;
+    loadLegs(&legs,
+            spot,
+            strike,
+            vol,
+            rate,
+            expiry,
+            isAmerican,
+            isCall,
+            dividendOffsets,
+            dividendTimes,
+            dividendAmounts);
+
+    const py::ssize_t n = legs.size();
+    if (greeks.ndim() != 2 || greeks.shape(0) != 6 || greeks.shape(1) != n) {
+        throw std::invalid_argument("greeks must have shape (6, legs)");
+    }
+    double *out = greeks.mutable_data();
+    const pricer::PricingOutputs outputs = { out, out + n, out + 2 * n,
+        out + 3 * n, out + 4 * n, out + 5 * n };
+
+    // The pricer locks its anchors, so Flask threads pricing the same
+    // ticker wait for each other rather than for the GIL.
+    py::gil_scoped_release release;
+    return incremental->price(outputs, legs);
+}
+
+py::dict incrementalStatistics(const pricer::IncrementalPricer& incremental)
+{
+    const pricer::IncrementalPricer::Statistics statistics
+            = incremental.statistics();
+    const std::size_t legs = statistics.d_updates + statistics.d_reprices;
+    const std::size_t anchored
+            = statistics.d_updates + statistics.d_fallbacks;
+
+    py::dict out;
+    out["updates"] = statistics.d_updates;
+    out["reprices"] = statistics.d_reprices;
+    out["fallbacks"] = statistics.d_fallbacks;
+    out["hit_rate"] = legs ? double(statistics.d_updates) / legs : 0.0;
+    out["fallback_rate"]
+            = anchored ? double(statistics.d_fallbacks) / anchored : 0.0;
+    return out;
+}
+
+py::dict priceEuropean(const Doubles& spot,
+        const Doubles& strike,
+        const Doubles& vol,
+        const Doubles& rate,
+        const Doubles& dividendYield,
+        const Doubles& expiry,
+        const std::vector<bool>& isCall,
+        bool black76)
+{
+    const std::size_t n = spot.size();
+    if (strike.size() != n || vol.size() != n || rate.size() != n
+            || dividendYield.size() != n || expiry.size() != n
+            || isCall.size() != n) {
+        throw std::invalid_argument("option arrays differ in length");
+    }
+
+    const std::vector<char> calls(isCall.begin(), isCall.end());
+    Doubles values[8];
+    for (int i = 0; i < 8; ++i) {
+        values[i].resize(n);
+    }
+    const char *names[] = { "price", "delta", "gamma", "vega", "theta",
+        "rho", "vanna", "volga" };
+    py::dict out;
+    if (n == 0) {
+        for (int i = 0; i < 8; ++i) {
+            out[names[i]] = values[i];
+        }
+        return out;
+    }
+
+    const pricer::EuropeanInputs inputs = { &spot[0], &strike[0], &vol[0],
+        &rate[0], &dividendYield[0], &expiry[0], &calls[0], n };
+    const pricer::EuropeanOutputs outputs = { &values[0][0], &values[1][0],
+        &values[2][0], &values[3][0], &values[4][0], &values[5][0],
+        &values[6][0], &values[7][0] };
+    {
+        py::gil_scoped_release release;
+        pricer::EuropeanKernel::price(outputs,
+                inputs,
+                black76 ? pricer::EuropeanKernel::e_BLACK76
+                        : pricer::EuropeanKernel::e_BLACK_SCHOLES);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        out[names[i]] = values[i];
+    }
+    return out;
+}
+
+py::dict priceChain(double spot,
+        double rate,
+        double expiry,
+        const Doubles& strike,
+        const Doubles& vol,
+        const Doubles& dividendTimes,
+        const Doubles& dividendAmounts)
+{
+    if (vol.size() != strike.size()) {
+        throw std::invalid_argument("strikes and vols differ in length");
+    }
+    if (dividendTimes.size() != dividendAmounts.size()) {
+        throw std::invalid_argument(
+                "dividend times and amounts differ in length");
+    }
+
+    const pricer::Chain chain = { spot, rate, expiry,
+        dividendTimes.empty() ? 0 : &dividendTimes[0],
+        dividendAmounts.empty() ? 0 : &dividendAmounts[0],
+        dividendTimes.size(), strike.empty() ? 0 : &strike[0],
+        vol.empty() ? 0 : &vol[0], strike.size() };
+    pricer::ChainPrices prices;
+    {
+        py::gil_scoped_release release;
+        pricer::ForwardEngine().price(&prices, chain);
+    }
+
+    py::dict out;
+    out["call"] = prices.d_call;
+    out["put"] = prices.d_put;
+    out["american_call"] = prices.d_americanCall;
+    out["american_put"] = prices.d_americanPut;
+    return out;
+}
+
+bool updateSurface(pricer::VolSurfaceBuilder *builder,
+        double spot,
+        double rate,
+        double expiry,
+        const Doubles& strike,
+        const Doubles& vol,
+        const Doubles& dividendTimes,
+        const Doubles& dividendAmounts)
+{
+    if (vol.size() != strike.size()) {
+        throw std::invalid_argument("strikes and vols differ in length");
+    }
+    if (dividendTimes.size() != dividendAmounts.size()) {
+        throw std::invalid_argument(
+                "dividend times and amounts differ in length");
+    }
+
+    const pricer::Chain chain = { spot, rate, expiry,
+        dividendTimes.empty() ? 0 : &dividendTimes[0],
+        dividendAmounts.empty() ? 0 : &dividendAmounts[0],
+        dividendTimes.size(), strike.empty() ? 0 : &strike[0],
+        vol.empty() ? 0 : &vol[0], strike.size() };
+    return builder->update(chain);
+}
+
+std::size_t publishSurface(pricer::VolSurfaceBuilder *builder)
+{
+    const std::shared_ptr<const pricer::VolSurface> surface
+            = builder->publish();
+    return surface ? surface->version() : 0;
+}
+
+Doubles surfaceVols(const pricer::VolSurfaceBuilder& builder,
+        const Doubles& strike,
+        const Doubles& expiry)
+{
+    if (expiry.size() != strike.size()) {
+        throw std::invalid_argument("strikes and expiries differ in length");
+    }
+    const std::shared_ptr<const pricer::VolSurface> surface
+            = builder.surface();
+    if (!surface) {
+        throw std::invalid_argument("no surface has been published");
+    }
+    Doubles vols(strike.size());
+    for (std::size_t i = 0; i < strike.size(); ++i) {
+        vols[i] = surface->vol(strike[i], expiry[i]);
+    }
+    return vols;
+}
+
+pricer::CurveBuilder makeCurveBuilder(double dayBasis)
+{
+    pricer::CurveBuilder::Config config;
+    config.d_dayBasis = dayBasis;
+    return pricer::CurveBuilder(config);
+}
+
+bool publishCurve(pricer::CurveBuilder *builder)
+{
+    return static_cast<bool>(builder->publish());
+}
+
+Doubles curveValues(const pricer::CurveBuilder& builder,
+        const Doubles& time,
+        bool zeroRates)
+{
+    const std::shared_ptr<const pricer::DiscountCurve> curve
+            = builder.curve();
+    if (!curve) {
+        throw std::invalid_argument("no curve has been published");
+    }
+    Doubles values(time.size());
+    for (std::size_t i = 0; i < time.size(); ++i) {
+        values[i] = zeroRates ? curve->zeroRate(time[i])
+                              : curve->discount(time[i]);
+    }
+    return values;
+}
+
+Doubles zeroRates(const pricer::CurveBuilder& builder, const Doubles& time)
+{
+    return curveValues(builder, time, true);
+}
+
+Doubles discountFactors(const pricer::CurveBuilder& builder,
+        const Doubles& time)
+{
+    return curveValues(builder, time, false);
+}
+
+} // close unnamed namespace
+
+PYBIND11_MODULE(bspricer, m)
+{
+    m.doc() = "Native batch pricer for the legs of an option strategy";
+
+    m.def("price_legs",
+            &priceLegs,
+            "Price every leg of a strategy in one call and return a dict of "
+            "lists 'price', 'delta', 'gamma', 'vega', 'theta' and 'rho'. "
+            "Expiries and "
+            "dividend times are year fractions (Actual/365) from today.",
+            py::arg("spot"),
+            py::arg("strike"),
+            py::arg("vol"),
+            py::arg("rate"),
+            py::arg("expiry"),
+            py::arg("is_american"),
+            py::arg("is_call"),
+            py::arg("dividend_times"),
+            py::arg("dividend_amounts"));
+
+    m.def("implied_vols",
+            &impliedVols,
+            "Solve the implied vol of every quoted price and return a dict "
+            "of lists 'vol', 'converged' and 'iterations'. A quote that "
+            "did not converge has a NaN vol. The legs are as in "
+            "price_legs, whose vol is only the first guess of an American "
+            "leg.",
+            py::arg("price"),
+            py::arg("spot"),
+            py::arg("strike"),
+            py::arg("vol"),
+            py::arg("rate"),
+            py::arg("expiry"),
+            py::arg("is_american"),
+            py::arg("is_call"),
+            py::arg("dividend_times"),
+            py::arg("dividend_amounts"));
+
+    m.def("price_legs_into",
+            &priceLegsInto,
+            "Price every leg of a strategy into the rows 'price', 'delta', "
+            "'gamma', 'vega', 'theta' and 'rho' of the preallocated "
+            "float64 array greeks of shape (6, legs), with the GIL "
+            "released. The dividends of leg i are the entries "
+            "[dividend_offsets[i], dividend_offsets[i + 1]) of the "
+            "dividend arrays. The inputs are copied once into a native "
+            "batch of legs; only greeks is written in place.",
+            py::arg("greeks").noconvert(),
+            py::arg("spot"),
+            py::arg("strike"),
+            py::arg("vol"),
+            py::arg("rate"),
+            py::arg("expiry"),
+            py::arg("is_american"),
+            py::arg("is_call"),
+            py::arg("dividend_offsets"),
+            py::arg("dividend_times"),
+            py::arg("dividend_amounts"));
+
+    m.def("implied_vols_into",
+            &impliedVolsInto,
+            "Solve the implied vol of every quote of price, of shape "
+            "(rows, legs), into the preallocated float64 array vols and "
+            "bool array converged of the same shape, with the GIL "
+            "released. The legs are as in price_legs_into.",
+            py::arg("vols").noconvert(),
+            py::arg("converged").noconvert(),
+            py::arg("price"),
+            py::arg("spot"),
+            py::arg("strike"),
+            py::arg("vol"),
+            py::arg("rate"),
+            py::arg("expiry"),
+            py::arg("is_american"),
+            py::arg("is_call"),
+            py::arg("dividend_offsets"),
+            py::arg("dividend_times"),
+            py::arg("dividend_amounts"));
+
+    m.def("scenario_ladder_into",
+            &scenarioLadderInto,
+            "Value the strategy holding quantity[i] of each leg under "
+            "every scenario of the ladder into the preallocated float64 "
+            "array values of shape (horizons, vol shifts, spot shifts), "
+            "evaluated across all cores with the GIL released. Spot "
+            "shifts are relative and increasing, vol shifts absolute, "
+            "and horizons year fractions by which the legs age. The legs "
+            "are as in price_legs_into.",
+            py::arg("values").noconvert(),
+            py::arg("quantity"),
+            py::arg("spot_shifts"),
+            py::arg("vol_shifts"),
+            py::arg("horizons"),
+            py::arg("spot"),
+            py::arg("strike"),
+            py::arg("vol"),
+            py::arg("rate"),
+            py::arg("expiry"),
+            py::arg("is_american"),
+            py::arg("is_call"),
+            py::arg("dividend_offsets"),
+            py::arg("dividend_times"),
+            py::arg("dividend_amounts"));
+
+    m.def("price_european",
+            &priceEuropean,
+            "Price a chain of European options in closed form and return a "
+            "dict of lists 'price', 'delta', 'gamma', 'vega', 'theta', "
+            "'rho', 'vanna' and 'volga'. With black76 the spot is the "
+            "forward and dividend_yield is ignored.",
+            py::arg("spot"),
+            py::arg("strike"),
+            py::arg("vol"),
+            py::arg("rate"),
+            py::arg("dividend_yield"),
+            py::arg("expiry"),
+            py::arg("is_call"),
+            py::arg("black76") = false);
+
+    m.def("price_chain",
+            &priceChain,
+            "Price every strike of one expiry from a single forward PDE "
+            "solve and return a dict of lists 'call', 'put', "
+            "'american_call' and 'american_put'. Strikes are increasing, "
+            "with the implied vol quoted at each.",
+            py::arg("spot"),
+            py::arg("rate"),
+            py::arg("expiry"),
+            py::arg("strike"),
+            py::arg("vol"),
+            py::arg("dividend_times"),
+            py::arg("dividend_amounts"));
+
+    py::class_<pricer::ChebyshevPricer>(m,
+            "ChebyshevPricer",
+            "Prices legs from Chebyshev interpolants of their finite "
+            "difference price and greeks over spot and vol, rebuilt in "
+            "the background when a leg leaves its interpolant.")
+            .def(py::init<>())
+            .def("price_legs_into",
+                    &chebyshevPriceInto,
+                    "Price the legs into greeks as "
+                    "bspricer.price_legs_into does and return the number "
+                    "of legs solved directly because no interpolant "
+                    "covered them.",
+                    py::arg("greeks").noconvert(),
+                    py::arg("spot"),
+                    py::arg("strike"),
+                    py::arg("vol"),
+                    py::arg("rate"),
+                    py::arg("expiry"),
+                    py::arg("is_american"),
+                    py::arg("is_call"),
+                    py::arg("dividend_offsets"),
+                    py::arg("dividend_times"),
+                    py::arg("dividend_amounts"))
+            .def("prepare",
+                    &chebyshevPrepare,
+                    "Build the interpolant centred on each leg now, such "
+                    "as after a refresh of the market data.",
+                    py::arg("spot"),
+                    py::arg("strike"),
+                    py::arg("vol"),
+                    py::arg("rate"),
+                    py::arg("expiry"),
+                    py::arg("is_american"),
+                    py::arg("is_call"),
+                    py::arg("dividend_offsets"),
+                    py::arg("dividend_times"),
+                    py::arg("dividend_amounts"))
+            .def("wait",
+                    &pricer::ChebyshevPricer::wait,
+                    "Block until the queued interpolants are built.",
+                    py::call_guard<py::gil_scoped_release>())
+            .def("clear",
+                    &pricer::ChebyshevPricer::clear,
+                    "Drop every interpolant.");
+
+    py::class_<pricer::IncrementalPricer>(m,
+            "IncrementalPricer",
+            "Reprices a strategy by second order Taylor updates from the "
+            "last full valuation of each leg while its spot, vol and rate "
+            "move less than the thresholds and the error estimate is within "
+            "tolerance, and in full otherwise. The estimate is exact for "
+            "European legs and approximate for American ones.")
+            .def(py::init(&makeIncrementalPricer),
+                    py::keep_alive<1, 2>(),
+                    "Full reprices come from full, a ChebyshevPricer, if "
+                    "given, and are exact solves otherwise. spot_move is "
+                    "relative, vol_move and rate_move absolute, and "
+                    "tolerance is in currency.",
+                    py::arg("full") = py::none(),
+                    py::arg("spot_move") = 0.01,
+                    py::arg("vol_move") = 0.01,
+                    py::arg("rate_move") = 0.0025,
+                    py::arg("tolerance") = 0.005)
+            .def("price_legs_into",
+                    &incrementalPriceInto,
+                    "Price the legs into greeks as "
+                    "bspricer.price_legs_into does, each leg updated from "
+                    "the last full valuation of the same index, and return "
+                    "the number of legs repriced in full.",
+                    py::arg("greeks").noconvert(),
+                    py::arg("spot"),
+                    py::arg("strike"),
+                    py::arg("vol"),
+                    py::arg("rate"),
+                    py::arg("expiry"),
+                    py::arg("is_american"),
+                    py::arg("is_call"),
+                    py::arg("dividend_offsets"),
+                    py::arg("dividend_times"),
+                    py::arg("dividend_amounts"))
+            .def("statistics",
+                    &incrementalStatistics,
+                    "Return a dict of the 'updates', 'reprices' and "
+                    "'fallbacks' since the last reset, with the "
+                    "'hit_rate' of updates among all legs and the "
+                    "'fallback_rate' of reprices among anchored legs.")
+            .def("reset_statistics",
+                    &pricer::IncrementalPricer::resetStatistics,
+                    "Zero the counters.",
+                    py::call_guard<py::gil_scoped_release>())
+            .def("clear",
+                    &pricer::IncrementalPricer::clear,
+                    "Drop the last valuations, so every leg is repriced "
+                    "in full next.",
+                    py::call_guard<py::gil_scoped_release>());
+
+    py::class_<pricer::VolSurfaceBuilder>(m,
+            "VolSurfaceBuilder",
+            "Implied vol surface of one underlying, fitted by SVI per "
+            "expiry with SSVI slices where a fit has arbitrage.")
+            .def(py::init<>())
+            .def("update",
+                    &updateSurface,
+                    "Replace the quoted vols of one expiry and return True "
+                    "if they changed. Strikes are increasing.",
+                    py::arg("spot"),
+                    py::arg("rate"),
+                    py::arg("expiry"),
+                    py::arg("strike"),
+                    py::arg("vol"),
+                    py::arg("dividend_times"),
+                    py::arg("dividend_amounts"))
+            .def("remove",
+                    &pricer::VolSurfaceBuilder::remove,
+                    "Drop the quotes of one expiry.",
+                    py::arg("expiry"))
+            .def("publish",
+                    &publishSurface,
+                    "Refit the changed expiries and return the version of "
+                    "the current surface, 0 if there is none.")
+            .def("vols",
+                    &surfaceVols,
+                    "Return the vol of the current surface at each pair of "
+                    "strike and expiry.",
+                    py::arg("strike"),
+                    py::arg("expiry"));
+
+    py::class_<pricer::CurveBuilder>(m,
+            "CurveBuilder",
+            "Discount curve bootstrapped from overnight index swap par "
+            "rates, with monotone convex forwards.")
+            .def(py::init(&makeCurveBuilder),
+                    "Accruals are the days over day_basis.",
+                    py::arg("day_basis") = 360.0)
+            .def("set_quotes",
+                    &pricer::CurveBuilder::setQuotes,
+                    "Replace all quotes by the par rates (decimal) of the "
+                    "swaps maturing after the increasing days.",
+                    py::arg("days"),
+                    py::arg("rates"))
+            .def("update_quote",
+                    &pricer::CurveBuilder::updateQuote,
+                    "Set the par rate of one swap, which re-bootstraps it "
+                    "and the later swaps on the next publish.",
+                    py::arg("index"),
+                    py::arg("rate"))
+            .def("publish",
+                    &publishCurve,
+                    "Bootstrap the changed quotes and return True if there "
+                    "is a curve.")
+            .def("zero_rates",
+                    &zeroRates,
+                    "Return the continuously compounded zero rate to each "
+                    "time, in years (Actual/365).",
+                    py::arg("time"))
+            .def("discount_factors",
+                    &discountFactors,
+                    "Return the discount factor to each time, in years "
+                    "(Actual/365).",
+                    py::arg("time"));
+}
@@ -0,0 +1,1049 @@
+#include "americanengine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace pricer {
+
+namespace {
+const double k_pi = 3.14159265358979323846;
+const double k_invSqrt2 = 0.70710678118654752440;
+const double k_invSqrt2Pi = 0.39894228040143267794;
+
+double normCdf(double x)
+{
+    return 0.5 * std::erfc(-x * k_invSqrt2);
+}
+
+double normPdf(double x)
+{
+    return k_invSqrt2Pi * std::exp(-0.5 * x * x);
+}
+
+// Bivariate normal CDF P(X < a, Y < b) with correlation `rho`, by Genz's
+// method (Drezner-Wesolowsky with Gauss-Legendre quadrature), accurate to
+// about 1e-15.
+double bivariateNormCdf(double a, double b, double rho)
+{
+    static const double w6[] = { 0.1713244923791705,
+        0.3607615730481384,
+        0.4679139345726904 };
+    static const double x6[] = { 0.9324695142031522,
+        0.6612093864662647,
+        0.2386191860831970 };
+    static const double w12[] = { 0.04717533638651177,
+        0.1069393259953183,
+        0.1600783285433464,
+        0.2031674267230659,
+        0.2334925365383547,
+        0.2491470458134029 };
+    static const double x12[] = { 0.9815606342467191,
+        0.9041172563704750,
+        0.7699026741943050,
+        0.5873179542866171,
+        0.3678314989981802,
+        0.1252334085114692 };
+    static const double w20[] = { 0.01761400713915212,
+        0.04060142980038694,
+        0.06267204833410906,
+        0.08327674157670475,
+        0.1019301198172404,
+        0.1181945319615184,
+        0.1316886384491766,
+        0.1420961093183821,
+        0.1491729864726037,
+        0.1527533871307259 };
+    static const double x20[] = { 0.9931285991850949,
+        0.9639719272779138,
+        0.9122344282513259,
+        0.8391169718222188,
+        0.7463319064601508,
+        0.6360536807265150,
+        0.5108670019508271,
+        0.3737060887154196,
+        0.2277858511416451,
+        0.07652652113349733 };
+
+    // Genz computes P(X > h, Y > k).
+    const double h = -a;
+    double k = -b;
+    if (rho == 0.0) {
+        return normCdf(a) * normCdf(b);
+    }
+
+    const double *w;
+    const double *x;
+    int n;
+    if (std::fabs(rho) < 0.3) {
+        w = w6;
+        x = x6;
+        n = 3;
+    }
+    else if (std::fabs(rho) < 0.75) {
+        w = w12;
+        x = x12;
+        n = 6;
+    }
+    else {
+        w = w20;
+        x = x20;
+        n = 10;
+    }
+
+    double hk = h * k;
+    double bvn = 0.0;
+    if (std::fabs(rho) < 0.925) {
+        const double hs = 0.5 * (h * h + k * k);
+        const double asr = 0.5 * std::asin(rho);
+        for (int i = 0; i < n; ++i) {
+            for (int sign = -1; sign <= 1; sign += 2) {
+                const double sn = std::sin(asr * (1.0 + sign * x[i]));
+                bvn += w[i] * std::exp((sn * hk - hs) / (1.0 - sn * sn));
+            }
+        }
+        bvn = bvn * asr / (2.0 * k_pi) + normCdf(-h) * normCdf(-k);
+    }
+    else {
+        if (rho < 0.0) {
+            k = -k;
+            hk = -hk;
+        }
+        if (std::fabs(rho) < 1.0) {
+            const double as = (1.0 - rho) * (1.0 + rho);
+            double aa = std::sqrt(as);
+            const double bs = (h - k) * (h - k);
+            const double c = (4.0 - hk) / 8.0;
+            const double d = (12.0 - hk) / 80.0;
+            double asr = -0.5 * (bs / as + hk);
+            if (asr > -100.0) {
+                bvn = aa * std::exp(asr)
+                        * (1.0 - c * (bs - as) * (1.0 - d * bs) / 3.0
+                                + c * d * as * as);
+            }
+            if (hk > -100.0) {
+                const double bb = std::sqrt(bs);
+                const double sp = std::sqrt(2.0 * k_pi) * normCdf(-bb / aa);
+                bvn -= std::exp(-0.5 * hk) * sp * bb
+                        * (1.0 - c * bs * (1.0 - d * bs) / 3.0);
+            }
+            aa *= 0.5;
+            double sum = 0.0;
+            for (int i = 0; i < n; ++i) {
+                for (int sign = -1; sign <= 1; sign += 2) {
+                    const double ax = aa * (1.0 + sign * x[i]);
+                    const double xs = ax * ax;
+                    asr = -0.5 * (bs / xs + hk);
+                    if (asr > -100.0) {
+                        const double sp = 1.0 + c * xs * (1.0 + 5.0 * d * xs);
+                        const double rs = std::sqrt(1.0 - xs);
+                        const double ep = std::exp(
+                                                  -0.5 * hk * xs
+                                                  / ((1.0 + rs) * (1.0 + rs)))
+                                / rs;
+                        sum += w[i] * std::exp(asr) * (sp - ep);
+                    }
+                }
+            }
+            bvn = (aa * sum - bvn) / (2.0 * k_pi);
+        }
+        if (rho > 0.0) {
+            bvn += normCdf(-std::max(h, k));
+        }
+        else if (h >= k) {
+            bvn = -bvn;
+        }
+        else {
+            const double l = h < 0.0 ? normCdf(k) - normCdf(h)
+                                     : normCdf(-h) - normCdf(-k);
+            bvn = l - bvn;
+        }
+    }
+    return std::max(0.0, std::min(1.0, bvn));
+}
+
+// The leg as a generalized Black-Scholes option with cost of carry `b`.
+struct Carry {
+    double d_spot;
+    double d_strike;
+    double d_expiry;
+    double d_rate;
+    double d_carry;
+    double d_vol;
+};
+
+double european(const Carry& c, bool isCall)
+{
+    const double sd = c.d_vol * std::sqrt(c.d_expiry);
+    const double d1 = (std::log(c.d_spot / c.d_strike)
+                              + c.d_carry * c.d_expiry)
+                    / sd
+            + 0.5 * sd;
+    const double d2 = d1 - sd;
+    const double sign = isCall ? 1.0 : -1.0;
+    return sign
+            * (c.d_spot * std::exp((c.d_carry - c.d_rate) * c.d_expiry)
+                            * normCdf(sign * d1)
+                    - c.d_strike * std::exp(-c.d_rate * c.d_expiry)
+                            * normCdf(sign * d2));
+}
+
+// The critical spot of Barone-Adesi and Whaley (1987), found by Newton's
+// method as in Haug, "The Complete Guide to Option Pricing Formulas". Load
+// the exponent q of the premium into `exponent` if it is not null.
+double criticalSpot(const Carry& c, bool isCall, double *exponent = 0)
+{
+    const double k = c.d_strike;
+    const double t = c.d_expiry;
+    const double r = c.d_rate;
+    const double b = c.d_carry;
+    const double v2 = c.d_vol * c.d_vol;
+    const double sd = c.d_vol * std::sqrt(t);
+    const double sign = isCall ? 1.0 : -1.0;
+
+    const double n = 2.0 * b / v2;
+    const double m = 2.0 * r / v2;
+    const double kk = r != 0.0 ? m / -std::expm1(-r * t) : 2.0 / (v2 * t);
+    const double root = std::sqrt((n - 1.0) * (n - 1.0) + 4.0 * kk);
+    const double rootInf = std::sqrt((n - 1.0) * (n - 1.0) + 4.0 * m);
+    const double q = 0.5 * (-(n - 1.0) + sign * root);
+    const double qInf = 0.5 * (-(n - 1.0) + sign * rootInf);
+    const double carryDf = std::exp((b - r) * t);
+    if (exponent) {
+        *exponent = q;
+    }
+
+    // Seed from the perpetual boundary, then iterate on
+    // sign (S* - K) = european(S*) + sign (1 - e^(b-r)T N(sign d1)) S* / q.
+    const double su = k / (1.0 - 1.0 / qInf);
+    double si = isCall
+            ? k + (su - k) * -std::expm1(-(b * t + 2.0 * sd) * k / (su - k))
+            : su + (k - su) * std::exp((b * t - 2.0 * sd) * k / (k - su));
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        Carry at = c;
+        at.d_spot = si;
+        const double d1 = (std::log(si / k) + b * t) / sd + 0.5 * sd;
+        const double nd1 = normCdf(sign * d1);
+        const double rhs
+                = european(at, isCall) + sign * (1.0 - carryDf * nd1) * si / q;
+        const double slope = sign * carryDf * nd1 * (1.0 - 1.0 / q)
+                + (sign - carryDf * normPdf(d1) / sd) / q;
+        const double next = isCall ? (k + rhs - slope * si) / (1.0 - slope)
+                                   : (k - rhs + slope * si) / (1.0 + slope);
+        const bool done = std::fabs(next - si) <= 1e-13 * k;
+        si = next;
+        if (done) {
+            break;
+        }
+    }
+    return si;
+}
+
+double baroneAdesiWhaley(const Carry& c, bool isCall)
+{
+    if (isCall ? c.d_carry >= c.d_rate : c.d_rate <= 0.0) {
+        return european(c, isCall);
+    }
+
+    double q;
+    const double si = criticalSpot(c, isCall, &q);
+    const double sign = isCall ? 1.0 : -1.0;
+    if (sign * (c.d_spot - si) >= 0.0) {
+        return sign * (c.d_spot - c.d_strike);
+    }
+
+    const double sd = c.d_vol * std::sqrt(c.d_expiry);
+    const double d1
+            = (std::log(si / c.d_strike) + c.d_carry * c.d_expiry) / sd
+            + 0.5 * sd;
+    const double carryDf = std::exp((c.d_carry - c.d_rate) * c.d_expiry);
+    const double a = sign * (si / q) * (1.0 - carryDf * normCdf(sign * d1));
+    return european(c, isCall) + a * std::pow(c.d_spot / si, q);
+}
+
+// Bjerksund-Stensland helpers phi and psi, as in Haug.
+double bsPhi(double s,
+        double t,
+        double gamma,
+        double h,
+        double i,
+        const Carry& c)
+{
+    const double v2 = c.d_vol * c.d_vol;
+    const double sd = c.d_vol * std::sqrt(t);
+    const double lambda = (-c.d_rate + gamma * c.d_carry
+                                  + 0.5 * gamma * (gamma - 1.0) * v2)
+            * t;
+    const double d
+            = -(std::log(s / h) + (c.d_carry + (gamma - 0.5) * v2) * t) / sd;
+    const double kappa = 2.0 * c.d_carry / v2 + 2.0 * gamma - 1.0;
+    return std::exp(lambda) * std::pow(s, gamma)
+            * (normCdf(d)
+                    - std::pow(i / s, kappa)
+                            * normCdf(d - 2.0 * std::log(i / s) / sd));
+}
+
+double bsPsi(double s,
+        double t,
+        double gamma,
+        double h,
+        double i2,
+        double i1,
+        double t1,
+        const Carry& c)
+{
+    const double v2 = c.d_vol * c.d_vol;
+    const double sdT = c.d_vol * std::sqrt(t);
+    const double sd1 = c.d_vol * std::sqrt(t1);
+    const double drift = c.d_carry + (gamma - 0.5) * v2;
+    const double e1 = (std::log(s / i1) + drift * t1) / sd1;
+    const double e2 = (std::log(i2 * i2 / (s * i1)) + drift * t1) / sd1;
+    const double e3 = (std::log(s / i1) - drift * t1) / sd1;
+    const double e4 = (std::log(i2 * i2 / (s * i1)) - drift * t1) / sd1;
+    const double f1 = (std::log(s / h) + drift * t) / sdT;
+    const double f2 = (std::log(i2 * i2 / (s * h)) + drift * t) / sdT;
+    const double f3 = (std::log(i1 * i1 / (s * h)) + drift * t) / sdT;
+    const double f4
+            = (std::log(s * i1 * i1 / (h * i2 * i2)) + drift * t) / sdT;
+    const double rho = std::sqrt(t1 / t);
+    const double lambda
+            = -c.d_rate + gamma * c.d_carry + 0.5 * gamma * (gamma - 1.0) * v2;
+    const double kappa = 2.0 * c.d_carry / v2 + 2.0 * gamma - 1.0;
+    return std::exp(lambda * t) * std::pow(s, gamma)
+            * (bivariateNormCdf(-e1, -f1, rho)
+                    - std::pow(i2 / s, kappa) * bivariateNormCdf(-e2, -f2, rho)
+                    - std::pow(i1 / s, kappa)
+                            * bivariateNormCdf(-e3, -f3, -rho)
+                    + std::pow(i1 / i2, kappa)
+                            * bivariateNormCdf(-e4, -f4, -rho));
+}
+
+// Bjerksund and Stensland (2002) call; puts use the put-call
+// transformation P(S, K, r, b) = C(K, S, r - b, -b).
+double bjerksundStenslandCall(const Carry& c)
+{
+    const double s = c.d_spot;
+    const double k = c.d_strike;
+    const double t = c.d_expiry;
+    const double r = c.d_rate;
+    const double b = c.d_carry;
+    const double v2 = c.d_vol * c.d_vol;
+    if (b >= r) {
+        return european(c, true);
+    }
+
+    const double beta = (0.5 - b / v2)
+            + std::sqrt((b / v2 - 0.5) * (b / v2 - 0.5) + 2.0 * r / v2);
+    const double bInf = beta / (beta - 1.0) * k;
+    const double b0 = std::max(k, r / (r - b) * k);
+    const double t1 = 0.5 * (std::sqrt(5.0) - 1.0) * t;
+    const double scale = k * k / ((bInf - b0) * b0);
+    const double h1 = -(b * t1 + 2.0 * c.d_vol * std::sqrt(t1)) * scale;
+    const double h2 = -(b * t + 2.0 * c.d_vol * std::sqrt(t)) * scale;
+    const double i1 = b0 + (bInf - b0) * (1.0 - std::exp(h1));
+    const double i2 = b0 + (bInf - b0) * (1.0 - std::exp(h2));
+    const double alpha1 = (i1 - k) * std::pow(i1, -beta);
+    const double alpha2 = (i2 - k) * std::pow(i2, -beta);
+    if (s >= i2) {
+        return s - k;
+    }
+
+    return alpha2 * std::pow(s, beta) - alpha2 * bsPhi(s, t1, beta, i2, i2, c)
+            + bsPhi(s, t1, 1.0, i2, i2, c) - bsPhi(s, t1, 1.0, i1, i2, c)
+            - k * bsPhi(s, t1, 0.0, i2, i2, c)
+            + k * bsPhi(s, t1, 0.0, i1, i2, c)
+            + alpha1 * bsPhi(s, t1, beta, i1, i2, c)
+            - alpha1 * bsPsi(s, t, beta, i1, i2, i1, t1, c)
+            + bsPsi(s, t, 1.0, i1, i2, i1, t1, c)
+            - bsPsi(s, t, 1.0, k, i2, i1, t1, c)
+            - k * bsPsi(s, t, 0.0, i1, i2, i1, t1, c)
+            + k * bsPsi(s, t, 0.0, k, i2, i1, t1, c);
+}
+
+double bjerksundStensland(const Carry& c, bool isCall)
+{
+    if (isCall) {
+        return bjerksundStenslandCall(c);
+    }
+    Carry swapped = c;
+    swapped.d_spot = c.d_strike;
+    swapped.d_strike = c.d_spot;
+    swapped.d_rate = c.d_rate - c.d_carry;
+    swapped.d_carry = -c.d_carry;
+    return bjerksundStenslandCall(swapped);
+}
+
+// The exercise boundary B(tau) of an American put of unit strike as a
+// Chebyshev interpolant of H = ln(B / X)^2 in sqrt(tau), where X = B(0+),
+// through the values at nodes i = 0..n, sqrt(tau) = sqrt(T) (1 +
+// cos(i pi / n)) / 2.
+class ExerciseBoundary {
+  private:
+    double d_sqrtExpiry;
+    double d_logLimit;
+    std::vector<double> d_coefficients;
+
+  public:
+    ExerciseBoundary(double expiry, double limit)
+        : d_sqrtExpiry(std::sqrt(expiry))
+        , d_logLimit(std::log(limit))
+    {
+    }
+
+    double node(int i, int n) const
+    {
+        const double x
+                = 0.5 * d_sqrtExpiry * (1.0 + std::cos(k_pi * i / n));
+        return x * x;
+    }
+
+    // Interpolate through the logarithms of the boundary in `logValues`.
+    void fit(const std::vector<double>& logValues)
+    {
+        const int n = static_cast<int>(logValues.size()) - 1;
+        d_coefficients.assign(n + 1, 0.0);
+        for (int i = 0; i <= n; ++i) {
+            const double l = logValues[i] - d_logLimit;
+            const double weight = i == 0 || i == n ? 0.5 : 1.0;
+            const double value = weight * l * l;
+
+            // cos(k i pi / n) = T_k(cos(i pi / n)) by the recurrence.
+            const double c = std::cos(k_pi * i / n);
+            double previous = 1.0;
+            double current = c;
+            d_coefficients[0] += value;
+            for (int k = 1; k <= n; ++k) {
+                d_coefficients[k] += value * current;
+                const double next = 2.0 * c * current - previous;
+                previous = current;
+                current = next;
+            }
+        }
+        for (int k = 0; k <= n; ++k) {
+            d_coefficients[k] *= 2.0 / n;
+        }
+        d_coefficients[0] *= 0.5;
+        d_coefficients[n] *= 0.5;
+    }
+
+    // Return ln B(tau).
+    double logBoundary(double tau) const
+    {
+        const double z = 2.0 * std::sqrt(std::max(tau, 0.0)) / d_sqrtExpiry
+                - 1.0;
+        double b1 = 0.0;
+        double b2 = 0.0;
+        for (int k = static_cast<int>(d_coefficients.size()) - 1; k > 0;
+                --k) {
+            const double b0 = 2.0 * z * b1 - b2 + d_coefficients[k];
+            b2 = b1;
+            b1 = b0;
+        }
+        const double h = z * b1 - b2 + d_coefficients[0];
+        return d_logLimit - std::sqrt(std::max(h, 0.0));
+    }
+};
+
+// Gauss-Legendre nodes and weights on [-1, 1].
+void gaussLegendre(std::vector<double> *nodes,
+        std::vector<double> *weights,
+        int n)
+{
+    nodes->resize(n);
+    weights->resize(n);
+    for (int i = 0; i < n; ++i) {
+        double x = std::cos(k_pi * (i + 0.75) / (n + 0.5));
+        double derivative = 1.0;
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            double p0 = 1.0;
+            double p1 = x;
+            for (int k = 2; k <= n; ++k) {
+                const double p2 = ((2 * k - 1) * x * p1 - (k - 1) * p0) / k;
+                p0 = p1;
+                p1 = p2;
+            }
+            derivative = n * (x * p1 - p0) / (x * x - 1.0);
+            const double step = p1 / derivative;
+            x -= step;
+            if (std::fabs(step) < 1e-15) {
+                break;
+            }
+        }
+        (*nodes)[i] = x;
+        (*weights)[i] = 2.0 / ((1.0 - x * x) * derivative * derivative);
+    }
+}
+
+// The American put of unit strike with rate `r`, dividend yield `q` and
+// volatility `vol`, by the fixed point method of Andersen, Lake and
+// Offengeim (2016): the boundary is iterated on the FP-B form of the Kim
+// integral equation, and the price is the European price plus the
+// integral of the early exercise premium along that boundary. Without a
+// positive rate the put is never exercised early.
+class FixedPointPut {
+  private:
+    double d_expiry;
+    double d_rate;
+    double d_yield;
+    double d_vol;
+    const std::vector<double> *d_nodes;
+    const std::vector<double> *d_weights;
+    ExerciseBoundary d_boundary;
+    std::vector<double> d_logValues;
+
+  public:
+    // Solve with `collocationNodes` + 1 nodes and `iterations` fixed point
+    // iterations, starting from the boundary of `start` if it is not null
+    // and has as many nodes, or else from Barone-Adesi-Whaley.
+    FixedPointPut(double expiry,
+            double r,
+            double q,
+            double vol,
+            int collocationNodes,
+            int iterations,
+            const std::vector<double>& nodes,
+            const std::vector<double>& weights,
+            const FixedPointPut *start = 0)
+        : d_expiry(expiry)
+        , d_rate(r)
+        , d_yield(q)
+        , d_vol(vol)
+        , d_nodes(&nodes)
+        , d_weights(&weights)
+        , d_boundary(expiry, q > r ? r / q : 1.0)
+    {
+        if (r <= 0.0) {
+            return;
+        }
+
+        const int n = collocationNodes;
+        const double logLimit = std::log(q > r ? r / q : 1.0);
+        const double logCap = logLimit - 1e-9;
+        if (start && start->d_logValues.size() == std::size_t(n + 1)) {
+            d_logValues = start->d_logValues;
+        }
+        else {
+            d_logValues.assign(n + 1, logLimit);
+            for (int i = 0; i < n; ++i) {
+                const Carry c = { 1.0, 1.0, d_boundary.node(i, n), r, r - q,
+                    vol };
+                d_logValues[i]
+                        = std::min(std::log(criticalSpot(c, false)), logCap);
+            }
+        }
+        d_boundary.fit(d_logValues);
+
+        const double mu = r - q - 0.5 * vol * vol;
+        for (int j = 0; j < iterations; ++j) {
+            for (int i = 0; i < n; ++i) {
+                const double tau = d_boundary.node(i, n);
+                const double logB = d_boundary.logBoundary(tau);
+                const double sqrtTau = std::sqrt(tau);
+
+                // The integrals over u in [0, tau], with
+                // tau - u = tau (1 + y)^2 / 4 removing the singularity of
+                // 1 / sqrt(tau - u) at u = tau.
+                double k1 = 0.0;
+                double k2 = 0.0;
+                double k3 = 0.0;
+                for (std::size_t p = 0; p < nodes.size(); ++p) {
+                    const double y = nodes[p];
+                    const double sqrtS = 0.5 * sqrtTau * (1.0 + y);
+                    const double s = sqrtS * sqrtS;
+                    const double u = tau - s;
+                    const double dm = (logB - d_boundary.logBoundary(u)
+                                              + mu * s)
+                            / (vol * sqrtS);
+                    const double w = weights[p];
+                    k3 += w * std::exp(r * u) * normPdf(dm);
+                    if (q != 0.0) {
+                        const double dp = dm + vol * sqrtS;
+                        const double eq = std::exp(q * u);
+                        k1 += w * eq * normCdf(dp) * sqrtS;
+                        k2 += w * eq * normPdf(dp);
+                    }
+                }
+                k1 *= 2.0 * sqrtTau;
+                k2 *= sqrtTau / vol;
+                k3 *= sqrtTau / vol;
+
+                const double dm = (logB + mu * tau) / (vol * sqrtTau);
+                const double dp = dm + vol * sqrtTau;
+                const double numerator
+                        = normPdf(dm) / (vol * sqrtTau) + r * k3;
+                const double denominator = normPdf(dp) / (vol * sqrtTau)
+                        + normCdf(dp) + q * (k1 + k2);
+                d_logValues[i] = std::min(
+                        std::log(numerator / denominator) - (r - q) * tau,
+                        logCap);
+            }
+            d_boundary.fit(d_logValues);
+        }
+    }
+
+    // Return true if this put has the given parameters.
+    bool solves(double expiry, double r, double q, double vol) const
+    {
+        return expiry == d_expiry && r == d_rate && q == d_yield
+                && vol == d_vol;
+    }
+
+    // Return the price at `spot`.
+    double price(double spot) const
+    {
+        const Carry c = { spot, 1.0, d_expiry, d_rate, d_rate - d_yield,
+            d_vol };
+        if (d_logValues.empty()) {
+            return european(c, false);
+        }
+        const double logSpot = std::log(spot);
+        if (logSpot <= d_boundary.logBoundary(d_expiry)) {
+            return 1.0 - spot;
+        }
+
+        const double mu = d_rate - d_yield - 0.5 * d_vol * d_vol;
+        const double sqrtT = std::sqrt(d_expiry);
+        double premium = 0.0;
+        for (std::size_t p = 0; p < d_nodes->size(); ++p) {
+            const double y = (*d_nodes)[p];
+            const double sqrtS = 0.5 * sqrtT * (1.0 + y);
+            const double s = sqrtS * sqrtS;
+            const double dm = (logSpot - d_boundary.logBoundary(d_expiry - s)
+                                      + mu * s)
+                    / (d_vol * sqrtS);
+            double value = d_rate * std::exp(-d_rate * s) * normCdf(-dm);
+            if (d_yield != 0.0) {
+                value -= d_yield * spot * std::exp(-d_yield * s)
+                        * normCdf(-dm - d_vol * sqrtS);
+            }
+            premium += (*d_weights)[p] * sqrtS * value;
+        }
+        return european(c, false) + premium * sqrtT;
+    }
+};
+
+// The continuous-yield equivalent of `leg`, or false if the spot does not
+// cover the dividends.
+bool yieldEquivalent(Carry *carry, double *dividends, const Leg& leg)
+{
+    *dividends = dividendValue(leg);
+    const double escrowed = leg.d_spot - *dividends;
+    if (!(escrowed > 0.0)) {
+        return false;
+    }
+    carry->d_spot = leg.d_spot;
+    carry->d_strike = leg.d_strike;
+    carry->d_expiry = leg.d_expiry;
+    carry->d_rate = leg.d_rate;
+    carry->d_carry
+            = leg.d_rate + std::log(escrowed / leg.d_spot) / leg.d_expiry;
+    carry->d_vol = leg.d_vol;
+    return true;
+}
+
+// Return `carry` on the spot less `dividends`, without dividend yield.
+Carry escrowedCarry(const Carry& carry, double dividends)
+{
+    Carry escrowed = carry;
+    escrowed.d_spot -= dividends;
+    escrowed.d_carry = escrowed.d_rate;
+    return escrowed;
+}
+
+// Return the fixed point solve of the put of unit strike that prices
+// `carry`: the put itself, or for a call the put with rate and dividend
+// yield exchanged, by put-call symmetry. Warm-start from `start` if it is
+// not null.
+FixedPointPut unitPut(const Carry& carry,
+        bool isCall,
+        int collocationNodes,
+        int iterations,
+        const std::vector<double>& abscissas,
+        const std::vector<double>& weights,
+        const FixedPointPut *start = 0)
+{
+    const double r = carry.d_rate;
+    const double q = carry.d_rate - carry.d_carry;
+    const double unitRate = isCall ? q : r;
+    const double unitYield = isCall ? r : q;
+    if (start
+            && start->solves(
+                    carry.d_expiry, unitRate, unitYield, carry.d_vol)) {
+        // Only the spot moved, and the boundary does not depend on it.
+        return *start;
+    }
+    return FixedPointPut(carry.d_expiry,
+            unitRate,
+            unitYield,
+            carry.d_vol,
+            collocationNodes,
+            iterations,
+            abscissas,
+            weights,
+            start);
+}
+
+// Return the price of `carry` from the solve `put` of `unitPut`.
+double unitPrice(const FixedPointPut& put, const Carry& carry, bool isCall)
+{
+    return isCall ? carry.d_spot * put.price(carry.d_strike / carry.d_spot)
+                  : carry.d_strike * put.price(carry.d_spot / carry.d_strike);
+}
+
+// Premium computes the early exercise premium of a yield equivalent under
+// one method. Fixed point solves start from `start` if it is not null,
+// which makes the bumped solves of the greeks cheap.
+struct Premium {
+    AmericanEngine::Method d_method;
+    int d_collocationNodes;
+    int d_iterations;
+    const std::vector<double> *d_abscissas;
+    const std::vector<double> *d_weights;
+    const FixedPointPut *d_start;       // start of yield equivalent solves
+    const FixedPointPut *d_escrowStart; // start of escrowed spot solves
+
+    double operator()(const Carry& carry,
+            bool isCall,
+            const FixedPointPut *start) const
+    {
+        double american;
+        switch (d_method) {
+          case AmericanEngine::e_BARONE_ADESI_WHALEY:
+            american = baroneAdesiWhaley(carry, isCall);
+            break;
+          case AmericanEngine::e_BJERKSUND_STENSLAND:
+            american = bjerksundStensland(carry, isCall);
+            break;
+          default:
+            american = unitPrice(unitPut(carry,
+                                         isCall,
+                                         d_collocationNodes,
+                                         d_iterations,
+                                         *d_abscissas,
+                                         *d_weights,
+                                         start),
+                    carry,
+                    isCall);
+            break;
+        }
+        return american - european(carry, isCall);
+    }
+};
+
+// Return the bound on the early exercise premium of `carry` from its
+// integral representation, whose integrand is at most r K exp(-r t) for a
+// put and q S exp(-q t) for a call on a dividend yield q.
+double premiumBound(const Carry& carry, bool isCall)
+{
+    const double rate = isCall ? carry.d_rate - carry.d_carry : carry.d_rate;
+    const double notional = isCall ? carry.d_spot : carry.d_strike;
+    return std::max(0.0, -notional * std::expm1(-rate * carry.d_expiry));
+}
+
+// Return Merton's bound on the early exercise premium of a call with
+// dividends: a call is only exercised just before an ex-date, and that
+// gains at most the dividend less the interest on the strike until the
+// next ex-date or expiry.
+double callPremiumBound(const Leg& leg)
+{
+    std::vector<std::pair<double, double> > dividends;
+    for (std::size_t i = 0; i < leg.d_numDividends; ++i) {
+        const double td = leg.d_dividendTimes[i];
+        if (td > 0.0 && td <= leg.d_expiry) {
+            dividends.push_back(
+                    std::make_pair(td, leg.d_dividendAmounts[i]));
+        }
+    }
+    std::sort(dividends.begin(), dividends.end());
+
+    double bound = 0.0;
+    for (std::size_t i = 0; i < dividends.size(); ++i) {
+        const double td = dividends[i].first;
+        const double next = i + 1 < dividends.size() ? dividends[i + 1].first
+                                                     : leg.d_expiry;
+        const double interest
+                = -leg.d_strike * std::expm1(-leg.d_rate * (next - td));
+        bound += std::exp(-leg.d_rate * td)
+                * std::max(0.0, dividends[i].second - interest);
+    }
+    return bound;
+}
+
+// Load into `value` the early exercise premium of `leg` and return true,
+// or return false if the spot does not cover the dividends. Without
+// dividends this is the premium of the yield equivalent. Otherwise a call
+// takes that premium capped by `callPremiumBound`, and a put the midpoint
+// of the premiums of the yield equivalent and of the escrowed spot without
+// dividends, which bracket the put with discrete dividends. Load into
+// `width` the width of that range if it is not null.
+bool premiumOf(double *value,
+        double *width,
+        const Leg& leg,
+        const Premium& premium)
+{
+    Carry carry;
+    double dividends;
+    if (!yieldEquivalent(&carry, &dividends, leg)) {
+        return false;
+    }
+    const double yield = premium(carry, leg.d_isCall, premium.d_start);
+    double range = 0.0;
+    if (dividends == 0.0) {
+        *value = yield;
+    }
+    else if (leg.d_isCall) {
+        const double bound = callPremiumBound(leg);
+        *value = std::min(yield, bound);
+        range = bound - *value;
+    }
+    else {
+        const double other = premium(escrowedCarry(carry, dividends),
+                false,
+                premium.d_escrowStart);
+        *value = 0.5 * (yield + other);
+        range = std::fabs(yield - other);
+    }
+    if (width) {
+        *width = range;
+    }
+    return true;
+}
+
+// Return the central difference of the premium between `up` and `down`,
+// or 0 if either cannot be priced.
+double difference(const Leg& up,
+        const Leg& down,
+        double step,
+        const Premium& premium)
+{
+    double valueUp;
+    double valueDown;
+    if (!premiumOf(&valueUp, 0, up, premium)
+            || !premiumOf(&valueDown, 0, down, premium)) {
+        return 0.0;
+    }
+    return (valueUp - valueDown) / (2.0 * step);
+}
+
+// Return `leg` without the dividends paid at or before the valuation date,
+// whose times and amounts are stored in `times` and `amounts`.
+Leg withoutPastDividends(const Leg& leg,
+        std::vector<double> *times,
+        std::vector<double> *amounts)
+{
+    times->clear();
+    amounts->clear();
+    for (std::size_t i = 0; i < leg.d_numDividends; ++i) {
+        if (leg.d_dividendTimes[i] > 0.0) {
+            times->push_back(leg.d_dividendTimes[i]);
+            amounts->push_back(leg.d_dividendAmounts[i]);
+        }
+    }
+    Leg result = leg;
+    result.d_numDividends = times->size();
+    result.d_dividendTimes = times->empty() ? 0 : &(*times)[0];
+    result.d_dividendAmounts = amounts->empty() ? 0 : &(*amounts)[0];
+    return result;
+}
+
+// Return `leg` seen from `shift` years after the valuation date, with its
+// dividend times stored in `times`.
+Leg shifted(const Leg& leg, double shift, std::vector<double> *times)
+{
+    times->assign(leg.d_dividendTimes,
+            leg.d_dividendTimes + leg.d_numDividends);
+    for (std::size_t i = 0; i < times->size(); ++i) {
+        (*times)[i] -= shift;
+    }
+    Leg result = leg;
+    result.d_expiry -= shift;
+    result.d_dividendTimes = times->empty() ? 0 : &(*times)[0];
+    return result;
+}
+}
+
+AmericanEngine::Config::Config()
+    : d_method(e_ANDERSEN_LAKE_OFFENGEIM)
+    , d_tolerance(5e-3)
+    , d_collocationNodes(8)
+    , d_iterations(4)
+    , d_greekIterations(2)
+    , d_quadraturePoints(12)
+{
+}
+
+AmericanEngine::AmericanEngine(const Config& config)
+    : d_config(config)
+    , d_analytic()
+{
+    gaussLegendre(&d_abscissas, &d_weights, d_config.d_quadraturePoints);
+    gaussLegendre(&d_coarseAbscissas,
+            &d_coarseWeights,
+            (d_config.d_quadraturePoints + 1) / 2);
+}
+
+bool AmericanEngine::price(Greeks *greeks,
+        double *error,
+        const Leg& givenLeg) const
+{
+    // Dividends already paid would otherwise be moved into the life of the
+    // leg by the theta bump.
+    std::vector<double> dividendTimes;
+    std::vector<double> dividendAmounts;
+    const Leg leg
+            = withoutPastDividends(givenLeg, &dividendTimes, &dividendAmounts);
+
+    Carry carry;
+    double dividends;
+    if (!yieldEquivalent(&carry, &dividends, leg)
+            || !d_analytic.price(greeks, leg)) {
+        return false;
+    }
+
+    const bool isCall = leg.d_isCall;
+    const Method method = d_config.d_method;
+    Premium premium = { method,
+        d_config.d_collocationNodes,
+        d_config.d_iterations,
+        &d_abscissas,
+        &d_weights,
+        0,
+        0 };
+
+    // The fixed point price is measured against a solve on half the nodes
+    // and quadrature points, and the premium and its bumps then start from
+    // the converged boundaries.
+    double approximationError;
+    std::unique_ptr<FixedPointPut> yieldSolve;
+    std::unique_ptr<FixedPointPut> escrowSolve;
+    if (method == e_ANDERSEN_LAKE_OFFENGEIM) {
+        yieldSolve.reset(new FixedPointPut(unitPut(carry,
+                isCall,
+                d_config.d_collocationNodes,
+                d_config.d_iterations,
+                d_abscissas,
+                d_weights)));
+        const double fixedPoint = unitPrice(*yieldSolve, carry, isCall);
+        const FixedPointPut coarse = unitPut(carry,
+                isCall,
+                d_config.d_collocationNodes / 2 + 1,
+                d_config.d_iterations,
+                d_coarseAbscissas,
+                d_coarseWeights);
+        approximationError
+                = std::fabs(fixedPoint - unitPrice(coarse, carry, isCall));
+        if (!isCall && dividends != 0.0) {
+            escrowSolve.reset(new FixedPointPut(unitPut(
+                    escrowedCarry(carry, dividends),
+                    false,
+                    d_config.d_collocationNodes,
+                    d_config.d_iterations,
+                    d_abscissas,
+                    d_weights)));
+        }
+        premium.d_iterations = d_config.d_greekIterations;
+        premium.d_start = yieldSolve.get();
+        premium.d_escrowStart = escrowSolve.get();
+    }
+    else {
+        // A closed form is measured against a cheap fixed point solve, on
+        // half the nodes with the iterations of the greeks, unless the
+        // premium is bounded within the tolerance, when both it and the
+        // closed form premium lie between 0 and the bound.
+        const double closedForm = premium(carry, isCall, 0);
+        const double bound = premiumBound(carry, isCall);
+        if (bound <= d_config.d_tolerance) {
+            approximationError = std::max(closedForm, bound - closedForm);
+        }
+        else {
+            const FixedPointPut check = unitPut(carry,
+                    isCall,
+                    d_config.d_collocationNodes / 2 + 1,
+                    d_config.d_greekIterations,
+                    d_abscissas,
+                    d_weights);
+            approximationError = std::fabs(closedForm
+                    + european(carry, isCall)
+                    - unitPrice(check, carry, isCall));
+        }
+    }
+
+    double value;
+    double width;
+    premiumOf(&value, &width, leg, premium);
+    *error = approximationError + width;
+
+    const double intrinsic = isCall ? leg.d_spot - leg.d_strike
+                                    : leg.d_strike - leg.d_spot;
+    const double price = greeks->d_price + value;
+    if (price <= intrinsic) {
+        // Exercise now.
+        const double sign = isCall ? 1.0 : -1.0;
+        greeks->d_price = intrinsic;
+        greeks->d_delta = sign;
+        greeks->d_gamma = 0.0;
+        greeks->d_vega = 0.0;
+        greeks->d_theta = 0.0;
+        greeks->d_rho = 0.0;
+        return true;
+    }
+
+    // The European part has exact greeks; those of the premium are central
+    // differences of the approximation.
+    greeks->d_price = price;
+    const double hs = 1e-3 * leg.d_spot;
+    const double hv = 1e-4;
+    const double ht = std::min(1e-4, 0.5 * leg.d_expiry);
+
+    Leg up = leg;
+    Leg down = leg;
+    up.d_spot += hs;
+    down.d_spot -= hs;
+    double valueUp;
+    double valueDown;
+    if (premiumOf(&valueUp, 0, up, premium)
+            && premiumOf(&valueDown, 0, down, premium)) {
+        greeks->d_delta += (valueUp - valueDown) / (2.0 * hs);
+        greeks->d_gamma += (valueUp - 2.0 * value + valueDown) / (hs * hs);
+    }
+
+    up = leg;
+    down = leg;
+    up.d_vol += hv;
+    down.d_vol -= hv;
+    greeks->d_vega += difference(up, down, hv, premium);
+
+    up = leg;
+    down = leg;
+    up.d_rate += hv;
+    down.d_rate -= hv;
+    greeks->d_rho += difference(up, down, hv, premium);
+
+    // Theta is a central difference unless moving the valuation date later
+    // would pass an ex-date, when it is one-sided towards the past.
+    bool dividendWithinStep = false;
+    for (std::size_t i = 0; i < leg.d_numDividends; ++i) {
+        dividendWithinStep |= leg.d_dividendTimes[i] <= ht;
+    }
+    std::vector<double> laterTimes;
+    std::vector<double> earlierTimes;
+    const Leg earlier = shifted(leg, -ht, &earlierTimes);
+    if (!dividendWithinStep) {
+        greeks->d_theta += difference(
+                shifted(leg, ht, &laterTimes), earlier, ht, premium);
+    }
+    else if (premiumOf(&valueDown, 0, earlier, premium)) {
+        greeks->d_theta += (value - valueDown) / ht;
+    }
+    return true;
+}
+
+bool AmericanEngine::accept(Greeks *greeks, const Leg& leg) const
+{
+    double error;
+    return price(greeks, &error, leg) && error <= d_config.d_tolerance;
+}
+
+} // close namespace pricer
@@ -0,0 +1,79 @@
+#ifndef _AMERICANENGINE_H_
+#define _AMERICANENGINE_H_
+
+#include "analyticengine.h"
+#include "legbatch.h"
+
+#include <vector>
+
+namespace pricer {
+
+// AmericanEngine prices American legs with a fast approximation of the
+// early exercise premium, and estimates the error of that price so the
+// caller can fall back to the finite difference solve when it is too large.
+// The accuracy tier is the method: the closed forms of Barone-Adesi-Whaley
+// (1987) or Bjerksund-Stensland (2002), or the fixed point method of
+// Andersen-Lake-Offengeim (2016), which iterates the exercise boundary of
+// the integral equation to a Chebyshev interpolant and integrates the
+// premium along it. The error of a closed form is estimated as its distance
+// from a fixed point price on half the collocation nodes and with the
+// iterations of the greeks, or, where the early exercise premium is bounded
+// within the tolerance, K (1 - exp(-r T)) for a put and S (1 - exp(-q T))
+// for a call, from that bound without a solve. The error of the fixed point
+// price is estimated as its distance from a solve on half the collocation
+// nodes and quadrature points.
+//
+// The premium is computed on a continuous-yield equivalent of the leg, whose
+// yield gives the same forward as the discrete dividends, and is added to
+// the escrowed European price. With dividends before expiry the yield
+// premium is only a guide, and the error estimate also includes the width
+// of the range the premium is known to lie in:
+//  - for calls, up to Merton's bound on the premium, as a call is only
+//    exercised just before an ex-date;
+//  - for puts, between the premiums of the yield equivalent and of the
+//    escrowed spot without dividends, whose midpoint is returned.
+class AmericanEngine {
+  public:
+    enum Method {
+        e_BARONE_ADESI_WHALEY = 0,
+        e_BJERKSUND_STENSLAND = 1,
+        e_ANDERSEN_LAKE_OFFENGEIM = 2
+    };
+
+    struct Config {
+        Method d_method;        // approximation whose price is returned
+        double d_tolerance;     // largest accepted error estimate, in currency
+        int d_collocationNodes; // fixed point boundary nodes, less one
+        int d_iterations;       // fixed point iterations
+        int d_greekIterations;  // iterations of the bumped solves of greeks
+        int d_quadraturePoints; // Gauss-Legendre points of each integral
+
+        Config();
+    };
+
+  private:
+    Config d_config;
+    AnalyticEngine d_analytic;
+    std::vector<double> d_abscissas;
+    std::vector<double> d_weights;
+    std::vector<double> d_coarseAbscissas;
+    std::vector<double> d_coarseWeights;
+
+  public:
+    explicit AmericanEngine(const Config& config = Config());
+
+    const Config& config() const { return d_config; }
+
+    // Load into `greeks` the approximate price and greeks of `leg`, and
+    // into `error` the estimate of the price error, and return true.
+    // Return false if the spot does not cover the dividends.
+    bool price(Greeks *greeks, double *error, const Leg& leg) const;
+
+    // Return true if `price` accepts `leg` with an error estimate within
+    // the tolerance, loading `greeks` as `price` does.
+    bool accept(Greeks *greeks, const Leg& leg) const;
+};
+
+} // close namespace pricer
+
+#endif
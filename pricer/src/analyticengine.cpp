@@ -0,0 +1,284 @@
+#include "analyticengine.h"
+#include "europeankernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace pricer {
+
+namespace {
+// Escrow describes a leg in the escrowed dividend model: the spot less the
+// present value of the dividends, with the volatility scaled by `d_scale`
+// and the derivatives of that scale in spot, rate and valuation date.
+struct Escrow {
+    double d_spot;
+    double d_pv;
+    double d_pvRate;
+    double d_scale;
+    double d_scaleSpot;
+    double d_scaleSpot2;
+    double d_scaleRate;
+    double d_scaleTime;
+};
+
+// Load into `escrow` the escrowed model of `leg` and return true, or return
+// false if the spot does not cover the dividends.
+//
+// The escrowed spot diffuses with volatility sigma S / (S - D(t)), where
+// D(t) is the value of the dividends still to be paid, so that it matches
+// the volatility of the stock the finite difference engine prices. The
+// scale is its root mean square over the life of the leg (Beneder and
+// Vorst, 2001).
+bool makeEscrow(Escrow *escrow, const Leg& leg)
+{
+    const double s = leg.d_spot;
+    const double r = leg.d_rate;
+    const double t = leg.d_expiry;
+
+    std::vector<std::pair<double, double> > dividends;
+    for (std::size_t i = 0; i < leg.d_numDividends; ++i) {
+        const double td = leg.d_dividendTimes[i];
+        if (td > 0.0 && td <= t) {
+            dividends.push_back(std::make_pair(
+                    td, leg.d_dividendAmounts[i] * std::exp(-r * td)));
+        }
+    }
+    std::sort(dividends.begin(), dividends.end());
+
+    double pv = 0.0;
+    double pvRate = 0.0;
+    for (std::size_t i = 0; i < dividends.size(); ++i) {
+        pv += dividends[i].second;
+        pvRate -= dividends[i].first * dividends[i].second;
+    }
+    if (!(s - pv > 0.0)) {
+        return false;
+    }
+
+    // Integrate F^2 = (S / (S - D))^2 and its derivatives over the
+    // intervals between ex-dates; D and its rate derivative drop by each
+    // dividend as it is paid. Moving the valuation date forward shortens
+    // the first interval and raises D at the rate.
+    double remaining = pv;
+    double remainingRate = pvRate;
+    double start = 0.0;
+    double g = 0.0, gSpot = 0.0, gSpot2 = 0.0, gRate = 0.0, gTime = 0.0;
+    for (std::size_t i = 0; i <= dividends.size(); ++i) {
+        const double end = i < dividends.size() ? dividends[i].first : t;
+        const double dt = end - start;
+        const double x = s - remaining;
+        const double f = s / x;
+        const double fSpot = -remaining / (x * x);
+        const double fSpot2 = 2.0 * remaining / (x * x * x);
+        const double fRate = s * remainingRate / (x * x);
+        const double fTime = s * r * remaining / (x * x);
+        g += dt * f * f;
+        gSpot += 2.0 * dt * f * fSpot;
+        gSpot2 += 2.0 * dt * (fSpot * fSpot + f * fSpot2);
+        gRate += 2.0 * dt * f * fRate;
+        gTime += 2.0 * dt * f * fTime;
+        if (i == 0) {
+            gTime -= f * f;
+        }
+        if (i < dividends.size()) {
+            remaining -= dividends[i].second;
+            remainingRate += dividends[i].first * dividends[i].second;
+        }
+        start = end;
+    }
+
+    const double scale = std::sqrt(g / t);
+    escrow->d_spot = s - pv;
+    escrow->d_pv = pv;
+    escrow->d_pvRate = pvRate;
+    escrow->d_scale = scale;
+    escrow->d_scaleSpot = gSpot / (2.0 * scale * t);
+    escrow->d_scaleSpot2
+            = (gSpot2 / t - 2.0 * escrow->d_scaleSpot * escrow->d_scaleSpot)
+            / (2.0 * scale);
+    escrow->d_scaleRate = gRate / (2.0 * scale * t);
+    escrow->d_scaleTime = (gTime / t + g / (t * t)) / (2.0 * scale);
+    return true;
+}
+
+// Load into `greeks` the greeks of `leg` from the entry `i` of `outputs`,
+// priced on the escrowed spot and scaled volatility. The escrowed spot
+// moves with the rate through the dividend present value and grows at the
+// rate as calendar time passes; the scale moves with spot, rate and time.
+void escrowedGreeks(Greeks *greeks,
+        const EuropeanOutputs& outputs,
+        std::size_t i,
+        const Escrow& escrow,
+        const Leg& leg)
+{
+    const double vega = outputs.d_vega[i];
+    const double volSpot = leg.d_vol * escrow.d_scaleSpot;
+    greeks->d_price = outputs.d_price[i];
+    greeks->d_delta = outputs.d_delta[i] + vega * volSpot;
+    greeks->d_gamma = outputs.d_gamma[i] + 2.0 * outputs.d_vanna[i] * volSpot
+            + outputs.d_volga[i] * volSpot * volSpot
+            + vega * leg.d_vol * escrow.d_scaleSpot2;
+    greeks->d_vega = vega * escrow.d_scale;
+    greeks->d_theta = outputs.d_theta[i]
+            - outputs.d_delta[i] * leg.d_rate * escrow.d_pv
+            + vega * leg.d_vol * escrow.d_scaleTime;
+    greeks->d_rho = outputs.d_rho[i] - outputs.d_delta[i] * escrow.d_pvRate
+            + vega * leg.d_vol * escrow.d_scaleRate;
+}
+
+// Return the greeks of entry `i` of `outputs`, for a leg priced on its
+// own spot.
+Greeks kernelGreeks(const EuropeanOutputs& outputs, std::size_t i)
+{
+    const Greeks greeks = { outputs.d_price[i], outputs.d_delta[i],
+        outputs.d_gamma[i], outputs.d_vega[i], outputs.d_theta[i],
+        outputs.d_rho[i] };
+    return greeks;
+}
+
+// Return true if `leg` has a dividend paid after the valuation date and no
+// later than expiry, so it must be priced on the escrowed spot.
+bool paysDividends(const Leg& leg)
+{
+    for (std::size_t i = 0; i < leg.d_numDividends; ++i) {
+        const double td = leg.d_dividendTimes[i];
+        if (td > 0.0 && td <= leg.d_expiry) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Price in one kernel call the European legs of `legs` at `index`, which
+// are calls if `isCall` and puts otherwise, on their escrowed spots if
+// `escrowed` and on their spots otherwise, and mark them in `priced`.
+void priceGroup(const PricingOutputs& results,
+        std::vector<char> *priced,
+        const LegBatch& legs,
+        const std::vector<std::size_t>& index,
+        bool isCall,
+        bool escrowed)
+{
+    std::vector<std::size_t> accepted;
+    std::vector<Escrow> escrows;
+    std::vector<double> spot, strike, vol, rate, expiry;
+    for (std::size_t j = 0; j < index.size(); ++j) {
+        const Leg leg = legs.leg(index[j]);
+        Escrow escrow;
+        if (escrowed && !makeEscrow(&escrow, leg)) {
+            continue;
+        }
+        accepted.push_back(index[j]);
+        strike.push_back(leg.d_strike);
+        rate.push_back(leg.d_rate);
+        expiry.push_back(leg.d_expiry);
+        if (escrowed) {
+            escrows.push_back(escrow);
+            spot.push_back(escrow.d_spot);
+            vol.push_back(leg.d_vol * escrow.d_scale);
+        }
+        else {
+            spot.push_back(leg.d_spot);
+            vol.push_back(leg.d_vol);
+        }
+    }
+
+    const std::size_t m = accepted.size();
+    if (m == 0) {
+        return;
+    }
+
+    const std::vector<char> type(m, isCall);
+    std::vector<double> values(8 * m);
+    const EuropeanInputs inputs = { &spot[0], &strike[0], &vol[0], &rate[0],
+        0, &expiry[0], &type[0], m };
+    const EuropeanOutputs outputs = { &values[0], &values[m], &values[2 * m],
+        &values[3 * m], &values[4 * m], &values[5 * m], &values[6 * m],
+        &values[7 * m] };
+    EuropeanKernel::price(outputs,
+            inputs,
+            EuropeanKernel::e_BLACK_SCHOLES,
+            EuropeanKernel::bestIsa(),
+            isCall ? EuropeanKernel::e_CALLS : EuropeanKernel::e_PUTS);
+
+    for (std::size_t j = 0; j < m; ++j) {
+        Greeks greeks;
+        if (escrowed) {
+            escrowedGreeks(
+                    &greeks, outputs, j, escrows[j], legs.leg(accepted[j]));
+        }
+        else {
+            greeks = kernelGreeks(outputs, j);
+        }
+        results.set(accepted[j], greeks);
+        (*priced)[accepted[j]] = 1;
+    }
+}
+}
+
+bool escrowedSpot(double *spot, double *volScale, const Leg& leg)
+{
+    Escrow escrow;
+    if (!makeEscrow(&escrow, leg)) {
+        return false;
+    }
+    *spot = escrow.d_spot;
+    *volScale = escrow.d_scale;
+    return true;
+}
+
+bool AnalyticEngine::price(Greeks *greeks, const Leg& leg) const
+{
+    const bool escrowed = paysDividends(leg);
+    Escrow escrow;
+    if (escrowed && !makeEscrow(&escrow, leg)) {
+        return false;
+    }
+
+    const char isCall = leg.d_isCall;
+    const double spot = escrowed ? escrow.d_spot : leg.d_spot;
+    const double vol = escrowed ? leg.d_vol * escrow.d_scale : leg.d_vol;
+    double values[8];
+    const EuropeanInputs inputs = {
+        &spot, &leg.d_strike, &vol, &leg.d_rate, 0, &leg.d_expiry, &isCall, 1
+    };
+    const EuropeanOutputs outputs = {
+        &values[0], &values[1], &values[2], &values[3], &values[4],
+        &values[5], &values[6], &values[7]
+    };
+    EuropeanKernel::price(outputs, inputs);
+    if (escrowed) {
+        escrowedGreeks(greeks, outputs, 0, escrow, leg);
+    }
+    else {
+        *greeks = kernelGreeks(outputs, 0);
+    }
+    return true;
+}
+
+void AnalyticEngine::price(const PricingOutputs& results,
+        std::vector<char> *priced,
+        const LegBatch& legs) const
+{
+    const std::size_t n = legs.size();
+    priced->assign(n, 0);
+
+    // The European legs are split once into calls and puts, with and
+    // without dividends before expiry, and each group is priced by the
+    // kernel of its payoff, the legs without dividends skipping the
+    // escrowed model.
+    std::vector<std::size_t> groups[4];
+    for (std::size_t i = 0; i < n; ++i) {
+        if (legs.d_isAmerican[i]) {
+            continue;
+        }
+        const bool escrowed = paysDividends(legs.leg(i));
+        groups[2 * escrowed + (legs.d_isCall[i] != 0)].push_back(i);
+    }
+    for (int g = 0; g < 4; ++g) {
+        priceGroup(results, priced, legs, groups[g], g % 2 != 0, g >= 2);
+    }
+}
+
+} // close namespace pricer
@@ -0,0 +1,38 @@
+#ifndef _ANALYTICENGINE_H_
+#define _ANALYTICENGINE_H_
+
+#include "legbatch.h"
+
+#include <vector>
+
+namespace pricer {
+
+// Load into `spot` the escrowed spot of `leg`, its spot less the present
+// value of the dividends paid before expiry, and into `volScale` the factor
+// the closed form applies to the volatility of the leg, and return true.
+// Return false if the spot does not cover the dividends.
+bool escrowedSpot(double *spot, double *volScale, const Leg& leg);
+
+// AnalyticEngine prices European legs in closed form. Discrete dividends
+// use the escrowed model: the Black-Scholes formula is applied to the spot
+// less the present value of the dividends paid before expiry. Both methods
+// evaluate the formula with EuropeanKernel, which vectorizes over legs.
+class AnalyticEngine {
+  public:
+    // Load into `greeks` the closed-form price and greeks of `leg` and
+    // return true, or return false if the spot does not cover the
+    // dividends and the leg cannot be priced in closed form.
+    bool price(Greeks *greeks, const Leg& leg) const;
+
+    // Price in one kernel call every European leg of `legs` that the
+    // closed form accepts, loading its entry of `results`, which must have
+    // room for `legs.size()` entries. Set `priced[i]` to 1 for those legs
+    // and to 0 for the legs left to the caller.
+    void price(const PricingOutputs& results,
+            std::vector<char> *priced,
+            const LegBatch& legs) const;
+};
+
+} // close namespace pricer
+
+#endif
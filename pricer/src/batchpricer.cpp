@@ -0,0 +1,44 @@
+#include "batchpricer.h"
+
+namespace pricer {
+
+BatchPricer::BatchPricer(const FdEngine::Config& config,
+        const AmericanEngine::Config& americanConfig)
+    : d_analytic()
+    , d_american(americanConfig)
+    , d_engine(config)
+{
+}
+
+void BatchPricer::price(PricingResults *results, const LegBatch& legs) const
+{
+    results->resize(legs.size());
+    price(results->outputs(), legs);
+}
+
+void BatchPricer::price(const PricingOutputs& outputs,
+        const LegBatch& legs) const
+{
+    legs.validate();
+
+    std::vector<char> priced;
+    d_analytic.price(outputs, &priced, legs);
+
+    std::vector<std::size_t> solves;
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        if (priced[i]) {
+            continue;
+        }
+        const Leg leg = legs.leg(i);
+        Greeks greeks;
+        if (leg.d_isAmerican && d_american.accept(&greeks, leg)) {
+            outputs.set(i, greeks);
+        }
+        else {
+            solves.push_back(i);
+        }
+    }
+    d_engine.price(outputs, legs, solves);
+}
+
+} // close namespace pricer
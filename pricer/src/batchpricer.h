@@ -0,0 +1,41 @@
+#ifndef _BATCHPRICER_H_
+#define _BATCHPRICER_H_
+
+#include "americanengine.h"
+#include "analyticengine.h"
+#include "fdengine.h"
+#include "legbatch.h"
+
+namespace pricer {
+
+// BatchPricer values every leg of a strategy in one call. European legs
+// are priced together by one vectorized closed-form call, and American legs
+// by the approximation of `AmericanEngine` when its error estimate is
+// within tolerance. The remaining legs, and European legs whose spot does
+// not cover the dividends, take a single finite difference solve that also
+// returns vega and rho.
+class BatchPricer {
+  private:
+    AnalyticEngine d_analytic;
+    AmericanEngine d_american;
+    FdEngine d_engine;
+
+  public:
+    explicit BatchPricer(
+            const FdEngine::Config& config = FdEngine::Config(),
+            const AmericanEngine::Config& americanConfig
+            = AmericanEngine::Config());
+
+    // Load into `results` the price and greeks of every leg in `legs`.
+    // Throw std::invalid_argument if `legs` is not valid.
+    void price(PricingResults *results, const LegBatch& legs) const;
+
+    // Load into `outputs`, which must have room for `legs.size()` entries,
+    // the price and greeks of every leg in `legs`. Throw
+    // std::invalid_argument if `legs` is not valid.
+    void price(const PricingOutputs& outputs, const LegBatch& legs) const;
+};
+
+} // close namespace pricer
+
+#endif
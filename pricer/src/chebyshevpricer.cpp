@@ -0,0 +1,500 @@
+#include "chebyshevpricer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace pricer {
+
+namespace {
+
+const double k_pi = 3.14159265358979323846;
+
+// The waits of the build thread are timed, as every wait rechecks its
+// condition anyway. Unlike `condition_variable::wait`, a timed wait is
+// compiled inline, so the library also loads against older C++ runtimes.
+const std::chrono::milliseconds k_waitPeriod(100);
+
+// The interpolated greeks, in the order of their coefficients.
+double Greeks::*const k_values[] = { &Greeks::d_price, &Greeks::d_delta,
+    &Greeks::d_gamma, &Greeks::d_vega, &Greeks::d_theta, &Greeks::d_rho };
+const int k_numValues = 6;
+
+// The check points of a surface on [-1, 1]^2 in spot and vol, away from
+// the nodes and spread over the domain.
+const double k_checks[ChebyshevSurface::k_CHECKS][2] = { { 0.13, 0.41 },
+    { -0.29, -0.17 }, { 0.57, -0.63 }, { -0.71, 0.77 } };
+
+// The narrowest half-width of a spot domain in log spot, for a leg so
+// close to expiry that sigma sqrt(T) vanishes.
+const double k_minSpotWidth = 1e-4;
+
+// Return the Chebyshev-Lobatto node `j` of `n` on [low, high], from `high`
+// at `j` = 0 down to `low`.
+double node(double low, double high, int j, int n)
+{
+    return 0.5 * (high + low)
+            + 0.5 * (high - low) * std::cos(k_pi * j / (n - 1));
+}
+
+// Return `u` in [-1, 1] mapped onto [low, high].
+double point(double low, double high, double u)
+{
+    return 0.5 * (high + low) + 0.5 * (high - low) * u;
+}
+
+// Return `x` in [low, high] mapped onto [-1, 1].
+double unit(double low, double high, double x)
+{
+    const double u = (2.0 * x - high - low) / (high - low);
+    return std::min(std::max(u, -1.0), 1.0);
+}
+
+// Load the Chebyshev polynomials T_0 to T_(n - 1) at `x` into `t`.
+void polynomials(double *t, int n, double x)
+{
+    t[0] = 1.0;
+    t[1] = x;
+    for (int i = 2; i < n; ++i) {
+        t[i] = 2.0 * x * t[i - 1] - t[i - 2];
+    }
+}
+
+// Replace the values at the `n` Lobatto nodes, `stride` apart from
+// `values`, by the coefficients of the Chebyshev series through them.
+void transform(double *values, int n, std::size_t stride)
+{
+    double f[ChebyshevSurface::k_MAX_NODES];
+    for (int j = 0; j < n; ++j) {
+        f[j] = values[j * stride];
+    }
+    const int m = n - 1;
+    for (int k = 0; k <= m; ++k) {
+        double sum = 0.5 * (f[0] + (k % 2 ? -f[m] : f[m]));
+        for (int j = 1; j < m; ++j) {
+            sum += f[j] * std::cos(k_pi * j * k / m);
+        }
+        const double c = 2.0 * sum / m;
+        values[k * stride] = k == 0 || k == m ? 0.5 * c : c;
+    }
+}
+
+// Worker solves the nodes of a surface and then its check points in turn,
+// taking the next from `d_next` until none is left.
+struct Worker {
+    const FdEngine *d_engine;
+    const Leg *d_leg;
+    const ChebyshevDomain *d_domain;
+    std::vector<Greeks> *d_values;
+    std::atomic<std::size_t> *d_next;
+
+    void operator()() const
+    {
+        const ChebyshevDomain& domain = *d_domain;
+        const std::size_t n = d_values->size();
+        const std::size_t nodes = domain.d_spotNodes * domain.d_volNodes;
+        while (true) {
+            const std::size_t i = d_next->fetch_add(1);
+            if (i >= n) {
+                break;
+            }
+            Leg leg = *d_leg;
+            if (i >= nodes) {
+                const double *check = k_checks[i - nodes];
+                leg.d_spot = point(domain.d_spotLow,
+                        domain.d_spotHigh,
+                        check[0]);
+                leg.d_vol = point(domain.d_volLow, domain.d_volHigh, check[1]);
+                (*d_values)[i] = d_engine->price(leg);
+                continue;
+            }
+            leg.d_spot = node(domain.d_spotLow,
+                    domain.d_spotHigh,
+                    static_cast<int>(i / domain.d_volNodes),
+                    domain.d_spotNodes);
+            leg.d_vol = node(domain.d_volLow,
+                    domain.d_volHigh,
+                    static_cast<int>(i % domain.d_volNodes),
+                    domain.d_volNodes);
+            (*d_values)[i] = d_engine->price(leg);
+        }
+    }
+};
+
+bool validNodes(int n)
+{
+    return n >= 2 && n <= ChebyshevSurface::k_MAX_NODES;
+}
+
+} // close unnamed namespace
+
+ChebyshevSurface::ChebyshevSurface(const Leg& leg,
+        const ChebyshevDomain& domain,
+        const FdEngine& engine,
+        int threads)
+    : d_domain(domain)
+    , d_strike(leg.d_strike)
+    , d_rate(leg.d_rate)
+    , d_expiry(leg.d_expiry)
+    , d_isCall(leg.d_isCall)
+    , d_isAmerican(leg.d_isAmerican)
+    , d_dividendTimes(leg.d_dividendTimes,
+              leg.d_dividendTimes + leg.d_numDividends)
+    , d_dividendAmounts(leg.d_dividendAmounts,
+              leg.d_dividendAmounts + leg.d_numDividends)
+    , d_error(0.0)
+{
+    if (!(domain.d_spotLow > 0.0) || !(domain.d_spotHigh > domain.d_spotLow)
+            || !(domain.d_volLow > 0.0)
+            || !(domain.d_volHigh > domain.d_volLow)) {
+        throw std::invalid_argument(
+                "domain must be a positive, non-empty rectangle");
+    }
+    if (!validNodes(domain.d_spotNodes) || !validNodes(domain.d_volNodes)) {
+        throw std::invalid_argument("domain has too few or too many nodes");
+    }
+
+    const int ns = domain.d_spotNodes;
+    const int nv = domain.d_volNodes;
+    std::vector<Greeks> values(ns * nv + k_CHECKS);
+    std::size_t count = threads > 0 ? threads
+                                    : std::thread::hardware_concurrency();
+    count = std::max<std::size_t>(std::min(count, values.size()), 1);
+    std::atomic<std::size_t> next(0);
+    const Worker worker = { &engine, &leg, &domain, &values, &next };
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < count; ++i) {
+        pool.push_back(std::thread(worker));
+    }
+    worker();
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+        pool[i].join();
+    }
+
+    // Coefficient (i, j) of greek q is at (i nv + j) k_numValues + q, so an
+    // evaluation accumulates the greeks side by side. The series is taken
+    // along the vols of each spot, then along the spots of each order in
+    // the vol.
+    d_coefficients.resize(ns * nv * k_numValues);
+    for (int i = 0; i < ns * nv; ++i) {
+        for (int q = 0; q < k_numValues; ++q) {
+            d_coefficients[i * k_numValues + q] = values[i].*k_values[q];
+        }
+    }
+    for (int q = 0; q < k_numValues; ++q) {
+        double *block = &d_coefficients[q];
+        for (int i = 0; i < ns; ++i) {
+            transform(block + i * nv * k_numValues, nv, k_numValues);
+        }
+        for (int j = 0; j < nv; ++j) {
+            transform(block + j * k_numValues, ns, nv * k_numValues);
+        }
+    }
+
+    for (int c = 0; c < k_CHECKS; ++c) {
+        const Greeks greeks = value(
+                point(domain.d_spotLow, domain.d_spotHigh, k_checks[c][0]),
+                point(domain.d_volLow, domain.d_volHigh, k_checks[c][1]));
+        d_error = std::max(d_error,
+                std::fabs(greeks.d_price - values[ns * nv + c].d_price));
+    }
+}
+
+bool ChebyshevSurface::covers(const Leg& leg) const
+{
+    if (leg.d_strike != d_strike || leg.d_rate != d_rate
+            || leg.d_expiry != d_expiry || leg.d_isCall != d_isCall
+            || leg.d_isAmerican != d_isAmerican
+            || leg.d_numDividends != d_dividendTimes.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < leg.d_numDividends; ++i) {
+        if (leg.d_dividendTimes[i] != d_dividendTimes[i]
+                || leg.d_dividendAmounts[i] != d_dividendAmounts[i]) {
+            return false;
+        }
+    }
+    return leg.d_spot >= d_domain.d_spotLow
+            && leg.d_spot <= d_domain.d_spotHigh
+            && leg.d_vol >= d_domain.d_volLow
+            && leg.d_vol <= d_domain.d_volHigh;
+}
+
+Greeks ChebyshevSurface::value(double spot, double vol) const
+{
+    const int ns = d_domain.d_spotNodes;
+    const int nv = d_domain.d_volNodes;
+    double ts[k_MAX_NODES];
+    double tv[k_MAX_NODES];
+    polynomials(ts,
+            ns,
+            unit(d_domain.d_spotLow, d_domain.d_spotHigh, spot));
+    polynomials(tv, nv, unit(d_domain.d_volLow, d_domain.d_volHigh, vol));
+
+    double sums[k_numValues] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    const double *c = &d_coefficients[0];
+    for (int i = 0; i < ns; ++i) {
+        for (int j = 0; j < nv; ++j) {
+            const double weight = ts[i] * tv[j];
+            for (int q = 0; q < k_numValues; ++q) {
+                sums[q] += weight * c[q];
+            }
+            c += k_numValues;
+        }
+    }
+
+    Greeks greeks;
+    for (int q = 0; q < k_numValues; ++q) {
+        greeks.*k_values[q] = sums[q];
+    }
+    return greeks;
+}
+
+ChebyshevPricer::Config::Config()
+    : d_spotNodes(12)
+    , d_volNodes(6)
+    , d_spotWidth(1.0)
+    , d_volWidth(0.3)
+    , d_tolerance(1e-3)
+    , d_threads(0)
+{
+}
+
+bool ChebyshevPricer::Key::operator<(const Key& other) const
+{
+    if (d_strike != other.d_strike) {
+        return d_strike < other.d_strike;
+    }
+    if (d_expiry != other.d_expiry) {
+        return d_expiry < other.d_expiry;
+    }
+    if (d_isCall != other.d_isCall) {
+        return d_isCall < other.d_isCall;
+    }
+    return d_isAmerican < other.d_isAmerican;
+}
+
+ChebyshevPricer::Key ChebyshevPricer::key(const Leg& leg)
+{
+    const Key key = { leg.d_strike, leg.d_expiry, leg.d_isCall,
+        leg.d_isAmerican };
+    return key;
+}
+
+ChebyshevDomain ChebyshevPricer::domain(const Leg& leg) const
+{
+    const double width = std::max(
+            d_config.d_spotWidth * leg.d_vol * std::sqrt(leg.d_expiry),
+            k_minSpotWidth);
+    const ChebyshevDomain domain = {
+        leg.d_spot * std::exp(-width),
+        leg.d_spot * std::exp(width),
+        leg.d_vol * (1.0 - d_config.d_volWidth),
+        leg.d_vol * (1.0 + d_config.d_volWidth),
+        d_config.d_spotNodes,
+        d_config.d_volNodes
+    };
+    return domain;
+}
+
+void ChebyshevPricer::solve(Greeks *greeks, const Leg& leg) const
+{
+    if (!leg.d_isAmerican || !d_american.accept(greeks, leg)) {
+        *greeks = d_engine.price(leg);
+    }
+}
+
+std::shared_ptr<const ChebyshevSurface> ChebyshevPricer::find(
+        const Leg& leg) const
+{
+    std::shared_ptr<const ChebyshevSurface> surface;
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        const Surfaces::const_iterator it = d_surfaces.find(key(leg));
+        if (it != d_surfaces.end()) {
+            surface = it->second;
+        }
+    }
+    if (surface && !surface->covers(leg)) {
+        surface.reset();
+    }
+    return surface;
+}
+
+void ChebyshevPricer::schedule(const Leg& leg)
+{
+    LegBatch job;
+    job.addLeg(leg.d_spot,
+            leg.d_strike,
+            leg.d_vol,
+            leg.d_rate,
+            leg.d_expiry,
+            leg.d_isCall,
+            leg.d_isAmerican,
+            std::vector<double>(leg.d_dividendTimes,
+                    leg.d_dividendTimes + leg.d_numDividends),
+            std::vector<double>(leg.d_dividendAmounts,
+                    leg.d_dividendAmounts + leg.d_numDividends));
+
+    const Key jobKey = key(leg);
+    std::lock_guard<std::mutex> lock(d_mutex);
+    for (std::size_t i = 0; i < d_queue.size(); ++i) {
+        const Key queued = key(d_queue[i].leg(0));
+        if (!(queued < jobKey) && !(jobKey < queued)) {
+            d_queue[i] = job;
+            return;
+        }
+    }
+    d_queue.push_back(job);
+    d_wakeup.notify_one();
+}
+
+void ChebyshevPricer::run()
+{
+    std::unique_lock<std::mutex> lock(d_mutex);
+    while (true) {
+        while (!d_stopping && d_queue.empty()) {
+            d_wakeup.wait_for(lock, k_waitPeriod);
+        }
+        if (d_stopping) {
+            break;
+        }
+        const LegBatch job = d_queue.front();
+        d_queue.pop_front();
+        const std::size_t generation = d_generation;
+        ++d_building;
+        lock.unlock();
+
+        const Leg leg = job.leg(0);
+        const std::shared_ptr<const ChebyshevSurface> surface(
+                new ChebyshevSurface(leg,
+                        domain(leg),
+                        d_engine,
+                        d_config.d_threads));
+
+        lock.lock();
+        if (generation == d_generation) {
+            d_surfaces[key(leg)] = surface;
+        }
+        --d_building;
+        if (d_queue.empty() && d_building == 0) {
+            d_idle.notify_all();
+        }
+    }
+}
+
+ChebyshevPricer::ChebyshevPricer(const Config& config,
+        const FdEngine::Config& fdConfig,
+        const AmericanEngine::Config& americanConfig)
+    : d_config(config)
+    , d_analytic()
+    , d_american(americanConfig)
+    , d_engine(fdConfig)
+    , d_building(0)
+    , d_generation(0)
+    , d_stopping(false)
+{
+    if (!(config.d_spotWidth > 0.0)
+            || !(config.d_volWidth > 0.0 && config.d_volWidth < 1.0)) {
+        throw std::invalid_argument(
+                "spot width must be positive and vol width in (0, 1)");
+    }
+    if (!(config.d_tolerance >= 0.0)) {
+        throw std::invalid_argument("tolerance must not be negative");
+    }
+    if (!validNodes(config.d_spotNodes) || !validNodes(config.d_volNodes)) {
+        throw std::invalid_argument("too few or too many nodes");
+    }
+    d_thread = std::thread(&ChebyshevPricer::run, this);
+}
+
+ChebyshevPricer::~ChebyshevPricer()
+{
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_stopping = true;
+    }
+    d_wakeup.notify_all();
+    d_thread.join();
+}
+
+void ChebyshevPricer::prepare(const LegBatch& legs)
+{
+    legs.validate();
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        const Leg leg = legs.leg(i);
+        Greeks greeks;
+        if (!leg.d_isAmerican && d_analytic.price(&greeks, leg)) {
+            continue;
+        }
+        const std::shared_ptr<const ChebyshevSurface> surface(
+                new ChebyshevSurface(leg,
+                        domain(leg),
+                        d_engine,
+                        d_config.d_threads));
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_surfaces[key(leg)] = surface;
+    }
+}
+
+bool ChebyshevPricer::price(Greeks *greeks, const Leg& leg)
+{
+    if (!leg.d_isAmerican && d_analytic.price(greeks, leg)) {
+        return true;
+    }
+    const std::shared_ptr<const ChebyshevSurface> surface = find(leg);
+    if (surface && surface->error() <= d_config.d_tolerance) {
+        *greeks = surface->value(leg.d_spot, leg.d_vol);
+        return true;
+    }
+    solve(greeks, leg);
+    if (!surface) {
+        schedule(leg);
+    }
+    return false;
+}
+
+std::size_t ChebyshevPricer::price(const PricingOutputs& outputs,
+        const LegBatch& legs)
+{
+    legs.validate();
+
+    std::vector<char> priced;
+    d_analytic.price(outputs, &priced, legs);
+
+    std::size_t solved = 0;
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        if (priced[i]) {
+            continue;
+        }
+        Greeks greeks;
+        if (!price(&greeks, legs.leg(i))) {
+            ++solved;
+        }
+        outputs.set(i, greeks);
+    }
+    return solved;
+}
+
+void ChebyshevPricer::wait()
+{
+    std::unique_lock<std::mutex> lock(d_mutex);
+    while (!d_queue.empty() || d_building > 0) {
+        d_idle.wait_for(lock, k_waitPeriod);
+    }
+}
+
+void ChebyshevPricer::clear()
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    d_surfaces.clear();
+    d_queue.clear();
+    ++d_generation;
+    if (d_building == 0) {
+        d_idle.notify_all();
+    }
+}
+
+} // close namespace pricer
@@ -0,0 +1,208 @@
+#ifndef _CHEBYSHEVPRICER_H_
+#define _CHEBYSHEVPRICER_H_
+
+#include "americanengine.h"
+#include "analyticengine.h"
+#include "fdengine.h"
+#include "legbatch.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pricer {
+
+// ChebyshevDomain is the rectangle of spots and vols a ChebyshevSurface
+// covers, with the number of Chebyshev nodes along each side.
+struct ChebyshevDomain {
+    double d_spotLow;
+    double d_spotHigh;
+    double d_volLow;
+    double d_volHigh;
+    int d_spotNodes;
+    int d_volNodes;
+};
+
+// ChebyshevSurface is an immutable tensor Chebyshev interpolant of the
+// finite difference price and greeks of one leg over spot and vol. Every
+// other input of the leg, its strike, expiry, rate, type and dividends, is
+// fixed. The values are solved at the Chebyshev-Lobatto nodes of the
+// domain, which include its edges, and turned into the coefficients of the
+// series in T_i(spot) T_j(vol), so an evaluation is two short recurrences
+// and one pass over the coefficients, a fraction of a microsecond.
+//
+// Each greek is interpolated from the greeks of the solves, not
+// differentiated from the price, since the gamma of an American leg jumps
+// at the exercise boundary where the series of the price converges slowest.
+//
+// The build also solves `k_CHECKS` points between the nodes, and `error`
+// is the largest difference between the interpolated and solved price
+// there, so a domain too wide for its nodes is detected.
+class ChebyshevSurface {
+  public:
+    enum {
+        k_MAX_NODES = 64,
+        k_CHECKS = 4
+    };
+
+  private:
+    ChebyshevDomain d_domain;
+    double d_strike;
+    double d_rate;
+    double d_expiry;
+    bool d_isCall;
+    bool d_isAmerican;
+    std::vector<double> d_dividendTimes;
+    std::vector<double> d_dividendAmounts;
+    std::vector<double> d_coefficients;
+    double d_error;
+
+  public:
+    // Solve `leg` with `engine` at the nodes of `domain` and at the check
+    // points, splitting the solves across `threads` threads, one per core
+    // if 0, and build the interpolant. The spot and vol of `leg` are
+    // ignored. Throw
+    // std::invalid_argument if the domain is empty or not positive, or has
+    // fewer than two or more than `k_MAX_NODES` nodes along a side.
+    ChebyshevSurface(const Leg& leg,
+            const ChebyshevDomain& domain,
+            const FdEngine& engine,
+            int threads = 0);
+
+    const ChebyshevDomain& domain() const { return d_domain; }
+
+    // Return the largest price error at the check points.
+    double error() const { return d_error; }
+
+    // Return true if `leg` differs from the leg of the surface only in its
+    // spot and vol, and those lie inside the domain.
+    bool covers(const Leg& leg) const;
+
+    // Return the interpolated price and greeks at `spot` and `vol`, which
+    // must lie inside the domain.
+    Greeks value(double spot, double vol) const;
+};
+
+// ChebyshevPricer prices legs from the ChebyshevSurface of their strike,
+// expiry and type, for an interactive screen that reprices the same legs
+// at many spots and vols. European legs the closed form accepts are priced
+// by it directly, as it is as fast as the interpolant.
+//
+// The spot domain of a surface spans a number of standard deviations
+// sigma sqrt(T) of the log spot either side of the spot, so a short-dated
+// leg, whose price bends sharply around the strike, gets nodes as dense
+// relative to that bend as a long-dated one.
+//
+// A leg no surface covers, because its spot or vol moved outside the
+// domain or its rate or dividends changed, is priced directly as
+// BatchPricer prices it, and a surface centred on it is queued for a
+// background thread, which publishes it when done. Surfaces are replaced
+// whole, so a caller never sees one half built. A surface whose error at
+// its check points exceeds the tolerance is kept, so it is not rebuilt
+// while the leg stays in its domain, but the legs it covers are priced
+// directly.
+//
+// All functions may be called from any thread.
+class ChebyshevPricer {
+  public:
+    struct Config {
+        int d_spotNodes;     // Chebyshev nodes along the spot
+        int d_volNodes;      // Chebyshev nodes along the vol
+        double d_spotWidth;  // half-width of the spot domain, in std devs
+        double d_volWidth;   // half-width of the vol domain, relative
+        double d_tolerance;  // largest accepted surface error, in currency
+        int d_threads;       // threads of one build, 0 for one per core
+
+        Config();
+    };
+
+  private:
+    struct Key {
+        double d_strike;
+        double d_expiry;
+        bool d_isCall;
+        bool d_isAmerican;
+
+        bool operator<(const Key& other) const;
+    };
+
+    typedef std::map<Key, std::shared_ptr<const ChebyshevSurface> > Surfaces;
+
+    Config d_config;
+    AnalyticEngine d_analytic;
+    AmericanEngine d_american;
+    FdEngine d_engine;
+    mutable std::mutex d_mutex;
+    std::condition_variable d_wakeup;
+    std::condition_variable d_idle;
+    Surfaces d_surfaces;
+    std::deque<LegBatch> d_queue;
+    std::size_t d_building;
+    std::size_t d_generation;
+    bool d_stopping;
+    std::thread d_thread;
+
+    static Key key(const Leg& leg);
+
+    ChebyshevDomain domain(const Leg& leg) const;
+
+    // Load into `greeks` the price and greeks of `leg` without a surface.
+    void solve(Greeks *greeks, const Leg& leg) const;
+
+    // Return the surface that covers `leg`, or an empty pointer.
+    std::shared_ptr<const ChebyshevSurface> find(const Leg& leg) const;
+
+    // Queue the build of a surface centred on `leg`, in place of a queued
+    // build of the same key, which would be centred on an older spot.
+    void schedule(const Leg& leg);
+
+    // Build the queued surfaces until `d_stopping` is set.
+    void run();
+
+  public:
+    // Create a pricer with no surfaces and start its build thread. Throw
+    // std::invalid_argument if the spot width is not positive, the vol
+    // width is not in (0, 1), the tolerance is negative or a node count is
+    // not in [2, ChebyshevSurface::k_MAX_NODES].
+    explicit ChebyshevPricer(const Config& config = Config(),
+            const FdEngine::Config& fdConfig = FdEngine::Config(),
+            const AmericanEngine::Config& americanConfig
+            = AmericanEngine::Config());
+
+    ~ChebyshevPricer();
+
+    const Config& config() const { return d_config; }
+
+    // Build in the calling thread the surface centred on each leg of
+    // `legs` the closed form does not price, replacing the one of its key,
+    // such as after a refresh of the market data. Throw
+    // std::invalid_argument if `legs` is not valid.
+    void prepare(const LegBatch& legs);
+
+    // Load into `greeks` the price and greeks of the valid `leg` and return
+    // true if they came from a surface or the closed form, or false if
+    // `leg` was priced directly, with a surface for it queued unless the
+    // one covering it failed its check.
+    bool price(Greeks *greeks, const Leg& leg);
+
+    // Load into `outputs`, which must have room for `legs.size()` entries,
+    // the price and greeks of every leg in `legs`, and return the number
+    // of legs solved directly. Throw std::invalid_argument if `legs` is not
+    // valid.
+    std::size_t price(const PricingOutputs& outputs, const LegBatch& legs);
+
+    // Block until the queued surfaces are built.
+    void wait();
+
+    // Drop every surface, such as after the valuation date moves.
+    void clear();
+};
+
+} // close namespace pricer
+
+#endif
@@ -0,0 +1,413 @@
+#include "discountcurve.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace pricer {
+
+namespace {
+
+const double k_daysPerYear = 365.0;
+
+// Load into `g` the deviation of the monotone convex forward from the
+// discrete forward of its interval at the fraction `x` of the interval,
+// and into `integral` its integral from 0 to `x`, for the deviations `g0`
+// and `g1` at the ends. The sectors are those of Hagan and West.
+void forwardDeviation(double *g,
+        double *integral,
+        double g0,
+        double g1,
+        double x)
+{
+    if (g0 == 0.0 && g1 == 0.0) {
+        *g = 0.0;
+        *integral = 0.0;
+        return;
+    }
+    const double x2 = x * x;
+    const double x3 = x2 * x;
+    if ((g0 < 0.0 && -0.5 * g0 <= g1 && g1 <= -2.0 * g0)
+            || (g0 > 0.0 && -0.5 * g0 >= g1 && g1 >= -2.0 * g0)) {
+        // (i) the quadratic through both ends.
+        *g = g0 * (1.0 - 4.0 * x + 3.0 * x2) + g1 * (-2.0 * x + 3.0 * x2);
+        *integral = g0 * (x - 2.0 * x2 + x3) + g1 * (x3 - x2);
+    }
+    else if ((g0 < 0.0 && g1 > -2.0 * g0) || (g0 > 0.0 && g1 < -2.0 * g0)) {
+        // (ii) flat, then quadratic up to g1.
+        const double eta = (g1 + 2.0 * g0) / (g1 - g0);
+        if (x <= eta) {
+            *g = g0;
+            *integral = g0 * x;
+        }
+        else {
+            const double u = (x - eta) / (1.0 - eta);
+            *g = g0 + (g1 - g0) * u * u;
+            *integral = g0 * x + (g1 - g0) * u * u * (x - eta) / 3.0;
+        }
+    }
+    else if ((g0 > 0.0 && 0.0 > g1 && g1 > -0.5 * g0)
+            || (g0 < 0.0 && 0.0 < g1 && g1 < -0.5 * g0)) {
+        // (iii) quadratic from g0, then flat.
+        const double eta = 3.0 * g1 / (g1 - g0);
+        if (x < eta) {
+            const double u = (eta - x) / eta;
+            *g = g1 + (g0 - g1) * u * u;
+            *integral = g1 * x + (g0 - g1) * eta * (1.0 - u * u * u) / 3.0;
+        }
+        else {
+            *g = g1;
+            *integral = g1 * x + (g0 - g1) * eta / 3.0;
+        }
+    }
+    else {
+        // (iv) both ends on one side, through a turning value A.
+        const double eta = g1 / (g1 + g0);
+        const double a = -g0 * g1 / (g0 + g1);
+        if (x < eta) {
+            const double u = (eta - x) / eta;
+            *g = a + (g0 - a) * u * u;
+            *integral = a * x + (g0 - a) * eta * (1.0 - u * u * u) / 3.0;
+        }
+        else {
+            const double left = (g0 - a) * eta / 3.0;
+            const double u = eta < 1.0 ? (x - eta) / (1.0 - eta) : 0.0;
+            *g = a + (g1 - a) * u * u;
+            *integral = a * x + left + (g1 - a) * u * u * (x - eta) / 3.0;
+        }
+    }
+}
+
+// Return the discount factor at `day` from the first `count` of the node
+// `discounts` at `days`, log-linear between them and with a flat forward
+// beyond the last.
+double logLinearDiscount(const std::vector<int>& days,
+        const std::vector<double>& discounts,
+        std::size_t count,
+        int day)
+{
+    int d0 = 0;
+    double p0 = 1.0;
+    std::size_t i = 0;
+    while (i < count && days[i] < day) {
+        d0 = days[i];
+        p0 = discounts[i];
+        ++i;
+    }
+    if (i < count) {
+        const double x = double(day - d0) / (days[i] - d0);
+        return p0 * std::pow(discounts[i] / p0, x);
+    }
+    if (count == 0) {
+        return 1.0;
+    }
+    const int dPrev = count > 1 ? days[count - 2] : 0;
+    const double pPrev = count > 1 ? discounts[count - 2] : 1.0;
+    const double rate = std::log(pPrev / discounts[count - 1])
+            / (days[count - 1] - dPrev);
+    return discounts[count - 1] * std::exp(-rate * (day - days[count - 1]));
+}
+
+// Bootstrap `discounts` of the swaps `from` on. A coupon between nodes is
+// discounted on `guess` if given, and log-linearly otherwise. Return true
+// if any coupon fell between nodes.
+bool bootstrap(std::vector<double> *discounts,
+        const std::vector<int>& days,
+        const std::vector<double>& rates,
+        double basis,
+        std::size_t from,
+        const DiscountCurve *guess)
+{
+    bool between = false;
+    for (std::size_t i = from; i < days.size(); ++i) {
+        const double r = rates[i];
+        const int maturity = days[i];
+
+        // Coupons fall yearly back from maturity, with a short first one.
+        std::vector<int> coupons;
+        for (int day = maturity; day > 0; day -= 365) {
+            coupons.push_back(day);
+        }
+        std::reverse(coupons.begin(), coupons.end());
+
+        double annuity = 0.0;
+        int start = 0;
+        std::size_t node = 0;
+        for (std::size_t j = 0; j + 1 < coupons.size(); ++j) {
+            const int day = coupons[j];
+            while (node < i && days[node] < day) {
+                ++node;
+            }
+            double p;
+            if (node < i && days[node] == day) {
+                p = (*discounts)[node];
+            }
+            else {
+                between = true;
+                p = guess ? guess->discount(day / k_daysPerYear)
+                          : logLinearDiscount(days, *discounts, i, day);
+            }
+            annuity += (day - start) / basis * p;
+            start = day;
+        }
+        const double tau = (maturity - start) / basis;
+        const double p = (1.0 - r * annuity) / (1.0 + r * tau);
+        if (!(p > 0.0)) {
+            throw std::invalid_argument(
+                    "swap quote implies a non-positive discount factor");
+        }
+        (*discounts)[i] = p;
+    }
+    return between;
+}
+
+} // close unnamed namespace
+
+DiscountCurve::DiscountCurve(const std::vector<double>& times,
+        const std::vector<double>& discounts,
+        const DiscountCurve *previous)
+{
+    const std::size_t n = times.size();
+    if (n == 0) {
+        throw std::invalid_argument("curve has no nodes");
+    }
+    if (discounts.size() != n) {
+        throw std::invalid_argument("curve arrays differ in length");
+    }
+    d_times.push_back(0.0);
+    d_logDiscounts.push_back(0.0);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!(times[i] > d_times.back())) {
+            throw std::invalid_argument(
+                    "curve times must be positive and increasing");
+        }
+        if (!(discounts[i] > 0.0)) {
+            throw std::invalid_argument(
+                    "curve discount factors must be positive");
+        }
+        d_times.push_back(times[i]);
+        d_logDiscounts.push_back(-std::log(discounts[i]));
+    }
+
+    // Discrete forwards of the intervals, and node forwards weighted by
+    // the lengths of the adjacent intervals.
+    d_discreteForwards.resize(n + 1);
+    for (std::size_t i = 1; i <= n; ++i) {
+        d_discreteForwards[i] = (d_logDiscounts[i] - d_logDiscounts[i - 1])
+                / (d_times[i] - d_times[i - 1]);
+    }
+    d_nodeForwards.resize(n + 1);
+    for (std::size_t i = 1; i < n; ++i) {
+        const double left = d_times[i] - d_times[i - 1];
+        const double right = d_times[i + 1] - d_times[i];
+        d_nodeForwards[i] = (left * d_discreteForwards[i + 1]
+                                    + right * d_discreteForwards[i])
+                / (left + right);
+    }
+    if (n == 1) {
+        d_nodeForwards[0] = d_discreteForwards[1];
+        d_nodeForwards[1] = d_discreteForwards[1];
+    }
+    else {
+        d_nodeForwards[0] = d_discreteForwards[1]
+                - 0.5 * (d_nodeForwards[1] - d_discreteForwards[1]);
+        d_nodeForwards[n] = d_discreteForwards[n]
+                - 0.5 * (d_nodeForwards[n - 1] - d_discreteForwards[n]);
+    }
+
+    // Interval i depends on the node discount factors i - 2 to i + 1, so
+    // the days up to node c - 2 of the first changed node c are reused.
+    const std::size_t days = static_cast<std::size_t>(
+            std::ceil(d_times[n] * k_daysPerYear));
+    d_daily.resize(days + 1);
+    std::size_t reuse = 0;
+    if (previous && previous->d_times == d_times) {
+        std::size_t changed = 1;
+        while (changed <= n
+                && previous->d_logDiscounts[changed]
+                        == d_logDiscounts[changed]) {
+            ++changed;
+        }
+        if (changed > n) {
+            reuse = days + 1;
+        }
+        else if (changed >= 3) {
+            reuse = static_cast<std::size_t>(
+                    d_times[changed - 2] * k_daysPerYear) + 1;
+        }
+        std::copy(previous->d_daily.begin(),
+                previous->d_daily.begin() + reuse,
+                d_daily.begin());
+    }
+    for (std::size_t day = reuse; day <= days; ++day) {
+        d_daily[day] = std::exp(-logDiscount(day / k_daysPerYear));
+    }
+}
+
+double DiscountCurve::logDiscount(double t) const
+{
+    const std::size_t n = d_times.size() - 1;
+    if (t >= d_times[n]) {
+        return d_logDiscounts[n] + d_nodeForwards[n] * (t - d_times[n]);
+    }
+    const std::size_t i = std::upper_bound(d_times.begin(), d_times.end(), t)
+            - d_times.begin();
+    const double length = d_times[i] - d_times[i - 1];
+    const double fd = d_discreteForwards[i];
+    double g;
+    double integral;
+    forwardDeviation(&g,
+            &integral,
+            d_nodeForwards[i - 1] - fd,
+            d_nodeForwards[i] - fd,
+            (t - d_times[i - 1]) / length);
+    return d_logDiscounts[i - 1] + (t - d_times[i - 1]) * fd
+            + length * integral;
+}
+
+double DiscountCurve::discount(double t) const
+{
+    const double day = t * k_daysPerYear;
+    const double whole = std::floor(day + 0.5);
+    if (std::fabs(day - whole) <= 1e-9 * (1.0 + whole) && whole >= 0.0
+            && whole < d_daily.size()) {
+        return d_daily[static_cast<std::size_t>(whole)];
+    }
+    return std::exp(-logDiscount(t));
+}
+
+double DiscountCurve::zeroRate(double t) const
+{
+    if (t <= 0.0) {
+        return d_nodeForwards[0];
+    }
+    return -std::log(discount(t)) / t;
+}
+
+double DiscountCurve::forwardRate(double t1, double t2) const
+{
+    if (t1 == t2) {
+        return instantaneousForward(t1);
+    }
+    return std::log(discount(t1) / discount(t2)) / (t2 - t1);
+}
+
+double DiscountCurve::instantaneousForward(double t) const
+{
+    const std::size_t n = d_times.size() - 1;
+    if (t >= d_times[n]) {
+        return d_nodeForwards[n];
+    }
+    const std::size_t i = std::upper_bound(d_times.begin(), d_times.end(),
+                                  std::max(t, 0.0))
+            - d_times.begin();
+    const double length = d_times[i] - d_times[i - 1];
+    const double fd = d_discreteForwards[i];
+    double g;
+    double integral;
+    forwardDeviation(&g,
+            &integral,
+            d_nodeForwards[i - 1] - fd,
+            d_nodeForwards[i] - fd,
+            (std::max(t, 0.0) - d_times[i - 1]) / length);
+    return fd + g;
+}
+
+void applyCurve(LegBatch *legs, const DiscountCurve& curve)
+{
+    for (std::size_t i = 0; i < legs->size(); ++i) {
+        legs->d_rate[i] = curve.zeroRate(legs->d_expiry[i]);
+    }
+}
+
+CurveBuilder::Config::Config()
+    : d_dayBasis(360.0)
+    , d_maxPasses(20)
+{
+}
+
+CurveBuilder::CurveBuilder(const Config& config)
+    : d_config(config)
+    , d_firstChanged(0)
+{
+}
+
+void CurveBuilder::setQuotes(const std::vector<int>& days,
+        const std::vector<double>& rates)
+{
+    if (days.empty()) {
+        throw std::invalid_argument("curve has no quotes");
+    }
+    if (rates.size() != days.size()) {
+        throw std::invalid_argument("days and rates differ in length");
+    }
+    for (std::size_t i = 0; i < days.size(); ++i) {
+        if (!(days[i] > (i == 0 ? 0 : days[i - 1]))) {
+            throw std::invalid_argument(
+                    "quote days must be positive and increasing");
+        }
+    }
+    d_days = days;
+    d_rates = rates;
+    d_discounts.assign(days.size(), 1.0);
+    d_firstChanged = 0;
+}
+
+void CurveBuilder::updateQuote(std::size_t index, double rate)
+{
+    if (index >= d_rates.size()) {
+        throw std::invalid_argument("no swap quote at this index");
+    }
+    if (d_rates[index] != rate) {
+        d_rates[index] = rate;
+        d_firstChanged = std::min(d_firstChanged, index);
+    }
+}
+
+std::shared_ptr<const DiscountCurve> CurveBuilder::publish()
+{
+    const std::size_t n = d_days.size();
+    if (d_firstChanged >= n) {
+        return curve();
+    }
+
+    std::vector<double> times(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        times[i] = d_days[i] / k_daysPerYear;
+    }
+    std::vector<double> discounts = d_discounts;
+    const double basis = d_config.d_dayBasis;
+    const bool between = bootstrap(
+            &discounts, d_days, d_rates, basis, d_firstChanged, 0);
+    const std::shared_ptr<const DiscountCurve> previous = curve();
+    std::shared_ptr<const DiscountCurve> result(
+            new DiscountCurve(times, discounts, previous.get()));
+
+    // Coupons between nodes depend on the interpolant, and so on later
+    // nodes: bootstrap again against the last pass until it settles.
+    for (int pass = 1; between && pass < d_config.d_maxPasses; ++pass) {
+        std::vector<double> next = discounts;
+        bootstrap(&next, d_days, d_rates, basis, 0, result.get());
+        double change = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            change = std::max(change, std::fabs(next[i] - discounts[i]));
+        }
+        discounts.swap(next);
+        result.reset(new DiscountCurve(times, discounts, previous.get()));
+        if (change <= 1e-15) {
+            break;
+        }
+    }
+
+    d_discounts.swap(discounts);
+    d_firstChanged = n;
+    std::atomic_store(&d_current, result);
+    return result;
+}
+
+std::shared_ptr<const DiscountCurve> CurveBuilder::curve() const
+{
+    return std::atomic_load(&d_current);
+}
+
+} // close namespace pricer
@@ -0,0 +1,123 @@
+#ifndef _DISCOUNTCURVE_H_
+#define _DISCOUNTCURVE_H_
+
+#include "legbatch.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace pricer {
+
+// DiscountCurve is an immutable zero curve on the node times of the
+// instruments it was bootstrapped from, in year fractions (Actual/365)
+// from the valuation date. Between the nodes the instantaneous forward is
+// the monotone convex interpolant of Hagan and West (2006), which is
+// continuous, reprices the node discount factors exactly and does not
+// overshoot between them; beyond the last node the forward is flat.
+//
+// The discount factor of every whole day up to the last node is computed
+// once, so a lookup at a day count maturity, as all maturities of the
+// pricer are, is one array read. Other times are interpolated directly.
+class DiscountCurve {
+  private:
+    std::vector<double> d_times;
+    std::vector<double> d_logDiscounts;
+    std::vector<double> d_discreteForwards;
+    std::vector<double> d_nodeForwards;
+    std::vector<double> d_daily;
+
+    // Return -ln P(0, t) from the interpolant, without the daily cache.
+    double logDiscount(double t) const;
+
+  public:
+    // Create the curve through the discount factors `discounts` at the
+    // increasing, positive `times`. Reuse the daily discount factors of
+    // `previous` up to the first node where the curves can differ, if
+    // `previous` is given and has the same times. Throw
+    // std::invalid_argument if there are no nodes, the sizes differ, the
+    // times are not increasing or a discount factor is not positive.
+    DiscountCurve(const std::vector<double>& times,
+            const std::vector<double>& discounts,
+            const DiscountCurve *previous = 0);
+
+    const std::vector<double>& times() const { return d_times; }
+
+    double discount(double t) const;
+
+    // Return the continuously compounded zero rate to `t`, the
+    // instantaneous forward at 0 if `t` is 0.
+    double zeroRate(double t) const;
+
+    // Return the continuously compounded forward rate from `t1` to `t2`,
+    // the instantaneous forward at `t1` if they are equal.
+    double forwardRate(double t1, double t2) const;
+
+    double instantaneousForward(double t) const;
+};
+
+// Set the rate of every leg of `legs` to the zero rate of `curve` to its
+// expiry, so the discounting of a European leg follows the curve exactly.
+void applyCurve(LegBatch *legs, const DiscountCurve& curve);
+
+// CurveBuilder bootstraps a DiscountCurve from the par rates of overnight
+// index swaps, such as the EUR ESTR, GBP SONIA and CHF SARON curves of
+// Bloomberg. A swap of up to one year pays once at maturity, so its
+// discount factor is 1 / (1 + r tau). A longer swap pays annual fixed
+// coupons back from maturity, with a short first period, so its discount
+// factor solves the par condition r sum(tau_j P(t_j)) = 1 - P(T) from the
+// discount factors of the earlier coupons. Accruals are the days over
+// `d_dayBasis`.
+//
+// The bootstrap is sequential, so a new quote re-bootstraps only its node
+// and the ones after it. When a coupon falls strictly between two nodes
+// its discount factor comes from the interpolant, and the whole curve is
+// bootstrapped again against the previous pass until it settles.
+//
+// `setQuotes`, `updateQuote` and `publish` are for one writer thread;
+// `curve` may be called from any thread, as for VolSurfaceBuilder.
+class CurveBuilder {
+  public:
+    struct Config {
+        double d_dayBasis; // 360 for ESTR and SARON, 365 for SONIA
+        int d_maxPasses;   // passes with coupons between nodes
+
+        Config();
+    };
+
+  private:
+    Config d_config;
+    std::vector<int> d_days;
+    std::vector<double> d_rates;
+    std::vector<double> d_discounts;
+    std::size_t d_firstChanged;
+    std::shared_ptr<const DiscountCurve> d_current;
+
+  public:
+    explicit CurveBuilder(const Config& config = Config());
+
+    const Config& config() const { return d_config; }
+
+    // Replace all quotes by the par `rates` of the swaps maturing after
+    // `days`. Throw std::invalid_argument if there are no quotes, the
+    // sizes differ or the days are not increasing and positive.
+    void setQuotes(const std::vector<int>& days,
+            const std::vector<double>& rates);
+
+    // Set the par rate of the swap `index` to `rate`. Throw
+    // std::invalid_argument if there is no such swap.
+    void updateQuote(std::size_t index, double rate);
+
+    // Bootstrap the nodes from the first changed quote on and publish the
+    // curve, or keep the current one if no quote changed. Throw
+    // std::invalid_argument if a quote implies a discount factor that is
+    // not positive, keeping the current curve.
+    std::shared_ptr<const DiscountCurve> publish();
+
+    // Return the last published curve, empty before the first publish.
+    std::shared_ptr<const DiscountCurve> curve() const;
+};
+
+} // close namespace pricer
+
+#endif
@@ -0,0 +1,201 @@
+#include "europeankernel.h"
+#include "europeankernelimpl.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace pricer {
+
+#ifdef PRICER_HAVE_AVX2
+void priceEuropeanAvx2(const EuropeanOutputs& outputs,
+        const EuropeanInputs& inputs,
+        EuropeanKernel::Model model,
+        EuropeanKernel::Payoff payoff);
+#endif
+#ifdef PRICER_HAVE_AVX512
+void priceEuropeanAvx512(const EuropeanOutputs& outputs,
+        const EuropeanInputs& inputs,
+        EuropeanKernel::Model model,
+        EuropeanKernel::Payoff payoff);
+#endif
+
+namespace {
+
+// One double at a time, with the same operations as the vector paths.
+struct ScalarTraits {
+    typedef double Vec;
+    typedef bool Mask;
+    enum { k_width = 1 };
+
+    static Vec set1(double x) { return x; }
+    static Vec load(const double *p) { return *p; }
+    static void store(double *p, Vec x) { *p = x; }
+    static Vec add(Vec a, Vec b) { return a + b; }
+    static Vec sub(Vec a, Vec b) { return a - b; }
+    static Vec mul(Vec a, Vec b) { return a * b; }
+    static Vec div(Vec a, Vec b) { return a / b; }
+    static Vec fmadd(Vec a, Vec b, Vec c) { return a * b + c; }
+    static Vec sqrt(Vec x) { return std::sqrt(x); }
+    static Vec min(Vec a, Vec b) { return b < a ? b : a; }
+    static Vec max(Vec a, Vec b) { return a < b ? b : a; }
+    static Vec abs(Vec x) { return std::fabs(x); }
+    static Mask lt(Vec a, Vec b) { return a < b; }
+    static Vec blend(Mask m, Vec a, Vec b) { return m ? a : b; }
+    static Vec round(Vec x) { return std::nearbyint(x); }
+
+    static Vec pow2(Vec n)
+    {
+        const unsigned long long bits
+                = static_cast<unsigned long long>(
+                          static_cast<long long>(n) + 1023)
+                << 52;
+        double result;
+        std::memcpy(&result, &bits, sizeof result);
+        return result;
+    }
+
+    static Vec exponent(Vec x)
+    {
+        unsigned long long bits;
+        std::memcpy(&bits, &x, sizeof bits);
+        return static_cast<double>(
+                static_cast<long long>(bits >> 52) - 1023);
+    }
+
+    static Vec mantissa(Vec x)
+    {
+        unsigned long long bits;
+        std::memcpy(&bits, &x, sizeof bits);
+        bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+        double result;
+        std::memcpy(&result, &bits, sizeof result);
+        return result;
+    }
+};
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !fma || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+bool cpuHasAvx512()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    if (!cpuHasAvx2() || (_xgetbv(0) & 0xe6) != 0xe6) {
+        return false;
+    }
+    int info[4];
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 16)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    return __builtin_cpu_supports("avx512f");
+#else
+    return false;
+#endif
+}
+
+EuropeanKernel::Isa detectIsa()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+#endif
+#ifdef PRICER_HAVE_AVX512
+    if (cpuHasAvx512()) {
+        return EuropeanKernel::e_AVX512;
+    }
+#endif
+#ifdef PRICER_HAVE_AVX2
+    if (cpuHasAvx2()) {
+        return EuropeanKernel::e_AVX2;
+    }
+#endif
+    return EuropeanKernel::e_SCALAR;
+}
+}
+
+EuropeanKernel::Isa EuropeanKernel::bestIsa()
+{
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+const char *EuropeanKernel::isaName(Isa isa)
+{
+    switch (isa) {
+    case e_AVX2:
+        return "avx2";
+    case e_AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+void EuropeanKernel::price(const EuropeanOutputs& outputs,
+        const EuropeanInputs& inputs,
+        Model model)
+{
+    price(outputs, inputs, model, bestIsa());
+}
+
+EuropeanKernel::Payoff EuropeanKernel::payoff(const EuropeanInputs& inputs)
+{
+    std::size_t calls = 0;
+    for (std::size_t i = 0; i < inputs.d_size; ++i) {
+        calls += inputs.d_isCall[i] != 0;
+    }
+    return calls == inputs.d_size ? e_CALLS
+            : calls == 0          ? e_PUTS
+                                  : e_MIXED;
+}
+
+void EuropeanKernel::price(const EuropeanOutputs& outputs,
+        const EuropeanInputs& inputs,
+        Model model,
+        Isa isa)
+{
+    price(outputs, inputs, model, isa, payoff(inputs));
+}
+
+void EuropeanKernel::price(const EuropeanOutputs& outputs,
+        const EuropeanInputs& inputs,
+        Model model,
+        Isa isa,
+        Payoff payoff)
+{
+    switch (isa) {
+#ifdef PRICER_HAVE_AVX512
+    case e_AVX512:
+        priceEuropeanAvx512(outputs, inputs, model, payoff);
+        return;
+#endif
+#ifdef PRICER_HAVE_AVX2
+    case e_AVX2:
+        priceEuropeanAvx2(outputs, inputs, model, payoff);
+        return;
+#endif
+    default:
+        priceAll<ScalarTraits>(outputs, inputs, model, payoff);
+        return;
+    }
+}
+
+} // close namespace pricer
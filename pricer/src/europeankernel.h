@@ -0,0 +1,98 @@
+#ifndef _EUROPEANKERNEL_H_
+#define _EUROPEANKERNEL_H_
+
+#include <cstddef>
+
+namespace pricer {
+
+// EuropeanInputs is a structure-of-arrays view of `d_size` European
+// options. Under Black-76 `d_spot` holds the forward and `d_dividendYield`
+// is ignored.
+struct EuropeanInputs {
+    const double *d_spot;
+    const double *d_strike;
+    const double *d_vol;
+    const double *d_rate;
+    const double *d_dividendYield;
+    const double *d_expiry;
+    const char *d_isCall;
+    std::size_t d_size;
+};
+
+// EuropeanOutputs receives one value per option in each array. Theta is
+// per year of calendar time; vega, vanna and volga are per 1.0 of
+// volatility and rho per 1.0 of rate.
+struct EuropeanOutputs {
+    double *d_price;
+    double *d_delta;
+    double *d_gamma;
+    double *d_vega;
+    double *d_theta;
+    double *d_rho;
+    double *d_vanna;
+    double *d_volga;
+};
+
+// EuropeanKernel evaluates Black-Scholes or Black-76 prices with first and
+// second order greeks over whole batches. The same kernel is compiled for
+// scalar, AVX2 and AVX-512 code, with polynomial exp, log and normal CDF so
+// that every path returns the same results to rounding; `price` picks the
+// widest path the CPU supports.
+//
+// The kernel is also compiled for each model, for batches of only calls,
+// only puts or both, and for batches with and without a dividend yield.
+// `price` chooses among them once per batch, from `d_isCall` and from
+// whether `d_dividendYield` is null, so a batch of one payoff type carries
+// no sign and one without a yield no carry.
+struct EuropeanKernel {
+    enum Model {
+        e_BLACK_SCHOLES = 0,
+        e_BLACK76 = 1
+    };
+
+    enum Isa {
+        e_SCALAR = 0,
+        e_AVX2 = 1,
+        e_AVX512 = 2
+    };
+
+    enum Payoff {
+        e_MIXED = 0,
+        e_CALLS = 1,
+        e_PUTS = 2
+    };
+
+    // Return the widest instruction set both compiled in and supported by
+    // the running CPU.
+    static Isa bestIsa();
+
+    static const char *isaName(Isa isa);
+
+    // Return e_CALLS or e_PUTS if every option of `inputs` is of that type,
+    // and e_MIXED otherwise.
+    static Payoff payoff(const EuropeanInputs& inputs);
+
+    static void price(const EuropeanOutputs& outputs,
+            const EuropeanInputs& inputs,
+            Model model = e_BLACK_SCHOLES);
+
+    // Price with the given instruction set, which must not be wider than
+    // `bestIsa()`. The scalar path is the reference for tests.
+    static void price(const EuropeanOutputs& outputs,
+            const EuropeanInputs& inputs,
+            Model model,
+            Isa isa);
+
+    // Price with the kernel for `payoff`, which must be e_MIXED unless
+    // every option is of that type. The mixed kernel with a yield, even a
+    // zero one, is the generic path the others are measured against.
+    static void price(const EuropeanOutputs& outputs,
+            const EuropeanInputs& inputs,
+            Model model,
+            Isa isa,
+            Payoff payoff);
+};
+
+} // close namespace pricer
+
+#endif
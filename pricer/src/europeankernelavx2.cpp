@@ -0,0 +1,84 @@
+// Compiled with AVX2 and FMA enabled; only called after the CPU check in
+// europeankernel.cpp.
+#include "europeankernel.h"
+#include "europeankernelimpl.h"
+
+#include <immintrin.h>
+
+namespace pricer {
+
+namespace {
+
+struct Avx2Traits {
+    typedef __m256d Vec;
+    typedef __m256d Mask;
+    enum { k_width = 4 };
+
+    static Vec set1(double x) { return _mm256_set1_pd(x); }
+    static Vec load(const double *p) { return _mm256_loadu_pd(p); }
+    static void store(double *p, Vec x) { _mm256_storeu_pd(p, x); }
+    static Vec add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm256_div_pd(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c)
+    {
+        return _mm256_fmadd_pd(a, b, c);
+    }
+    static Vec sqrt(Vec x) { return _mm256_sqrt_pd(x); }
+    static Vec min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+
+    static Vec abs(Vec x)
+    {
+        return _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+    }
+
+    static Mask lt(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+
+    static Vec blend(Mask m, Vec a, Vec b)
+    {
+        return _mm256_blendv_pd(b, a, m);
+    }
+
+    static Vec round(Vec x)
+    {
+        return _mm256_round_pd(
+                x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+
+    static Vec pow2(Vec n)
+    {
+        __m256i bits = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n));
+        bits = _mm256_add_epi64(bits, _mm256_set1_epi64x(1023));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(bits, 52));
+    }
+
+    static Vec exponent(Vec x)
+    {
+        // Drop the biased exponent into the mantissa of 2^52 to convert it.
+        const Vec magic = _mm256_set1_pd(4503599627370496.0);
+        const __m256i bits = _mm256_srli_epi64(_mm256_castpd_si256(x), 52);
+        const Vec biased = _mm256_or_pd(_mm256_castsi256_pd(bits), magic);
+        return _mm256_sub_pd(
+                biased, _mm256_add_pd(magic, _mm256_set1_pd(1023.0)));
+    }
+
+    static Vec mantissa(Vec x)
+    {
+        const Vec mask = _mm256_castsi256_pd(
+                _mm256_set1_epi64x(0x000fffffffffffffLL));
+        return _mm256_or_pd(_mm256_and_pd(x, mask), _mm256_set1_pd(1.0));
+    }
+};
+}
+
+void priceEuropeanAvx2(const EuropeanOutputs& outputs,
+        const EuropeanInputs& inputs,
+        EuropeanKernel::Model model,
+        EuropeanKernel::Payoff payoff)
+{
+    priceAll<Avx2Traits>(outputs, inputs, model, payoff);
+}
+
+} // close namespace pricer
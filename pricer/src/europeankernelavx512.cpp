@@ -0,0 +1,72 @@
+// Compiled with AVX-512F enabled; only called after the CPU check in
+// europeankernel.cpp.
+#include "europeankernel.h"
+#include "europeankernelimpl.h"
+
+#include <immintrin.h>
+
+namespace pricer {
+
+namespace {
+
+struct Avx512Traits {
+    typedef __m512d Vec;
+    typedef __mmask8 Mask;
+    enum { k_width = 8 };
+
+    static Vec set1(double x) { return _mm512_set1_pd(x); }
+    static Vec load(const double *p) { return _mm512_loadu_pd(p); }
+    static void store(double *p, Vec x) { _mm512_storeu_pd(p, x); }
+    static Vec add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm512_mul_pd(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm512_div_pd(a, b); }
+    static Vec fmadd(Vec a, Vec b, Vec c)
+    {
+        return _mm512_fmadd_pd(a, b, c);
+    }
+
+    static Vec sqrt(Vec x) { return _mm512_sqrt_pd(x); }
+    static Vec min(Vec a, Vec b) { return _mm512_min_pd(a, b); }
+    static Vec max(Vec a, Vec b) { return _mm512_max_pd(a, b); }
+    static Vec abs(Vec x) { return _mm512_abs_pd(x); }
+
+    static Mask lt(Vec a, Vec b)
+    {
+        return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ);
+    }
+
+    static Vec blend(Mask m, Vec a, Vec b)
+    {
+        return _mm512_mask_blend_pd(m, b, a);
+    }
+
+    static Vec round(Vec x)
+    {
+        return _mm512_roundscale_pd(
+                x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    }
+
+    static Vec pow2(Vec n)
+    {
+        return _mm512_scalef_pd(_mm512_set1_pd(1.0), n);
+    }
+
+    static Vec exponent(Vec x) { return _mm512_getexp_pd(x); }
+
+    static Vec mantissa(Vec x)
+    {
+        return _mm512_getmant_pd(x, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+    }
+};
+}
+
+void priceEuropeanAvx512(const EuropeanOutputs& outputs,
+        const EuropeanInputs& inputs,
+        EuropeanKernel::Model model,
+        EuropeanKernel::Payoff payoff)
+{
+    priceAll<Avx512Traits>(outputs, inputs, model, payoff);
+}
+
+} // close namespace pricer
@@ -0,0 +1,316 @@
+//
+// europeankernelimpl.h
+// The European kernel written once over a vector traits type `T`, and
+// included by each instruction set translation unit. Everything here has
+// internal linkage, and nothing calls into the standard library, so code
+// compiled for AVX cannot leak into the scalar path through the linker.
+//
+// `T` provides the vector type `Vec`, its mask type `Mask`, `k_width`, and
+// set1, load, store, add, sub, mul, div, fmadd (a * b + c), sqrt, min,
+// max, abs, lt, blend (mask ? a : b), round, pow2 (2^n for integral n),
+// exponent and mantissa (x = mantissa * 2^exponent, mantissa in [1, 2)).
+//
+#ifndef _EUROPEANKERNELIMPL_H_
+#define _EUROPEANKERNELIMPL_H_
+
+#include "europeankernel.h"
+
+namespace pricer {
+namespace {
+
+const double k_log2e = 1.4426950408889634074;
+const double k_ln2Hi = 6.93147180369123816490e-01;
+const double k_ln2Lo = 1.90821492927058770002e-10;
+const double k_sqrt2 = 1.41421356237309504880;
+const double k_invSqrt2Pi = 0.39894228040143267794;
+
+// exp(x) by reduction to r = x - n ln2, |r| <= ln2 / 2, and the degree 12
+// Taylor polynomial of exp(r); relative error below 2e-16.
+template <class T>
+typename T::Vec vexp(typename T::Vec x)
+{
+    typedef typename T::Vec Vec;
+    x = T::min(T::max(x, T::set1(-708.0)), T::set1(709.0));
+    const Vec n = T::round(T::mul(x, T::set1(k_log2e)));
+    Vec r = T::fmadd(n, T::set1(-k_ln2Hi), x);
+    r = T::fmadd(n, T::set1(-k_ln2Lo), r);
+
+    Vec p = T::set1(1.0 / 479001600.0);
+    p = T::fmadd(p, r, T::set1(1.0 / 39916800.0));
+    p = T::fmadd(p, r, T::set1(1.0 / 3628800.0));
+    p = T::fmadd(p, r, T::set1(1.0 / 362880.0));
+    p = T::fmadd(p, r, T::set1(1.0 / 40320.0));
+    p = T::fmadd(p, r, T::set1(1.0 / 5040.0));
+    p = T::fmadd(p, r, T::set1(1.0 / 720.0));
+    p = T::fmadd(p, r, T::set1(1.0 / 120.0));
+    p = T::fmadd(p, r, T::set1(1.0 / 24.0));
+    p = T::fmadd(p, r, T::set1(1.0 / 6.0));
+    p = T::fmadd(p, r, T::set1(0.5));
+    p = T::fmadd(p, r, T::set1(1.0));
+    p = T::fmadd(p, r, T::set1(1.0));
+    return T::mul(p, T::pow2(n));
+}
+
+// log(x) for positive normal x: x = m 2^e with m in [sqrt(2)/2, sqrt(2)),
+// and log(m) = 2 atanh(s), s = (m - 1) / (m + 1), summed to s^19.
+template <class T>
+typename T::Vec vlog(typename T::Vec x)
+{
+    typedef typename T::Vec Vec;
+    Vec m = T::mantissa(x);
+    Vec e = T::exponent(x);
+    const typename T::Mask big = T::lt(T::set1(k_sqrt2), m);
+    m = T::blend(big, T::mul(m, T::set1(0.5)), m);
+    e = T::blend(big, T::add(e, T::set1(1.0)), e);
+
+    const Vec s = T::div(T::sub(m, T::set1(1.0)), T::add(m, T::set1(1.0)));
+    const Vec s2 = T::mul(s, s);
+    Vec p = T::set1(1.0 / 19.0);
+    p = T::fmadd(p, s2, T::set1(1.0 / 17.0));
+    p = T::fmadd(p, s2, T::set1(1.0 / 15.0));
+    p = T::fmadd(p, s2, T::set1(1.0 / 13.0));
+    p = T::fmadd(p, s2, T::set1(1.0 / 11.0));
+    p = T::fmadd(p, s2, T::set1(1.0 / 9.0));
+    p = T::fmadd(p, s2, T::set1(1.0 / 7.0));
+    p = T::fmadd(p, s2, T::set1(1.0 / 5.0));
+    p = T::fmadd(p, s2, T::set1(1.0 / 3.0));
+    p = T::fmadd(p, s2, T::set1(1.0));
+    const Vec logM = T::mul(T::add(s, s), p);
+    return T::fmadd(
+            e, T::set1(k_ln2Hi), T::fmadd(e, T::set1(k_ln2Lo), logM));
+}
+
+// Normal CDF by Hart's double precision algorithm (West, 2005), given
+// `expHalfX2` = exp(-x^2 / 2) so callers can share it with the density.
+template <class T>
+typename T::Vec vnormCdf(typename T::Vec x, typename T::Vec expHalfX2)
+{
+    typedef typename T::Vec Vec;
+    const Vec a = T::abs(x);
+
+    Vec num = T::set1(3.52624965998911e-02);
+    num = T::fmadd(num, a, T::set1(0.700383064443688));
+    num = T::fmadd(num, a, T::set1(6.37396220353165));
+    num = T::fmadd(num, a, T::set1(33.912866078383));
+    num = T::fmadd(num, a, T::set1(112.079291497871));
+    num = T::fmadd(num, a, T::set1(221.213596169931));
+    num = T::fmadd(num, a, T::set1(220.206867912376));
+    Vec den = T::set1(8.83883476483184e-02);
+    den = T::fmadd(den, a, T::set1(1.75566716318264));
+    den = T::fmadd(den, a, T::set1(16.064177579207));
+    den = T::fmadd(den, a, T::set1(86.7807322029461));
+    den = T::fmadd(den, a, T::set1(296.564248779674));
+    den = T::fmadd(den, a, T::set1(637.333633378831));
+    den = T::fmadd(den, a, T::set1(793.826512519948));
+    den = T::fmadd(den, a, T::set1(440.413735824752));
+    const Vec nearTail = T::div(T::mul(expHalfX2, num), den);
+
+    Vec cf = T::add(a, T::set1(0.65));
+    cf = T::add(a, T::div(T::set1(4.0), cf));
+    cf = T::add(a, T::div(T::set1(3.0), cf));
+    cf = T::add(a, T::div(T::set1(2.0), cf));
+    cf = T::add(a, T::div(T::set1(1.0), cf));
+    const Vec farTail
+            = T::div(expHalfX2, T::mul(cf, T::set1(2.506628274631)));
+
+    Vec tail = T::blend(
+            T::lt(a, T::set1(7.07106781186547)), nearTail, farTail);
+    tail = T::blend(T::lt(T::set1(37.0), a), T::set1(0.0), tail);
+    return T::blend(
+            T::lt(T::set1(0.0), x), T::sub(T::set1(1.0), tail), tail);
+}
+
+// Return `x` times `sign`, the sign of the payoff, +1 for a call and -1
+// for a put, which a batch of calls skips.
+template <class T, int PAYOFF>
+typename T::Vec withSign(typename T::Vec sign, typename T::Vec x)
+{
+    return PAYOFF == EuropeanKernel::e_CALLS ? x : T::mul(sign, x);
+}
+
+// Price one block of `T::k_width` options read from contiguous arrays. The
+// model, the payoffs of the batch and whether it has a dividend yield are
+// template arguments, so the sign of a batch of one type and the carry of
+// one without a yield compile out; the results are those of the mixed
+// kernel with a zero yield to the last bit.
+template <class T, int MODEL, int PAYOFF, bool HAS_YIELD>
+void priceBlock(double *const *out,
+        const double *s,
+        const double *k,
+        const double *v,
+        const double *r,
+        const double *q,
+        const double *t,
+        const double *w)
+{
+    typedef typename T::Vec Vec;
+    const bool black76 = MODEL == EuropeanKernel::e_BLACK76;
+    const bool carry = black76 || HAS_YIELD;
+    const Vec spot = T::load(s);
+    const Vec strike = T::load(k);
+    const Vec vol = T::load(v);
+    const Vec rate = T::load(r);
+    const Vec yield = black76 ? rate
+            : HAS_YIELD       ? T::load(q)
+                              : T::set1(0.0);
+    const Vec expiry = T::load(t);
+    const Vec sign = PAYOFF == EuropeanKernel::e_MIXED ? T::load(w)
+            : PAYOFF == EuropeanKernel::e_PUTS         ? T::set1(-1.0)
+                                                       : T::set1(1.0);
+    const Vec half = T::set1(0.5);
+
+    const Vec sqrtT = T::sqrt(expiry);
+    const Vec sd = T::mul(vol, sqrtT);
+    const Vec df = vexp<T>(T::sub(T::set1(0.0), T::mul(rate, expiry)));
+    const Vec dq = black76 ? df
+            : HAS_YIELD
+            ? vexp<T>(T::sub(T::set1(0.0), T::mul(yield, expiry)))
+            : T::set1(1.0);
+    const Vec logMoneyness = vlog<T>(T::div(spot, strike));
+    const Vec drift = carry ? T::sub(rate, yield) : rate;
+    const Vec d1 = T::fmadd(
+            half, sd, T::div(T::fmadd(drift, expiry, logMoneyness), sd));
+    const Vec d2 = T::sub(d1, sd);
+    const Vec e1 = vexp<T>(T::mul(T::set1(-0.5), T::mul(d1, d1)));
+    const Vec e2 = vexp<T>(T::mul(T::set1(-0.5), T::mul(d2, d2)));
+    const Vec phi = T::mul(e1, T::set1(k_invSqrt2Pi));
+    const Vec nd1 = vnormCdf<T>(withSign<T, PAYOFF>(sign, d1), e1);
+    const Vec nd2 = vnormCdf<T>(withSign<T, PAYOFF>(sign, d2), e2);
+
+    const Vec sdq = carry ? T::mul(spot, dq) : spot;
+    const Vec dqPhi = carry ? T::mul(dq, phi) : phi;
+    const Vec kdf = T::mul(strike, df);
+    const Vec price = withSign<T, PAYOFF>(
+            sign, T::sub(T::mul(sdq, nd1), T::mul(kdf, nd2)));
+    const Vec vega = T::mul(T::mul(sdq, phi), sqrtT);
+    const Vec invVol = T::div(T::set1(1.0), vol);
+
+    T::store(out[0], price);
+    T::store(out[1],
+            carry ? T::mul(withSign<T, PAYOFF>(sign, dq), nd1)
+                  : withSign<T, PAYOFF>(sign, nd1));
+    T::store(out[2], T::div(dqPhi, T::mul(spot, sd)));
+    T::store(out[3], vega);
+
+    // theta = -S e^-qT phi vol / (2 sqrtT) - w r K e^-rT N2 + w q S e^-qT N1
+    Vec theta = T::div(T::mul(T::mul(sdq, phi), vol), T::add(sqrtT, sqrtT));
+    const Vec carryTheta
+            = carry ? T::mul(T::mul(yield, sdq), nd1) : T::set1(0.0);
+    theta = T::sub(withSign<T, PAYOFF>(sign,
+                           T::sub(carryTheta,
+                                   T::mul(T::mul(rate, kdf), nd2))),
+            theta);
+    T::store(out[4], theta);
+
+    const Vec rho = black76
+            ? T::sub(T::set1(0.0), T::mul(expiry, price))
+            : T::mul(withSign<T, PAYOFF>(sign, kdf), T::mul(expiry, nd2));
+    T::store(out[5], rho);
+    T::store(out[6],
+            T::sub(T::set1(0.0), T::mul(dqPhi, T::mul(d2, invVol))));
+    T::store(out[7], T::mul(T::mul(vega, T::mul(d1, d2)), invVol));
+}
+
+// Price all options of `inputs` with the kernel of the template arguments,
+// padding the last partial block with a benign option whose results are
+// discarded.
+template <class T, int MODEL, int PAYOFF, bool HAS_YIELD>
+void priceBatch(const EuropeanOutputs& outputs, const EuropeanInputs& inputs)
+{
+    const int W = T::k_width;
+    const bool readYield = HAS_YIELD && MODEL != EuropeanKernel::e_BLACK76;
+    const bool readSign = PAYOFF == EuropeanKernel::e_MIXED;
+    const std::size_t n = inputs.d_size;
+
+    double s[W], k[W], v[W], r[W], q[W], t[W], w[W];
+    double results[8][W];
+    double *blockOut[8];
+
+    for (std::size_t i = 0; i < n; i += W) {
+        const std::size_t count = n - i < std::size_t(W) ? n - i : W;
+        for (int j = 0; j < W; ++j) {
+            const bool valid = std::size_t(j) < count;
+            const std::size_t at = valid ? i + j : i;
+            s[j] = valid ? inputs.d_spot[at] : 1.0;
+            k[j] = valid ? inputs.d_strike[at] : 1.0;
+            v[j] = valid ? inputs.d_vol[at] : 0.2;
+            r[j] = valid ? inputs.d_rate[at] : 0.0;
+            if (readYield) {
+                q[j] = valid ? inputs.d_dividendYield[at] : 0.0;
+            }
+            t[j] = valid ? inputs.d_expiry[at] : 1.0;
+            if (readSign) {
+                w[j] = valid && !inputs.d_isCall[at] ? -1.0 : 1.0;
+            }
+        }
+        for (int m = 0; m < 8; ++m) {
+            blockOut[m] = results[m];
+        }
+        priceBlock<T, MODEL, PAYOFF, HAS_YIELD>(
+                blockOut, s, k, v, r, q, t, w);
+
+        double *const targets[8] = { outputs.d_price,
+            outputs.d_delta,
+            outputs.d_gamma,
+            outputs.d_vega,
+            outputs.d_theta,
+            outputs.d_rho,
+            outputs.d_vanna,
+            outputs.d_volga };
+        for (int m = 0; m < 8; ++m) {
+            if (targets[m]) {
+                for (std::size_t j = 0; j < count; ++j) {
+                    targets[m][i + j] = results[m][j];
+                }
+            }
+        }
+    }
+}
+
+template <class T, int MODEL, bool HAS_YIELD>
+void priceBatch(const EuropeanOutputs& outputs,
+        const EuropeanInputs& inputs,
+        EuropeanKernel::Payoff payoff)
+{
+    switch (payoff) {
+    case EuropeanKernel::e_CALLS:
+        priceBatch<T, MODEL, EuropeanKernel::e_CALLS, HAS_YIELD>(
+                outputs, inputs);
+        return;
+    case EuropeanKernel::e_PUTS:
+        priceBatch<T, MODEL, EuropeanKernel::e_PUTS, HAS_YIELD>(
+                outputs, inputs);
+        return;
+    default:
+        priceBatch<T, MODEL, EuropeanKernel::e_MIXED, HAS_YIELD>(
+                outputs, inputs);
+        return;
+    }
+}
+
+// Price all options of `inputs` with the kernel for `model`, `payoff` and
+// the presence of a yield, chosen once for the batch.
+template <class T>
+void priceAll(const EuropeanOutputs& outputs,
+        const EuropeanInputs& inputs,
+        EuropeanKernel::Model model,
+        EuropeanKernel::Payoff payoff)
+{
+    if (model == EuropeanKernel::e_BLACK76) {
+        priceBatch<T, EuropeanKernel::e_BLACK76, false>(
+                outputs, inputs, payoff);
+    }
+    else if (inputs.d_dividendYield) {
+        priceBatch<T, EuropeanKernel::e_BLACK_SCHOLES, true>(
+                outputs, inputs, payoff);
+    }
+    else {
+        priceBatch<T, EuropeanKernel::e_BLACK_SCHOLES, false>(
+                outputs, inputs, payoff);
+    }
+}
+
+} // close unnamed namespace
+} // close namespace pricer
+
+#endif
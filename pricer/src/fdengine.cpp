@@ -0,0 +1,585 @@
+#include "fdengine.h"
+
+#include "fdscheme.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pricer {
+
+namespace {
+
+// Present value at time `t` of the dividends still to be paid in (t, T],
+// optionally loading its derivative in the rate into `pvRate`.
+double remainingDividends(const Leg& leg, double t, double *pvRate = 0)
+{
+    double pv = 0.0;
+    double rate = 0.0;
+    for (std::size_t k = 0; k < leg.d_numDividends; ++k) {
+        const double td = leg.d_dividendTimes[k];
+        if (td > t && td > 0.0 && td <= leg.d_expiry) {
+            const double value = leg.d_dividendAmounts[k]
+                    * std::exp(-leg.d_rate * (td - t));
+            pv += value;
+            rate -= (td - t) * value;
+        }
+    }
+    if (pvRate) {
+        *pvRate = rate;
+    }
+    return pv;
+}
+
+// Apply V(S) <- V(S - amount) on the grid, interpolating in ln(S) by a
+// cubic. Below the lower boundary the values are extrapolated with `slope`,
+// -1 for a put (K - S) and 0 for the call and for the tangents.
+void applyDividend(std::vector<double> *values,
+        std::vector<double> *scratch,
+        const std::vector<double>& spots,
+        const std::vector<double>& x,
+        double amount,
+        double slope)
+{
+    std::vector<double>& v = *values;
+    std::vector<double>& out = *scratch;
+    int hint = 0;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        const double shifted = spots[i] - amount;
+        out[i] = shifted <= spots[0]
+                ? v[0] + slope * (std::max(shifted, 0.0) - spots[0])
+                : interpolateCubic(x, v, std::log(shifted), &hint);
+    }
+    v.swap(out);
+}
+
+// The Black-Scholes operator in x = ln(S) on a non-uniform grid, with its
+// derivatives in volatility and rate.
+struct Operator {
+    Stencil d_value;
+    Stencil d_vol;
+    Stencil d_rate;
+
+    Operator(const std::vector<double>& x, double vol, double r)
+        : d_value(static_cast<int>(x.size()))
+        , d_vol(static_cast<int>(x.size()))
+        , d_rate(static_cast<int>(x.size()))
+    {
+        const double var = vol * vol;
+        const double drift = r - 0.5 * var;
+        for (int i = 1; i + 1 < static_cast<int>(x.size()); ++i) {
+            double d1[3];
+            double d2[3];
+            derivativeWeights(d1, d2, x, i);
+            d_value.d_a[i] = 0.5 * var * d2[0] + drift * d1[0];
+            d_value.d_b[i] = 0.5 * var * d2[1] + drift * d1[1] - r;
+            d_value.d_c[i] = 0.5 * var * d2[2] + drift * d1[2];
+            d_vol.d_a[i] = vol * (d2[0] - d1[0]);
+            d_vol.d_b[i] = vol * (d2[1] - d1[1]);
+            d_vol.d_c[i] = vol * (d2[2] - d1[2]);
+            d_rate.d_a[i] = d1[0];
+            d_rate.d_b[i] = d1[1] - 1.0;
+            d_rate.d_c[i] = d1[2];
+        }
+    }
+};
+
+// The state of a solve: the price on the grid and its tangents in
+// volatility and rate, stepped back together.
+class Solution {
+  private:
+    const Leg *d_leg;
+    std::vector<double> d_spots;
+    std::vector<double> d_payoff;
+    std::vector<double> d_next;
+    std::vector<double> d_mix;
+    std::vector<double> d_scratch;
+    std::vector<char> d_exercised;
+
+  public:
+    std::vector<double> d_value;
+    std::vector<double> d_vega;
+    std::vector<double> d_rho;
+
+    Solution(const Leg& leg, const std::vector<double>& x)
+        : d_leg(&leg)
+        , d_spots(x.size())
+        , d_payoff(x.size())
+        , d_next(x.size())
+        , d_mix(x.size())
+        , d_scratch(x.size())
+        , d_exercised(x.size(), 0)
+        , d_vega(x.size(), 0.0)
+        , d_rho(x.size(), 0.0)
+    {
+        const double sign = leg.d_isCall ? 1.0 : -1.0;
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            d_spots[i] = std::exp(x[i]);
+            d_payoff[i] = std::max(sign * (d_spots[i] - leg.d_strike), 0.0);
+        }
+        d_value = d_payoff;
+    }
+
+    const std::vector<double>& spots() const { return d_spots; }
+
+    const std::vector<double>& payoff() const { return d_payoff; }
+
+    // Step back to `t` by `scheme`, exercising an American leg where the
+    // payoff exceeds its value. The type and exercise of the leg, and
+    // whether it pays dividends, are template arguments.
+    template <bool IS_CALL, bool IS_AMERICAN, bool HAS_DIVIDENDS>
+    void step(const ThetaStep& scheme, const Operator& op, double t);
+
+    // Apply the dividend `amount` paid at the current time.
+    template <bool IS_CALL>
+    void payDividend(const std::vector<double>& x, double amount);
+
+    // Exercise an American leg where the payoff exceeds its value, after
+    // a jump.
+    template <bool IS_AMERICAN>
+    void exercise();
+};
+
+template <bool IS_CALL, bool IS_AMERICAN, bool HAS_DIVIDENDS>
+void Solution::step(const ThetaStep& scheme, const Operator& op, double t)
+{
+    const Leg& leg = *d_leg;
+    const int n = static_cast<int>(d_spots.size());
+    const double theta = scheme.theta();
+
+    // Boundary values at `t` and their derivatives in the rate.
+    const double tau = leg.d_expiry - t;
+    double pvRate = 0.0;
+    const double pv
+            = HAS_DIVIDENDS ? remainingDividends(leg, t, &pvRate) : 0.0;
+    const double discountedStrike = leg.d_strike * std::exp(-leg.d_rate * tau);
+    double lowerValue = 0.0;
+    double upperValue = 0.0;
+    double lowerRate = 0.0;
+    double upperRate = 0.0;
+    if (IS_CALL) {
+        upperValue = d_spots[n - 1] - pv - discountedStrike;
+        upperRate = tau * discountedStrike - pvRate;
+        if (IS_AMERICAN && d_payoff[n - 1] > upperValue) {
+            upperValue = d_payoff[n - 1];
+            upperRate = 0.0;
+        }
+    }
+    else {
+        lowerValue = discountedStrike + pv - d_spots[0];
+        lowerRate = pvRate - tau * discountedStrike;
+        if (IS_AMERICAN && d_payoff[0] > lowerValue) {
+            lowerValue = d_payoff[0];
+            lowerRate = 0.0;
+        }
+    }
+
+    scheme.step(&d_next,
+            &d_scratch,
+            d_value,
+            lowerValue,
+            upperValue,
+            IS_AMERICAN ? &d_payoff : 0,
+            &d_exercised);
+    std::vector<char> *exercised = IS_AMERICAN ? &d_exercised : 0;
+
+    // The tangents solve the same system, with the derivative of the
+    // operator applied to the theta-weighted price as a source.
+    for (int i = 0; i < n; ++i) {
+        d_mix[i] = theta * d_next[i] + (1.0 - theta) * d_value[i];
+    }
+    d_value.swap(d_next);
+    scheme.step(&d_next,
+            &d_scratch,
+            d_vega,
+            0.0,
+            0.0,
+            0,
+            exercised,
+            &op.d_vol,
+            &d_mix);
+    d_vega.swap(d_next);
+    scheme.step(&d_next,
+            &d_scratch,
+            d_rho,
+            lowerRate,
+            upperRate,
+            0,
+            exercised,
+            &op.d_rate,
+            &d_mix);
+    d_rho.swap(d_next);
+}
+
+template <bool IS_CALL>
+void Solution::payDividend(const std::vector<double>& x, double amount)
+{
+    applyDividend(
+            &d_value, &d_scratch, d_spots, x, amount, IS_CALL ? 0.0 : -1.0);
+    applyDividend(&d_vega, &d_scratch, d_spots, x, amount, 0.0);
+    applyDividend(&d_rho, &d_scratch, d_spots, x, amount, 0.0);
+}
+
+template <bool IS_AMERICAN>
+void Solution::exercise()
+{
+    if (!IS_AMERICAN) {
+        return;
+    }
+    for (std::size_t i = 0; i < d_value.size(); ++i) {
+        if (d_value[i] <= d_payoff[i]) {
+            d_value[i] = d_payoff[i];
+            d_vega[i] = 0.0;
+            d_rho[i] = 0.0;
+        }
+    }
+}
+
+typedef std::vector<std::pair<double, double> > Dividends;
+
+// Step `solution` back from the expiry of `leg` to today in about
+// `timeSteps` steps, paying `dividends`, latest first, on their ex-dates.
+// The kernel is compiled for each type, exercise and dividend mode, so
+// neither the steps nor the nodes test the leg, and a leg without
+// dividends never looks for them.
+template <bool IS_CALL, bool IS_AMERICAN, bool HAS_DIVIDENDS>
+void rollbackKernel(Solution *solution,
+        const Operator& op,
+        const Leg& leg,
+        const std::vector<double>& x,
+        const Dividends& dividends,
+        int timeSteps,
+        const FdEngine::Config& config)
+{
+    const int steps = std::max(timeSteps, 1);
+    std::size_t next = 0;
+    double t = leg.d_expiry;
+    while (true) {
+        while (HAS_DIVIDENDS && next < dividends.size()
+                && dividends[next].first >= t) {
+            solution->payDividend<IS_CALL>(x, dividends[next].second);
+            ++next;
+        }
+        solution->exercise<IS_AMERICAN>();
+        if (t <= 0.0) {
+            break;
+        }
+
+        // Step to the next ex-date, or to today, with the first steps
+        // after the payoff or the jump as two implicit half steps each.
+        const double end = HAS_DIVIDENDS && next < dividends.size()
+                ? dividends[next].first
+                : 0.0;
+        const int count = std::max(1,
+                static_cast<int>(
+                        std::ceil((t - end) / leg.d_expiry * steps - 1e-9)));
+        const double dt = (t - end) / count;
+        const ThetaStep smoothing(op.d_value, 1.0, 0.5 * dt, IS_CALL);
+        const ThetaStep crankNicolson(
+                op.d_value, config.d_theta, dt, IS_CALL);
+        for (int j = 0; j < count; ++j) {
+            const double stepEnd = j + 1 == count ? end : t - (j + 1) * dt;
+            if (j < config.d_rannacherSteps) {
+                solution->step<IS_CALL, IS_AMERICAN, HAS_DIVIDENDS>(
+                        smoothing, op, stepEnd + 0.5 * dt);
+                solution->step<IS_CALL, IS_AMERICAN, HAS_DIVIDENDS>(
+                        smoothing, op, stepEnd);
+            }
+            else {
+                solution->step<IS_CALL, IS_AMERICAN, HAS_DIVIDENDS>(
+                        crankNicolson, op, stepEnd);
+            }
+        }
+        t = end;
+    }
+}
+
+// Step `solution` back as the kernels do, choosing the step for the type
+// and exercise of `leg` at every step and looking for dividends whether or
+// not it pays any, as the solver did before the kernels were specialized.
+// Only benchmarks choose it, to measure the specialization.
+void rollbackGeneric(Solution *solution,
+        const Operator& op,
+        const Leg& leg,
+        const std::vector<double>& x,
+        const Dividends& dividends,
+        int timeSteps,
+        const FdEngine::Config& config)
+{
+    typedef void (Solution::*Step)(
+            const ThetaStep&, const Operator&, double);
+    static const Step stepOf[4] = { &Solution::step<false, false, true>,
+        &Solution::step<false, true, true>,
+        &Solution::step<true, false, true>,
+        &Solution::step<true, true, true> };
+
+    const int steps = std::max(timeSteps, 1);
+    std::size_t next = 0;
+    double t = leg.d_expiry;
+    while (true) {
+        while (next < dividends.size() && dividends[next].first >= t) {
+            if (leg.d_isCall) {
+                solution->payDividend<true>(x, dividends[next].second);
+            }
+            else {
+                solution->payDividend<false>(x, dividends[next].second);
+            }
+            ++next;
+        }
+        if (leg.d_isAmerican) {
+            solution->exercise<true>();
+        }
+        if (t <= 0.0) {
+            break;
+        }
+
+        const double end = next < dividends.size() ? dividends[next].first
+                                                   : 0.0;
+        const int count = std::max(1,
+                static_cast<int>(
+                        std::ceil((t - end) / leg.d_expiry * steps - 1e-9)));
+        const double dt = (t - end) / count;
+        const ThetaStep smoothing(op.d_value, 1.0, 0.5 * dt, leg.d_isCall);
+        const ThetaStep crankNicolson(
+                op.d_value, config.d_theta, dt, leg.d_isCall);
+        for (int j = 0; j < count; ++j) {
+            const Step step = stepOf[2 * leg.d_isCall + leg.d_isAmerican];
+            const double stepEnd = j + 1 == count ? end : t - (j + 1) * dt;
+            if (j < config.d_rannacherSteps) {
+                (solution->*step)(smoothing, op, stepEnd + 0.5 * dt);
+                (solution->*step)(smoothing, op, stepEnd);
+            }
+            else {
+                (solution->*step)(crankNicolson, op, stepEnd);
+            }
+        }
+        t = end;
+    }
+}
+
+typedef void (*Kernel)(Solution *,
+        const Operator&,
+        const Leg&,
+        const std::vector<double>&,
+        const Dividends&,
+        int,
+        const FdEngine::Config&);
+
+const Kernel k_KERNELS[8] = { &rollbackKernel<false, false, false>,
+    &rollbackKernel<false, false, true>,
+    &rollbackKernel<false, true, false>,
+    &rollbackKernel<false, true, true>,
+    &rollbackKernel<true, false, false>,
+    &rollbackKernel<true, false, true>,
+    &rollbackKernel<true, true, false>,
+    &rollbackKernel<true, true, true> };
+
+// Load into `dividends` the dividends paid during the life of `leg`,
+// latest first. Their ex-dates split the time grid, so each is paid
+// exactly on a step.
+void dividendsOf(Dividends *dividends, const Leg& leg)
+{
+    dividends->clear();
+    for (std::size_t i = 0; i < leg.d_numDividends; ++i) {
+        const double td = leg.d_dividendTimes[i];
+        if (td > 0.0 && td <= leg.d_expiry && leg.d_dividendAmounts[i] != 0) {
+            dividends->push_back(
+                    std::make_pair(td, leg.d_dividendAmounts[i]));
+        }
+    }
+    std::sort(dividends->rbegin(), dividends->rend());
+}
+
+// Return true if `leg` pays a dividend during its life.
+bool paysDividends(const Leg& leg)
+{
+    for (std::size_t i = 0; i < leg.d_numDividends; ++i) {
+        const double td = leg.d_dividendTimes[i];
+        if (td > 0.0 && td <= leg.d_expiry && leg.d_dividendAmounts[i] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Return the index in k_KERNELS of the kernel for `leg`, which pays
+// dividends if `hasDividends`.
+int kernelOf(const Leg& leg, bool hasDividends)
+{
+    return 4 * leg.d_isCall + 2 * leg.d_isAmerican + hasDividends;
+}
+
+// Return the kernel of index `kernel`, or the generic kernel if `config`
+// asks for it.
+Kernel kernelAt(int kernel, const FdEngine::Config& config)
+{
+    return config.d_specialized ? k_KERNELS[kernel] : &rollbackGeneric;
+}
+
+// Price `leg`, which pays `dividends`, on `grid` with `kernel`.
+Greeks solveWith(Kernel kernel,
+        const Leg& leg,
+        const FdGrid& grid,
+        const Dividends& dividends,
+        const FdEngine::Config& config)
+{
+    const std::vector<double>& x = grid.d_x;
+    const Operator op(x, leg.d_vol, leg.d_rate);
+    Solution solution(leg, x);
+
+    kernel(&solution, op, leg, x, dividends, grid.d_timeSteps, config);
+
+    const std::vector<double>& v = solution.d_value;
+    const int i = grid.d_spotIndex;
+    const double s = solution.spots()[i];
+    double d1[3];
+    double d2[3];
+    derivativeWeights(d1, d2, x, i);
+    const double vx = d1[0] * v[i - 1] + d1[1] * v[i] + d1[2] * v[i + 1];
+    const double vxx = d2[0] * v[i - 1] + d2[1] * v[i] + d2[2] * v[i + 1];
+
+    Greeks greeks;
+    greeks.d_price = v[i];
+    greeks.d_delta = vx / s;
+    greeks.d_gamma = (vxx - vx) / (s * s);
+    greeks.d_vega = solution.d_vega[i];
+    greeks.d_rho = solution.d_rho[i];
+
+    // Theta from the PDE itself, zero where the leg is exercised.
+    const double var = leg.d_vol * leg.d_vol;
+    const double r = leg.d_rate;
+    const bool exercised = leg.d_isAmerican && v[i] <= solution.payoff()[i];
+    greeks.d_theta = exercised ? 0.0
+                               : -(0.5 * var * s * s * greeks.d_gamma
+                                         + r * s * greeks.d_delta
+                                         - r * v[i]);
+    return greeks;
+}
+
+} // close unnamed namespace
+
+FdEngine::Config::Config()
+    : d_timeSteps(100)
+    , d_spaceSteps(200)
+    , d_minTimeSteps(30)
+    , d_minSpaceSteps(80)
+    , d_rannacherSteps(2)
+    , d_theta(0.5)
+    , d_stdDevs(5.0)
+    , d_density(0.5)
+    , d_specialized(true)
+{
+}
+
+FdEngine::FdEngine(const Config& config)
+    : d_config(config)
+{
+}
+
+FdGrid FdEngine::makeGrid(const Leg& leg) const
+{
+    return makeGrid(leg, leg.d_spot, leg.d_spot);
+}
+
+FdGrid FdEngine::makeGrid(const Leg& leg,
+        double lowSpot,
+        double highSpot) const
+{
+    const double totalDividends = remainingDividends(leg, 0.0);
+    const double stdDev = std::max(leg.d_vol * std::sqrt(leg.d_expiry), 0.05);
+    const double exDividend
+            = std::max(leg.d_spot - totalDividends, 0.1 * leg.d_spot);
+    const double xSpot = std::log(leg.d_spot);
+    const double xStrike = std::log(leg.d_strike);
+    const double width = d_config.d_stdDevs * stdDev;
+    const double lo = std::min(std::log(exDividend), xStrike) - width;
+    const double hi = std::max(xSpot, xStrike) + width;
+    const double wideLo = std::min(lo, std::log(lowSpot) - width);
+    const double wideHi = std::max(hi, std::log(highSpot) + width);
+
+    const double root = std::sqrt(leg.d_expiry);
+    const double widening = (wideHi - wideLo) / (hi - lo);
+    const int n = std::max(std::max(d_config.d_minSpaceSteps, 5),
+            static_cast<int>(std::ceil(
+                    d_config.d_spaceSteps * std::sqrt(root) * widening)));
+
+    FdGrid grid;
+    grid.d_timeSteps = std::max(std::max(d_config.d_minTimeSteps, 1),
+            static_cast<int>(std::ceil(d_config.d_timeSteps * root)));
+
+    // x = ln(K) + alpha sinh(c1 + (c2 - c1) u) on a uniform u in [0, 1],
+    // with c2 moved so that the spot falls on a node.
+    const double alpha = d_config.d_density * stdDev;
+    const double c1 = std::asinh((wideLo - xStrike) / alpha);
+    const double c2 = std::asinh((wideHi - xStrike) / alpha);
+    const double cSpot = std::asinh((xSpot - xStrike) / alpha);
+    grid.d_spotIndex
+            = static_cast<int>((cSpot - c1) / (c2 - c1) * (n - 1) + 0.5);
+    grid.d_spotIndex = std::min(std::max(grid.d_spotIndex, 1), n - 2);
+    const double step = (cSpot - c1) / grid.d_spotIndex;
+    grid.d_x.resize(n);
+    for (int i = 0; i < n; ++i) {
+        grid.d_x[i] = xStrike + alpha * std::sinh(c1 + i * step);
+    }
+    grid.d_x[grid.d_spotIndex] = xSpot;
+    return grid;
+}
+
+Greeks FdEngine::solve(const Leg& leg, const FdGrid& grid) const
+{
+    Dividends dividends;
+    dividendsOf(&dividends, leg);
+    return solveWith(kernelAt(kernelOf(leg, !dividends.empty()), d_config),
+            leg,
+            grid,
+            dividends,
+            d_config);
+}
+
+void FdEngine::price(const PricingOutputs& outputs,
+        const LegBatch& legs,
+        const std::vector<std::size_t>& indices) const
+{
+    std::vector<std::size_t> groups[8];
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        const Leg leg = legs.leg(indices[i]);
+        groups[kernelOf(leg, paysDividends(leg))].push_back(indices[i]);
+    }
+
+    Dividends dividends;
+    for (int k = 0; k < 8; ++k) {
+        const Kernel kernel = kernelAt(k, d_config);
+        for (std::size_t i = 0; i < groups[k].size(); ++i) {
+            const Leg leg = legs.leg(groups[k][i]);
+            dividendsOf(&dividends, leg);
+            outputs.set(groups[k][i],
+                    solveWith(
+                            kernel, leg, makeGrid(leg), dividends, d_config));
+        }
+    }
+}
+
+void FdEngine::priceSpots(std::vector<double> *prices,
+        const Leg& leg,
+        const std::vector<double>& spots) const
+{
+    prices->resize(spots.size());
+    if (spots.empty()) {
+        return;
+    }
+    const FdGrid grid = makeGrid(leg, spots.front(), spots.back());
+    const std::vector<double>& x = grid.d_x;
+    const Operator op(x, leg.d_vol, leg.d_rate);
+    Solution solution(leg, x);
+    Dividends dividends;
+    dividendsOf(&dividends, leg);
+    kernelAt(kernelOf(leg, !dividends.empty()), d_config)(
+            &solution, op, leg, x, dividends, grid.d_timeSteps, d_config);
+
+    int hint = 0;
+    for (std::size_t i = 0; i < spots.size(); ++i) {
+        (*prices)[i] = interpolateCubic(
+                x, solution.d_value, std::log(spots[i]), &hint);
+    }
+}
+
+} // close namespace pricer
@@ -0,0 +1,100 @@
+#ifndef _FDENGINE_H_
+#define _FDENGINE_H_
+
+#include "legbatch.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace pricer {
+
+// FdGrid is the log-spot grid a leg is solved on, with the number of time
+// steps to expiry. The nodes are stretched by a sinh map so they are
+// densest around the strike, and the spot of the leg always lies on node
+// `d_spotIndex`, so price and greeks are read off the grid without
+// interpolation.
+struct FdGrid {
+    std::vector<double> d_x;
+    int d_spotIndex;
+    int d_timeSteps;
+};
+
+// FdEngine solves the Black-Scholes PDE for one leg backwards from expiry
+// with Crank-Nicolson in x = ln(S). The time grid is split at every
+// discrete dividend inside the life of the leg, which is applied exactly at
+// its ex-date as the jump condition V(S, t-) = V(S - D, t+). Rannacher
+// smoothing replaces the first steps after expiry and after each dividend
+// by implicit half steps, which damps the oscillations the payoff kink and
+// the jumps excite. American legs are projected onto the payoff inside
+// each step by the Brennan-Schwartz algorithm, which keeps the scheme
+// second order where explicit projection after the step is first order.
+//
+// The grid adapts to the leg: it spans `d_stdDevs` standard deviations, and
+// the step counts grow with the square root of the expiry in time and its
+// fourth root in space, which holds the absolute error of the price about
+// constant.
+//
+// Vega and rho are the exact derivatives of the discrete solution: the
+// tangent of the scheme in volatility and rate is stepped alongside the
+// price, reusing its factorised matrix, so no bumped solve is needed.
+//
+// Each leg is stepped by a kernel compiled for its type, exercise and
+// dividend mode. With `d_specialized` false, every leg is stepped by one
+// generic kernel instead, which the benchmarks compare them with.
+class FdEngine {
+  public:
+    struct Config {
+        int d_timeSteps;      // time steps of a one year leg
+        int d_spaceSteps;     // space nodes of a one year leg
+        int d_minTimeSteps;
+        int d_minSpaceSteps;
+        int d_rannacherSteps; // steps taken as two implicit half steps
+        double d_theta;       // implicit weight, 0.5 for Crank-Nicolson
+        double d_stdDevs;     // half-width of the grid
+        double d_density;     // width of the fine region, in std devs
+        bool d_specialized;   // false steps every leg by the generic kernel
+
+        Config();
+    };
+
+  private:
+    Config d_config;
+
+  public:
+    explicit FdEngine(const Config& config = Config());
+
+    const Config& config() const { return d_config; }
+
+    FdGrid makeGrid(const Leg& leg) const;
+
+    // Return the grid of `leg` widened to cover the spots in
+    // [`lowSpot`, `highSpot`] as well, with its space nodes added in
+    // proportion to the width, so the spacing around the strike is kept.
+    FdGrid makeGrid(const Leg& leg, double lowSpot, double highSpot) const;
+
+    // Price `leg` on `grid`. Reusing one grid for bumped legs keeps finite
+    // difference greeks free of grid noise.
+    Greeks solve(const Leg& leg, const FdGrid& grid) const;
+
+    Greeks price(const Leg& leg) const { return solve(leg, makeGrid(leg)); }
+
+    // Load into `outputs` the price and greeks of the legs of `legs` at
+    // `indices`, each on its own grid. The legs are grouped by type,
+    // exercise and dividend mode, and each group is stepped by the kernel
+    // compiled for it, chosen once for the group.
+    void price(const PricingOutputs& outputs,
+            const LegBatch& legs,
+            const std::vector<std::size_t>& indices) const;
+
+    // Load into `prices` the price of `leg` at each of the increasing,
+    // positive `spots`, from one solve on a grid covering them all. The
+    // prices between nodes are interpolated by cubics in ln(S), and the
+    // spot of `leg` only centres the grid.
+    void priceSpots(std::vector<double> *prices,
+            const Leg& leg,
+            const std::vector<double>& spots) const;
+};
+
+} // close namespace pricer
+
+#endif
@@ -0,0 +1,152 @@
+#include "fdscheme.h"
+
+#include <algorithm>
+
+namespace pricer {
+
+void derivativeWeights(double *d1,
+        double *d2,
+        const std::vector<double>& x,
+        int i)
+{
+    const double hm = x[i] - x[i - 1];
+    const double hp = x[i + 1] - x[i];
+    const double h = hm + hp;
+    d1[0] = -hp / (hm * h);
+    d1[1] = (hp - hm) / (hm * hp);
+    d1[2] = hm / (hp * h);
+    d2[0] = 2.0 / (hm * h);
+    d2[1] = -2.0 / (hm * hp);
+    d2[2] = 2.0 / (hp * h);
+}
+
+ThetaStep::ThetaStep(const Stencil& op,
+        double theta,
+        double h,
+        bool exerciseAbove)
+    : d_operator(&op)
+    , d_theta(theta)
+    , d_h(h)
+{
+    const int n = static_cast<int>(op.d_a.size());
+    d_first = exerciseAbove ? 1 : n - 2;
+    d_last = exerciseAbove ? n - 2 : 1;
+    d_direction = exerciseAbove ? 1 : -1;
+    d_forward.assign(n, 0.0);
+    d_backward.assign(n, 0.0);
+    d_invDenom.assign(n, 0.0);
+    d_lower.assign(n, 0.0);
+    d_upper.assign(n, 0.0);
+    for (int i = 1; i < n - 1; ++i) {
+        d_lower[i] = -theta * h * op.d_a[i];
+        d_upper[i] = -theta * h * op.d_c[i];
+    }
+
+    // The couplings of the first and last rows to the boundary values are
+    // moved to the right hand side.
+    for (int i = d_first;; i += d_direction) {
+        const double back = exerciseAbove ? d_lower[i] : d_upper[i];
+        const double forward = exerciseAbove ? d_upper[i] : d_lower[i];
+        const double diag = 1.0 - theta * h * op.d_b[i];
+        const double pivot = i == d_first
+                ? diag
+                : diag - back * d_forward[i - d_direction];
+        d_invDenom[i] = 1.0 / pivot;
+        d_forward[i] = i == d_last ? 0.0 : forward * d_invDenom[i];
+        d_backward[i] = i == d_first ? 0.0 : back * d_invDenom[i];
+        if (i == d_last) {
+            break;
+        }
+    }
+}
+
+void ThetaStep::step(std::vector<double> *out,
+        std::vector<double> *rhs,
+        const std::vector<double>& in,
+        double lowerValue,
+        double upperValue,
+        const std::vector<double> *payoff,
+        std::vector<char> *exercised,
+        const Stencil *source,
+        const std::vector<double> *mix) const
+{
+    const Stencil& l = *d_operator;
+    const int n = static_cast<int>(in.size());
+    const double explicitWeight = (1.0 - d_theta) * d_h;
+    std::vector<double>& d = *rhs;
+    std::vector<double>& v = *out;
+    for (int i = 1; i < n - 1; ++i) {
+        d[i] = in[i]
+                + explicitWeight
+                        * (l.d_a[i] * in[i - 1] + l.d_b[i] * in[i]
+                                + l.d_c[i] * in[i + 1]);
+    }
+    if (source) {
+        const std::vector<double>& m = *mix;
+        for (int i = 1; i < n - 1; ++i) {
+            d[i] += d_h
+                    * (source->d_a[i] * m[i - 1] + source->d_b[i] * m[i]
+                            + source->d_c[i] * m[i + 1]);
+        }
+    }
+    d[0] = 0.0;
+    d[n - 1] = 0.0;
+    d[1] -= d_lower[1] * lowerValue;
+    d[n - 2] -= d_upper[n - 2] * upperValue;
+
+    const int dir = d_direction;
+    for (int i = d_first; i != d_last + dir; i += dir) {
+        d[i] = d[i] * d_invDenom[i] - d_backward[i] * d[i - dir];
+    }
+    v[0] = lowerValue;
+    v[n - 1] = upperValue;
+    if (payoff) {
+        const std::vector<double>& p = *payoff;
+        std::vector<char>& e = *exercised;
+        for (int i = d_last; i != d_first - dir; i -= dir) {
+            const double value = d[i] - d_forward[i] * v[i + dir];
+            e[i] = value <= p[i];
+            v[i] = e[i] ? p[i] : value;
+        }
+    }
+    else if (exercised) {
+        const std::vector<char>& e = *exercised;
+        for (int i = d_last; i != d_first - dir; i -= dir) {
+            v[i] = e[i] ? 0.0 : d[i] - d_forward[i] * v[i + dir];
+        }
+    }
+    else {
+        for (int i = d_last; i != d_first - dir; i -= dir) {
+            v[i] = d[i] - d_forward[i] * v[i + dir];
+        }
+    }
+}
+
+double interpolateCubic(const std::vector<double>& x,
+        const std::vector<double>& v,
+        double xs,
+        int *hint)
+{
+    const int n = static_cast<int>(x.size());
+    int j = std::min(std::max(*hint, 0), n - 2);
+    while (j < n - 2 && x[j + 1] < xs) {
+        ++j;
+    }
+    *hint = j;
+
+    const int lo = std::max(j - 1, 0);
+    const int hi = std::min(j + 2, n - 1);
+    double value = 0.0;
+    for (int m = lo; m <= hi; ++m) {
+        double weight = 1.0;
+        for (int k = lo; k <= hi; ++k) {
+            if (k != m) {
+                weight *= (xs - x[k]) / (x[m] - x[k]);
+            }
+        }
+        value += weight * v[m];
+    }
+    return value;
+}
+
+} // close namespace pricer
@@ -0,0 +1,93 @@
+#ifndef _FDSCHEME_H_
+#define _FDSCHEME_H_
+
+#include <vector>
+
+namespace pricer {
+
+// The building blocks shared by the finite difference engines: three point
+// operators on a non-uniform grid, the theta scheme that steps them, and
+// interpolation between nodes.
+
+// Coefficients of a three point operator
+// (L V)[i] = a[i] V[i-1] + b[i] V[i] + c[i] V[i+1] on the interior nodes.
+struct Stencil {
+    std::vector<double> d_a;
+    std::vector<double> d_b;
+    std::vector<double> d_c;
+
+    explicit Stencil(int n)
+        : d_a(n, 0.0)
+        , d_b(n, 0.0)
+        , d_c(n, 0.0)
+    {
+    }
+};
+
+// Load into the arrays `d1` and `d2` the weights on nodes i - 1, i and
+// i + 1 of the first and second derivatives at interior node `i` of `x`,
+// exact for quadratics.
+void derivativeWeights(double *d1,
+        double *d2,
+        const std::vector<double>& x,
+        int i);
+
+// ThetaStep is one step of length `h` of the theta scheme for dV/ds = L V,
+// (I - theta h L) V(s + h) = (I + (1 - theta) h L) V(s), with the
+// tridiagonal system factorised once for all steps of that length. The
+// elimination runs towards the side an American value is exercised on, so
+// that the back substitution can start there and project onto the payoff
+// as it goes: the algorithm of Brennan and Schwartz, exact when the
+// exercise region is one interval at that edge.
+class ThetaStep {
+  private:
+    const Stencil *d_operator;
+    double d_theta;
+    double d_h;
+    int d_first;     // first row eliminated
+    int d_last;      // last row eliminated, first substituted
+    int d_direction; // +1 or -1 from `d_first` to `d_last`
+    std::vector<double> d_forward;
+    std::vector<double> d_backward;
+    std::vector<double> d_invDenom;
+    std::vector<double> d_lower;
+    std::vector<double> d_upper;
+
+  public:
+    // Factorise the step of `op`, which must outlive it, eliminating
+    // towards the high end of the grid if `exerciseAbove` and towards the
+    // low end otherwise.
+    ThetaStep(const Stencil& op, double theta, double h, bool exerciseAbove);
+
+    // Load into `out` the step from `in` with the boundary values
+    // `lowerValue` and `upperValue`, using `rhs` as scratch. If `payoff` is
+    // not null, project onto it and mark the exercised nodes in
+    // `exercised`; otherwise the nodes marked in `exercised`, if not null,
+    // are set to zero, as a tangent is there. For a tangent, `source` is
+    // the derivative of the operator and `mix` the theta-weighted value it
+    // applies to.
+    void step(std::vector<double> *out,
+            std::vector<double> *rhs,
+            const std::vector<double>& in,
+            double lowerValue,
+            double upperValue,
+            const std::vector<double> *payoff,
+            std::vector<char> *exercised,
+            const Stencil *source = 0,
+            const std::vector<double> *mix = 0) const;
+
+    double theta() const { return d_theta; }
+};
+
+// Return the value at `xs` of the cubic through the values `v` at the two
+// nodes of `x` either side of it, fewer at the edges. `x` is increasing,
+// and `hint` is the index of a node at or below `xs`, updated so that
+// calls at increasing `xs` search the grid once.
+double interpolateCubic(const std::vector<double>& x,
+        const std::vector<double>& v,
+        double xs,
+        int *hint);
+
+} // close namespace pricer
+
+#endif
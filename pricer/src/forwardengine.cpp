@@ -0,0 +1,333 @@
+#include "forwardengine.h"
+
+#include "fdscheme.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace pricer {
+
+namespace {
+
+typedef std::vector<std::pair<double, double> > Dividends;
+
+enum Kind { e_CALL, e_AMERICAN_CALL, e_AMERICAN_PUT };
+
+// Present value today of the `dividends` paid no later than `t`.
+double paidDividends(const Dividends& dividends, double rate, double t)
+{
+    double pv = 0.0;
+    for (std::size_t i = 0; i < dividends.size(); ++i) {
+        if (dividends[i].first <= t) {
+            pv += dividends[i].second * std::exp(-rate * dividends[i].first);
+        }
+    }
+    return pv;
+}
+
+void validate(const Chain& chain)
+{
+    if (chain.d_numStrikes == 0) {
+        throw std::invalid_argument("chain has no strikes");
+    }
+    if (!(chain.d_spot > 0.0) || !(chain.d_expiry > 0.0)) {
+        throw std::invalid_argument(
+                "chain spot and expiry must be positive");
+    }
+    for (std::size_t i = 0; i < chain.d_numStrikes; ++i) {
+        if (!(chain.d_strikes[i] > 0.0) || !(chain.d_vols[i] > 0.0)) {
+            throw std::invalid_argument(
+                    "chain strikes and vols must be positive");
+        }
+        if (i > 0 && !(chain.d_strikes[i] > chain.d_strikes[i - 1])) {
+            throw std::invalid_argument(
+                    "chain strikes must be increasing");
+        }
+    }
+}
+
+// Load into `vols` the local volatility at each node of `x` implied by the
+// quotes of `chain`, interpolated linearly in ln(K) and flat beyond them.
+// In the short expiry limit 1 / sigma_imp(k) is the mean of
+// 1 / sigma_loc over [0, k], k = ln(K / F), so
+// sigma_loc = sigma_imp / (1 - k sigma_imp' / sigma_imp). The factor is
+// held within [1/2, 2] where the quotes are too steep for the limit.
+void localVolatility(std::vector<double> *vols,
+        const Chain& chain,
+        const std::vector<double>& x,
+        double forward)
+{
+    const std::size_t m = chain.d_numStrikes;
+    const double xForward = std::log(forward);
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        while (j < m && std::log(chain.d_strikes[j]) < x[i]) {
+            ++j;
+        }
+        double implied = j == 0 ? chain.d_vols[0] : chain.d_vols[m - 1];
+        double slope = 0.0;
+        if (j > 0 && j < m) {
+            const double x0 = std::log(chain.d_strikes[j - 1]);
+            const double x1 = std::log(chain.d_strikes[j]);
+            slope = (chain.d_vols[j] - chain.d_vols[j - 1]) / (x1 - x0);
+            implied = chain.d_vols[j - 1] + slope * (x[i] - x0);
+        }
+        double factor = 1.0 - (x[i] - xForward) * slope / implied;
+        factor = std::min(std::max(factor, 0.5), 2.0);
+        (*vols)[i] = implied / factor;
+    }
+}
+
+// Load into `op` Dupire's operator in x = ln(K) for the local `vols` at
+// the nodes of `x`.
+void makeOperator(Stencil *op,
+        const std::vector<double>& x,
+        const std::vector<double>& vols,
+        double rate)
+{
+    for (int i = 1; i + 1 < static_cast<int>(x.size()); ++i) {
+        double d1[3];
+        double d2[3];
+        derivativeWeights(d1, d2, x, i);
+        const double var = vols[i] * vols[i];
+        const double drift = rate + 0.5 * var;
+        op->d_a[i] = 0.5 * var * d2[0] - drift * d1[0];
+        op->d_b[i] = 0.5 * var * d2[1] - drift * d1[1];
+        op->d_c[i] = 0.5 * var * d2[2] - drift * d1[2];
+    }
+}
+
+// Step `kind` forward from the payoff at T = 0 to the expiry of `chain` on
+// `x` by the operator `op`, and load its values at the nodes into
+// `values`.
+void solve(std::vector<double> *values,
+        Kind kind,
+        const Chain& chain,
+        const Dividends& dividends,
+        const std::vector<double>& x,
+        const Stencil& op,
+        int steps,
+        int rannacherSteps)
+{
+    const int n = static_cast<int>(x.size());
+    const double spot = chain.d_spot;
+    const double r = chain.d_rate;
+    const double expiry = chain.d_expiry;
+    const bool isPut = kind == e_AMERICAN_PUT;
+    const double sign = isPut ? -1.0 : 1.0;
+
+    std::vector<double> strikes(n);
+    std::vector<double> payoff(n);
+    for (int i = 0; i < n; ++i) {
+        strikes[i] = std::exp(x[i]);
+        payoff[i] = std::max(sign * (spot - strikes[i]), 0.0);
+    }
+    std::vector<double>& v = *values;
+    v = payoff;
+    std::vector<double> next(n);
+    std::vector<double> scratch(n);
+    std::vector<char> exercised(n, 0);
+    const std::vector<double> *obstacle = kind == e_CALL ? 0 : &payoff;
+
+    std::size_t nextDividend = 0;
+    double t = 0.0;
+    while (true) {
+        // A dividend D at T moves every later price to the strike K + D.
+        // Above the grid a call is worthless and a put is exercised.
+        while (nextDividend < dividends.size()
+                && dividends[nextDividend].first <= t) {
+            const double amount = dividends[nextDividend].second;
+            int hint = 0;
+            for (int i = 0; i < n; ++i) {
+                const double shifted = strikes[i] + amount;
+                next[i] = shifted >= strikes[n - 1]
+                        ? v[n - 1] + (isPut ? shifted - strikes[n - 1] : 0.0)
+                        : interpolateCubic(x, v, std::log(shifted), &hint);
+                if (obstacle) {
+                    next[i] = std::max(next[i], payoff[i]);
+                }
+            }
+            v.swap(next);
+            ++nextDividend;
+        }
+        if (t >= expiry) {
+            break;
+        }
+
+        const double end = nextDividend < dividends.size()
+                ? dividends[nextDividend].first
+                : expiry;
+        const double share = (end - t) / expiry;
+        const int count = std::max(1,
+                static_cast<int>(std::ceil(share * steps - 1e-9)));
+        const double dt = (end - t) / count;
+        const ThetaStep smoothing(op, 1.0, 0.5 * dt, isPut);
+        const ThetaStep crankNicolson(op, 0.5, dt, isPut);
+        for (int j = 0; j < count; ++j) {
+            const int halves = j < rannacherSteps ? 2 : 1;
+            const ThetaStep& scheme = halves == 2 ? smoothing : crankNicolson;
+            for (int k = 1; k <= halves; ++k) {
+                const double to = j + 1 == count && k == halves
+                        ? end
+                        : t + (j + double(k) / halves) * dt;
+
+                // A deep in the money call is worth the discounted forward
+                // less the strike, or its payoff if that is more.
+                const double pv = paidDividends(dividends, r, to);
+                double lower = 0.0;
+                double upper = 0.0;
+                if (isPut) {
+                    upper = payoff[n - 1];
+                }
+                else {
+                    lower = spot - pv - strikes[0] * std::exp(-r * to);
+                    if (obstacle) {
+                        lower = std::max(lower, payoff[0]);
+                    }
+                }
+                scheme.step(&next,
+                        &scratch,
+                        v,
+                        lower,
+                        upper,
+                        obstacle,
+                        &exercised);
+                v.swap(next);
+            }
+        }
+        t = end;
+    }
+}
+
+} // close unnamed namespace
+
+void ChainPrices::resize(std::size_t n)
+{
+    d_call.resize(n);
+    d_put.resize(n);
+    d_americanCall.resize(n);
+    d_americanPut.resize(n);
+}
+
+ForwardEngine::Config::Config()
+    : d_timeSteps(100)
+    , d_spaceSteps(200)
+    , d_minTimeSteps(30)
+    , d_minSpaceSteps(80)
+    , d_rannacherSteps(2)
+    , d_stdDevs(5.0)
+    , d_density(0.5)
+{
+}
+
+ForwardEngine::ForwardEngine(const Config& config)
+    : d_config(config)
+{
+}
+
+void ForwardEngine::price(ChainPrices *prices, const Chain& chain) const
+{
+    validate(chain);
+
+    Dividends dividends;
+    for (std::size_t i = 0; i < chain.d_numDividends; ++i) {
+        const double td = chain.d_dividendTimes[i];
+        if (td > 0.0 && td <= chain.d_expiry
+                && chain.d_dividendAmounts[i] != 0.0) {
+            dividends.push_back(
+                    std::make_pair(td, chain.d_dividendAmounts[i]));
+        }
+    }
+    std::sort(dividends.begin(), dividends.end());
+    const double r = chain.d_rate;
+    const double expiry = chain.d_expiry;
+    const double pv = paidDividends(dividends, r, expiry);
+    if (!(chain.d_spot - pv > 0.0)) {
+        throw std::invalid_argument("chain spot does not cover dividends");
+    }
+
+    // The grid spans the strikes and the spot with a margin of
+    // `d_stdDevs` standard deviations at the highest vol, and is densest at
+    // the spot, where the payoff has its kink.
+    const std::size_t m = chain.d_numStrikes;
+    const double maxVol = *std::max_element(chain.d_vols, chain.d_vols + m);
+    const double stdDev = std::max(maxVol * std::sqrt(expiry), 0.05);
+    const double xSpot = std::log(chain.d_spot);
+    const double lo = std::min(std::log(chain.d_spot - pv),
+                              std::log(chain.d_strikes[0]))
+            - d_config.d_stdDevs * stdDev;
+    const double hi = std::max(xSpot, std::log(chain.d_strikes[m - 1]))
+            + d_config.d_stdDevs * stdDev;
+
+    const double root = std::sqrt(expiry);
+    const int n = std::max(std::max(d_config.d_minSpaceSteps, 5),
+            static_cast<int>(
+                    std::ceil(d_config.d_spaceSteps * std::sqrt(root))));
+    const int steps = std::max(std::max(d_config.d_minTimeSteps, 1),
+            static_cast<int>(std::ceil(d_config.d_timeSteps * root)));
+
+    const double alpha = d_config.d_density * stdDev;
+    const double c1 = std::asinh((lo - xSpot) / alpha);
+    const double c2 = std::asinh((hi - xSpot) / alpha);
+    std::vector<double> x(n);
+    for (int i = 0; i < n; ++i) {
+        x[i] = xSpot + alpha * std::sinh(c1 + (c2 - c1) * i / (n - 1));
+    }
+
+    const double forward = (chain.d_spot - pv) * std::exp(r * expiry);
+    std::vector<double> vols(n);
+    localVolatility(&vols, chain, x, forward);
+    Stencil op(n);
+    makeOperator(&op, x, vols, r);
+    const int rannacher = d_config.d_rannacherSteps;
+    std::vector<double> calls;
+    std::vector<double> americanCalls;
+    std::vector<double> americanPuts;
+    solve(&calls, e_CALL, chain, dividends, x, op, steps, rannacher);
+    solve(&americanPuts,
+            e_AMERICAN_PUT,
+            chain,
+            dividends,
+            x,
+            op,
+            steps,
+            rannacher);
+    if (dividends.empty()) {
+        americanCalls = calls;
+    }
+    else {
+        solve(&americanCalls,
+                e_AMERICAN_CALL,
+                chain,
+                dividends,
+                x,
+                op,
+                steps,
+                rannacher);
+    }
+
+    prices->resize(m);
+    const double discount = std::exp(-r * expiry);
+    int hint = 0;
+    for (std::size_t j = 0; j < m; ++j) {
+        const double strike = chain.d_strikes[j];
+        const double xs = std::log(strike);
+        const int at = hint;
+        const double call = interpolateCubic(x, calls, xs, &hint);
+        const double put = call - (chain.d_spot - pv) + strike * discount;
+        hint = at;
+        const double americanCall
+                = interpolateCubic(x, americanCalls, xs, &hint);
+        hint = at;
+        const double americanPut
+                = interpolateCubic(x, americanPuts, xs, &hint);
+        prices->d_call[j] = call;
+        prices->d_put[j] = put;
+        prices->d_americanCall[j] = std::max(americanCall, call);
+        prices->d_americanPut[j] = std::max(americanPut, put);
+    }
+}
+
+} // close namespace pricer
@@ -0,0 +1,389 @@
+#include "impliedvolsolver.h"
+
+#include "analyticengine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace pricer {
+
+namespace {
+
+const double k_pi = 3.14159265358979323846;
+const double k_sqrt2 = 1.41421356237309504880;
+const double k_sqrt3 = 1.73205080756887729353;
+const double k_invSqrt2Pi = 0.39894228040143267794;
+
+double normCdf(double x)
+{
+    return 0.5 * std::erfc(-x / k_sqrt2);
+}
+
+// Return the polynomial with the `n` coefficients `c`, highest degree
+// first, at `x`.
+double polynomial(const double *c, int n, double x)
+{
+    double value = c[0];
+    for (int i = 1; i < n; ++i) {
+        value = value * x + c[i];
+    }
+    return value;
+}
+
+// Inverse of the normal CDF by Wichura's algorithm AS 241 (1988), with a
+// relative error below 1e-16.
+double inverseNormCdf(double p)
+{
+    static const double a[] = { 2.5090809287301226727e+3,
+        3.3430575583588128105e+4, 6.7265770927008700853e+4,
+        4.5921953931549871457e+4, 1.3731693765509461125e+4,
+        1.9715909503065514427e+3, 1.3314166789178437745e+2,
+        3.3871328727963666080e+0 };
+    static const double b[] = { 5.2264952788528545610e+3,
+        2.8729085735721942674e+4, 3.9307895800092710610e+4,
+        2.1213794301586595867e+4, 5.3941960214247511077e+3,
+        6.8718700749205790830e+2, 4.2313330701600911252e+1, 1.0 };
+    static const double c[] = { 7.74545014278341407640e-4,
+        2.27238449892691845833e-2, 2.41780725177450611770e-1,
+        1.27045825245236838258e+0, 3.64784832476320460504e+0,
+        5.76949722146069140550e+0, 4.63033784615654529590e+0,
+        1.42343711074968357734e+0 };
+    static const double d[] = { 1.05075007164441684324e-9,
+        5.47593808499534494600e-4, 1.51986665636164571966e-2,
+        1.48103976427480074590e-1, 6.89767334985100004550e-1,
+        1.67638483018380384940e+0, 2.05319162663775882187e+0, 1.0 };
+    static const double e[] = { 2.01033439929228813265e-7,
+        2.71155556874348757815e-5, 1.24266094738807843860e-3,
+        2.65321895265761230930e-2, 2.96560571828504891230e-1,
+        1.78482653991729133580e+0, 5.46378491116411436990e+0,
+        6.65790464350110377720e+0 };
+    static const double f[] = { 2.04426310338993978564e-15,
+        1.42151175831644588870e-7, 1.84631831751005468180e-5,
+        7.86869131145613259100e-4, 1.48753612908506148525e-2,
+        1.36929880922735805310e-1, 5.99832206555887937690e-1, 1.0 };
+
+    const double q = p - 0.5;
+    if (std::fabs(q) <= 0.425) {
+        const double r = 0.180625 - q * q;
+        return q * polynomial(a, 8, r) / polynomial(b, 8, r);
+    }
+    const double r = std::sqrt(-std::log(q < 0.0 ? p : 1.0 - p));
+    const double value = r <= 5.0
+            ? polynomial(c, 8, r - 1.6) / polynomial(d, 8, r - 1.6)
+            : polynomial(e, 8, r - 5.0) / polynomial(f, 8, r - 5.0);
+    return q < 0.0 ? -value : value;
+}
+
+// The normalised Black price of an out of the money call,
+// b(x, s) = e^(x/2) N(x/s + s/2) - e^(-x/2) N(x/s - s/2), for the
+// log-moneyness x = ln(F / K) <= 0 and the total volatility s > 0, with its
+// first three derivatives in s.
+void normalisedBlack(double *b, double *derivatives, double x, double s)
+{
+    const double a = x / s;
+    *b = std::exp(0.5 * x) * normCdf(a + 0.5 * s)
+            - std::exp(-0.5 * x) * normCdf(a - 0.5 * s);
+    const double vega
+            = k_invSqrt2Pi * std::exp(-0.5 * (a * a + 0.25 * s * s));
+    const double u = x * x / (s * s * s) - 0.25 * s;
+    derivatives[0] = vega;
+    derivatives[1] = vega * u;
+    derivatives[2] = vega * (u * u - 3.0 * x * x / (s * s * s * s) - 0.25);
+}
+
+// Return the total volatility s > 0 with b(x, s) = `b`, for x <= 0 and
+// 0 < b < e^(x/2), loading the Householder iterations into `iterations`.
+//
+// Below the inflection point s_c = sqrt(2|x|) of b the guess inverts the
+// small volatility asymptote
+// b ~ 2 pi |x| / (3 sqrt(3)) N(-|x| / (sqrt(3) s))^3, and above it the
+// large volatility one
+// b ~ e^(x/2) - (e^(x/2) + e^(-x/2)) N(-s/2), exact at the money. The steps
+// solve ln b(s) = ln b below s_c, where the price is exponentially small,
+// and b(s) = b above it, within a bracket narrowed at every step.
+double totalVolatility(int *iterations, double x, double b)
+{
+    const double upper = std::exp(0.5 * x);
+    const double sc = std::sqrt(-2.0 * x);
+    double bc = 0.0;
+    double dummy[3];
+    if (sc > 0.0) {
+        normalisedBlack(&bc, dummy, x, sc);
+    }
+
+    const bool low = b < bc;
+    double s;
+    double lo = low ? 0.0 : sc;
+    double hi = low ? sc : std::numeric_limits<double>::infinity();
+    if (low) {
+        const double ax = -x;
+        const double z = std::cbrt(3.0 * k_sqrt3 * b / (2.0 * k_pi * ax));
+        s = -ax / (k_sqrt3 * inverseNormCdf(std::min(z, 0.5)));
+    }
+    else {
+        const double tail = (upper - b) / (upper + 1.0 / upper);
+        s = -2.0 * inverseNormCdf(tail);
+    }
+    if (!(s > lo && s < hi)) {
+        s = low ? 0.5 * sc : std::max(sc, 1e-8) * 2.0;
+    }
+
+    const double logTarget = std::log(b);
+    *iterations = 0;
+    for (int i = 0; i < 32; ++i) {
+        double value;
+        double d[3];
+        normalisedBlack(&value, d, x, s);
+        ++*iterations;
+        if (value == b) {
+            break;
+        }
+        if (value < b) {
+            lo = s;
+        }
+        else {
+            hi = s;
+        }
+
+        // Householder's third order step for f(s) = 0.
+        double f;
+        double h1;
+        double h2;
+        if (low) {
+            const double g1 = d[0] / value;
+            const double g2 = d[1] / value - g1 * g1;
+            const double g3 = d[2] / value - 3.0 * g1 * d[1] / value
+                    + 2.0 * g1 * g1 * g1;
+            f = std::log(value) - logTarget;
+            h1 = g2 / g1;
+            h2 = g3 / g1;
+            f /= g1;
+        }
+        else {
+            f = (value - b) / d[0];
+            h1 = d[1] / d[0];
+            h2 = d[2] / d[0];
+        }
+        const double nu = -f;
+        double next = s
+                + nu * (1.0 + 0.5 * h1 * nu)
+                        / (1.0 + nu * (h1 + h2 * nu / 6.0));
+        if (std::fabs(next - s) <= 1e-12 * s) {
+            s = next;
+            break;
+        }
+        if (!(next > lo && next < hi)) {
+            next = std::isinf(hi) ? 2.0 * s : 0.5 * (lo + hi);
+        }
+        s = next;
+    }
+    return s;
+}
+
+// Return the Black implied volatility of the undiscounted `price` of the
+// option on the forward `forward` struck at `strike` with `expiry`, or NaN
+// if the price is outside the bounds of the formula.
+double blackImpliedVol(int *iterations,
+        double price,
+        double forward,
+        double strike,
+        double expiry,
+        bool isCall)
+{
+    *iterations = 0;
+    const double intrinsic = std::max(
+            isCall ? forward - strike : strike - forward, 0.0);
+    const double timeValue = price - intrinsic;
+    const double scale = std::sqrt(forward * strike);
+    const double x = -std::fabs(std::log(forward / strike));
+    const double b = timeValue / scale;
+    if (!(b > 0.0) || !(b < std::exp(0.5 * x))) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return totalVolatility(iterations, x, b) / std::sqrt(expiry);
+}
+
+// Worker solves chunks of a batch, taking the next chunk from `d_next`
+// until none is left.
+struct Worker {
+    const ImpliedVolSolver *d_solver;
+    const ImpliedVolOutputs *d_outputs;
+    const LegBatch *d_legs;
+    const double *d_prices;
+    std::atomic<std::size_t> *d_next;
+    std::size_t d_chunk;
+
+    void operator()() const
+    {
+        const std::size_t n = d_legs->size();
+        while (true) {
+            const std::size_t begin = d_next->fetch_add(d_chunk);
+            if (begin >= n) {
+                break;
+            }
+            const std::size_t end = std::min(begin + d_chunk, n);
+            for (std::size_t i = begin; i < end; ++i) {
+                bool converged;
+                int iterations;
+                d_outputs->d_vol[i] = d_solver->solve(&converged,
+                        &iterations,
+                        d_legs->leg(i),
+                        d_prices[i]);
+                d_outputs->d_converged[i] = converged;
+                if (d_outputs->d_iterations) {
+                    d_outputs->d_iterations[i] = iterations;
+                }
+            }
+        }
+    }
+};
+
+} // close unnamed namespace
+
+void ImpliedVols::resize(std::size_t n)
+{
+    d_vol.resize(n);
+    d_converged.resize(n);
+    d_iterations.resize(n);
+}
+
+ImpliedVolOutputs ImpliedVols::outputs()
+{
+    const ImpliedVolOutputs outputs = { d_vol.data(), d_converged.data(),
+        d_iterations.data() };
+    return outputs;
+}
+
+ImpliedVolSolver::Config::Config()
+    : d_tolerance(1e-6)
+    , d_maxIterations(50)
+    , d_threads(0)
+{
+}
+
+ImpliedVolSolver::ImpliedVolSolver(const Config& config,
+        const FdEngine::Config& fdConfig,
+        const AmericanEngine::Config& americanConfig)
+    : d_config(config)
+    , d_american(americanConfig)
+    , d_engine(fdConfig)
+{
+}
+
+double ImpliedVolSolver::solve(bool *converged,
+        int *iterations,
+        const Leg& leg,
+        double price) const
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    *converged = false;
+    *iterations = 0;
+
+    // The European implied vol of the price, exact for a European leg.
+    double spot;
+    double volScale;
+    double european = nan;
+    if (escrowedSpot(&spot, &volScale, leg)) {
+        const double growth = std::exp(leg.d_rate * leg.d_expiry);
+        european = blackImpliedVol(iterations,
+                           price * growth,
+                           spot * growth,
+                           leg.d_strike,
+                           leg.d_expiry,
+                           leg.d_isCall)
+                / volScale;
+        if (!leg.d_isAmerican) {
+            *converged = !std::isnan(european);
+            return european;
+        }
+    }
+
+    // Newton steps from the European vol, which is close to and above the
+    // American one, kept inside the bracket [lo, hi] of vols whose prices
+    // are below and above the quote. The bracket spans orders of
+    // magnitude, so a step that leaves it is replaced by its geometric
+    // midpoint.
+    double lo = 1e-4;
+    double hi = 10.0;
+    Leg trial = leg;
+    trial.d_vol = std::isnan(european) ? leg.d_vol : european;
+    trial.d_vol = std::min(std::max(trial.d_vol, lo), hi);
+    Greeks greeks;
+    double error;
+    const bool useApproximation = d_american.accept(&greeks, trial);
+    const FdGrid grid = d_engine.makeGrid(trial);
+    for (int i = 0; i < d_config.d_maxIterations; ++i) {
+        if (!useApproximation) {
+            greeks = d_engine.solve(trial, grid);
+        }
+        else if (i > 0) {
+            d_american.price(&greeks, &error, trial);
+        }
+        ++*iterations;
+
+        const double difference = greeks.d_price - price;
+        if (std::fabs(difference) <= d_config.d_tolerance) {
+            *converged = true;
+            return trial.d_vol;
+        }
+        if (difference < 0.0) {
+            lo = trial.d_vol;
+        }
+        else {
+            hi = trial.d_vol;
+        }
+        if (hi - lo <= 1e-12 * hi) {
+            break;
+        }
+        double next = trial.d_vol - difference / greeks.d_vega;
+        if (!(next > lo && next < hi)) {
+            next = std::sqrt(lo * hi);
+        }
+        trial.d_vol = next;
+    }
+    return nan;
+}
+
+void ImpliedVolSolver::solve(ImpliedVols *vols,
+        const LegBatch& legs,
+        const std::vector<double>& prices) const
+{
+    if (prices.size() != legs.size()) {
+        throw std::invalid_argument("prices and legs differ in length");
+    }
+    vols->resize(legs.size());
+    solve(vols->outputs(), legs, prices.data());
+}
+
+void ImpliedVolSolver::solve(const ImpliedVolOutputs& outputs,
+        const LegBatch& legs,
+        const double *prices) const
+{
+    legs.validate();
+    const std::size_t n = legs.size();
+
+    // Workers take chunks of quotes in turn, so a few slow American quotes
+    // do not hold up one thread with a fixed share of the batch.
+    const std::size_t chunk = 16;
+    std::size_t threads = d_config.d_threads > 0
+            ? d_config.d_threads
+            : std::thread::hardware_concurrency();
+    threads = std::max<std::size_t>(
+            std::min(threads, (n + chunk - 1) / chunk), 1);
+    std::atomic<std::size_t> next(0);
+    const Worker worker = { this, &outputs, &legs, prices, &next, chunk };
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < threads; ++i) {
+        pool.push_back(std::thread(worker));
+    }
+    worker();
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+        pool[i].join();
+    }
+}
+
+} // close namespace pricer
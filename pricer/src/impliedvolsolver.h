@@ -0,0 +1,104 @@
+#ifndef _IMPLIEDVOLSOLVER_H_
+#define _IMPLIEDVOLSOLVER_H_
+
+#include "americanengine.h"
+#include "fdengine.h"
+#include "legbatch.h"
+
+#include <vector>
+
+namespace pricer {
+
+// ImpliedVolOutputs receives the implied vols of a batch in arrays owned
+// by the caller, each with one entry per quote in the order of the batch.
+// `d_iterations` may be null.
+struct ImpliedVolOutputs {
+    double *d_vol;
+    char *d_converged;
+    int *d_iterations;
+};
+
+// ImpliedVols holds one entry per quote, in the order of the batch. A quote
+// the model cannot reach, such as one below the intrinsic value, has
+// `d_converged` 0 and a NaN vol.
+class ImpliedVols {
+  public:
+    std::vector<double> d_vol;
+    std::vector<char> d_converged;
+    std::vector<int> d_iterations;
+
+    void resize(std::size_t n);
+
+    // Return the arrays of the vols, valid until the next `resize`.
+    ImpliedVolOutputs outputs();
+};
+
+// ImpliedVolSolver inverts the pricing model of BatchPricer for a batch of
+// quoted prices, splitting the quotes across threads.
+//
+// A European quote is inverted in closed form up to the Black formula on
+// the escrowed forward, whose volatility scale is that of AnalyticEngine.
+// The Black price is normalised as in Jaeckel's "Let's Be Rational"
+// (2015): an out of the money time value b of the log-moneyness x, where
+// the initial guess inverts a rational map of the asymptotics of b on
+// either side of its inflection point and third order Householder steps
+// converge to machine precision in two or three iterations.
+//
+// An American quote is solved by Newton steps on the vega the engines
+// return, starting from the European implied vol of the same price, which
+// is close to the American one and above it, as the American price is
+// never below the European one. The steps are kept inside a bracket of
+// vols priced below and above the quote and replaced by bisection when they
+// leave it. The leg is priced by AmericanEngine if it accepts the leg at
+// the first guess, and otherwise by FdEngine on one grid for all
+// iterations, so the price is smooth in the vol.
+class ImpliedVolSolver {
+  public:
+    struct Config {
+        double d_tolerance;  // price tolerance of an American quote
+        int d_maxIterations; // iterations of an American quote
+        int d_threads;       // worker threads, 0 for one per core
+
+        Config();
+    };
+
+  private:
+    Config d_config;
+    AmericanEngine d_american;
+    FdEngine d_engine;
+
+  public:
+    explicit ImpliedVolSolver(const Config& config = Config(),
+            const FdEngine::Config& fdConfig = FdEngine::Config(),
+            const AmericanEngine::Config& americanConfig
+            = AmericanEngine::Config());
+
+    const Config& config() const { return d_config; }
+
+    // Load into `vols` the implied volatility of each leg of `legs` at the
+    // price of the same index of `prices`. The vol of each leg is only used
+    // as the first guess of an American quote. Throw std::invalid_argument
+    // if `legs` is not valid or the sizes differ.
+    void solve(ImpliedVols *vols,
+            const LegBatch& legs,
+            const std::vector<double>& prices) const;
+
+    // Load into `outputs`, which must have room for `legs.size()` entries,
+    // the implied volatility of each leg of `legs` at the price of the same
+    // index of `prices`, which holds `legs.size()` entries. Throw
+    // std::invalid_argument if `legs` is not valid.
+    void solve(const ImpliedVolOutputs& outputs,
+            const LegBatch& legs,
+            const double *prices) const;
+
+    // Return the implied volatility of `leg` at `price`, loading whether
+    // it converged into `converged` and the iterations into `iterations`.
+    double solve(bool *converged,
+            int *iterations,
+            const Leg& leg,
+            double price) const;
+};
+
+} // close namespace pricer
+
+#endif
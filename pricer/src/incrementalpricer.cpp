@@ -0,0 +1,204 @@
+#include "incrementalpricer.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace pricer {
+
+namespace {
+
+// Return true if `leg` has the strike, expiry, type and dividends of the
+// anchor leg `anchor`.
+bool sameContract(const Leg& anchor, const Leg& leg)
+{
+    if (leg.d_strike != anchor.d_strike || leg.d_expiry != anchor.d_expiry
+            || leg.d_isCall != anchor.d_isCall
+            || leg.d_isAmerican != anchor.d_isAmerican
+            || leg.d_numDividends != anchor.d_numDividends) {
+        return false;
+    }
+    for (std::size_t i = 0; i < leg.d_numDividends; ++i) {
+        if (leg.d_dividendTimes[i] != anchor.d_dividendTimes[i]
+                || leg.d_dividendAmounts[i] != anchor.d_dividendAmounts[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Return the Taylor update of `greeks` by the moves `ds`, `dv` and `dr`.
+Greeks taylor(const Greeks& greeks, double ds, double dv, double dr)
+{
+    Greeks result = greeks;
+    result.d_price += greeks.d_delta * ds
+            + 0.5 * greeks.d_gamma * ds * ds + greeks.d_vega * dv
+            + greeks.d_rho * dr;
+    result.d_delta += greeks.d_gamma * ds;
+    return result;
+}
+
+} // close unnamed namespace
+
+IncrementalPricer::Config::Config()
+    : d_spotMove(0.01)
+    , d_volMove(0.01)
+    , d_rateMove(0.0025)
+    , d_tolerance(0.005)
+{
+}
+
+IncrementalPricer::Statistics::Statistics()
+    : d_updates(0)
+    , d_reprices(0)
+    , d_fallbacks(0)
+{
+}
+
+IncrementalPricer::IncrementalPricer(const Config& config,
+        ChebyshevPricer *surfaces)
+    : d_config(config)
+    , d_analytic()
+    , d_pricer()
+    , d_surfaces(surfaces)
+{
+    if (!(config.d_spotMove >= 0.0) || !(config.d_volMove >= 0.0)
+            || !(config.d_rateMove >= 0.0) || !(config.d_tolerance >= 0.0)) {
+        throw std::invalid_argument(
+                "thresholds and tolerance must not be negative");
+    }
+}
+
+bool IncrementalPricer::update(Greeks *greeks,
+        const Anchor& anchor,
+        const Leg& leg) const
+{
+    const Leg base = anchor.d_leg.leg(0);
+    if (!anchor.d_hasEuropean || !sameContract(base, leg)) {
+        return false;
+    }
+    const double ds = leg.d_spot - base.d_spot;
+    const double dv = leg.d_vol - base.d_vol;
+    const double dr = leg.d_rate - base.d_rate;
+    if (std::fabs(ds) > d_config.d_spotMove * base.d_spot
+            || std::fabs(dv) > d_config.d_volMove
+            || std::fabs(dr) > d_config.d_rateMove) {
+        return false;
+    }
+
+    Leg european = leg;
+    european.d_isAmerican = false;
+    Greeks exact;
+    if (!d_analytic.price(&exact, european)) {
+        return false;
+    }
+    const double bound = std::fabs(exact.d_price
+            - taylor(anchor.d_european, ds, dv, dr).d_price);
+    if (bound > d_config.d_tolerance) {
+        return false;
+    }
+    *greeks = taylor(anchor.d_greeks, ds, dv, dr);
+    return true;
+}
+
+void IncrementalPricer::setAnchor(Anchor *anchor,
+        const Leg& leg,
+        const Greeks& greeks)
+{
+    anchor->d_leg = LegBatch();
+    anchor->d_leg.addLeg(leg.d_spot,
+            leg.d_strike,
+            leg.d_vol,
+            leg.d_rate,
+            leg.d_expiry,
+            leg.d_isCall,
+            leg.d_isAmerican,
+            std::vector<double>(leg.d_dividendTimes,
+                    leg.d_dividendTimes + leg.d_numDividends),
+            std::vector<double>(leg.d_dividendAmounts,
+                    leg.d_dividendAmounts + leg.d_numDividends));
+    anchor->d_greeks = greeks;
+
+    Leg european = leg;
+    european.d_isAmerican = false;
+    anchor->d_hasEuropean = d_analytic.price(&anchor->d_european, european);
+}
+
+IncrementalPricer::Statistics IncrementalPricer::statistics() const
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    return d_statistics;
+}
+
+void IncrementalPricer::resetStatistics()
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    d_statistics = Statistics();
+}
+
+std::size_t IncrementalPricer::price(const PricingOutputs& outputs,
+        const LegBatch& legs)
+{
+    legs.validate();
+    std::lock_guard<std::mutex> lock(d_mutex);
+    const std::size_t n = legs.size();
+    const std::size_t anchored = d_anchors.size();
+    d_anchors.resize(n);
+
+    // The legs that cannot be updated are repriced together, so the
+    // European ones still share one closed-form call.
+    std::vector<std::size_t> index;
+    LegBatch full;
+    for (std::size_t i = 0; i < n; ++i) {
+        const Leg leg = legs.leg(i);
+        Greeks greeks;
+        if (i < anchored && update(&greeks, d_anchors[i], leg)) {
+            outputs.set(i, greeks);
+            ++d_statistics.d_updates;
+            continue;
+        }
+        if (i < anchored) {
+            ++d_statistics.d_fallbacks;
+        }
+        index.push_back(i);
+        full.addLeg(leg.d_spot,
+                leg.d_strike,
+                leg.d_vol,
+                leg.d_rate,
+                leg.d_expiry,
+                leg.d_isCall,
+                leg.d_isAmerican,
+                std::vector<double>(leg.d_dividendTimes,
+                        leg.d_dividendTimes + leg.d_numDividends),
+                std::vector<double>(leg.d_dividendAmounts,
+                        leg.d_dividendAmounts + leg.d_numDividends));
+    }
+    if (index.empty()) {
+        return 0;
+    }
+
+    PricingResults results;
+    results.resize(full.size());
+    if (d_surfaces) {
+        d_surfaces->price(results.outputs(), full);
+    }
+    else {
+        d_pricer.price(results.outputs(), full);
+    }
+    for (std::size_t j = 0; j < index.size(); ++j) {
+        const Greeks greeks = { results.d_price[j], results.d_delta[j],
+            results.d_gamma[j], results.d_vega[j], results.d_theta[j],
+            results.d_rho[j] };
+        outputs.set(index[j], greeks);
+        setAnchor(&d_anchors[index[j]], full.leg(j), greeks);
+    }
+    d_statistics.d_reprices += index.size();
+    return index.size();
+}
+
+void IncrementalPricer::clear()
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    d_anchors.clear();
+}
+
+} // close namespace pricer
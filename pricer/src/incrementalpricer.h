@@ -0,0 +1,109 @@
+#ifndef _INCREMENTALPRICER_H_
+#define _INCREMENTALPRICER_H_
+
+#include "analyticengine.h"
+#include "batchpricer.h"
+#include "chebyshevpricer.h"
+#include "legbatch.h"
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace pricer {
+
+// IncrementalPricer reprices a strategy whose market data moves a little
+// between refreshes, as spot does by a few ticks. It keeps the last full
+// valuation of each leg as an anchor and, while the spot, vol and rate of
+// the leg stay within thresholds of the anchor, returns the second order
+// Taylor update
+//     P = P0 + delta dS + gamma dS^2 / 2 + vega dvol + rho dr,
+// with the delta moved by gamma dS and the other greeks of the anchor.
+//
+// The error of the update is estimated by applying the same update to the
+// closed-form European price of the leg and comparing it to the closed
+// form at the new inputs. The leg is repriced in full, and becomes the new
+// anchor, when that estimate exceeds the tolerance, when a move exceeds
+// its threshold, or when its strike, expiry, type or dividends changed.
+// Full reprices are exact BatchPricer solves, or come from a
+// ChebyshevPricer if one is given.
+//
+// For a European leg the estimate is the error of the update itself. For
+// an American leg it is only approximate: the European proxy does not see
+// the early exercise premium, whose curvature near the exercise boundary
+// can be larger, so the thresholds on the moves are what keep the update
+// of a deep in the money American leg close.
+//
+// All functions may be called from any thread; a call holds a lock on the
+// anchors for its duration.
+class IncrementalPricer {
+  public:
+    struct Config {
+        double d_spotMove;  // largest spot move, relative to the anchor
+        double d_volMove;   // largest absolute vol move
+        double d_rateMove;  // largest absolute rate move
+        double d_tolerance; // largest price error bound, in currency
+
+        Config();
+    };
+
+    // Statistics counts the legs priced since the last reset. Every leg is
+    // either updated or repriced; `d_fallbacks` counts the reprices of legs
+    // that had an anchor, whose move or error bound was too large.
+    struct Statistics {
+        std::size_t d_updates;
+        std::size_t d_reprices;
+        std::size_t d_fallbacks;
+
+        Statistics();
+    };
+
+  private:
+    struct Anchor {
+        LegBatch d_leg;       // the inputs of the full valuation
+        Greeks d_greeks;      // its price and greeks
+        Greeks d_european;    // the closed form of the leg as European
+        bool d_hasEuropean;   // false if the closed form rejected the leg
+    };
+
+    Config d_config;
+    AnalyticEngine d_analytic;
+    BatchPricer d_pricer;
+    ChebyshevPricer *d_surfaces;
+    mutable std::mutex d_mutex;
+    std::vector<Anchor> d_anchors;
+    Statistics d_statistics;
+
+    // Load into `greeks` the update of `leg` from `anchor` and return true,
+    // or return false if `leg` must be repriced in full.
+    bool update(Greeks *greeks, const Anchor& anchor, const Leg& leg) const;
+
+    void setAnchor(Anchor *anchor, const Leg& leg, const Greeks& greeks);
+
+  public:
+    // Create a pricer with no anchors, taking full reprices from
+    // `surfaces` if it is not null. Throw std::invalid_argument if a
+    // threshold or the tolerance is negative.
+    explicit IncrementalPricer(const Config& config = Config(),
+            ChebyshevPricer *surfaces = 0);
+
+    const Config& config() const { return d_config; }
+
+    Statistics statistics() const;
+
+    void resetStatistics();
+
+    // Load into `outputs`, which must have room for `legs.size()` entries,
+    // the price and greeks of every leg in `legs`, the leg at each index
+    // being updated from the anchor of the same index, and return the
+    // number of legs repriced in full. Throw std::invalid_argument if
+    // `legs` is not valid.
+    std::size_t price(const PricingOutputs& outputs, const LegBatch& legs);
+
+    // Drop the anchors, so the next legs are repriced in full.
+    void clear();
+};
+
+} // close namespace pricer
+
+#endif
@@ -0,0 +1,143 @@
+#include "legbatch.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace pricer {
+
+double dividendValue(const Leg& leg, double *pvRate)
+{
+    double pv = 0.0;
+    double rate = 0.0;
+    for (std::size_t i = 0; i < leg.d_numDividends; ++i) {
+        const double td = leg.d_dividendTimes[i];
+        if (td > 0.0 && td <= leg.d_expiry) {
+            const double value
+                    = leg.d_dividendAmounts[i] * std::exp(-leg.d_rate * td);
+            pv += value;
+            rate -= td * value;
+        }
+    }
+    if (pvRate) {
+        *pvRate = rate;
+    }
+    return pv;
+}
+
+LegBatch::LegBatch()
+    : d_dividendOffsets(1, 0)
+{
+}
+
+void LegBatch::addLeg(double spot,
+        double strike,
+        double vol,
+        double rate,
+        double expiry,
+        bool isCall,
+        bool isAmerican,
+        const std::vector<double>& dividendTimes,
+        const std::vector<double>& dividendAmounts)
+{
+    if (dividendTimes.size() != dividendAmounts.size()) {
+        throw std::invalid_argument(
+                "dividend times and amounts differ in length");
+    }
+
+    d_spot.push_back(spot);
+    d_strike.push_back(strike);
+    d_vol.push_back(vol);
+    d_rate.push_back(rate);
+    d_expiry.push_back(expiry);
+    d_isCall.push_back(isCall);
+    d_isAmerican.push_back(isAmerican);
+    d_dividendTimes.insert(d_dividendTimes.end(),
+            dividendTimes.begin(),
+            dividendTimes.end());
+    d_dividendAmounts.insert(d_dividendAmounts.end(),
+            dividendAmounts.begin(),
+            dividendAmounts.end());
+    d_dividendOffsets.push_back(d_dividendTimes.size());
+}
+
+Leg LegBatch::leg(std::size_t i) const
+{
+    Leg leg;
+    leg.d_spot = d_spot[i];
+    leg.d_strike = d_strike[i];
+    leg.d_vol = d_vol[i];
+    leg.d_rate = d_rate[i];
+    leg.d_expiry = d_expiry[i];
+    leg.d_isCall = d_isCall[i] != 0;
+    leg.d_isAmerican = d_isAmerican[i] != 0;
+    leg.d_numDividends = d_dividendOffsets[i + 1] - d_dividendOffsets[i];
+    leg.d_dividendTimes = leg.d_numDividends
+            ? &d_dividendTimes[d_dividendOffsets[i]]
+            : 0;
+    leg.d_dividendAmounts = leg.d_numDividends
+            ? &d_dividendAmounts[d_dividendOffsets[i]]
+            : 0;
+    return leg;
+}
+
+void LegBatch::validate() const
+{
+    const std::size_t n = size();
+    if (d_strike.size() != n || d_vol.size() != n || d_rate.size() != n
+            || d_expiry.size() != n || d_isCall.size() != n
+            || d_isAmerican.size() != n || d_dividendOffsets.size() != n + 1
+            || d_dividendTimes.size() != d_dividendAmounts.size()
+            || d_dividendOffsets.back() != d_dividendTimes.size()) {
+        throw std::invalid_argument("leg arrays differ in length");
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!(d_spot[i] > 0.0) || !(d_strike[i] > 0.0) || !(d_vol[i] > 0.0)
+                || !(d_expiry[i] > 0.0)) {
+            std::ostringstream os;
+            os << "leg " << i
+               << ": spot, strike, vol and expiry must be positive";
+            throw std::invalid_argument(os.str());
+        }
+    }
+}
+
+void PricingOutputs::set(std::size_t i, const Greeks& greeks) const
+{
+    d_price[i] = greeks.d_price;
+    d_delta[i] = greeks.d_delta;
+    d_gamma[i] = greeks.d_gamma;
+    d_vega[i] = greeks.d_vega;
+    d_theta[i] = greeks.d_theta;
+    d_rho[i] = greeks.d_rho;
+}
+
+void PricingResults::resize(std::size_t n)
+{
+    d_price.assign(n, 0.0);
+    d_delta.assign(n, 0.0);
+    d_gamma.assign(n, 0.0);
+    d_vega.assign(n, 0.0);
+    d_theta.assign(n, 0.0);
+    d_rho.assign(n, 0.0);
+}
+
+void PricingResults::set(std::size_t i, const Greeks& greeks)
+{
+    d_price[i] = greeks.d_price;
+    d_delta[i] = greeks.d_delta;
+    d_gamma[i] = greeks.d_gamma;
+    d_vega[i] = greeks.d_vega;
+    d_theta[i] = greeks.d_theta;
+    d_rho[i] = greeks.d_rho;
+}
+
+PricingOutputs PricingResults::outputs()
+{
+    const PricingOutputs outputs = { d_price.data(), d_delta.data(),
+        d_gamma.data(), d_vega.data(), d_theta.data(), d_rho.data() };
+    return outputs;
+}
+
+} // close namespace pricer
@@ -0,0 +1,116 @@
+#ifndef _LEGBATCH_H_
+#define _LEGBATCH_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace pricer {
+
+// Leg is a read-only view of one option leg inside a LegBatch. Times are
+// year fractions (Actual/365) measured from the valuation date; dividends
+// are cash amounts paid at the given ex-date times.
+struct Leg {
+    double d_spot;
+    double d_strike;
+    double d_vol;
+    double d_rate;
+    double d_expiry;
+    bool d_isCall;
+    bool d_isAmerican;
+    const double *d_dividendTimes;
+    const double *d_dividendAmounts;
+    std::size_t d_numDividends;
+};
+
+// Return the present value of the dividends of `leg` paid after the
+// valuation date and no later than expiry, and load its derivative in the
+// rate into `pvRate` if it is not null.
+double dividendValue(const Leg& leg, double *pvRate = 0);
+
+// LegBatch holds all legs of a strategy as structure-of-arrays. The
+// dividend schedule of leg `i` is the range
+// [d_dividendOffsets[i], d_dividendOffsets[i + 1]) of the dividend arrays.
+class LegBatch {
+  public:
+    std::vector<double> d_spot;
+    std::vector<double> d_strike;
+    std::vector<double> d_vol;
+    std::vector<double> d_rate;
+    std::vector<double> d_expiry;
+    std::vector<char> d_isCall;
+    std::vector<char> d_isAmerican;
+    std::vector<std::size_t> d_dividendOffsets;
+    std::vector<double> d_dividendTimes;
+    std::vector<double> d_dividendAmounts;
+
+    LegBatch();
+
+    void addLeg(double spot,
+            double strike,
+            double vol,
+            double rate,
+            double expiry,
+            bool isCall,
+            bool isAmerican,
+            const std::vector<double>& dividendTimes
+            = std::vector<double>(),
+            const std::vector<double>& dividendAmounts
+            = std::vector<double>());
+
+    std::size_t size() const { return d_spot.size(); }
+
+    Leg leg(std::size_t i) const;
+
+    // Throw std::invalid_argument if the arrays are not consistent or a
+    // leg has a non-positive spot, strike, vol or expiry.
+    void validate() const;
+};
+
+// Greeks is the full first-order sensitivity set of one leg. Theta is the
+// change in value per year of calendar time, vega and rho are per 1.0
+// absolute change in volatility and rate.
+struct Greeks {
+    double d_price;
+    double d_delta;
+    double d_gamma;
+    double d_vega;
+    double d_theta;
+    double d_rho;
+};
+
+// PricingOutputs receives the price and greeks of a batch in arrays owned
+// by the caller, such as the buffers of NumPy arrays, each with one entry
+// per leg in the order of the batch.
+struct PricingOutputs {
+    double *d_price;
+    double *d_delta;
+    double *d_gamma;
+    double *d_vega;
+    double *d_theta;
+    double *d_rho;
+
+    void set(std::size_t i, const Greeks& greeks) const;
+};
+
+// PricingResults holds one entry per leg, in the order of the batch, with
+// the same units as Greeks.
+class PricingResults {
+  public:
+    std::vector<double> d_price;
+    std::vector<double> d_delta;
+    std::vector<double> d_gamma;
+    std::vector<double> d_vega;
+    std::vector<double> d_theta;
+    std::vector<double> d_rho;
+
+    void resize(std::size_t n);
+
+    void set(std::size_t i, const Greeks& greeks);
+
+    // Return the arrays of the results, valid until the next `resize`.
+    PricingOutputs outputs();
+};
+
+} // close namespace pricer
+
+#endif
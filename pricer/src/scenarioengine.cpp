@@ -0,0 +1,315 @@
+#include "scenarioengine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace pricer {
+
+namespace {
+
+// Return true if `a` and `b` have the same inputs, dividends included.
+bool sameInputs(const Leg& a, const Leg& b)
+{
+    if (a.d_spot != b.d_spot || a.d_strike != b.d_strike
+            || a.d_vol != b.d_vol || a.d_rate != b.d_rate
+            || a.d_expiry != b.d_expiry || a.d_isCall != b.d_isCall
+            || a.d_isAmerican != b.d_isAmerican
+            || a.d_numDividends != b.d_numDividends) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.d_numDividends; ++i) {
+        if (a.d_dividendTimes[i] != b.d_dividendTimes[i]
+                || a.d_dividendAmounts[i] != b.d_dividendAmounts[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Load into `values` the value of `base` at each of `spots`, with its vol
+// moved by `volShift` and its expiry and dividends brought forward by
+// `horizon`.
+void valueLeg(double *values,
+        const Leg& base,
+        const std::vector<double>& spots,
+        double volShift,
+        double horizon,
+        const AnalyticEngine& analytic,
+        const FdEngine& engine)
+{
+    const std::size_t n = spots.size();
+    Leg leg = base;
+    leg.d_vol += volShift;
+    leg.d_expiry -= horizon;
+    if (leg.d_expiry <= 0.0) {
+        const double sign = leg.d_isCall ? 1.0 : -1.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            values[i] = std::max(sign * (spots[i] - leg.d_strike), 0.0);
+        }
+        return;
+    }
+
+    std::vector<double> times(base.d_dividendTimes,
+            base.d_dividendTimes + base.d_numDividends);
+    for (std::size_t k = 0; k < times.size(); ++k) {
+        times[k] -= horizon;
+    }
+    leg.d_dividendTimes = times.empty() ? 0 : &times[0];
+
+    if (!leg.d_isAmerican) {
+        std::size_t i = 0;
+        for (; i < n; ++i) {
+            leg.d_spot = spots[i];
+            Greeks greeks;
+            if (!analytic.price(&greeks, leg)) {
+                break;
+            }
+            values[i] = greeks.d_price;
+        }
+        if (i == n) {
+            return;
+        }
+        leg.d_spot = base.d_spot;
+    }
+
+    std::vector<double> prices;
+    engine.priceSpots(&prices, leg, spots);
+    std::copy(prices.begin(), prices.end(), values);
+}
+
+// TaskQueues holds the tasks dealt to each thread. A thread takes its own
+// tasks from the front of its queue, in the order dealt, and steals from
+// the back of the queues of the others, so owner and thief rarely contend
+// for the same task.
+class TaskQueues {
+  private:
+    struct Queue {
+        std::mutex d_mutex;
+        std::deque<std::size_t> d_tasks;
+    };
+
+    std::vector<Queue> d_queues;
+
+  public:
+    explicit TaskQueues(std::size_t threads)
+        : d_queues(threads)
+    {
+    }
+
+    void push(std::size_t thread, std::size_t task)
+    {
+        d_queues[thread].d_tasks.push_back(task);
+    }
+
+    // Load into `task` the next task of `thread`, or one stolen from
+    // another thread, and return true, or return false if none is left.
+    bool pop(std::size_t *task, std::size_t thread)
+    {
+        const std::size_t n = d_queues.size();
+        for (std::size_t k = 0; k < n; ++k) {
+            Queue& queue = d_queues[(thread + k) % n];
+            std::lock_guard<std::mutex> lock(queue.d_mutex);
+            if (queue.d_tasks.empty()) {
+                continue;
+            }
+            if (k == 0) {
+                *task = queue.d_tasks.front();
+                queue.d_tasks.pop_front();
+            }
+            else {
+                *task = queue.d_tasks.back();
+                queue.d_tasks.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+// Worker runs the tasks of one thread, each of which values the leg
+// `d_legs[task / cells]` at every spot of the cell `task % cells`, a vol
+// shift and horizon, into `d_values`.
+struct Worker {
+    TaskQueues *d_queues;
+    std::size_t d_thread;
+    const std::vector<Leg> *d_legs;
+    const std::vector<std::vector<double> > *d_spots;
+    const ScenarioGrid *d_grid;
+    const AnalyticEngine *d_analytic;
+    const FdEngine *d_engine;
+    double *d_values;
+
+    void operator()() const
+    {
+        const std::size_t spots = d_grid->d_spotShifts.size();
+        const std::size_t vols = d_grid->d_volShifts.size();
+        const std::size_t cells = vols * d_grid->d_horizons.size();
+        std::size_t task;
+        while (d_queues->pop(&task, d_thread)) {
+            const std::size_t leg = task / cells;
+            const std::size_t cell = task % cells;
+            valueLeg(d_values + task * spots,
+                    (*d_legs)[leg],
+                    (*d_spots)[leg],
+                    d_grid->d_volShifts[cell % vols],
+                    d_grid->d_horizons[cell / vols],
+                    *d_analytic,
+                    *d_engine);
+        }
+    }
+};
+
+} // close unnamed namespace
+
+std::size_t ScenarioGrid::size() const
+{
+    return d_spotShifts.size() * d_volShifts.size() * d_horizons.size();
+}
+
+ScenarioEngine::Config::Config()
+    : d_threads(0)
+{
+}
+
+ScenarioEngine::ScenarioEngine(const Config& config,
+        const FdEngine::Config& fdConfig)
+    : d_config(config)
+    , d_analytic()
+    , d_engine(fdConfig)
+{
+}
+
+void ScenarioEngine::value(std::vector<double> *values,
+        const LegBatch& legs,
+        const std::vector<double>& quantities,
+        const ScenarioGrid& grid) const
+{
+    values->resize(grid.size());
+    value(values->empty() ? 0 : &(*values)[0], legs, quantities, grid);
+}
+
+void ScenarioEngine::value(double *values,
+        const LegBatch& legs,
+        const std::vector<double>& quantities,
+        const ScenarioGrid& grid) const
+{
+    legs.validate();
+    if (quantities.size() != legs.size()) {
+        throw std::invalid_argument("one quantity is needed per leg");
+    }
+    const std::vector<double>& spotShifts = grid.d_spotShifts;
+    for (std::size_t i = 0; i < spotShifts.size(); ++i) {
+        if (!(spotShifts[i] > -1.0)
+                || (i > 0 && !(spotShifts[i] > spotShifts[i - 1]))) {
+            throw std::invalid_argument(
+                    "spot shifts must be increasing and above -1");
+        }
+    }
+    for (std::size_t i = 0; i < grid.d_horizons.size(); ++i) {
+        if (!(grid.d_horizons[i] >= 0.0)) {
+            throw std::invalid_argument("horizons must not be negative");
+        }
+    }
+
+    // The distinct legs held, with their net quantities.
+    std::vector<Leg> distinct;
+    std::vector<double> weights;
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        if (quantities[i] == 0.0) {
+            continue;
+        }
+        const Leg leg = legs.leg(i);
+        for (std::size_t k = 0; k < grid.d_volShifts.size(); ++k) {
+            if (!(leg.d_vol + grid.d_volShifts[k] > 0.0)) {
+                throw std::invalid_argument("shifted vols must be positive");
+            }
+        }
+        std::size_t j = 0;
+        while (j < distinct.size() && !sameInputs(distinct[j], leg)) {
+            ++j;
+        }
+        if (j == distinct.size()) {
+            distinct.push_back(leg);
+            weights.push_back(0.0);
+        }
+        weights[j] += quantities[i];
+    }
+
+    const std::size_t size = grid.size();
+    std::fill(values, values + size, 0.0);
+    if (distinct.empty() || size == 0) {
+        return;
+    }
+
+    std::vector<std::vector<double> > spots(distinct.size());
+    for (std::size_t j = 0; j < distinct.size(); ++j) {
+        spots[j].resize(spotShifts.size());
+        for (std::size_t i = 0; i < spotShifts.size(); ++i) {
+            spots[j][i] = distinct[j].d_spot * (1.0 + spotShifts[i]);
+        }
+    }
+
+    // The tasks that need a finite difference solve are dealt first, so
+    // they start before the closed-form ones, and round robin, so each
+    // thread starts with its share of them.
+    const std::size_t cells = grid.d_volShifts.size() * grid.d_horizons.size();
+    const std::size_t tasks = distinct.size() * cells;
+    std::vector<std::size_t> order;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (std::size_t task = 0; task < tasks; ++task) {
+            if (distinct[task / cells].d_isAmerican == (pass == 0)) {
+                order.push_back(task);
+            }
+        }
+    }
+
+    std::size_t threads = d_config.d_threads > 0
+            ? d_config.d_threads
+            : std::thread::hardware_concurrency();
+    threads = std::max<std::size_t>(std::min(threads, tasks), 1);
+    TaskQueues queues(threads);
+    for (std::size_t k = 0; k < order.size(); ++k) {
+        queues.push(k % threads, order[k]);
+    }
+
+    // Each task fills its own row of the values of one leg, which are
+    // summed once all are done.
+    std::vector<double> legValues(distinct.size() * size);
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < threads; ++t) {
+        const Worker worker = { &queues,
+            t,
+            &distinct,
+            &spots,
+            &grid,
+            &d_analytic,
+            &d_engine,
+            &legValues[0] };
+        pool.push_back(std::thread(worker));
+    }
+    const Worker worker = { &queues,
+        0,
+        &distinct,
+        &spots,
+        &grid,
+        &d_analytic,
+        &d_engine,
+        &legValues[0] };
+    worker();
+    for (std::size_t t = 0; t < pool.size(); ++t) {
+        pool[t].join();
+    }
+
+    for (std::size_t j = 0; j < distinct.size(); ++j) {
+        const double *row = &legValues[j * size];
+        for (std::size_t s = 0; s < size; ++s) {
+            values[s] += weights[j] * row[s];
+        }
+    }
+}
+
+} // close namespace pricer
@@ -0,0 +1,87 @@
+#ifndef _SCENARIOENGINE_H_
+#define _SCENARIOENGINE_H_
+
+#include "analyticengine.h"
+#include "fdengine.h"
+#include "legbatch.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace pricer {
+
+// ScenarioGrid is the set of scenarios of a risk ladder: every spot shift
+// with every vol shift at every horizon. Spot shifts are relative, so a
+// shift of -0.1 takes the spot of each leg to 90% of today, vol shifts are
+// added to the vol of each leg, and horizons are year fractions from the
+// valuation date, by which the expiry and dividend times of each leg are
+// brought forward.
+struct ScenarioGrid {
+    std::vector<double> d_spotShifts;
+    std::vector<double> d_volShifts;
+    std::vector<double> d_horizons;
+
+    // Return the number of scenarios, the size of the value array.
+    std::size_t size() const;
+};
+
+// ScenarioEngine values a strategy, the legs of a LegBatch held in the
+// given quantities, under every scenario of a ScenarioGrid, for the spot,
+// vol and time ladders of a screen. The values are stored densely with
+// the spot shift varying fastest, at
+//     (horizon * volShifts + vol) * spotShifts + spot.
+//
+// The work is split into one task per leg, vol shift and horizon, which
+// values the leg at every spot shift: European legs by the closed form at
+// each spot, and any other leg by one finite difference solve on a grid
+// covering all spots, read off between nodes. Legs with the same inputs,
+// such as the two wings of a butterfly entered separately, are valued
+// once. The tasks are dealt out to the threads ahead of time, American
+// solves first, and a thread that runs out steals from the others, so the
+// few slow solves do not hold up the ladder. The strategy values are
+// summed over the legs in a fixed order once all tasks are done, so they
+// do not depend on the schedule.
+//
+// A leg that has expired by a horizon is worth its intrinsic value at
+// the shifted spot.
+class ScenarioEngine {
+  public:
+    struct Config {
+        int d_threads; // worker threads, 0 for one per core
+
+        Config();
+    };
+
+  private:
+    Config d_config;
+    AnalyticEngine d_analytic;
+    FdEngine d_engine;
+
+  public:
+    explicit ScenarioEngine(const Config& config = Config(),
+            const FdEngine::Config& fdConfig = FdEngine::Config());
+
+    const Config& config() const { return d_config; }
+
+    // Load into `values`, which must have room for `grid.size()` entries,
+    // the value of the strategy holding `quantities[i]` of leg `i` of
+    // `legs` under every scenario of `grid`. Throw std::invalid_argument
+    // if `legs` is not valid, the quantities do not match the legs, the
+    // spot shifts are not increasing and above -1, a shifted vol is not
+    // positive, or a horizon is negative.
+    void value(double *values,
+            const LegBatch& legs,
+            const std::vector<double>& quantities,
+            const ScenarioGrid& grid) const;
+
+    // Load into `values` the value of the strategy under every scenario of
+    // `grid`, resizing it to `grid.size()` entries.
+    void value(std::vector<double> *values,
+            const LegBatch& legs,
+            const std::vector<double>& quantities,
+            const ScenarioGrid& grid) const;
+};
+
+} // close namespace pricer
+
+#endif
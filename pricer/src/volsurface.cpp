@@ -0,0 +1,769 @@
+#include "volsurface.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace pricer {
+
+namespace {
+
+typedef std::vector<double> Doubles;
+
+void validate(const Chain& chain)
+{
+    if (chain.d_numStrikes < 3) {
+        throw std::invalid_argument("chain needs at least three strikes");
+    }
+    if (!(chain.d_spot > 0.0) || !(chain.d_expiry > 0.0)) {
+        throw std::invalid_argument(
+                "chain spot and expiry must be positive");
+    }
+    for (std::size_t i = 0; i < chain.d_numStrikes; ++i) {
+        if (!(chain.d_strikes[i] > 0.0) || !(chain.d_vols[i] > 0.0)) {
+            throw std::invalid_argument(
+                    "chain strikes and vols must be positive");
+        }
+        if (i > 0 && !(chain.d_strikes[i] > chain.d_strikes[i - 1])) {
+            throw std::invalid_argument(
+                    "chain strikes must be increasing");
+        }
+    }
+}
+
+// Minimise `objective` over the `x.size()` variables by Nelder-Mead from
+// `x` with the initial simplex steps `step`, for at most `iterations`
+// iterations, and load the best point into `x`.
+template <class OBJECTIVE>
+double minimize(Doubles *x,
+        const OBJECTIVE& objective,
+        const Doubles& step,
+        int iterations)
+{
+    const std::size_t n = x->size();
+    std::vector<Doubles> points(n + 1, *x);
+    Doubles values(n + 1);
+    for (std::size_t i = 0; i < n; ++i) {
+        points[i + 1][i] += step[i];
+    }
+    for (std::size_t i = 0; i <= n; ++i) {
+        values[i] = objective(points[i]);
+    }
+
+    Doubles centroid(n);
+    Doubles trial(n);
+    Doubles expanded(n);
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        // Order the vertices so that points[0] is the best and points[n]
+        // the worst.
+        for (std::size_t i = 1; i <= n; ++i) {
+            for (std::size_t j = i; j > 0 && values[j] < values[j - 1];
+                    --j) {
+                std::swap(values[j], values[j - 1]);
+                points[j].swap(points[j - 1]);
+            }
+        }
+        if (values[n] - values[0] <= 1e-14 * (1.0 + std::fabs(values[0]))) {
+            break;
+        }
+
+        std::fill(centroid.begin(), centroid.end(), 0.0);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t j = 0; j < n; ++j) {
+                centroid[j] += points[i][j] / n;
+            }
+        }
+        for (std::size_t j = 0; j < n; ++j) {
+            trial[j] = 2.0 * centroid[j] - points[n][j];
+        }
+        const double reflected = objective(trial);
+        if (reflected < values[0]) {
+            for (std::size_t j = 0; j < n; ++j) {
+                expanded[j] = 3.0 * centroid[j] - 2.0 * points[n][j];
+            }
+            const double value = objective(expanded);
+            if (value < reflected) {
+                points[n] = expanded;
+                values[n] = value;
+            }
+            else {
+                points[n] = trial;
+                values[n] = reflected;
+            }
+            continue;
+        }
+        if (reflected < values[n - 1]) {
+            points[n] = trial;
+            values[n] = reflected;
+            continue;
+        }
+
+        // Contract towards the better of the worst and reflected points,
+        // and shrink the simplex towards the best if that fails too.
+        const bool outside = reflected < values[n];
+        const Doubles& from = outside ? trial : points[n];
+        for (std::size_t j = 0; j < n; ++j) {
+            expanded[j] = 0.5 * (centroid[j] + from[j]);
+        }
+        const double contracted = objective(expanded);
+        if (contracted < std::min(reflected, values[n])) {
+            points[n] = expanded;
+            values[n] = contracted;
+            continue;
+        }
+        for (std::size_t i = 1; i <= n; ++i) {
+            for (std::size_t j = 0; j < n; ++j) {
+                points[i][j] = 0.5 * (points[0][j] + points[i][j]);
+            }
+            values[i] = objective(points[i]);
+        }
+    }
+
+    const std::size_t best = std::min_element(values.begin(), values.end())
+            - values.begin();
+    *x = points[best];
+    return values[best];
+}
+
+// Return the least squares residual against the total variances `w` at
+// `k` of the SVI slice with the fixed `m` and `sigma`, and load the slice
+// into `slice`. With y = (k - m) / sigma the slice is
+// w = a + d y + c sqrt(y^2 + 1), c = b sigma, d = rho b sigma, which is
+// linear in (a, c, d); the bounds 0 <= c <= 4 sigma, |d| <= c and
+// |d| <= 4 sigma - c, those of b (1 + |rho|) <= 4, and a non-negative
+// minimum variance are met by solving on each face of the domain where
+// the unconstrained solution leaves it.
+double fitLinear(SviSlice *slice,
+        const Doubles& k,
+        const Doubles& w,
+        double m,
+        double sigma)
+{
+    const std::size_t n = k.size();
+    Doubles y(n);
+    Doubles z(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        y[i] = (k[i] - m) / sigma;
+        z[i] = std::sqrt(y[i] * y[i] + 1.0);
+    }
+    const double bound = 4.0 * sigma;
+
+    double best = HUGE_VAL;
+    double bestA = 0.0;
+    double bestC = 0.0;
+    double bestD = 0.0;
+    const double tolerance = 1e-12 * bound;
+
+    // Candidate 0 is unconstrained; candidates 1 to 4 are the faces
+    // d = s c + t, and 5 and 6 the edges c = 0 and c = 4 sigma.
+    for (int candidate = 0; candidate < 7; ++candidate) {
+        double a;
+        double c;
+        double d;
+        if (candidate == 0) {
+            double s[3][4] = { { 0.0 } };
+            for (std::size_t i = 0; i < n; ++i) {
+                const double row[3] = { 1.0, y[i], z[i] };
+                for (int r = 0; r < 3; ++r) {
+                    for (int q = 0; q < 3; ++q) {
+                        s[r][q] += row[r] * row[q];
+                    }
+                    s[r][3] += row[r] * w[i];
+                }
+            }
+
+            // Gaussian elimination of the normal equations.
+            bool singular = false;
+            for (int r = 0; r < 3 && !singular; ++r) {
+                int pivot = r;
+                for (int q = r + 1; q < 3; ++q) {
+                    if (std::fabs(s[q][r]) > std::fabs(s[pivot][r])) {
+                        pivot = q;
+                    }
+                }
+                for (int q = 0; q < 4; ++q) {
+                    std::swap(s[r][q], s[pivot][q]);
+                }
+                if (std::fabs(s[r][r]) < 1e-300) {
+                    singular = true;
+                    break;
+                }
+                for (int q = r + 1; q < 3; ++q) {
+                    const double f = s[q][r] / s[r][r];
+                    for (int p = r; p < 4; ++p) {
+                        s[q][p] -= f * s[r][p];
+                    }
+                }
+            }
+            if (singular) {
+                continue;
+            }
+            double solution[3];
+            for (int r = 2; r >= 0; --r) {
+                double sum = s[r][3];
+                for (int q = r + 1; q < 3; ++q) {
+                    sum -= s[r][q] * solution[q];
+                }
+                solution[r] = sum / s[r][r];
+            }
+            a = solution[0];
+            d = solution[1];
+            c = solution[2];
+        }
+        else if (candidate <= 4) {
+            const double slope = candidate % 2 == 1 ? 1.0 : -1.0;
+            const double offset = candidate <= 2 ? 0.0 : -slope * bound;
+            double su = 0.0;
+            double suu = 0.0;
+            double sv = 0.0;
+            double suv = 0.0;
+            for (std::size_t i = 0; i < n; ++i) {
+                const double u = z[i] + slope * y[i];
+                const double v = w[i] - offset * y[i];
+                su += u;
+                suu += u * u;
+                sv += v;
+                suv += u * v;
+            }
+            const double det = n * suu - su * su;
+            if (std::fabs(det) < 1e-300) {
+                continue;
+            }
+            c = (n * suv - su * sv) / det;
+            a = (sv - c * su) / n;
+            d = slope * c + offset;
+        }
+        else {
+            c = candidate == 5 ? 0.0 : bound;
+            d = 0.0;
+            a = 0.0;
+            for (std::size_t i = 0; i < n; ++i) {
+                a += (w[i] - c * z[i]) / n;
+            }
+        }
+
+        if (c < -tolerance || c > bound + tolerance
+                || std::fabs(d) > c + tolerance
+                || std::fabs(d) > bound - c + tolerance
+                || a + std::sqrt(std::max(c * c - d * d, 0.0)) < 0.0) {
+            continue;
+        }
+        double residual = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            const double e = a + d * y[i] + c * z[i] - w[i];
+            residual += e * e;
+        }
+        if (residual < best) {
+            best = residual;
+            bestA = a;
+            bestC = std::max(c, 0.0);
+            bestD = d;
+        }
+    }
+
+    slice->d_a = bestA;
+    slice->d_b = bestC / sigma;
+    slice->d_rho = bestC > 0.0
+            ? std::max(std::min(bestD / bestC, 1.0), -1.0)
+            : 0.0;
+    slice->d_m = m;
+    slice->d_sigma = sigma;
+    return best;
+}
+
+// The residual of the best SVI slice at (m, ln sigma).
+class SviObjective {
+  private:
+    const Doubles *d_k;
+    const Doubles *d_w;
+
+  public:
+    SviObjective(const Doubles *k, const Doubles *w)
+        : d_k(k)
+        , d_w(w)
+    {
+    }
+
+    double operator()(const Doubles& x) const
+    {
+        SviSlice slice;
+        const double sigma = std::exp(std::min(std::max(x[1], -9.0), 2.0));
+        return fitLinear(&slice, *d_k, *d_w, x[0], sigma);
+    }
+};
+
+// Load into `slice` the SVI fit of the total variances `w` at `k`, starting
+// from `slice` if it holds an earlier fit.
+void fitSvi(SviSlice *slice,
+        const Doubles& k,
+        const Doubles& w,
+        int iterations)
+{
+    Doubles x(2);
+    if (slice->d_sigma > 0.0) {
+        x[0] = slice->d_m;
+        x[1] = std::log(slice->d_sigma);
+    }
+    else {
+        x[0] = k[std::min_element(w.begin(), w.end()) - w.begin()];
+        x[1] = std::log(0.1);
+    }
+    Doubles step(2);
+    step[0] = 0.1;
+    step[1] = 0.5;
+    const SviObjective objective(&k, &w);
+    minimize(&x, objective, step, iterations);
+    const double sigma = std::exp(std::min(std::max(x[1], -9.0), 2.0));
+    fitLinear(slice, k, w, x[0], sigma);
+}
+
+// The SSVI slice of the at the money total variance `theta`, for the
+// correlation `rho` and the power law phi(theta) = eta / sqrt(theta
+// (1 + theta)), written as a raw SVI slice.
+SviSlice ssviSlice(double theta, double rho, double eta)
+{
+    const double phi = eta / std::sqrt(theta * (1.0 + theta));
+    SviSlice slice;
+    slice.d_a = 0.5 * theta * (1.0 - rho * rho);
+    slice.d_b = 0.5 * theta * phi;
+    slice.d_rho = rho;
+    slice.d_m = -rho / phi;
+    slice.d_sigma = std::sqrt(1.0 - rho * rho) / phi;
+    return slice;
+}
+
+// Map the unconstrained `x` to (rho, eta) with |rho| < 1 and
+// eta (1 + |rho|) < 2.
+void ssviParameters(double *rho, double *eta, const Doubles& x)
+{
+    *rho = 0.999 * std::tanh(x[0]);
+    *eta = 2.0 / (1.0 + std::fabs(*rho)) / (1.0 + std::exp(-x[1]));
+}
+
+// The residual of the SSVI surface with the at the money variances
+// `thetas` against all quotes.
+class SsviObjective {
+  private:
+    const std::vector<const Doubles *> *d_k;
+    const std::vector<const Doubles *> *d_w;
+    const Doubles *d_thetas;
+
+  public:
+    SsviObjective(const std::vector<const Doubles *> *k,
+            const std::vector<const Doubles *> *w,
+            const Doubles *thetas)
+        : d_k(k)
+        , d_w(w)
+        , d_thetas(thetas)
+    {
+    }
+
+    double operator()(const Doubles& x) const
+    {
+        double rho;
+        double eta;
+        ssviParameters(&rho, &eta, x);
+        double residual = 0.0;
+        for (std::size_t j = 0; j < d_thetas->size(); ++j) {
+            const SviSlice slice = ssviSlice((*d_thetas)[j], rho, eta);
+            const Doubles& k = *(*d_k)[j];
+            const Doubles& w = *(*d_w)[j];
+            for (std::size_t i = 0; i < k.size(); ++i) {
+                const double e = slice.totalVariance(k[i]) - w[i];
+                residual += e * e;
+            }
+        }
+        return residual;
+    }
+};
+
+// Return true if `slice` is free of butterfly arbitrage at `points`
+// log-moneynesses in [lo, hi], and lies above `before`, if any.
+bool isArbitrageFree(const SviSlice& slice,
+        const SviSlice *before,
+        double lo,
+        double hi,
+        int points)
+{
+    for (int i = 0; i < points; ++i) {
+        const double k = lo + (hi - lo) * i / (points - 1);
+        const double w = slice.totalVariance(k);
+        if (!(w > 0.0)) {
+            return false;
+        }
+        if (before && w < before->totalVariance(k) - 1e-12) {
+            return false;
+        }
+
+        // Gatheral's density condition g(k) >= 0.
+        double dw;
+        double d2w;
+        slice.derivatives(&dw, &d2w, k);
+        const double u = 1.0 - 0.5 * k * dw / w;
+        const double g = u * u - 0.25 * dw * dw * (1.0 / w + 0.25)
+                + 0.5 * d2w;
+        if (g < -1e-10) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Worker fits the expiries of `d_dirty` in turn, taking the next from
+// `d_next` until none is left.
+struct Worker {
+    const std::vector<Doubles *> *d_k;
+    const std::vector<Doubles *> *d_w;
+    const std::vector<SviSlice *> *d_fits;
+    std::atomic<std::size_t> *d_next;
+    int d_iterations;
+
+    void operator()() const
+    {
+        while (true) {
+            const std::size_t i = d_next->fetch_add(1);
+            if (i >= d_fits->size()) {
+                break;
+            }
+            fitSvi((*d_fits)[i], *(*d_k)[i], *(*d_w)[i], d_iterations);
+        }
+    }
+};
+
+// Return true if `values` holds the `n` values at `data`.
+bool sameValues(const Doubles& values, const double *data, std::size_t n)
+{
+    return values.size() == n
+            && std::equal(values.begin(), values.end(), data);
+}
+
+} // close unnamed namespace
+
+double SviSlice::totalVariance(double k) const
+{
+    const double x = k - d_m;
+    return d_a + d_b * (d_rho * x + std::sqrt(x * x + d_sigma * d_sigma));
+}
+
+void SviSlice::derivatives(double *dw, double *d2w, double k) const
+{
+    const double x = k - d_m;
+    const double r = std::sqrt(x * x + d_sigma * d_sigma);
+    *dw = d_b * (d_rho + x / r);
+    *d2w = d_b * d_sigma * d_sigma / (r * r * r);
+}
+
+VolSurface::VolSurface(std::size_t version,
+        double spot,
+        const std::vector<double>& expiries,
+        const std::vector<double>& forwards,
+        const std::vector<SviSlice>& slices,
+        const std::vector<char>& isSsvi)
+    : d_version(version)
+    , d_spot(spot)
+    , d_expiries(expiries)
+    , d_forwards(forwards)
+    , d_slices(slices)
+    , d_isSsvi(isSsvi)
+{
+    if (expiries.empty()) {
+        throw std::invalid_argument("surface has no slices");
+    }
+    if (forwards.size() != expiries.size()
+            || slices.size() != expiries.size()
+            || isSsvi.size() != expiries.size()) {
+        throw std::invalid_argument("surface arrays differ in length");
+    }
+    for (std::size_t i = 0; i < expiries.size(); ++i) {
+        if (!(expiries[i] > (i == 0 ? 0.0 : expiries[i - 1]))) {
+            throw std::invalid_argument(
+                    "surface expiries must be positive and increasing");
+        }
+    }
+}
+
+double VolSurface::forward(double expiry) const
+{
+    const std::size_t n = d_expiries.size();
+    const std::size_t j = std::upper_bound(d_expiries.begin(),
+                                  d_expiries.end(),
+                                  expiry)
+            - d_expiries.begin();
+    const std::size_t from = j == n ? n - 1 : j;
+    const double t0 = from == 0 ? 0.0 : d_expiries[from - 1];
+    const double f0 = from == 0 ? d_spot : d_forwards[from - 1];
+    const double t1 = d_expiries[from];
+    const double f1 = d_forwards[from];
+    return f0 * std::exp(std::log(f1 / f0) * (expiry - t0) / (t1 - t0));
+}
+
+double VolSurface::totalVariance(double k, double expiry) const
+{
+    const std::size_t n = d_expiries.size();
+    const std::size_t j = std::upper_bound(d_expiries.begin(),
+                                  d_expiries.end(),
+                                  expiry)
+            - d_expiries.begin();
+    if (j == 0) {
+        return d_slices[0].totalVariance(k) * expiry / d_expiries[0];
+    }
+    if (j == n) {
+        return d_slices[n - 1].totalVariance(k) * expiry
+                / d_expiries[n - 1];
+    }
+    const double t0 = d_expiries[j - 1];
+    const double t1 = d_expiries[j];
+    const double alpha = (expiry - t0) / (t1 - t0);
+    return (1.0 - alpha) * d_slices[j - 1].totalVariance(k)
+            + alpha * d_slices[j].totalVariance(k);
+}
+
+double VolSurface::vol(double strike, double expiry) const
+{
+    if (!(strike > 0.0) || !(expiry > 0.0)) {
+        throw std::invalid_argument(
+                "surface strike and expiry must be positive");
+    }
+    const double k = std::log(strike / forward(expiry));
+    return std::sqrt(std::max(totalVariance(k, expiry), 0.0) / expiry);
+}
+
+VolSurfaceBuilder::Config::Config()
+    : d_threads(0)
+    , d_iterations(200)
+    , d_checkPoints(41)
+{
+}
+
+VolSurfaceBuilder::Expiry::Expiry()
+    : d_spot(0.0)
+    , d_rate(0.0)
+    , d_forward(0.0)
+    , d_dirty(false)
+{
+    d_fit.d_a = 0.0;
+    d_fit.d_b = 0.0;
+    d_fit.d_rho = 0.0;
+    d_fit.d_m = 0.0;
+    d_fit.d_sigma = 0.0;
+}
+
+VolSurfaceBuilder::VolSurfaceBuilder(const Config& config)
+    : d_config(config)
+    , d_spot(0.0)
+    , d_changed(false)
+    , d_version(0)
+{
+}
+
+bool VolSurfaceBuilder::update(const Chain& chain)
+{
+    validate(chain);
+    std::map<double, Expiry>::iterator it = d_expiries.find(chain.d_expiry);
+    if (it != d_expiries.end() && it->second.d_spot == chain.d_spot
+            && it->second.d_rate == chain.d_rate
+            && sameValues(it->second.d_dividendTimes,
+                    chain.d_dividendTimes,
+                    chain.d_numDividends)
+            && sameValues(it->second.d_dividendAmounts,
+                    chain.d_dividendAmounts,
+                    chain.d_numDividends)
+            && sameValues(it->second.d_strikes,
+                    chain.d_strikes,
+                    chain.d_numStrikes)
+            && sameValues(
+                    it->second.d_vols, chain.d_vols, chain.d_numStrikes)) {
+        d_spot = chain.d_spot;
+        return false;
+    }
+
+    const double r = chain.d_rate;
+    const double expiry = chain.d_expiry;
+    double pv = 0.0;
+    for (std::size_t i = 0; i < chain.d_numDividends; ++i) {
+        const double td = chain.d_dividendTimes[i];
+        if (td > 0.0 && td <= expiry) {
+            pv += chain.d_dividendAmounts[i] * std::exp(-r * td);
+        }
+    }
+    if (!(chain.d_spot - pv > 0.0)) {
+        throw std::invalid_argument("chain spot does not cover dividends");
+    }
+    const double forward = (chain.d_spot - pv) * std::exp(r * expiry);
+
+    const std::size_t n = chain.d_numStrikes;
+    Doubles k(n);
+    Doubles w(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        k[i] = std::log(chain.d_strikes[i] / forward);
+        w[i] = chain.d_vols[i] * chain.d_vols[i] * expiry;
+    }
+
+    d_spot = chain.d_spot;
+    if (it == d_expiries.end()) {
+        it = d_expiries.insert(std::make_pair(expiry, Expiry())).first;
+    }
+    Expiry& entry = it->second;
+    entry.d_spot = chain.d_spot;
+    entry.d_rate = chain.d_rate;
+    entry.d_dividendTimes.assign(chain.d_dividendTimes,
+            chain.d_dividendTimes + chain.d_numDividends);
+    entry.d_dividendAmounts.assign(chain.d_dividendAmounts,
+            chain.d_dividendAmounts + chain.d_numDividends);
+    entry.d_strikes.assign(chain.d_strikes, chain.d_strikes + n);
+    entry.d_vols.assign(chain.d_vols, chain.d_vols + n);
+    entry.d_forward = forward;
+    entry.d_k.swap(k);
+    entry.d_w.swap(w);
+    entry.d_dirty = true;
+    d_changed = true;
+    return true;
+}
+
+void VolSurfaceBuilder::remove(double expiry)
+{
+    if (d_expiries.erase(expiry) > 0) {
+        d_changed = true;
+    }
+}
+
+std::shared_ptr<const VolSurface> VolSurfaceBuilder::publish()
+{
+    if (!d_changed) {
+        return surface();
+    }
+
+    // Refit the changed expiries across threads, each from its last fit.
+    std::vector<Doubles *> ks;
+    std::vector<Doubles *> ws;
+    std::vector<SviSlice *> fits;
+    std::map<double, Expiry>::iterator it;
+    for (it = d_expiries.begin(); it != d_expiries.end(); ++it) {
+        if (it->second.d_dirty) {
+            ks.push_back(&it->second.d_k);
+            ws.push_back(&it->second.d_w);
+            fits.push_back(&it->second.d_fit);
+            it->second.d_dirty = false;
+        }
+    }
+    std::size_t threads = d_config.d_threads > 0
+            ? d_config.d_threads
+            : std::thread::hardware_concurrency();
+    threads = std::max<std::size_t>(std::min(threads, fits.size()), 1);
+    std::atomic<std::size_t> next(0);
+    const Worker worker = { &ks, &ws, &fits, &next, d_config.d_iterations };
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < threads; ++i) {
+        pool.push_back(std::thread(worker));
+    }
+    worker();
+    for (std::size_t i = 0; i < pool.size(); ++i) {
+        pool[i].join();
+    }
+    d_changed = false;
+
+    if (d_expiries.empty()) {
+        std::atomic_store(&d_current, std::shared_ptr<const VolSurface>());
+        return d_current;
+    }
+
+    const std::size_t n = d_expiries.size();
+    Doubles expiries;
+    Doubles forwards;
+    std::vector<SviSlice> slices;
+    std::vector<const Doubles *> allK;
+    std::vector<const Doubles *> allW;
+    for (it = d_expiries.begin(); it != d_expiries.end(); ++it) {
+        expiries.push_back(it->first);
+        forwards.push_back(it->second.d_forward);
+        slices.push_back(it->second.d_fit);
+        allK.push_back(&it->second.d_k);
+        allW.push_back(&it->second.d_w);
+    }
+
+    // The at the money variances of the fits, made non-decreasing, are
+    // those of the SSVI surface, which is only fitted if a slice fails.
+    Doubles thetas(n);
+    for (std::size_t j = 0; j < n; ++j) {
+        thetas[j] = std::max(slices[j].totalVariance(0.0), 1e-8);
+        if (j > 0) {
+            thetas[j] = std::max(thetas[j], thetas[j - 1]);
+        }
+    }
+    bool haveSsvi = false;
+    double rho = 0.0;
+    double eta = 0.0;
+
+    std::vector<char> isSsvi(n, 0);
+    const int points = std::max(d_config.d_checkPoints, 2);
+    for (std::size_t j = 0; j < n; ++j) {
+        const SviSlice *before = j == 0 ? 0 : &slices[j - 1];
+        double lo = allK[j]->front();
+        double hi = allK[j]->back();
+        if (before) {
+            lo = std::min(lo, allK[j - 1]->front());
+            hi = std::max(hi, allK[j - 1]->back());
+        }
+        if (isArbitrageFree(slices[j], before, lo, hi, points)) {
+            continue;
+        }
+
+        if (!haveSsvi) {
+            Doubles x(2, 0.0);
+            Doubles step(2, 0.5);
+            const SsviObjective objective(&allK, &allW, &thetas);
+            minimize(&x, objective, step, d_config.d_iterations);
+            ssviParameters(&rho, &eta, x);
+            haveSsvi = true;
+        }
+
+        // Raise theta by doubling, then bisection, until the slice lies
+        // above the one before.
+        double theta = thetas[j];
+        SviSlice slice = ssviSlice(theta, rho, eta);
+        if (!isArbitrageFree(slice, before, lo, hi, points)) {
+            double low = theta;
+            double high = 2.0 * theta;
+            for (int i = 0; i < 60; ++i) {
+                if (isArbitrageFree(ssviSlice(high, rho, eta),
+                            before,
+                            lo,
+                            hi,
+                            points)) {
+                    break;
+                }
+                low = high;
+                high *= 2.0;
+            }
+            for (int i = 0; i < 40; ++i) {
+                const double mid = 0.5 * (low + high);
+                const SviSlice trial = ssviSlice(mid, rho, eta);
+                if (isArbitrageFree(trial, before, lo, hi, points)) {
+                    high = mid;
+                }
+                else {
+                    low = mid;
+                }
+            }
+            theta = high;
+            slice = ssviSlice(theta, rho, eta);
+        }
+        slices[j] = slice;
+        isSsvi[j] = 1;
+    }
+
+    ++d_version;
+    const std::shared_ptr<const VolSurface> surface(new VolSurface(
+            d_version, d_spot, expiries, forwards, slices, isSsvi));
+    std::atomic_store(&d_current, surface);
+    return surface;
+}
+
+std::shared_ptr<const VolSurface> VolSurfaceBuilder::surface() const
+{
+    return std::atomic_load(&d_current);
+}
+
+} // close namespace pricer
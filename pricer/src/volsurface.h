@@ -0,0 +1,164 @@
+#ifndef _VOLSURFACE_H_
+#define _VOLSURFACE_H_
+
+#include "forwardengine.h"
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace pricer {
+
+// SviSlice is the raw SVI total implied variance of one expiry,
+//     w(k) = a + b (rho (k - m) + sqrt((k - m)^2 + sigma^2)),
+// in the log-moneyness k = ln(K / F) against the forward F of the expiry.
+struct SviSlice {
+    double d_a;
+    double d_b;
+    double d_rho;
+    double d_m;
+    double d_sigma;
+
+    double totalVariance(double k) const;
+
+    // Load the first and second derivatives of `totalVariance` at `k`.
+    void derivatives(double *dw, double *d2w, double k) const;
+};
+
+// VolSurface is an immutable implied volatility surface of one underlying:
+// an SVI slice and a forward per expiry. Between expiries the total
+// variance is linear in time at a fixed log-moneyness, which keeps the
+// surface free of calendar arbitrage where its slices are; before the
+// first expiry and after the last the implied vol of a log-moneyness is
+// flat. Forwards are log-linear in time from the spot.
+//
+// A surface is published by VolSurfaceBuilder and shared by pointer, so
+// any number of threads query it without locking.
+class VolSurface {
+  private:
+    std::size_t d_version;
+    double d_spot;
+    std::vector<double> d_expiries;
+    std::vector<double> d_forwards;
+    std::vector<SviSlice> d_slices;
+    std::vector<char> d_isSsvi;
+
+  public:
+    // Create the surface `version` of `spot` with the slices at increasing
+    // `expiries`, the forward of each and whether the slice was replaced by
+    // its SSVI slice. Throw std::invalid_argument if there are no slices,
+    // the sizes differ, or the expiries are not increasing.
+    VolSurface(std::size_t version,
+            double spot,
+            const std::vector<double>& expiries,
+            const std::vector<double>& forwards,
+            const std::vector<SviSlice>& slices,
+            const std::vector<char>& isSsvi);
+
+    std::size_t version() const { return d_version; }
+    double spot() const { return d_spot; }
+    const std::vector<double>& expiries() const { return d_expiries; }
+    const std::vector<SviSlice>& slices() const { return d_slices; }
+    const std::vector<char>& isSsvi() const { return d_isSsvi; }
+
+    double forward(double expiry) const;
+
+    // Return the total variance at the log-moneyness `k` and `expiry`.
+    double totalVariance(double k, double expiry) const;
+
+    // Return the implied vol at `strike` and `expiry`. Throw
+    // std::invalid_argument if either is not positive.
+    double vol(double strike, double expiry) const;
+};
+
+// VolSurfaceBuilder calibrates a VolSurface from the quoted implied vols of
+// option chains, one chain per expiry.
+//
+// Each expiry is fitted by raw SVI with the quasi-explicit method of
+// Zeliade (2009): for fixed (m, sigma) the remaining parameters are a
+// linear least squares problem under the no-arbitrage bounds on b and rho,
+// and (m, sigma) are found by Nelder-Mead. The fits of the expiries are
+// independent and run across threads. Only expiries whose quotes changed
+// since the last publish are refitted; the others keep their fit. A chain
+// is compared to the last one of its expiry as given, spot, rate,
+// dividends, strikes and vols, so an unchanged chain costs no logarithms
+// and rounding in the forward cannot mark it as changed.
+//
+// The slices are then checked in order of expiry, on the range of the
+// quoted strikes, for butterfly arbitrage and for calendar arbitrage
+// against the slice before. A failing slice is replaced by the SSVI slice
+// (Gatheral and Jacquier, 2014) of its at the money variance, with the
+// power law phi(theta) = eta / (theta^gamma (1 + theta)^(1 - gamma)),
+// gamma = 1/2, and eta (1 + |rho|) <= 2 fitted to all quotes, which is free
+// of butterfly arbitrage. Its at the money variance is raised where needed
+// until it lies above the slice before.
+//
+// `update`, `remove` and `publish` are for one writer thread. `surface`
+// may be called from any thread: the pointer is swapped atomically, so a
+// reader holds its version while a publish replaces it, and queries on a
+// surface take no lock.
+class VolSurfaceBuilder {
+  public:
+    struct Config {
+        int d_threads;       // worker threads, 0 for one per core
+        int d_iterations;    // Nelder-Mead iterations of a fit
+        int d_checkPoints;   // strikes checked for arbitrage per slice
+
+        Config();
+    };
+
+  private:
+    struct Expiry {
+        // The chain as given.
+        double d_spot;
+        double d_rate;
+        std::vector<double> d_dividendTimes;
+        std::vector<double> d_dividendAmounts;
+        std::vector<double> d_strikes;
+        std::vector<double> d_vols;
+
+        // The quotes fitted, in log-moneyness and total variance.
+        double d_forward;
+        std::vector<double> d_k;
+        std::vector<double> d_w;
+        SviSlice d_fit;
+        bool d_dirty;
+
+        Expiry();
+    };
+
+    Config d_config;
+    double d_spot;
+    std::map<double, Expiry> d_expiries;
+    bool d_changed;
+    std::size_t d_version;
+    std::shared_ptr<const VolSurface> d_current;
+
+  public:
+    explicit VolSurfaceBuilder(const Config& config = Config());
+
+    const Config& config() const { return d_config; }
+
+    // Replace the quotes of the expiry of `chain` and return true if they
+    // differ from those of the last update. Throw std::invalid_argument if
+    // the chain has fewer than three strikes, its strikes are not
+    // increasing, a spot, strike, vol or expiry is not positive, or the
+    // spot does not cover the dividends.
+    bool update(const Chain& chain);
+
+    // Drop the quotes of `expiry`, such as one that has expired.
+    void remove(double expiry);
+
+    // Refit the expiries whose quotes changed and publish the next version
+    // of the surface, or keep the current one if nothing changed. Return
+    // the current surface, which is empty before the first quotes.
+    std::shared_ptr<const VolSurface> publish();
+
+    // Return the last published surface.
+    std::shared_ptr<const VolSurface> surface() const;
+};
+
+} // close namespace pricer
+
+#endif
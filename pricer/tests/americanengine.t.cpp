@@ -0,0 +1,314 @@
+#include <americanengine.h>
+#include <analyticengine.h>
+#include <fdengine.h>
+#include <legbatch.h>
+
+#include <referencemodels.h>
+
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+namespace {
+Leg makeLeg(double strike, double vol, double expiry, bool isCall)
+{
+    const Leg leg = { 100.0, strike, vol, 0.05, expiry, isCall, true, 0, 0,
+        0 };
+    return leg;
+}
+
+double priceOf(const AmericanEngine& engine, const Leg& leg)
+{
+    Greeks greeks;
+    double error;
+    EXPECT_TRUE(engine.price(&greeks, &error, leg));
+    return greeks.d_price;
+}
+}
+
+//
+// Concern:
+// Verify every method against a binomial tree without dividends, and that
+// the error estimate covers the actual error.
+//
+// Plan:
+// 1. Price puts across strikes, volatilities and expiries with each method.
+// 2. Compare to a fine Cox-Ross-Rubinstein tree, allowing for its own
+//    error.
+// 3. Expect the fixed point method within a cent of the tree.
+//
+TEST(AmericanEngineTest, MatchesTreeWithoutDividends)
+{
+    typedef AmericanEngine Engine;
+    const Engine::Method methods[] = { Engine::e_BARONE_ADESI_WHALEY,
+        Engine::e_BJERKSUND_STENSLAND,
+        Engine::e_ANDERSEN_LAKE_OFFENGEIM };
+    const double treeError = 2e-3;
+    for (int m = 0; m < 3; ++m) {
+        Engine::Config config;
+        config.d_method = methods[m];
+        const Engine engine(config);
+        for (double strike = 90.0; strike <= 110.0; strike += 10.0) {
+            for (double vol = 0.15; vol < 0.5; vol += 0.2) {
+                for (double expiry = 0.25; expiry < 2.0; expiry *= 4.0) {
+                    const Leg leg = makeLeg(strike, vol, expiry, false);
+                    const double tree = reference::americanTree(
+                            100.0, strike, vol, 0.05, expiry, false, 2000);
+                    Greeks greeks;
+                    double error;
+                    ASSERT_TRUE(engine.price(&greeks, &error, leg));
+                    EXPECT_NEAR(tree, greeks.d_price, error + treeError)
+                            << m << " " << strike << " " << vol << " "
+                            << expiry;
+                    if (methods[m] == Engine::e_ANDERSEN_LAKE_OFFENGEIM) {
+                        EXPECT_NEAR(tree, greeks.d_price, 1e-2);
+                    }
+                }
+            }
+        }
+    }
+}
+
+//
+// Concern:
+// Verify that the closed forms accept only the legs they price within the
+// tolerance, whether their error is estimated from a cheap fixed point
+// solve or from the bound on the early exercise premium.
+//
+// Plan:
+// 1. Price puts across strikes, volatilities, rates and expiries with each
+//    closed form, and expect those accepted within the tolerance of a
+//    fine fixed point solve.
+// 2. Expect a long-dated put deep in the money, that Barone-Adesi-Whaley
+//    underprices, to be refused.
+// 3. Price a put whose premium bound is within the tolerance, and expect
+//    an error estimate no larger than the bound and a price within it of
+//    the fine solve.
+//
+TEST(AmericanEngineTest, ClosedFormsEstimateTheirError)
+{
+    typedef AmericanEngine Engine;
+    Engine::Config fineConfig;
+    fineConfig.d_collocationNodes = 16;
+    fineConfig.d_iterations = 8;
+    fineConfig.d_quadraturePoints = 24;
+    const Engine fine(fineConfig);
+    const Engine::Method methods[] = { Engine::e_BARONE_ADESI_WHALEY,
+        Engine::e_BJERKSUND_STENSLAND };
+    for (int m = 0; m < 2; ++m) {
+        Engine::Config config;
+        config.d_method = methods[m];
+        const Engine engine(config);
+        for (double strike = 80.0; strike <= 120.0; strike += 10.0) {
+            for (double vol = 0.1; vol < 0.7; vol += 0.2) {
+                for (double expiry = 0.05; expiry < 3.0; expiry *= 3.0) {
+                    for (double rate = 0.0; rate < 0.11; rate += 0.05) {
+                        Leg leg = makeLeg(strike, vol, expiry, false);
+                        leg.d_rate = rate;
+                        Greeks greeks;
+                        if (!engine.accept(&greeks, leg)) {
+                            continue;
+                        }
+                        EXPECT_NEAR(priceOf(fine, leg),
+                                greeks.d_price,
+                                config.d_tolerance)
+                                << m << " " << strike << " " << vol << " "
+                                << expiry << " " << rate;
+                    }
+                }
+            }
+        }
+    }
+
+    Engine::Config config;
+    config.d_method = Engine::e_BARONE_ADESI_WHALEY;
+    const Engine engine(config);
+    Greeks greeks;
+    EXPECT_FALSE(engine.accept(&greeks, makeLeg(130.0, 0.4, 0.78, false)));
+
+    Leg leg = makeLeg(100.0, 0.3, 0.02, false);
+    leg.d_rate = 1e-3;
+    const double bound = -leg.d_strike * std::expm1(-leg.d_rate * 0.02);
+    ASSERT_LT(bound, config.d_tolerance);
+    double error;
+    ASSERT_TRUE(engine.price(&greeks, &error, leg));
+    EXPECT_LE(error, bound + 1e-12);
+    EXPECT_NEAR(priceOf(fine, leg), greeks.d_price, bound);
+}
+
+//
+// Concern:
+// Verify that a call without dividends is priced as European.
+//
+TEST(AmericanEngineTest, CallWithoutDividendsIsEuropean)
+{
+    const Leg leg = makeLeg(95.0, 0.3, 1.0, true);
+    Greeks greeks;
+    double error;
+    ASSERT_TRUE(AmericanEngine().price(&greeks, &error, leg));
+    EXPECT_NEAR(reference::blackScholes(100.0, 95.0, 0.3, 0.05, 1.0, true),
+            greeks.d_price,
+            1e-10);
+    EXPECT_LT(error, 1e-6);
+}
+
+//
+// Concern:
+// Verify the greeks against bumped prices of the engine itself.
+//
+TEST(AmericanEngineTest, GreeksMatchFiniteDifferences)
+{
+    const AmericanEngine engine;
+    const Leg leg = makeLeg(105.0, 0.3, 0.75, false);
+    Greeks greeks;
+    double error;
+    ASSERT_TRUE(engine.price(&greeks, &error, leg));
+
+    const double hs = 0.5;
+    Leg up = leg;
+    Leg down = leg;
+    up.d_spot += hs;
+    down.d_spot -= hs;
+    const double priceUp = priceOf(engine, up);
+    const double priceDown = priceOf(engine, down);
+    EXPECT_NEAR((priceUp - priceDown) / (2 * hs), greeks.d_delta, 1e-3);
+    EXPECT_NEAR((priceUp - 2 * greeks.d_price + priceDown) / (hs * hs),
+            greeks.d_gamma,
+            1e-3);
+
+    const double h = 1e-3;
+    up = leg;
+    down = leg;
+    up.d_vol += h;
+    down.d_vol -= h;
+    EXPECT_NEAR((priceOf(engine, up) - priceOf(engine, down)) / (2 * h),
+            greeks.d_vega,
+            0.1);
+
+    up = leg;
+    down = leg;
+    up.d_rate += h;
+    down.d_rate -= h;
+    EXPECT_NEAR((priceOf(engine, up) - priceOf(engine, down)) / (2 * h),
+            greeks.d_rho,
+            0.1);
+
+    up = leg;
+    down = leg;
+    up.d_expiry -= h;
+    down.d_expiry += h;
+    EXPECT_NEAR((priceOf(engine, up) - priceOf(engine, down)) / (2 * h),
+            greeks.d_theta,
+            0.1);
+}
+
+//
+// Concern:
+// Verify that with discrete dividends the estimate still covers the error,
+// so that the legs it cannot price fall back to the finite difference
+// solve.
+//
+// Plan:
+// 1. Price puts and calls with small and large dividends.
+// 2. Compare to a fine finite difference solve.
+// 3. Expect a call whose dividends never pay for early exercise to be
+//    priced as the escrowed European, and one whose dividends do to be
+//    refused.
+//
+TEST(AmericanEngineTest, DiscreteDividends)
+{
+    FdEngine::Config fdConfig;
+    fdConfig.d_timeSteps = 800;
+    fdConfig.d_spaceSteps = 801;
+    const FdEngine fd(fdConfig);
+    const AmericanEngine engine;
+
+    const double times[] = { 0.3, 0.8 };
+    const double small[] = { 0.5, 0.5 };
+    const double large[] = { 2.0, 2.0 };
+    const double *const amounts[] = { small, large };
+    for (int a = 0; a < 2; ++a) {
+        for (int isCall = 0; isCall < 2; ++isCall) {
+            for (double strike = 80.0; strike <= 120.0; strike += 20.0) {
+                Leg leg = makeLeg(strike, 0.25, 1.0, isCall != 0);
+                leg.d_dividendTimes = times;
+                leg.d_dividendAmounts = amounts[a];
+                leg.d_numDividends = 2;
+
+                Greeks greeks;
+                double error;
+                ASSERT_TRUE(engine.price(&greeks, &error, leg));
+                EXPECT_NEAR(fd.price(leg).d_price,
+                        greeks.d_price,
+                        error + 5e-3)
+                        << a << " " << isCall << " " << strike;
+            }
+        }
+    }
+
+    Leg leg = makeLeg(100.0, 0.25, 1.0, true);
+    leg.d_dividendTimes = times;
+    leg.d_dividendAmounts = small;
+    leg.d_numDividends = 2;
+    Greeks greeks;
+    Greeks european;
+    EXPECT_TRUE(engine.accept(&greeks, leg));
+    EXPECT_TRUE(AnalyticEngine().price(&european, leg));
+    EXPECT_NEAR(european.d_price, greeks.d_price, 1e-12);
+
+    leg.d_strike = 80.0;
+    leg.d_dividendAmounts = large;
+    EXPECT_FALSE(engine.accept(&greeks, leg));
+}
+
+//
+// Concern:
+// Verify that dividends paid before the valuation date do not move the
+// price or the greeks, and that one paid within the theta bump does not
+// make theta blow up.
+//
+// Plan:
+// 1. Price a put with a dividend with an ex-date in the past, one on the
+//    valuation date and one after expiry, and expect the price and greeks
+//    of the same put without dividends.
+// 2. Price a put with a dividend a fraction of the theta bump away, and
+//    expect its theta close to that of a put with the dividend a day
+//    away.
+//
+TEST(AmericanEngineTest, IgnoresPastDividends)
+{
+    const AmericanEngine engine;
+    Leg leg = makeLeg(105.0, 0.3, 0.25, false);
+    Greeks plain;
+    double error;
+    ASSERT_TRUE(engine.price(&plain, &error, leg));
+
+    const double times[] = { -0.1, -5e-5, 0.0, 0.5 };
+    const double amounts[] = { 1.5, 1.5, 1.5, 1.5 };
+    leg.d_dividendTimes = times;
+    leg.d_dividendAmounts = amounts;
+    leg.d_numDividends = 4;
+    Greeks greeks;
+    ASSERT_TRUE(engine.price(&greeks, &error, leg));
+    EXPECT_NEAR(plain.d_price, greeks.d_price, 1e-12);
+    EXPECT_NEAR(plain.d_delta, greeks.d_delta, 1e-9);
+    EXPECT_NEAR(plain.d_vega, greeks.d_vega, 1e-9);
+    EXPECT_NEAR(plain.d_theta, greeks.d_theta, 1e-9);
+
+    const double soon[] = { 2e-5 };
+    const double dayAway[] = { 1.0 / 365.0 };
+    leg.d_dividendAmounts = amounts;
+    leg.d_numDividends = 1;
+    leg.d_dividendTimes = soon;
+    Greeks imminent;
+    ASSERT_TRUE(engine.price(&imminent, &error, leg));
+    leg.d_dividendTimes = dayAway;
+    Greeks nextDay;
+    ASSERT_TRUE(engine.price(&nextDay, &error, leg));
+    EXPECT_TRUE(std::isfinite(imminent.d_theta));
+    EXPECT_NEAR(nextDay.d_theta,
+            imminent.d_theta,
+            0.1 * std::fabs(nextDay.d_theta));
+}
@@ -0,0 +1,113 @@
+#include <analyticengine.h>
+#include <legbatch.h>
+
+#include <referencemodels.h>
+
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+namespace {
+const double k_times[] = { 0.2, 0.45 };
+const double k_amounts[] = { 1.0, 1.5 };
+
+LegBatch makeLegs(double spot, double vol, double rate, double shift)
+{
+    // `shift` moves the valuation date forward, for theta.
+    std::vector<double> times;
+    times.push_back(k_times[0] - shift);
+    times.push_back(k_times[1] - shift);
+    std::vector<double> amounts(k_amounts, k_amounts + 2);
+
+    LegBatch legs;
+    legs.addLeg(spot, 100.0, vol, rate, 0.75 - shift, true, false);
+    legs.addLeg(spot, 95.0, vol, rate, 0.75 - shift, false, false);
+    legs.addLeg(spot, 100.0, vol, rate, 0.75 - shift, true, false, times,
+            amounts);
+    legs.addLeg(spot, 95.0, vol, rate, 0.75 - shift, false, false, times,
+            amounts);
+    return legs;
+}
+
+double priceOf(const LegBatch& legs, std::size_t i)
+{
+    Greeks greeks;
+    AnalyticEngine().price(&greeks, legs.leg(i));
+    return greeks.d_price;
+}
+}
+
+//
+// Concern:
+// Verify that the closed form matches Black-Scholes without dividends.
+//
+TEST(AnalyticEngineTest, MatchesBlackScholes)
+{
+    const LegBatch legs = makeLegs(100.0, 0.2, 0.03, 0.0);
+    EXPECT_NEAR(reference::blackScholes(100.0, 100.0, 0.2, 0.03, 0.75, true),
+            priceOf(legs, 0),
+            1e-12);
+    EXPECT_NEAR(reference::blackScholes(100.0, 95.0, 0.2, 0.03, 0.75, false),
+            priceOf(legs, 1),
+            1e-12);
+}
+
+//
+// Concern:
+// Verify every closed-form greek, with and without escrowed dividends.
+//
+// Plan:
+// Compare each greek to a central difference of the closed-form price in
+// spot, volatility, rate and valuation date.
+//
+TEST(AnalyticEngineTest, GreeksMatchFiniteDifferences)
+{
+    const double h = 1e-4;
+    const LegBatch base = makeLegs(100.0, 0.2, 0.03, 0.0);
+    const LegBatch spotUp = makeLegs(100.0 + h, 0.2, 0.03, 0.0);
+    const LegBatch spotDown = makeLegs(100.0 - h, 0.2, 0.03, 0.0);
+    const LegBatch volUp = makeLegs(100.0, 0.2 + h, 0.03, 0.0);
+    const LegBatch volDown = makeLegs(100.0, 0.2 - h, 0.03, 0.0);
+    const LegBatch rateUp = makeLegs(100.0, 0.2, 0.03 + h, 0.0);
+    const LegBatch rateDown = makeLegs(100.0, 0.2, 0.03 - h, 0.0);
+    const LegBatch later = makeLegs(100.0, 0.2, 0.03, h);
+    const LegBatch earlier = makeLegs(100.0, 0.2, 0.03, -h);
+
+    for (std::size_t i = 0; i < base.size(); ++i) {
+        Greeks greeks;
+        ASSERT_TRUE(AnalyticEngine().price(&greeks, base.leg(i)));
+
+        const double up = priceOf(spotUp, i);
+        const double down = priceOf(spotDown, i);
+        EXPECT_NEAR((up - down) / (2 * h), greeks.d_delta, 1e-6);
+        EXPECT_NEAR((up - 2 * greeks.d_price + down) / (h * h),
+                greeks.d_gamma,
+                1e-4);
+        EXPECT_NEAR((priceOf(volUp, i) - priceOf(volDown, i)) / (2 * h),
+                greeks.d_vega,
+                1e-5);
+        EXPECT_NEAR((priceOf(rateUp, i) - priceOf(rateDown, i)) / (2 * h),
+                greeks.d_rho,
+                1e-5);
+        EXPECT_NEAR((priceOf(later, i) - priceOf(earlier, i)) / (2 * h),
+                greeks.d_theta,
+                1e-5);
+    }
+}
+
+//
+// Concern:
+// Verify that legs whose dividends exceed the spot are refused.
+//
+TEST(AnalyticEngineTest, RefusesDividendsAboveSpot)
+{
+    std::vector<double> times(1, 0.1);
+    std::vector<double> amounts(1, 150.0);
+    LegBatch legs;
+    legs.addLeg(100.0, 100.0, 0.2, 0.03, 0.5, true, false, times, amounts);
+
+    Greeks greeks;
+    EXPECT_FALSE(AnalyticEngine().price(&greeks, legs.leg(0)));
+}
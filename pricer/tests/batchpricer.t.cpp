@@ -0,0 +1,141 @@
+#include <batchpricer.h>
+#include <fdengine.h>
+#include <legbatch.h>
+
+#include <referencemodels.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+//
+// Concern:
+// Verify that a multi-leg batch returns one result per leg, in order, with
+// vega close to the Black-Scholes vega.
+//
+// Plan:
+// 1. Build a European butterfly of calls without dividends.
+// 2. Price the batch.
+// 3. Compare price and vega of every leg to the closed form.
+//
+TEST(BatchPricerTest, PricesEveryLegInOrder)
+{
+    LegBatch legs;
+    const double strikes[] = { 90.0, 100.0, 110.0 };
+    for (int i = 0; i < 3; ++i) {
+        legs.addLeg(100.0, strikes[i], 0.25, 0.03, 0.5, true, false);
+    }
+
+    PricingResults results;
+    BatchPricer pricer;
+    pricer.price(&results, legs);
+
+    ASSERT_EQ(3u, results.d_price.size());
+    for (int i = 0; i < 3; ++i) {
+        const double expected = reference::blackScholes(
+                100.0, strikes[i], 0.25, 0.03, 0.5, true);
+        const double h = 1e-4;
+        const double expectedVega
+                = (reference::blackScholes(
+                           100.0, strikes[i], 0.25 + h, 0.03, 0.5, true)
+                          - reference::blackScholes(100.0,
+                                  strikes[i],
+                                  0.25 - h,
+                                  0.03,
+                                  0.5,
+                                  true))
+                / (2 * h);
+        EXPECT_NEAR(expected, results.d_price[i], 1e-2);
+        EXPECT_NEAR(expectedVega, results.d_vega[i], 0.02 * expectedVega);
+    }
+    EXPECT_GT(results.d_price[0], results.d_price[1]);
+    EXPECT_GT(results.d_price[1], results.d_price[2]);
+}
+
+//
+// Concern:
+// Verify that invalid legs are rejected.
+//
+TEST(BatchPricerTest, RejectsInvalidLegs)
+{
+    LegBatch legs;
+    legs.addLeg(100.0, 100.0, 0.0, 0.03, 0.5, true, false);
+
+    PricingResults results;
+    BatchPricer pricer;
+    EXPECT_THROW(pricer.price(&results, legs), std::invalid_argument);
+
+    std::vector<double> times(2, 0.1);
+    std::vector<double> amounts(1, 1.0);
+    EXPECT_THROW(legs.addLeg(100.0, 100.0, 0.2, 0.03, 0.5, true, false,
+                         times, amounts),
+            std::invalid_argument);
+}
+
+//
+// Concern:
+// Verify that American legs take the approximation within tolerance, and
+// the finite difference solve otherwise.
+//
+// Plan:
+// 1. Price an American put with the default tolerance and with none.
+// 2. Expect the first close to, and the second equal to, the finite
+//    difference price.
+//
+TEST(BatchPricerTest, AmericanLegsFallBackToFiniteDifferences)
+{
+    LegBatch legs;
+    legs.addLeg(100.0, 105.0, 0.3, 0.05, 0.75, false, true);
+    const Greeks fd = FdEngine().price(legs.leg(0));
+
+    PricingResults results;
+    BatchPricer().price(&results, legs);
+    EXPECT_NE(fd.d_price, results.d_price[0]);
+    EXPECT_NEAR(fd.d_price, results.d_price[0], 1e-2);
+
+    AmericanEngine::Config config;
+    config.d_tolerance = 0.0;
+    BatchPricer(FdEngine::Config(), config).price(&results, legs);
+    EXPECT_EQ(fd.d_price, results.d_price[0]);
+    EXPECT_EQ(fd.d_vega, results.d_vega[0]);
+}
+
+//
+// Concern:
+// Verify that pricing into caller owned arrays gives the same results as
+// PricingResults and writes nothing past the batch.
+//
+// Plan:
+// 1. Price a European and an American leg into PricingResults.
+// 2. Price them again into one strided block of arrays with a guard entry
+//    after each, and compare.
+//
+TEST(BatchPricerTest, PricesIntoCallerArrays)
+{
+    LegBatch legs;
+    legs.addLeg(100.0, 95.0, 0.25, 0.03, 0.5, true, false);
+    legs.addLeg(100.0, 105.0, 0.3, 0.05, 0.75, false, true);
+    PricingResults results;
+    BatchPricer pricer;
+    pricer.price(&results, legs);
+
+    std::vector<double> block(18, -1.0);
+    const PricingOutputs outputs = { &block[0], &block[3], &block[6],
+        &block[9], &block[12], &block[15] };
+    pricer.price(outputs, legs);
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        EXPECT_EQ(results.d_price[i], outputs.d_price[i]);
+        EXPECT_EQ(results.d_delta[i], outputs.d_delta[i]);
+        EXPECT_EQ(results.d_gamma[i], outputs.d_gamma[i]);
+        EXPECT_EQ(results.d_vega[i], outputs.d_vega[i]);
+        EXPECT_EQ(results.d_theta[i], outputs.d_theta[i]);
+        EXPECT_EQ(results.d_rho[i], outputs.d_rho[i]);
+    }
+    for (std::size_t j = 2; j < block.size(); j += 3) {
+        EXPECT_EQ(-1.0, block[j]);
+    }
+}
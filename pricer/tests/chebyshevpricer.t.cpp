@@ -0,0 +1,271 @@
+#include <batchpricer.h>
+#include <chebyshevpricer.h>
+#include <fdengine.h>
+#include <legbatch.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+namespace {
+// An American put with a dividend half way to expiry.
+LegBatch americanPut()
+{
+    LegBatch legs;
+    legs.addLeg(100.0,
+            100.0,
+            0.3,
+            0.05,
+            0.5,
+            false,
+            true,
+            std::vector<double>(1, 0.25),
+            std::vector<double>(1, 2.0));
+    return legs;
+}
+
+// An at the money American put expiring in `expiry` years.
+Leg shortPut(double expiry)
+{
+    const Leg leg = { 100.0, 100.0, 0.3, 0.05, expiry, false, true, 0, 0,
+        0 };
+    return leg;
+}
+
+// Return the price of `leg` from BatchPricer.
+double batchPrice(const Leg& leg)
+{
+    LegBatch legs;
+    legs.addLeg(leg.d_spot,
+            leg.d_strike,
+            leg.d_vol,
+            leg.d_rate,
+            leg.d_expiry,
+            leg.d_isCall,
+            leg.d_isAmerican,
+            std::vector<double>(leg.d_dividendTimes,
+                    leg.d_dividendTimes + leg.d_numDividends),
+            std::vector<double>(leg.d_dividendAmounts,
+                    leg.d_dividendAmounts + leg.d_numDividends));
+    PricingResults results;
+    BatchPricer().price(&results, legs);
+    return results.d_price[0];
+}
+}
+
+//
+// Concern:
+// Verify that the interpolant reproduces the finite difference price and
+// greeks of an American put with a dividend between the nodes.
+//
+// Plan:
+// 1. Build the surface of the put on spots 80 to 120 and vols 20% to 40%.
+// 2. Compare it to direct solves on a grid of points off the nodes.
+//
+TEST(ChebyshevPricerTest, SurfaceMatchesSolves)
+{
+    const LegBatch legs = americanPut();
+    const ChebyshevDomain domain = { 80.0, 120.0, 0.2, 0.4, 12, 6 };
+    const FdEngine engine;
+    const ChebyshevSurface surface(legs.leg(0), domain, engine);
+
+    for (double spot = 81.3; spot < 120.0; spot += 3.7) {
+        for (double vol = 0.207; vol < 0.4; vol += 0.031) {
+            Leg leg = legs.leg(0);
+            leg.d_spot = spot;
+            leg.d_vol = vol;
+            EXPECT_TRUE(surface.covers(leg));
+            const Greeks fd = engine.price(leg);
+            const Greeks value = surface.value(spot, vol);
+            EXPECT_NEAR(fd.d_price, value.d_price, 1e-3) << spot << " " << vol;
+            EXPECT_NEAR(fd.d_delta, value.d_delta, 1e-4);
+            EXPECT_NEAR(fd.d_gamma, value.d_gamma, 1e-4);
+            EXPECT_NEAR(fd.d_vega, value.d_vega, 0.1);
+            EXPECT_NEAR(fd.d_theta, value.d_theta, 1e-2);
+            EXPECT_NEAR(fd.d_rho, value.d_rho, 0.1);
+        }
+    }
+    EXPECT_LT(surface.error(), 1e-3);
+
+    Leg leg = legs.leg(0);
+    leg.d_spot = 121.0;
+    EXPECT_FALSE(surface.covers(leg));
+    leg.d_spot = 100.0;
+    leg.d_rate = 0.04;
+    EXPECT_FALSE(surface.covers(leg));
+}
+
+//
+// Concern:
+// Verify that a leg no surface covers is solved directly and its surface
+// built in the background, and that a move of the spot outside the domain
+// or a new rate leads to a rebuild.
+//
+// Plan:
+// 1. Price the put, expect a direct solve, wait, and expect the next price
+//    at a nearby spot to come from the surface.
+// 2. Move the spot by 30%, then the rate, and expect a direct solve each
+//    time, followed by a surface again.
+// 3. Expect European legs to take the closed form, and `clear` to drop the
+//    surfaces.
+//
+TEST(ChebyshevPricerTest, RebuildsInBackground)
+{
+    LegBatch legs = americanPut();
+    legs.addLeg(100.0, 110.0, 0.25, 0.05, 0.5, true, false);
+    ChebyshevPricer pricer;
+    const FdEngine engine;
+
+    std::vector<double> block(12);
+    const PricingOutputs outputs = { &block[0], &block[2], &block[4],
+        &block[6], &block[8], &block[10] };
+    EXPECT_EQ(1u, pricer.price(outputs, legs));
+    EXPECT_EQ(batchPrice(legs.leg(0)), outputs.d_price[0]);
+    pricer.wait();
+
+    legs.d_spot[0] = 104.0;
+    legs.d_spot[1] = 104.0;
+    EXPECT_EQ(0u, pricer.price(outputs, legs));
+    EXPECT_NEAR(engine.price(legs.leg(0)).d_price, outputs.d_price[0], 1e-3);
+
+    legs.d_spot[0] = 130.0;
+    Greeks greeks;
+    EXPECT_FALSE(pricer.price(&greeks, legs.leg(0)));
+    pricer.wait();
+    EXPECT_TRUE(pricer.price(&greeks, legs.leg(0)));
+
+    legs.d_rate[0] = 0.04;
+    EXPECT_FALSE(pricer.price(&greeks, legs.leg(0)));
+    pricer.wait();
+    EXPECT_TRUE(pricer.price(&greeks, legs.leg(0)));
+    EXPECT_NEAR(engine.price(legs.leg(0)).d_price, greeks.d_price, 1e-3);
+
+    EXPECT_TRUE(pricer.price(&greeks, legs.leg(1)));
+    pricer.clear();
+    EXPECT_FALSE(pricer.price(&greeks, legs.leg(0)));
+}
+
+//
+// Concern:
+// Verify that `prepare` builds the surfaces of the legs at once.
+//
+TEST(ChebyshevPricerTest, PrepareBuildsSurfaces)
+{
+    const LegBatch legs = americanPut();
+    ChebyshevPricer pricer;
+    pricer.prepare(legs);
+    Greeks greeks;
+    EXPECT_TRUE(pricer.price(&greeks, legs.leg(0)));
+    EXPECT_NEAR(FdEngine().price(legs.leg(0)).d_price, greeks.d_price, 1e-3);
+}
+
+//
+// Concern:
+// Verify that the spot domain narrows with sigma sqrt(T), so the surfaces
+// of legs a week and a few weeks from expiry match the solves as closely
+// as those of longer legs.
+//
+// Plan:
+// 1. Prepare the surfaces of at the money puts expiring in one week and in
+//    0.05 years, and expect each domain within 10% of the spot.
+// 2. Compare the surfaces to direct solves at spots and vols across the
+//    domain, and expect the prices to come from the surfaces.
+//
+TEST(ChebyshevPricerTest, ShortDatedLegs)
+{
+    const double expiries[] = { 7.0 / 365.0, 0.05 };
+    for (int e = 0; e < 2; ++e) {
+        const Leg put = shortPut(expiries[e]);
+        LegBatch legs;
+        legs.addLeg(put.d_spot,
+                put.d_strike,
+                put.d_vol,
+                put.d_rate,
+                put.d_expiry,
+                put.d_isCall,
+                put.d_isAmerican);
+        ChebyshevPricer pricer;
+        pricer.prepare(legs);
+        const FdEngine engine;
+        const double width = pricer.config().d_spotWidth * put.d_vol
+                * std::sqrt(put.d_expiry);
+        EXPECT_LT(width, 0.1);
+
+        for (double u = -0.95; u < 1.0; u += 0.13) {
+            for (double vol = 0.25; vol < 0.36; vol += 0.027) {
+                Leg leg = put;
+                leg.d_spot = 100.0 * std::exp(u * width);
+                leg.d_vol = vol;
+                Greeks greeks;
+                EXPECT_TRUE(pricer.price(&greeks, leg)) << e << " " << u;
+                const Greeks fd = engine.price(leg);
+                EXPECT_NEAR(fd.d_price, greeks.d_price, 1e-3)
+                        << e << " " << u << " " << vol;
+                EXPECT_NEAR(fd.d_delta, greeks.d_delta, 2e-3);
+            }
+        }
+    }
+}
+
+//
+// Concern:
+// Verify that a surface whose check points miss the solves is not used,
+// and that the legs it covers are priced as BatchPricer prices them
+// without rebuilding the surface.
+//
+// Plan:
+// 1. Prepare the surface of a put over six standard deviations with three
+//    spot nodes, and expect its error above the tolerance.
+// 2. Expect the price of the put to be solved directly and to equal that
+//    of BatchPricer, and no build to be queued.
+//
+TEST(ChebyshevPricerTest, InaccurateSurfaceFallsBack)
+{
+    ChebyshevPricer::Config config;
+    config.d_spotWidth = 6.0;
+    config.d_spotNodes = 3;
+    ChebyshevPricer pricer(config);
+    const LegBatch legs = americanPut();
+    pricer.prepare(legs);
+
+    Leg leg = legs.leg(0);
+    leg.d_spot = 97.0;
+    Greeks greeks;
+    EXPECT_FALSE(pricer.price(&greeks, leg));
+    EXPECT_EQ(batchPrice(leg), greeks.d_price);
+    pricer.wait();
+    EXPECT_FALSE(pricer.price(&greeks, leg));
+}
+
+//
+// Concern:
+// Verify that invalid domains and configurations are rejected.
+//
+TEST(ChebyshevPricerTest, InvalidInputThrows)
+{
+    const LegBatch legs = americanPut();
+    const FdEngine engine;
+    const ChebyshevDomain empty = { 80.0, 80.0, 0.2, 0.4, 12, 6 };
+    EXPECT_THROW(ChebyshevSurface(legs.leg(0), empty, engine),
+            std::invalid_argument);
+    const ChebyshevDomain coarse = { 80.0, 120.0, 0.2, 0.4, 12, 1 };
+    EXPECT_THROW(ChebyshevSurface(legs.leg(0), coarse, engine),
+            std::invalid_argument);
+
+    ChebyshevPricer::Config config;
+    config.d_spotWidth = 0.0;
+    EXPECT_THROW(ChebyshevPricer pricer(config), std::invalid_argument);
+    config = ChebyshevPricer::Config();
+    config.d_volWidth = 1.0;
+    EXPECT_THROW(ChebyshevPricer pricer(config), std::invalid_argument);
+    config = ChebyshevPricer::Config();
+    config.d_tolerance = -1.0;
+    EXPECT_THROW(ChebyshevPricer pricer(config), std::invalid_argument);
+    config = ChebyshevPricer::Config();
+    config.d_volNodes = ChebyshevSurface::k_MAX_NODES + 1;
+    EXPECT_THROW(ChebyshevPricer pricer(config), std::invalid_argument);
+}
@@ -0,0 +1,236 @@
+#include <discountcurve.h>
+#include <legbatch.h>
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+namespace {
+// The tenors of the EUR ESTR swaps, in days, with an upward sloping curve
+// of par rates.
+void estrQuotes(std::vector<int> *days, std::vector<double> *rates)
+{
+    const int tenors[] = { 7, 14, 30, 60, 90, 180, 270, 360, 540, 720,
+        1080 };
+    const double quotes[] = { 0.0300, 0.0301, 0.0303, 0.0306, 0.0310,
+        0.0318, 0.0322, 0.0325, 0.0321, 0.0315, 0.0305 };
+    days->assign(tenors, tenors + 11);
+    rates->assign(quotes, quotes + 11);
+}
+
+// Return the par rate of the swap maturing after `maturity` days on
+// `curve`, with annual coupons back from maturity.
+double parRate(const DiscountCurve& curve, int maturity, double basis)
+{
+    double annuity = 0.0;
+    int end = maturity;
+    while (end > 0) {
+        const int start = std::max(end - 365, 0);
+        annuity += (end - start) / basis * curve.discount(end / 365.0);
+        end = start;
+    }
+    return (1.0 - curve.discount(maturity / 365.0)) / annuity;
+}
+}
+
+//
+// Concern:
+// Verify that the bootstrapped curve reprices every swap it was built
+// from, short single payment swaps and annual coupon swaps alike.
+//
+// Plan:
+// 1. Bootstrap the ESTR tenors.
+// 2. Compare the par rate of each swap on the curve to its quote.
+//
+TEST(DiscountCurveTest, RepricesInstruments)
+{
+    std::vector<int> days;
+    std::vector<double> rates;
+    estrQuotes(&days, &rates);
+    CurveBuilder builder;
+    EXPECT_FALSE(builder.curve());
+    builder.setQuotes(days, rates);
+    const std::shared_ptr<const DiscountCurve> curve = builder.publish();
+    ASSERT_TRUE(curve);
+    EXPECT_EQ(curve, builder.curve());
+
+    for (std::size_t i = 0; i < days.size(); ++i) {
+        EXPECT_NEAR(rates[i], parRate(*curve, days[i], 360.0), 1e-12)
+                << days[i];
+    }
+    EXPECT_NEAR(1.0 / (1.0 + 0.0310 * 90 / 360.0),
+            curve->discount(90 / 365.0),
+            1e-15);
+}
+
+//
+// Concern:
+// Verify the monotone convex interpolant: the forward is continuous across
+// the nodes, the discount factor is its integral, and the cached whole
+// days agree with the interpolant between them.
+//
+// Plan:
+// 1. Compare the forward either side of every node.
+// 2. Compare the instantaneous forward to a central difference of the log
+//    discount factor inside the intervals.
+// 3. Compare the discount at a whole day to a time a hair beyond it, which
+//    misses the cache.
+//
+TEST(DiscountCurveTest, ForwardsAreContinuous)
+{
+    std::vector<int> days;
+    std::vector<double> rates;
+    estrQuotes(&days, &rates);
+    CurveBuilder builder;
+    builder.setQuotes(days, rates);
+    const std::shared_ptr<const DiscountCurve> curve = builder.publish();
+
+    for (std::size_t i = 0; i + 1 < days.size(); ++i) {
+        const double t = days[i] / 365.0;
+        EXPECT_NEAR(curve->instantaneousForward(t - 1e-9),
+                curve->instantaneousForward(t + 1e-9),
+                1e-6)
+                << days[i];
+    }
+    for (double t = 0.01; t < 3.5; t += 0.0537) {
+        const double h = 1e-5;
+        const double difference
+                = std::log(curve->discount(t - h) / curve->discount(t + h))
+                / (2 * h);
+        EXPECT_NEAR(difference, curve->instantaneousForward(t), 1e-7) << t;
+        EXPECT_NEAR(curve->forwardRate(t - h, t + h), difference, 1e-12);
+    }
+    for (int day = 0; day <= 1100; day += 37) {
+        const double t = day / 365.0;
+        EXPECT_NEAR(curve->discount(t + 1e-11), curve->discount(t), 1e-12)
+                << day;
+        if (day > 0) {
+            EXPECT_NEAR(-std::log(curve->discount(t)) / t,
+                    curve->zeroRate(t),
+                    1e-15);
+        }
+    }
+}
+
+//
+// Concern:
+// Verify that one ticking quote is re-bootstrapped incrementally and gives
+// the same curve as a full bootstrap.
+//
+// Plan:
+// 1. Publish a curve, move the two year quote and publish again.
+// 2. Expect the nodes before it unchanged, and every discount factor equal
+//    to that of a builder given all quotes at once.
+// 3. Expect publishing with no change to return the same curve.
+//
+TEST(DiscountCurveTest, TickRebootstrapsIncrementally)
+{
+    std::vector<int> days;
+    std::vector<double> rates;
+    estrQuotes(&days, &rates);
+    CurveBuilder builder;
+    builder.setQuotes(days, rates);
+    const std::shared_ptr<const DiscountCurve> first = builder.publish();
+    builder.updateQuote(9, 0.0330);
+    const std::shared_ptr<const DiscountCurve> second = builder.publish();
+    EXPECT_NE(first, second);
+    EXPECT_EQ(second, builder.publish());
+
+    rates[9] = 0.0330;
+    CurveBuilder full;
+    full.setQuotes(days, rates);
+    const std::shared_ptr<const DiscountCurve> expected = full.publish();
+    for (std::size_t i = 0; i < days.size(); ++i) {
+        const double t = days[i] / 365.0;
+        if (i < 9) {
+            EXPECT_EQ(first->discount(t), second->discount(t)) << days[i];
+        }
+        EXPECT_EQ(expected->discount(t), second->discount(t)) << days[i];
+    }
+    for (int day = 0; day <= 1100; day += 11) {
+        EXPECT_EQ(expected->discount(day / 365.0),
+                second->discount(day / 365.0))
+                << day;
+    }
+}
+
+//
+// Concern:
+// Verify that swaps whose coupons fall between nodes are solved against
+// the final interpolant.
+//
+// Plan:
+// Bootstrap a curve of three and five year swaps only, whose earlier
+// coupons have no node, and compare their par rates to the quotes.
+//
+TEST(DiscountCurveTest, CouponsBetweenNodes)
+{
+    std::vector<int> days;
+    std::vector<double> rates;
+    days.push_back(90);
+    days.push_back(1095);
+    days.push_back(1825);
+    rates.push_back(0.02);
+    rates.push_back(0.025);
+    rates.push_back(0.03);
+    CurveBuilder::Config config;
+    config.d_dayBasis = 365.0;
+    CurveBuilder builder(config);
+    builder.setQuotes(days, rates);
+    const std::shared_ptr<const DiscountCurve> curve = builder.publish();
+    for (std::size_t i = 0; i < days.size(); ++i) {
+        EXPECT_NEAR(rates[i], parRate(*curve, days[i], 365.0), 1e-12)
+                << days[i];
+    }
+}
+
+//
+// Concern:
+// Verify that legs take the zero rate of the curve to their expiry.
+//
+TEST(DiscountCurveTest, AppliesToLegs)
+{
+    std::vector<int> days;
+    std::vector<double> rates;
+    estrQuotes(&days, &rates);
+    CurveBuilder builder;
+    builder.setQuotes(days, rates);
+    const std::shared_ptr<const DiscountCurve> curve = builder.publish();
+
+    LegBatch legs;
+    legs.addLeg(100.0, 100.0, 0.2, 0.0, 180 / 365.0, true, false);
+    legs.addLeg(100.0, 100.0, 0.2, 0.0, 2.5, false, true);
+    applyCurve(&legs, *curve);
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        EXPECT_NEAR(curve->discount(legs.d_expiry[i]),
+                std::exp(-legs.d_rate[i] * legs.d_expiry[i]),
+                1e-15);
+    }
+}
+
+//
+// Concern:
+// Verify that invalid quotes are rejected.
+//
+TEST(DiscountCurveTest, InvalidQuotesThrow)
+{
+    CurveBuilder builder;
+    EXPECT_THROW(builder.setQuotes(std::vector<int>(),
+                         std::vector<double>()),
+            std::invalid_argument);
+    std::vector<int> days(2, 30);
+    std::vector<double> rates(2, 0.01);
+    EXPECT_THROW(builder.setQuotes(days, rates), std::invalid_argument);
+    days[1] = 60;
+    EXPECT_THROW(builder.setQuotes(days, std::vector<double>(1, 0.01)),
+            std::invalid_argument);
+    builder.setQuotes(days, rates);
+    EXPECT_THROW(builder.updateQuote(2, 0.01), std::invalid_argument);
+    builder.updateQuote(1, -20.0);
+    EXPECT_THROW(builder.publish(), std::invalid_argument);
+}
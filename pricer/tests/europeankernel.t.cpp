@@ -0,0 +1,279 @@
+#include <europeankernel.h>
+
+#include <referencemodels.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+namespace {
+// Options laid out as the kernel expects, with room for every output.
+struct Batch {
+    std::vector<double> d_spot, d_strike, d_vol, d_rate, d_yield, d_expiry;
+    std::vector<char> d_isCall;
+    std::vector<double> d_out[8];
+
+    void add(double spot,
+            double strike,
+            double vol,
+            double rate,
+            double yield,
+            double expiry,
+            bool isCall)
+    {
+        d_spot.push_back(spot);
+        d_strike.push_back(strike);
+        d_vol.push_back(vol);
+        d_rate.push_back(rate);
+        d_yield.push_back(yield);
+        d_expiry.push_back(expiry);
+        d_isCall.push_back(isCall);
+    }
+
+    void price(EuropeanKernel::Model model, EuropeanKernel::Isa isa)
+    {
+        price(model, isa, EuropeanKernel::e_MIXED, true);
+    }
+
+    // Price with the kernel for `payoff`, and without the yields if not
+    // `withYield`.
+    void price(EuropeanKernel::Model model,
+            EuropeanKernel::Isa isa,
+            EuropeanKernel::Payoff payoff,
+            bool withYield)
+    {
+        for (int m = 0; m < 8; ++m) {
+            d_out[m].assign(d_spot.size(), 0.0);
+        }
+        const EuropeanInputs inputs = { &d_spot[0], &d_strike[0], &d_vol[0],
+            &d_rate[0], withYield ? &d_yield[0] : 0, &d_expiry[0],
+            &d_isCall[0], d_spot.size() };
+        const EuropeanOutputs outputs = { &d_out[0][0], &d_out[1][0],
+            &d_out[2][0], &d_out[3][0], &d_out[4][0], &d_out[5][0],
+            &d_out[6][0], &d_out[7][0] };
+        EuropeanKernel::price(outputs, inputs, model, isa, payoff);
+    }
+
+    double price(std::size_t i) const { return d_out[0][i]; }
+};
+
+Batch single(double spot,
+        double strike,
+        double vol,
+        double rate,
+        double yield,
+        double expiry,
+        bool isCall,
+        EuropeanKernel::Model model = EuropeanKernel::e_BLACK_SCHOLES)
+{
+    Batch batch;
+    batch.add(spot, strike, vol, rate, yield, expiry, isCall);
+    batch.price(model, EuropeanKernel::e_SCALAR);
+    return batch;
+}
+}
+
+//
+// Concern:
+// Verify that the scalar path, with its polynomial exp, log and normal
+// CDF, matches Black-Scholes computed with the standard library.
+//
+TEST(EuropeanKernelTest, ScalarMatchesReference)
+{
+    Batch batch;
+    const double strikes[] = { 40.0, 80.0, 100.0, 125.0, 250.0 };
+    const double expiries[] = { 0.01, 0.5, 3.0 };
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            batch.add(100.0, strikes[i], 0.3, 0.04, 0.0, expiries[j], true);
+            batch.add(100.0, strikes[i], 0.3, 0.04, 0.0, expiries[j], false);
+        }
+    }
+    batch.price(EuropeanKernel::e_BLACK_SCHOLES, EuropeanKernel::e_SCALAR);
+
+    for (std::size_t i = 0; i < batch.d_spot.size(); ++i) {
+        const double expected = reference::blackScholes(batch.d_spot[i],
+                batch.d_strike[i],
+                batch.d_vol[i],
+                batch.d_rate[i],
+                batch.d_expiry[i],
+                batch.d_isCall[i] != 0);
+        EXPECT_NEAR(expected, batch.price(i), 1e-12 * (1.0 + expected));
+    }
+}
+
+//
+// Concern:
+// Verify that every instruction set the CPU supports returns the scalar
+// results to rounding, including for a partial last vector.
+//
+// Plan:
+// Price 37 varied options with each path up to `bestIsa()` and compare
+// every output to the scalar path.
+//
+TEST(EuropeanKernelTest, EveryIsaMatchesScalar)
+{
+    Batch batch;
+    for (int i = 0; i < 37; ++i) {
+        batch.add(80.0 + 1.3 * i,
+                60.0 + 2.0 * (i % 23),
+                0.05 + 0.02 * (i % 11),
+                -0.01 + 0.005 * (i % 7),
+                0.01 * (i % 3),
+                0.02 + 0.3 * (i % 9),
+                i % 2 == 0);
+    }
+
+    const EuropeanKernel::Model models[] = { EuropeanKernel::e_BLACK_SCHOLES,
+        EuropeanKernel::e_BLACK76 };
+    for (int m = 0; m < 2; ++m) {
+        Batch scalar = batch;
+        scalar.price(models[m], EuropeanKernel::e_SCALAR);
+
+        for (int isa = EuropeanKernel::e_AVX2; isa <= EuropeanKernel::bestIsa();
+                ++isa) {
+            SCOPED_TRACE(EuropeanKernel::isaName(EuropeanKernel::Isa(isa)));
+            Batch wide = batch;
+            wide.price(models[m], EuropeanKernel::Isa(isa));
+            for (int out = 0; out < 8; ++out) {
+                for (std::size_t i = 0; i < batch.d_spot.size(); ++i) {
+                    const double expected = scalar.d_out[out][i];
+                    EXPECT_NEAR(expected,
+                            wide.d_out[out][i],
+                            1e-12 * std::max(1.0, std::fabs(expected)));
+                }
+            }
+        }
+    }
+}
+
+//
+// Concern:
+// Verify the first and second order greeks, with a dividend yield.
+//
+// Plan:
+// Compare each greek to a central difference of the kernel price, or of
+// the kernel delta and vega for vanna and volga.
+//
+TEST(EuropeanKernelTest, GreeksMatchFiniteDifferences)
+{
+    const double s = 100.0, k = 90.0, vol = 0.35, r = 0.03, q = 0.02;
+    const double t = 0.8;
+    const double h = 1e-4;
+    for (int isCall = 0; isCall < 2; ++isCall) {
+        const Batch base = single(s, k, vol, r, q, t, isCall != 0);
+        const Batch spotUp = single(s + h, k, vol, r, q, t, isCall != 0);
+        const Batch spotDown = single(s - h, k, vol, r, q, t, isCall != 0);
+        const Batch volUp = single(s, k, vol + h, r, q, t, isCall != 0);
+        const Batch volDown = single(s, k, vol - h, r, q, t, isCall != 0);
+        const Batch rateUp = single(s, k, vol, r + h, q, t, isCall != 0);
+        const Batch rateDown = single(s, k, vol, r - h, q, t, isCall != 0);
+        const Batch later = single(s, k, vol, r, q, t - h, isCall != 0);
+        const Batch earlier = single(s, k, vol, r, q, t + h, isCall != 0);
+
+        const double up = spotUp.price(0);
+        const double down = spotDown.price(0);
+        EXPECT_NEAR((up - down) / (2 * h), base.d_out[1][0], 1e-7);
+        EXPECT_NEAR((up - 2 * base.price(0) + down) / (h * h),
+                base.d_out[2][0],
+                1e-4);
+        EXPECT_NEAR((volUp.price(0) - volDown.price(0)) / (2 * h),
+                base.d_out[3][0],
+                1e-6);
+        EXPECT_NEAR((later.price(0) - earlier.price(0)) / (2 * h),
+                base.d_out[4][0],
+                1e-6);
+        EXPECT_NEAR((rateUp.price(0) - rateDown.price(0)) / (2 * h),
+                base.d_out[5][0],
+                1e-6);
+        EXPECT_NEAR((volUp.d_out[1][0] - volDown.d_out[1][0]) / (2 * h),
+                base.d_out[6][0],
+                1e-7);
+        EXPECT_NEAR((volUp.d_out[3][0] - volDown.d_out[3][0]) / (2 * h),
+                base.d_out[7][0],
+                1e-5);
+    }
+}
+
+//
+// Concern:
+// Verify Black-76 on a forward.
+//
+// Plan:
+// 1. With the forward S exp(rT), the price must equal Black-Scholes on S.
+// 2. Rho must be -T times the price, as the forward is held fixed.
+//
+TEST(EuropeanKernelTest, Black76)
+{
+    const double s = 100.0, k = 105.0, vol = 0.25, r = 0.05, t = 1.5;
+    const double forward = s * std::exp(r * t);
+    for (int isCall = 0; isCall < 2; ++isCall) {
+        const Batch batch = single(forward, k, vol, r, 0.0, t, isCall != 0,
+                EuropeanKernel::e_BLACK76);
+        EXPECT_NEAR(reference::blackScholes(s, k, vol, r, t, isCall != 0),
+                batch.price(0),
+                1e-11);
+        EXPECT_NEAR(-t * batch.price(0), batch.d_out[5][0], 1e-12);
+    }
+}
+
+//
+// Concern:
+// Verify that the kernels specialized for a batch of calls, of puts, or
+// without a yield return the results of the generic kernel to the last
+// bit, on every instruction set and for both models.
+//
+// Plan:
+// 1. Price calls, puts and a mix of both with zero yields by the generic
+//    kernel, the mixed one given the yields.
+// 2. Price them again with the payoff `EuropeanKernel::payoff` reads and
+//    no yields, and expect equal outputs.
+//
+TEST(EuropeanKernelTest, SpecializedMatchesGeneric)
+{
+    for (int type = 0; type < 3; ++type) {
+        Batch batch;
+        for (int i = 0; i < 13; ++i) {
+            batch.add(90.0 + 2.1 * i,
+                    70.0 + 3.0 * (i % 11),
+                    0.1 + 0.03 * (i % 5),
+                    -0.01 + 0.01 * (i % 4),
+                    0.0,
+                    0.05 + 0.4 * (i % 6),
+                    type == 2 ? i % 3 == 0 : type == 0);
+        }
+        const EuropeanInputs inputs = { 0, 0, 0, 0, 0, 0, &batch.d_isCall[0],
+            batch.d_isCall.size() };
+        const EuropeanKernel::Payoff payoff = EuropeanKernel::payoff(inputs);
+        EXPECT_EQ(type == 0 ? EuropeanKernel::e_CALLS
+                        : type == 1 ? EuropeanKernel::e_PUTS
+                                    : EuropeanKernel::e_MIXED,
+                payoff);
+
+        for (int m = 0; m < 2; ++m) {
+            const EuropeanKernel::Model model = EuropeanKernel::Model(m);
+            for (int isa = EuropeanKernel::e_SCALAR;
+                    isa <= EuropeanKernel::bestIsa();
+                    ++isa) {
+                SCOPED_TRACE(
+                        EuropeanKernel::isaName(EuropeanKernel::Isa(isa)));
+                Batch generic = batch;
+                generic.price(model,
+                        EuropeanKernel::Isa(isa),
+                        EuropeanKernel::e_MIXED,
+                        true);
+                Batch specialized = batch;
+                specialized.price(
+                        model, EuropeanKernel::Isa(isa), payoff, false);
+                for (int out = 0; out < 8; ++out) {
+                    EXPECT_EQ(generic.d_out[out], specialized.d_out[out])
+                            << type << " " << m << " " << out;
+                }
+            }
+        }
+    }
+}
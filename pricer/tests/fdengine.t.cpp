@@ -0,0 +1,333 @@
+#include <fdengine.h>
+#include <legbatch.h>
+
+#include <referencemodels.h>
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+namespace {
+Leg makeLeg(double spot,
+        double strike,
+        double vol,
+        double rate,
+        double expiry,
+        bool isCall,
+        bool isAmerican)
+{
+    Leg leg;
+    leg.d_spot = spot;
+    leg.d_strike = strike;
+    leg.d_vol = vol;
+    leg.d_rate = rate;
+    leg.d_expiry = expiry;
+    leg.d_isCall = isCall;
+    leg.d_isAmerican = isAmerican;
+    leg.d_dividendTimes = 0;
+    leg.d_dividendAmounts = 0;
+    leg.d_numDividends = 0;
+    return leg;
+}
+}
+
+//
+// Concern:
+// Verify that European legs without dividends match Black-Scholes.
+//
+// Plan:
+// Price calls and puts across strikes and compare to the closed form.
+//
+TEST(FdEngineTest, EuropeanMatchesBlackScholes)
+{
+    FdEngine engine;
+    const double strikes[] = { 80.0, 100.0, 120.0 };
+    for (int i = 0; i < 3; ++i) {
+        for (int isCall = 0; isCall < 2; ++isCall) {
+            Leg leg = makeLeg(100.0, strikes[i], 0.25, 0.03, 0.75,
+                    isCall != 0, false);
+            const double expected = reference::blackScholes(
+                    100.0, strikes[i], 0.25, 0.03, 0.75, isCall != 0);
+            EXPECT_NEAR(expected, engine.price(leg).d_price, 1e-2);
+        }
+    }
+}
+
+//
+// Concern:
+// Verify that the grid adapts to the expiry, so short and long legs are
+// priced to about the same absolute accuracy.
+//
+// Plan:
+// Price at-the-money and out-of-the-money puts from two weeks to five years
+// at low and high volatility, and compare to the closed form.
+//
+TEST(FdEngineTest, AdaptiveGridAcrossExpiries)
+{
+    FdEngine engine;
+    const double expiries[] = { 0.04, 0.25, 1.0, 5.0 };
+    const double vols[] = { 0.1, 0.5 };
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            for (double strike = 90.0; strike <= 100.0; strike += 10.0) {
+                Leg leg = makeLeg(100.0, strike, vols[j], 0.03, expiries[i],
+                        false, false);
+                const double expected = reference::blackScholes(100.0,
+                        strike, vols[j], 0.03, expiries[i], false);
+                EXPECT_NEAR(expected, engine.price(leg).d_price, 5e-3)
+                        << expiries[i] << " " << vols[j] << " " << strike;
+            }
+        }
+    }
+}
+
+//
+// Concern:
+// Verify that American puts match a fine binomial tree and that American
+// calls without dividends are never exercised early.
+//
+TEST(FdEngineTest, AmericanWithoutDividends)
+{
+    FdEngine engine;
+
+    Leg put = makeLeg(100.0, 105.0, 0.3, 0.05, 1.0, false, true);
+    const double expectedPut = reference::americanTree(
+            100.0, 105.0, 0.3, 0.05, 1.0, false);
+    EXPECT_NEAR(expectedPut, engine.price(put).d_price, 2e-2);
+
+    Leg call = makeLeg(100.0, 105.0, 0.3, 0.05, 1.0, true, true);
+    const double european
+            = reference::blackScholes(100.0, 105.0, 0.3, 0.05, 1.0, true);
+    EXPECT_NEAR(european, engine.price(call).d_price, 1e-2);
+}
+
+//
+// Concern:
+// Verify that discrete dividends are applied as spot jumps.
+//
+// Plan:
+// 1. European call and put with two dividends must satisfy put-call parity
+//    C - P = S - PV(D) - K exp(-rT).
+// 2. An American call with a large dividend just before expiry is worth
+//    more than the European call.
+//
+TEST(FdEngineTest, DiscreteDividends)
+{
+    FdEngine engine;
+    const double times[] = { 0.25, 0.7 };
+    const double amounts[] = { 1.5, 2.0 };
+    const double r = 0.04;
+    const double t = 1.0;
+
+    Leg call = makeLeg(100.0, 100.0, 0.2, r, t, true, false);
+    call.d_dividendTimes = times;
+    call.d_dividendAmounts = amounts;
+    call.d_numDividends = 2;
+    Leg put = call;
+    put.d_isCall = false;
+
+    const double pv = amounts[0] * std::exp(-r * times[0])
+            + amounts[1] * std::exp(-r * times[1]);
+    const double parity = 100.0 - pv - 100.0 * std::exp(-r * t);
+    EXPECT_NEAR(parity,
+            engine.price(call).d_price - engine.price(put).d_price,
+            1e-2);
+
+    const double lateTimes[] = { 0.95 };
+    const double lateAmounts[] = { 8.0 };
+    Leg europeanCall = makeLeg(100.0, 90.0, 0.2, r, t, true, false);
+    europeanCall.d_dividendTimes = lateTimes;
+    europeanCall.d_dividendAmounts = lateAmounts;
+    europeanCall.d_numDividends = 1;
+    Leg americanCall = europeanCall;
+    americanCall.d_isAmerican = true;
+
+    EXPECT_GT(engine.price(americanCall).d_price,
+            engine.price(europeanCall).d_price + 0.5);
+}
+
+//
+// Concern:
+// Verify that delta and gamma read off the grid match Black-Scholes.
+//
+TEST(FdEngineTest, GridGreeks)
+{
+    FdEngine engine;
+    Leg leg = makeLeg(100.0, 95.0, 0.2, 0.02, 0.5, true, false);
+    const Greeks result = engine.price(leg);
+
+    const double h = 0.01;
+    const double up
+            = reference::blackScholes(100.0 + h, 95.0, 0.2, 0.02, 0.5, true);
+    const double mid
+            = reference::blackScholes(100.0, 95.0, 0.2, 0.02, 0.5, true);
+    const double down
+            = reference::blackScholes(100.0 - h, 95.0, 0.2, 0.02, 0.5, true);
+    EXPECT_NEAR((up - down) / (2 * h), result.d_delta, 2e-3);
+    EXPECT_NEAR((up - 2 * mid + down) / (h * h), result.d_gamma, 1e-3);
+}
+
+//
+// Concern:
+// Verify that vega and rho from the tangent solve are the derivatives of
+// the discrete American price, dividends and early exercise included.
+//
+// Plan:
+// 1. Price an American put with a dividend.
+// 2. Reprice on the same grid with volatility and rate bumped both ways.
+// 3. Compare the central differences to the tangent greeks.
+//
+TEST(FdEngineTest, TangentGreeksMatchBumpedSolves)
+{
+    FdEngine engine;
+    const double times[] = { 0.4 };
+    const double amounts[] = { 2.0 };
+    Leg leg = makeLeg(100.0, 100.0, 0.3, 0.04, 1.0, false, true);
+    leg.d_dividendTimes = times;
+    leg.d_dividendAmounts = amounts;
+    leg.d_numDividends = 1;
+
+    const FdGrid grid = engine.makeGrid(leg);
+    const Greeks result = engine.solve(leg, grid);
+
+    const double h = 1e-4;
+    Leg up = leg;
+    Leg down = leg;
+    up.d_vol += h;
+    down.d_vol -= h;
+    const double vega = (engine.solve(up, grid).d_price
+                                - engine.solve(down, grid).d_price)
+            / (2 * h);
+    EXPECT_NEAR(vega, result.d_vega, 1e-2 * vega);
+
+    up = leg;
+    down = leg;
+    up.d_rate += h;
+    down.d_rate -= h;
+    const double rho = (engine.solve(up, grid).d_price
+                               - engine.solve(down, grid).d_price)
+            / (2 * h);
+    EXPECT_NEAR(rho, result.d_rho, 1e-2 * std::fabs(rho));
+}
+
+//
+// Concern:
+// Verify that theta follows Black-Scholes for a European leg.
+//
+TEST(FdEngineTest, Theta)
+{
+    FdEngine engine;
+    Leg leg = makeLeg(100.0, 105.0, 0.25, 0.03, 0.5, false, false);
+
+    const double h = 1e-4;
+    const double expected = (reference::blackScholes(
+                                     100.0, 105.0, 0.25, 0.03, 0.5 - h, false)
+                                    - reference::blackScholes(100.0,
+                                            105.0,
+                                            0.25,
+                                            0.03,
+                                            0.5 + h,
+                                            false))
+            / (2 * h);
+    EXPECT_NEAR(expected,
+            engine.price(leg).d_theta,
+            2e-2 * std::fabs(expected));
+}
+
+//
+// Concern:
+// Verify that one solve prices a leg across a range of spots well beyond
+// its grid, between nodes as well as on them.
+//
+// Plan:
+// Price an American put at spots from 60% to 150% of its own from one
+// solve, and compare each to the solve centred on that spot.
+//
+TEST(FdEngineTest, PriceSpots)
+{
+    FdEngine engine;
+    const Leg leg = makeLeg(100.0, 95.0, 0.3, 0.04, 0.5, false, true);
+    std::vector<double> spots;
+    for (double spot = 60.0; spot <= 150.0; spot += 7.5) {
+        spots.push_back(spot);
+    }
+    std::vector<double> prices;
+    engine.priceSpots(&prices, leg, spots);
+    ASSERT_EQ(spots.size(), prices.size());
+    for (std::size_t i = 0; i < spots.size(); ++i) {
+        Leg shifted = leg;
+        shifted.d_spot = spots[i];
+        EXPECT_NEAR(engine.price(shifted).d_price, prices[i], 2e-3)
+                << spots[i];
+    }
+}
+
+//
+// Concern:
+// Verify that pricing legs in groups of one kernel, and stepping them by
+// the generic kernel, give the greeks of pricing each leg on its own.
+//
+// Plan:
+// 1. Build a batch of calls and puts, European and American, with and
+//    without a dividend during their life, in mixed order.
+// 2. Price a subset of them in groups, with the specialized kernels and
+//    with the generic kernel, and expect each greek to equal the single
+//    leg solve bit for bit, and the legs left out to be untouched.
+//
+TEST(FdEngineTest, GroupedAndGenericKernelsMatchSingleSolves)
+{
+    LegBatch legs;
+    const std::vector<double> times(1, 0.3);
+    const std::vector<double> amounts(1, 2.0);
+    for (int i = 0; i < 16; ++i) {
+        legs.addLeg(100.0,
+                90.0 + 2.5 * i,
+                0.25,
+                0.03,
+                i % 2 ? 0.5 : 0.2,
+                i % 4 < 2,
+                i % 8 < 4,
+                times,
+                amounts);
+    }
+
+    FdEngine::Config genericConfig;
+    genericConfig.d_specialized = false;
+    const FdEngine specialized;
+    const FdEngine generic(genericConfig);
+    std::vector<std::size_t> indices;
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        if (i % 3 != 2) {
+            indices.push_back(i);
+        }
+    }
+    PricingResults grouped;
+    grouped.resize(legs.size());
+    specialized.price(grouped.outputs(), legs, indices);
+    PricingResults stepped;
+    stepped.resize(legs.size());
+    generic.price(stepped.outputs(), legs, indices);
+
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        if (next < indices.size() && indices[next] == i) {
+            ++next;
+            const Greeks single = specialized.price(legs.leg(i));
+            EXPECT_EQ(single.d_price, grouped.d_price[i]) << i;
+            EXPECT_EQ(single.d_delta, grouped.d_delta[i]) << i;
+            EXPECT_EQ(single.d_gamma, grouped.d_gamma[i]) << i;
+            EXPECT_EQ(single.d_vega, grouped.d_vega[i]) << i;
+            EXPECT_EQ(single.d_theta, grouped.d_theta[i]) << i;
+            EXPECT_EQ(single.d_rho, grouped.d_rho[i]) << i;
+            EXPECT_EQ(single.d_price, stepped.d_price[i]) << i;
+            EXPECT_EQ(single.d_vega, stepped.d_vega[i]) << i;
+            EXPECT_EQ(single.d_rho, stepped.d_rho[i]) << i;
+        }
+        else {
+            EXPECT_EQ(0.0, grouped.d_price[i]) << i;
+        }
+    }
+}
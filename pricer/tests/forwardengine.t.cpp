@@ -0,0 +1,203 @@
+#include <fdengine.h>
+#include <forwardengine.h>
+#include <legbatch.h>
+
+#include <referencemodels.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+namespace {
+Chain makeChain(const std::vector<double>& strikes,
+        const std::vector<double>& vols,
+        double expiry)
+{
+    Chain chain;
+    chain.d_spot = 100.0;
+    chain.d_rate = 0.04;
+    chain.d_expiry = expiry;
+    chain.d_dividendTimes = 0;
+    chain.d_dividendAmounts = 0;
+    chain.d_numDividends = 0;
+    chain.d_strikes = &strikes[0];
+    chain.d_vols = &vols[0];
+    chain.d_numStrikes = strikes.size();
+    return chain;
+}
+
+Leg legOf(const Chain& chain, std::size_t i, bool isCall, bool isAmerican)
+{
+    const Leg leg = { chain.d_spot, chain.d_strikes[i], chain.d_vols[i],
+        chain.d_rate, chain.d_expiry, isCall, isAmerican,
+        chain.d_dividendTimes, chain.d_dividendAmounts,
+        chain.d_numDividends };
+    return leg;
+}
+}
+
+//
+// Concern:
+// Verify that one solve prices every strike of a flat chain without
+// dividends, European and American.
+//
+// Plan:
+// 1. Compare the European prices to the closed form.
+// 2. Compare the American puts to a fine binomial tree, and expect the
+//    American calls to equal the European calls.
+//
+TEST(ForwardEngineTest, FlatChainMatchesClosedForm)
+{
+    std::vector<double> strikes;
+    for (double strike = 70.0; strike <= 130.0; strike += 5.0) {
+        strikes.push_back(strike);
+    }
+    const std::vector<double> vols(strikes.size(), 0.3);
+    const Chain chain = makeChain(strikes, vols, 0.5);
+
+    ChainPrices prices;
+    ForwardEngine().price(&prices, chain);
+    ASSERT_EQ(strikes.size(), prices.d_call.size());
+    for (std::size_t i = 0; i < strikes.size(); ++i) {
+        EXPECT_NEAR(reference::blackScholes(
+                            100.0, strikes[i], 0.3, 0.04, 0.5, true),
+                prices.d_call[i],
+                5e-3)
+                << strikes[i];
+        EXPECT_NEAR(reference::blackScholes(
+                            100.0, strikes[i], 0.3, 0.04, 0.5, false),
+                prices.d_put[i],
+                5e-3)
+                << strikes[i];
+        EXPECT_EQ(prices.d_call[i], prices.d_americanCall[i]);
+        if (i % 4 == 0) {
+            EXPECT_NEAR(reference::americanTree(
+                                100.0, strikes[i], 0.3, 0.04, 0.5, false),
+                    prices.d_americanPut[i],
+                    1e-2)
+                    << strikes[i];
+        }
+    }
+}
+
+//
+// Concern:
+// Verify that dividends are applied as spot jumps, so the chain agrees with
+// a backward solve of each strike.
+//
+// Plan:
+// 1. Price a chain with two dividends of half a percent of the spot.
+// 2. Compare the European prices to fine FdEngine solves, and the American
+//    approximations to within a few cents.
+//
+TEST(ForwardEngineTest, DividendsMatchBackwardSolves)
+{
+    std::vector<double> strikes;
+    for (double strike = 80.0; strike <= 120.0; strike += 10.0) {
+        strikes.push_back(strike);
+    }
+    const std::vector<double> vols(strikes.size(), 0.25);
+    Chain chain = makeChain(strikes, vols, 1.0);
+    const double times[] = { 0.3, 0.7 };
+    const double amounts[] = { 0.5, 0.5 };
+    chain.d_dividendTimes = times;
+    chain.d_dividendAmounts = amounts;
+    chain.d_numDividends = 2;
+
+    FdEngine::Config config;
+    config.d_timeSteps = 400;
+    config.d_spaceSteps = 800;
+    const FdEngine fd(config);
+    ChainPrices prices;
+    ForwardEngine().price(&prices, chain);
+    for (std::size_t i = 0; i < strikes.size(); ++i) {
+        EXPECT_NEAR(fd.price(legOf(chain, i, true, false)).d_price,
+                prices.d_call[i],
+                5e-3)
+                << strikes[i];
+        EXPECT_NEAR(fd.price(legOf(chain, i, false, false)).d_price,
+                prices.d_put[i],
+                5e-3)
+                << strikes[i];
+        EXPECT_NEAR(fd.price(legOf(chain, i, true, true)).d_price,
+                prices.d_americanCall[i],
+                5e-2)
+                << strikes[i];
+        EXPECT_NEAR(fd.price(legOf(chain, i, false, true)).d_price,
+                prices.d_americanPut[i],
+                5e-2)
+                << strikes[i];
+    }
+}
+
+//
+// Concern:
+// Verify that a skewed chain is repriced close to its quotes near the
+// money at a short expiry.
+//
+// Plan:
+// Price a one month chain with a steep skew and expect each price within
+// half a volatility point of the closed form at the quoted vol.
+//
+TEST(ForwardEngineTest, SmileIsRepricedNearTheMoney)
+{
+    std::vector<double> strikes;
+    std::vector<double> vols;
+    for (double strike = 80.0; strike <= 120.0; strike += 5.0) {
+        const double k = std::log(strike / 100.0);
+        strikes.push_back(strike);
+        vols.push_back(0.25 - 0.3 * k + 0.5 * k * k);
+    }
+    const double expiry = 1.0 / 12.0;
+    const Chain chain = makeChain(strikes, vols, expiry);
+
+    ChainPrices prices;
+    ForwardEngine().price(&prices, chain);
+    for (std::size_t i = 2; i + 2 < strikes.size(); ++i) {
+        const double h = 1e-4;
+        const double up = reference::blackScholes(
+                100.0, strikes[i], vols[i] + h, 0.04, expiry, true);
+        const double down = reference::blackScholes(
+                100.0, strikes[i], vols[i] - h, 0.04, expiry, true);
+        const double vega = (up - down) / (2 * h);
+        EXPECT_NEAR(reference::blackScholes(
+                            100.0, strikes[i], vols[i], 0.04, expiry, true),
+                prices.d_call[i],
+                0.005 * vega)
+                << strikes[i];
+    }
+}
+
+//
+// Concern:
+// Verify that invalid chains are rejected.
+//
+TEST(ForwardEngineTest, InvalidChainThrows)
+{
+    std::vector<double> strikes(1, 100.0);
+    std::vector<double> vols(1, 0.2);
+    ChainPrices prices;
+    const ForwardEngine engine;
+
+    Chain chain = makeChain(strikes, vols, 1.0);
+    chain.d_numStrikes = 0;
+    EXPECT_THROW(engine.price(&prices, chain), std::invalid_argument);
+
+    strikes.push_back(90.0);
+    vols.push_back(0.2);
+    chain = makeChain(strikes, vols, 1.0);
+    EXPECT_THROW(engine.price(&prices, chain), std::invalid_argument);
+
+    strikes[1] = 110.0;
+    chain = makeChain(strikes, vols, 1.0);
+    const double times[] = { 0.5 };
+    const double amounts[] = { 150.0 };
+    chain.d_dividendTimes = times;
+    chain.d_dividendAmounts = amounts;
+    chain.d_numDividends = 1;
+    EXPECT_THROW(engine.price(&prices, chain), std::invalid_argument);
+}
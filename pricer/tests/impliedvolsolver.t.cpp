@@ -0,0 +1,174 @@
+#include <batchpricer.h>
+#include <impliedvolsolver.h>
+#include <legbatch.h>
+
+#include <referencemodels.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+//
+// Concern:
+// Verify that European quotes are inverted to the vol they were priced at,
+// including deep wings and short expiries, in a few iterations.
+//
+// Plan:
+// 1. Price calls and puts across strikes, vols and expiries in closed form.
+// 2. Solve the batch on several threads and compare each vol.
+//
+TEST(ImpliedVolSolverTest, EuropeanRoundTrip)
+{
+    LegBatch legs;
+    std::vector<double> prices;
+    std::vector<double> vols;
+    const double expiries[] = { 1.0 / 365.0, 0.1, 1.0, 5.0 };
+    const double strikes[] = { 50.0, 90.0, 100.0, 110.0, 200.0 };
+    const double sigmas[] = { 0.05, 0.3, 1.5 };
+    for (int e = 0; e < 4; ++e) {
+        for (int k = 0; k < 5; ++k) {
+            for (int v = 0; v < 3; ++v) {
+                for (int c = 0; c < 2; ++c) {
+                    const double price = reference::blackScholes(100.0,
+                            strikes[k],
+                            sigmas[v],
+                            0.03,
+                            expiries[e],
+                            c == 1);
+                    // Quotes with no time value over the forward carry no
+                    // vol.
+                    const double pv = strikes[k]
+                            * std::exp(-0.03 * expiries[e]);
+                    const double intrinsic = std::max(
+                            c == 1 ? 100.0 - pv : pv - 100.0, 0.0);
+                    if (price - intrinsic < 1e-6) {
+                        continue;
+                    }
+                    legs.addLeg(100.0,
+                            strikes[k],
+                            0.2,
+                            0.03,
+                            expiries[e],
+                            c == 1,
+                            false);
+                    prices.push_back(price);
+                    vols.push_back(sigmas[v]);
+                }
+            }
+        }
+    }
+
+    ImpliedVolSolver::Config config;
+    config.d_threads = 4;
+    ImpliedVols result;
+    ImpliedVolSolver(config).solve(&result, legs, prices);
+    ASSERT_EQ(vols.size(), result.d_vol.size());
+    for (std::size_t i = 0; i < vols.size(); ++i) {
+        EXPECT_TRUE(result.d_converged[i]) << i;
+        EXPECT_NEAR(vols[i], result.d_vol[i], 1e-4 * vols[i]) << i;
+        EXPECT_LE(result.d_iterations[i], 6) << i;
+    }
+}
+
+//
+// Concern:
+// Verify that American quotes, with and without dividends, are inverted to
+// the vol BatchPricer priced them at.
+//
+// Plan:
+// 1. Price American puts and calls with BatchPricer.
+// 2. Solve the batch and compare each vol within a small fraction of a vol
+//    point, allowing for the grid being chosen at another vol.
+//
+TEST(ImpliedVolSolverTest, AmericanRoundTrip)
+{
+    std::vector<double> times(2);
+    std::vector<double> amounts(2);
+    times[0] = 0.2;
+    times[1] = 0.7;
+    amounts[0] = 1.0;
+    amounts[1] = 1.0;
+
+    LegBatch legs;
+    std::vector<double> vols;
+    const double strikes[] = { 80.0, 100.0, 120.0 };
+    for (int k = 0; k < 3; ++k) {
+        for (int c = 0; c < 2; ++c) {
+            const double vol = 0.15 + 0.1 * k;
+            legs.addLeg(100.0, strikes[k], vol, 0.05, 1.0, c == 1, true);
+            vols.push_back(vol);
+            legs.addLeg(100.0,
+                    strikes[k],
+                    vol,
+                    0.05,
+                    1.0,
+                    c == 1,
+                    true,
+                    times,
+                    amounts);
+            vols.push_back(vol);
+        }
+    }
+    PricingResults results;
+    BatchPricer().price(&results, legs);
+
+    // The solver only uses the vol of a leg as a first guess.
+    LegBatch guesses = legs;
+    for (std::size_t i = 0; i < guesses.size(); ++i) {
+        guesses.d_vol[i] = 0.5;
+    }
+    ImpliedVols result;
+    ImpliedVolSolver().solve(&result, guesses, results.d_price);
+    for (std::size_t i = 0; i < vols.size(); ++i) {
+        EXPECT_TRUE(result.d_converged[i]) << i;
+        EXPECT_NEAR(vols[i], result.d_vol[i], 1e-3) << i;
+    }
+}
+
+//
+// Concern:
+// Verify that a quote the model cannot reach is flagged rather than solved.
+//
+// Plan:
+// Quote a European and an American put below intrinsic, and expect NaN
+// vols that did not converge next to a valid quote that did.
+//
+TEST(ImpliedVolSolverTest, UnreachableQuoteIsFlagged)
+{
+    LegBatch legs;
+    legs.addLeg(100.0, 120.0, 0.2, 0.03, 0.5, false, false);
+    legs.addLeg(100.0, 120.0, 0.2, 0.03, 0.5, false, true);
+    legs.addLeg(100.0, 100.0, 0.2, 0.03, 0.5, true, false);
+    std::vector<double> prices(3, 5.0);
+
+    ImpliedVols result;
+    ImpliedVolSolver().solve(&result, legs, prices);
+    EXPECT_FALSE(result.d_converged[0]);
+    EXPECT_TRUE(std::isnan(result.d_vol[0]));
+    EXPECT_FALSE(result.d_converged[1]);
+    EXPECT_TRUE(std::isnan(result.d_vol[1]));
+    EXPECT_TRUE(result.d_converged[2]);
+    EXPECT_NEAR(reference::blackScholes(
+                        100.0, 100.0, result.d_vol[2], 0.03, 0.5, true),
+            5.0,
+            1e-9);
+}
+
+//
+// Concern:
+// Verify that a batch whose prices do not match its legs is rejected.
+//
+TEST(ImpliedVolSolverTest, SizeMismatchThrows)
+{
+    LegBatch legs;
+    legs.addLeg(100.0, 100.0, 0.2, 0.03, 0.5, true, false);
+    ImpliedVols result;
+    EXPECT_THROW(ImpliedVolSolver().solve(
+                         &result, legs, std::vector<double>(2, 1.0)),
+            std::invalid_argument);
+}
@@ -0,0 +1,202 @@
+#include <batchpricer.h>
+#include <incrementalpricer.h>
+#include <legbatch.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+namespace {
+// A European call spread and an American put with a dividend.
+LegBatch strategy(double spot)
+{
+    LegBatch legs;
+    legs.addLeg(spot, 100.0, 0.25, 0.03, 0.5, true, false);
+    legs.addLeg(spot, 110.0, 0.25, 0.03, 0.5, true, false);
+    legs.addLeg(spot,
+            95.0,
+            0.3,
+            0.03,
+            0.75,
+            false,
+            true,
+            std::vector<double>(1, 0.3),
+            std::vector<double>(1, 1.5));
+    return legs;
+}
+
+struct Outputs {
+    std::vector<double> d_values;
+    PricingOutputs d_outputs;
+
+    explicit Outputs(std::size_t n)
+        : d_values(6 * n)
+    {
+        const PricingOutputs outputs = { &d_values[0], &d_values[n],
+            &d_values[2 * n], &d_values[3 * n], &d_values[4 * n],
+            &d_values[5 * n] };
+        d_outputs = outputs;
+    }
+};
+}
+
+//
+// Concern:
+// Verify that small spot moves are Taylor updates within the tolerance of
+// a full reprice, and that the counters report them.
+//
+// Plan:
+// 1. Price the strategy once, which reprices every leg in full.
+// 2. Move the spot by a few ticks at a time, expect no full reprice, and
+//    compare every price to BatchPricer.
+//
+TEST(IncrementalPricerTest, SmallMovesAreUpdated)
+{
+    IncrementalPricer pricer;
+    Outputs outputs(3);
+    EXPECT_EQ(3u, pricer.price(outputs.d_outputs, strategy(100.0)));
+    EXPECT_EQ(3u, pricer.statistics().d_reprices);
+    EXPECT_EQ(0u, pricer.statistics().d_fallbacks);
+
+    for (int tick = -5; tick <= 5; ++tick) {
+        const LegBatch legs = strategy(100.0 + 0.05 * tick);
+        EXPECT_EQ(0u, pricer.price(outputs.d_outputs, legs)) << tick;
+        PricingResults exact;
+        BatchPricer().price(&exact, legs);
+        for (std::size_t i = 0; i < legs.size(); ++i) {
+            EXPECT_NEAR(exact.d_price[i],
+                    outputs.d_outputs.d_price[i],
+                    pricer.config().d_tolerance)
+                    << tick << " " << i;
+        }
+    }
+    EXPECT_EQ(33u, pricer.statistics().d_updates);
+    EXPECT_EQ(3u, pricer.statistics().d_reprices);
+
+    pricer.resetStatistics();
+    EXPECT_EQ(0u, pricer.statistics().d_updates);
+}
+
+//
+// Concern:
+// Verify that a leg falls back to a full reprice when its move exceeds a
+// threshold or the error bound, or its contract changes, and becomes the
+// new anchor.
+//
+// Plan:
+// 1. Anchor the strategy, then move the spot by 0.8%, within the
+//    threshold but with an error bound above a tight tolerance.
+// 2. Move the vol of one leg beyond its threshold, then change a strike.
+// 3. Expect the fallbacks counted and the prices equal to BatchPricer.
+//
+TEST(IncrementalPricerTest, LargeMovesAreRepriced)
+{
+    IncrementalPricer::Config config;
+    config.d_tolerance = 1e-6;
+    IncrementalPricer pricer(config);
+    Outputs outputs(3);
+    pricer.price(outputs.d_outputs, strategy(100.0));
+
+    LegBatch legs = strategy(100.8);
+    EXPECT_EQ(3u, pricer.price(outputs.d_outputs, legs));
+    EXPECT_EQ(3u, pricer.statistics().d_fallbacks);
+    PricingResults exact;
+    BatchPricer().price(&exact, legs);
+    for (std::size_t i = 0; i < legs.size(); ++i) {
+        EXPECT_EQ(exact.d_price[i], outputs.d_outputs.d_price[i]);
+    }
+
+    legs.d_vol[0] += 0.02;
+    EXPECT_EQ(1u, pricer.price(outputs.d_outputs, legs));
+    legs.d_strike[1] = 105.0;
+    EXPECT_EQ(1u, pricer.price(outputs.d_outputs, legs));
+    EXPECT_EQ(5u, pricer.statistics().d_fallbacks);
+    EXPECT_EQ(4u, pricer.statistics().d_updates);
+
+    pricer.clear();
+    EXPECT_EQ(3u, pricer.price(outputs.d_outputs, legs));
+    EXPECT_EQ(5u, pricer.statistics().d_fallbacks);
+}
+
+//
+// Concern:
+// Verify that full reprices can come from a ChebyshevPricer.
+//
+TEST(IncrementalPricerTest, RepricesFromSurfaces)
+{
+    ChebyshevPricer surfaces;
+    IncrementalPricer pricer(IncrementalPricer::Config(), &surfaces);
+    Outputs outputs(3);
+    LegBatch legs = strategy(100.0);
+    surfaces.prepare(legs);
+    pricer.price(outputs.d_outputs, legs);
+    legs.d_spot[2] = 110.0;
+    EXPECT_EQ(1u, pricer.price(outputs.d_outputs, legs));
+    PricingResults exact;
+    BatchPricer().price(&exact, legs);
+    EXPECT_NEAR(exact.d_price[2], outputs.d_outputs.d_price[2], 1e-2);
+}
+
+//
+// Concern:
+// Verify that threads sharing one pricer each get the prices of their own
+// legs and that every leg is counted once.
+//
+// Plan:
+// 1. Price the strategy at different spots from four threads at once,
+//    with a clear in between, for a few hundred rounds.
+// 2. Expect every price within the tolerance of BatchPricer and the
+//    counters to add up to the legs priced.
+//
+TEST(IncrementalPricerTest, SharedBetweenThreads)
+{
+    IncrementalPricer pricer;
+    const int threads = 4;
+    const int rounds = 200;
+    std::vector<int> misses(threads, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.push_back(std::thread([&pricer, &misses, t, rounds]() {
+            Outputs outputs(3);
+            const LegBatch legs = strategy(100.0 + 0.02 * t);
+            PricingResults exact;
+            BatchPricer().price(&exact, legs);
+            for (int r = 0; r < rounds; ++r) {
+                pricer.price(outputs.d_outputs, legs);
+                for (std::size_t i = 0; i < legs.size(); ++i) {
+                    if (std::fabs(exact.d_price[i]
+                                - outputs.d_outputs.d_price[i])
+                            > pricer.config().d_tolerance) {
+                        ++misses[t];
+                    }
+                }
+                if (r % 50 == 0) {
+                    pricer.clear();
+                }
+            }
+        }));
+    }
+    for (int t = 0; t < threads; ++t) {
+        workers[t].join();
+        EXPECT_EQ(0, misses[t]) << t;
+    }
+    const IncrementalPricer::Statistics statistics = pricer.statistics();
+    EXPECT_EQ(3u * threads * rounds,
+            statistics.d_updates + statistics.d_reprices);
+}
+
+//
+// Concern:
+// Verify that negative thresholds are rejected.
+//
+TEST(IncrementalPricerTest, InvalidConfigThrows)
+{
+    IncrementalPricer::Config config;
+    config.d_spotMove = -0.01;
+    EXPECT_THROW(IncrementalPricer pricer(config), std::invalid_argument);
+}
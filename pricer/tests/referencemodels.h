@@ -0,0 +1,63 @@
+//
+// referencemodels.h
+// Independent, deliberately simple implementations used as references by
+// the pricer tests.
+//
+#ifndef _REFERENCE_MODELS_
+#define _REFERENCE_MODELS_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace reference {
+
+inline double normCdf(double x)
+{
+    return 0.5 * std::erfc(-x / std::sqrt(2.0));
+}
+
+inline double blackScholes(
+        double s, double k, double vol, double r, double t, bool isCall)
+{
+    const double sd = vol * std::sqrt(t);
+    const double d1 = (std::log(s / k) + r * t) / sd + 0.5 * sd;
+    const double d2 = d1 - sd;
+    const double df = std::exp(-r * t);
+    return isCall ? s * normCdf(d1) - k * df * normCdf(d2)
+                  : k * df * normCdf(-d2) - s * normCdf(-d1);
+}
+
+// Cox-Ross-Rubinstein tree for an American option without dividends.
+inline double americanTree(double s,
+        double k,
+        double vol,
+        double r,
+        double t,
+        bool isCall,
+        int steps = 4000)
+{
+    const double dt = t / steps;
+    const double u = std::exp(vol * std::sqrt(dt));
+    const double d = 1.0 / u;
+    const double p = (std::exp(r * dt) - d) / (u - d);
+    const double df = std::exp(-r * dt);
+
+    std::vector<double> v(steps + 1);
+    for (int i = 0; i <= steps; ++i) {
+        const double st = s * std::pow(u, steps - 2 * i);
+        v[i] = std::max(isCall ? st - k : k - st, 0.0);
+    }
+    for (int n = steps - 1; n >= 0; --n) {
+        for (int i = 0; i <= n; ++i) {
+            const double st = s * std::pow(u, n - 2 * i);
+            const double cont = df * (p * v[i] + (1.0 - p) * v[i + 1]);
+            v[i] = std::max(cont, std::max(isCall ? st - k : k - st, 0.0));
+        }
+    }
+    return v[0];
+}
+
+} // close namespace reference
+
+#endif
@@ -0,0 +1,184 @@
+#include <analyticengine.h>
+#include <fdengine.h>
+#include <legbatch.h>
+#include <scenarioengine.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+namespace {
+// A put ratio spread on a dividend payer: long an American put, short two
+// European puts further out of the money.
+void ratioSpread(LegBatch *legs, std::vector<double> *quantities)
+{
+    const std::vector<double> times(1, 0.2);
+    const std::vector<double> amounts(1, 1.5);
+    legs->addLeg(100.0, 100.0, 0.25, 0.03, 0.5, false, true, times, amounts);
+    legs->addLeg(100.0, 90.0, 0.28, 0.03, 0.5, false, false, times, amounts);
+    quantities->push_back(1.0);
+    quantities->push_back(-2.0);
+}
+
+ScenarioGrid ladder()
+{
+    ScenarioGrid grid;
+    for (int i = -4; i <= 4; ++i) {
+        grid.d_spotShifts.push_back(0.05 * i);
+    }
+    grid.d_volShifts.push_back(-0.05);
+    grid.d_volShifts.push_back(0.0);
+    grid.d_volShifts.push_back(0.1);
+    grid.d_horizons.push_back(0.0);
+    grid.d_horizons.push_back(0.25);
+    grid.d_horizons.push_back(0.6);
+    return grid;
+}
+}
+
+//
+// Concern:
+// Verify that every cell of the ladder is the strategy valued leg by leg
+// at the shifted spot and vol, with the expiry and dividends brought
+// forward by the horizon.
+//
+// Plan:
+// 1. Value the ratio spread on the ladder.
+// 2. Price the shifted legs one at a time, the European leg in closed form
+//    and the American leg by a solve centred on the shifted spot, and
+//    compare the strategy value of each cell, laid out spot fastest.
+// 3. Expect the last horizon, after expiry, to be intrinsic.
+//
+TEST(ScenarioEngineTest, MatchesLegPrices)
+{
+    LegBatch legs;
+    std::vector<double> quantities;
+    ratioSpread(&legs, &quantities);
+    const ScenarioGrid grid = ladder();
+    std::vector<double> values;
+    ScenarioEngine().value(&values, legs, quantities, grid);
+    ASSERT_EQ(grid.size(), values.size());
+
+    const AnalyticEngine analytic;
+    const FdEngine engine;
+    const std::size_t spots = grid.d_spotShifts.size();
+    const std::size_t vols = grid.d_volShifts.size();
+    for (std::size_t h = 0; h < grid.d_horizons.size(); ++h) {
+        const double horizon = grid.d_horizons[h];
+        for (std::size_t v = 0; v < vols; ++v) {
+            for (std::size_t s = 0; s < spots; ++s) {
+                double expected = 0.0;
+                for (std::size_t i = 0; i < legs.size(); ++i) {
+                    Leg leg = legs.leg(i);
+                    leg.d_spot *= 1.0 + grid.d_spotShifts[s];
+                    leg.d_vol += grid.d_volShifts[v];
+                    leg.d_expiry -= horizon;
+                    const double time = leg.d_dividendTimes[0] - horizon;
+                    leg.d_dividendTimes = &time;
+                    double price;
+                    if (leg.d_expiry <= 0.0) {
+                        price = std::max(leg.d_strike - leg.d_spot, 0.0);
+                    }
+                    else if (leg.d_isAmerican) {
+                        price = engine.price(leg).d_price;
+                    }
+                    else {
+                        Greeks greeks;
+                        ASSERT_TRUE(analytic.price(&greeks, leg));
+                        price = greeks.d_price;
+                    }
+                    expected += quantities[i] * price;
+                }
+                EXPECT_NEAR(expected, values[(h * vols + v) * spots + s], 3e-3)
+                        << horizon << " " << v << " " << s;
+            }
+        }
+    }
+}
+
+//
+// Concern:
+// Verify that the values do not depend on the number of threads or on
+// which thread ran which task, and that repeated legs are netted.
+//
+// Plan:
+// 1. Value the ladder on one thread and on eight, and expect equal values.
+// 2. Value the spread with the short leg entered twice at -1, and expect
+//    the same values.
+//
+TEST(ScenarioEngineTest, ScheduleDoesNotChangeValues)
+{
+    LegBatch legs;
+    std::vector<double> quantities;
+    ratioSpread(&legs, &quantities);
+    const ScenarioGrid grid = ladder();
+    ScenarioEngine::Config config;
+    config.d_threads = 1;
+    std::vector<double> serial;
+    ScenarioEngine(config).value(&serial, legs, quantities, grid);
+    config.d_threads = 8;
+    std::vector<double> parallel;
+    ScenarioEngine(config).value(&parallel, legs, quantities, grid);
+    EXPECT_EQ(serial, parallel);
+
+    LegBatch repeated;
+    std::vector<double> split;
+    ratioSpread(&repeated, &split);
+    const Leg shortLeg = repeated.leg(1);
+    repeated.addLeg(shortLeg.d_spot,
+            shortLeg.d_strike,
+            shortLeg.d_vol,
+            shortLeg.d_rate,
+            shortLeg.d_expiry,
+            shortLeg.d_isCall,
+            shortLeg.d_isAmerican,
+            std::vector<double>(1, 0.2),
+            std::vector<double>(1, 1.5));
+    split[1] = -1.0;
+    split.push_back(-1.0);
+    std::vector<double> netted;
+    ScenarioEngine(config).value(&netted, repeated, split, grid);
+    EXPECT_EQ(serial, netted);
+}
+
+//
+// Concern:
+// Verify that grids and quantities that cannot be valued are rejected.
+//
+TEST(ScenarioEngineTest, InvalidGridThrows)
+{
+    LegBatch legs;
+    std::vector<double> quantities;
+    ratioSpread(&legs, &quantities);
+    const ScenarioEngine engine;
+    std::vector<double> values;
+
+    ScenarioGrid grid = ladder();
+    EXPECT_THROW(
+            engine.value(&values, legs, std::vector<double>(1, 1.0), grid),
+            std::invalid_argument);
+    grid.d_spotShifts[1] = grid.d_spotShifts[0];
+    EXPECT_THROW(engine.value(&values, legs, quantities, grid),
+            std::invalid_argument);
+    grid = ladder();
+    grid.d_spotShifts[0] = -1.0;
+    EXPECT_THROW(engine.value(&values, legs, quantities, grid),
+            std::invalid_argument);
+    grid = ladder();
+    grid.d_volShifts[0] = -0.3;
+    EXPECT_THROW(engine.value(&values, legs, quantities, grid),
+            std::invalid_argument);
+    grid = ladder();
+    grid.d_horizons[0] = -0.1;
+    EXPECT_THROW(engine.value(&values, legs, quantities, grid),
+            std::invalid_argument);
+
+    grid = ladder();
+    grid.d_horizons.clear();
+    engine.value(&values, legs, quantities, grid);
+    EXPECT_TRUE(values.empty());
+}
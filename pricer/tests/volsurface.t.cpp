@@ -0,0 +1,232 @@
+#include <forwardengine.h>
+#include <volsurface.h>
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace pricer;
+
+namespace {
+// An arbitrage-free SSVI surface to draw quotes from: theta is the at the
+// money total variance, with rho = -0.5 and phi = 1 / sqrt(theta).
+double ssviVol(double strike, double forward, double expiry)
+{
+    const double theta = 0.04 * expiry + 0.01 * (1.0 - std::exp(-expiry));
+    const double rho = -0.5;
+    const double phi = 1.0 / std::sqrt(theta);
+    const double k = std::log(strike / forward);
+    const double w = 0.5 * theta
+            * (1.0 + rho * phi * k
+                    + std::sqrt((phi * k + rho) * (phi * k + rho) + 1.0
+                            - rho * rho));
+    return std::sqrt(w / expiry);
+}
+
+Chain makeChain(std::vector<double> *strikes,
+        std::vector<double> *vols,
+        double expiry,
+        double shift)
+{
+    const double spot = 100.0;
+    const double rate = 0.03;
+    const double forward = spot * std::exp(rate * expiry);
+    const double width = 0.8 * std::sqrt(expiry) + 0.1;
+    strikes->clear();
+    vols->clear();
+    for (int i = -6; i <= 6; ++i) {
+        const double strike = forward * std::exp(width * i / 6.0);
+        strikes->push_back(strike);
+        vols->push_back(ssviVol(strike, forward, expiry) + shift);
+    }
+
+    Chain chain;
+    chain.d_spot = spot;
+    chain.d_rate = rate;
+    chain.d_expiry = expiry;
+    chain.d_dividendTimes = 0;
+    chain.d_dividendAmounts = 0;
+    chain.d_numDividends = 0;
+    chain.d_strikes = &(*strikes)[0];
+    chain.d_vols = &(*vols)[0];
+    chain.d_numStrikes = strikes->size();
+    return chain;
+}
+
+const double k_expiries[] = { 0.1, 0.25, 0.5, 1.0, 2.0 };
+}
+
+//
+// Concern:
+// Verify that quotes drawn from an arbitrage-free surface are fitted by SVI
+// slices and repriced between and beyond the expiries.
+//
+// Plan:
+// 1. Update and publish five expiries of SSVI quotes.
+// 2. Expect every slice to be an SVI fit, and the vol of each quote and of
+//    strikes between the expiries close to the source surface.
+//
+TEST(VolSurfaceTest, FitsArbitrageFreeQuotes)
+{
+    VolSurfaceBuilder builder;
+    EXPECT_FALSE(builder.surface());
+    std::vector<double> strikes;
+    std::vector<double> vols;
+    for (int e = 0; e < 5; ++e) {
+        EXPECT_TRUE(builder.update(
+                makeChain(&strikes, &vols, k_expiries[e], 0.0)));
+    }
+    const std::shared_ptr<const VolSurface> surface = builder.publish();
+    ASSERT_TRUE(surface);
+    EXPECT_EQ(surface, builder.surface());
+    EXPECT_EQ(1u, surface->version());
+    ASSERT_EQ(5u, surface->expiries().size());
+
+    for (int e = 0; e < 5; ++e) {
+        EXPECT_FALSE(surface->isSsvi()[e]) << k_expiries[e];
+        makeChain(&strikes, &vols, k_expiries[e], 0.0);
+        for (std::size_t i = 0; i < strikes.size(); ++i) {
+            EXPECT_NEAR(vols[i],
+                    surface->vol(strikes[i], k_expiries[e]),
+                    1e-4)
+                    << k_expiries[e] << " " << strikes[i];
+        }
+    }
+
+    // Total variance is linear in time at a fixed log-moneyness between
+    // the expiries, and the vol is flat beyond the last.
+    const double expiry = 0.75;
+    const double forward = surface->forward(expiry);
+    EXPECT_NEAR(100.0 * std::exp(0.03 * expiry), forward, 1e-9);
+    const double theta0 = 0.04 * 0.5 + 0.01 * (1.0 - std::exp(-0.5));
+    const double theta1 = 0.04 * 1.0 + 0.01 * (1.0 - std::exp(-1.0));
+    const double atm = std::sqrt(0.5 * (theta0 + theta1) / expiry);
+    EXPECT_NEAR(atm, surface->vol(forward, expiry), 1e-4);
+    EXPECT_NEAR(surface->vol(surface->forward(2.0) * 1.1, 2.0),
+            surface->vol(surface->forward(3.0) * 1.1, 3.0),
+            1e-12);
+}
+
+//
+// Concern:
+// Verify that recalibration is incremental: unchanged quotes publish no new
+// version, and a changed expiry is the only one refitted.
+//
+// Plan:
+// 1. Publish a surface, then update every expiry with the same quotes and
+//    expect the same surface back.
+// 2. Shift the vols of one expiry, publish, and expect a new version in
+//    which only that slice differs.
+// 3. Expect a new rate or dividend to count as a change, and a chain
+//    given again to not.
+//
+TEST(VolSurfaceTest, RefitsOnlyChangedExpiries)
+{
+    VolSurfaceBuilder builder;
+    std::vector<double> strikes;
+    std::vector<double> vols;
+    for (int e = 0; e < 5; ++e) {
+        builder.update(makeChain(&strikes, &vols, k_expiries[e], 0.0));
+    }
+    const std::shared_ptr<const VolSurface> first = builder.publish();
+
+    for (int e = 0; e < 5; ++e) {
+        EXPECT_FALSE(builder.update(
+                makeChain(&strikes, &vols, k_expiries[e], 0.0)));
+    }
+    EXPECT_EQ(first, builder.publish());
+
+    EXPECT_TRUE(
+            builder.update(makeChain(&strikes, &vols, k_expiries[4], 0.01)));
+    const std::shared_ptr<const VolSurface> second = builder.publish();
+    EXPECT_EQ(2u, second->version());
+    EXPECT_EQ(1u, first->version());
+    for (int e = 0; e < 4; ++e) {
+        const SviSlice& before = first->slices()[e];
+        const SviSlice& after = second->slices()[e];
+        EXPECT_EQ(before.d_a, after.d_a);
+        EXPECT_EQ(before.d_b, after.d_b);
+        EXPECT_EQ(before.d_rho, after.d_rho);
+        EXPECT_EQ(before.d_m, after.d_m);
+        EXPECT_EQ(before.d_sigma, after.d_sigma);
+    }
+    const double forward = second->forward(2.0);
+    EXPECT_NEAR(first->vol(forward, 2.0) + 0.01,
+            second->vol(forward, 2.0),
+            1e-4);
+
+    Chain chain = makeChain(&strikes, &vols, k_expiries[2], 0.0);
+    chain.d_rate = 0.031;
+    EXPECT_TRUE(builder.update(chain));
+    EXPECT_FALSE(builder.update(chain));
+    const double times[] = { 0.2 };
+    const double amounts[] = { 1.0 };
+    chain.d_dividendTimes = times;
+    chain.d_dividendAmounts = amounts;
+    chain.d_numDividends = 1;
+    EXPECT_TRUE(builder.update(chain));
+    EXPECT_FALSE(builder.update(chain));
+
+    builder.remove(k_expiries[0]);
+    EXPECT_EQ(4u, builder.publish()->expiries().size());
+}
+
+//
+// Concern:
+// Verify that a slice with calendar arbitrage against the one before is
+// replaced by an SSVI slice that lies above it.
+//
+// Plan:
+// 1. Quote the one year expiry five vol points below the source surface,
+//    so its total variance is below that of six months.
+// 2. Expect that slice to be an SSVI slice, and the total variance to be
+//    non-decreasing in time across the quoted strikes.
+//
+TEST(VolSurfaceTest, CalendarArbitrageIsRemoved)
+{
+    VolSurfaceBuilder builder;
+    std::vector<double> strikes;
+    std::vector<double> vols;
+    for (int e = 0; e < 5; ++e) {
+        const double shift = k_expiries[e] == 1.0 ? -0.05 : 0.0;
+        builder.update(makeChain(&strikes, &vols, k_expiries[e], shift));
+    }
+    const std::shared_ptr<const VolSurface> surface = builder.publish();
+    EXPECT_FALSE(surface->isSsvi()[2]);
+    EXPECT_TRUE(surface->isSsvi()[3]);
+
+    for (double k = -1.0; k <= 1.0; k += 0.05) {
+        for (int e = 1; e < 5; ++e) {
+            EXPECT_GE(surface->totalVariance(k, k_expiries[e]) + 1e-12,
+                    surface->totalVariance(k, k_expiries[e - 1]))
+                    << k << " " << k_expiries[e];
+        }
+    }
+}
+
+//
+// Concern:
+// Verify that invalid chains and queries are rejected.
+//
+TEST(VolSurfaceTest, InvalidInputThrows)
+{
+    VolSurfaceBuilder builder;
+    std::vector<double> strikes;
+    std::vector<double> vols;
+    Chain chain = makeChain(&strikes, &vols, 0.5, 0.0);
+    chain.d_numStrikes = 2;
+    EXPECT_THROW(builder.update(chain), std::invalid_argument);
+
+    chain = makeChain(&strikes, &vols, 0.5, 0.0);
+    vols[3] = 0.0;
+    EXPECT_THROW(builder.update(chain), std::invalid_argument);
+
+    chain = makeChain(&strikes, &vols, 0.5, 0.0);
+    builder.update(chain);
+    const std::shared_ptr<const VolSurface> surface = builder.publish();
+    EXPECT_THROW(surface->vol(0.0, 0.5), std::invalid_argument);
+    EXPECT_THROW(surface->vol(100.0, 0.0), std::invalid_argument);
+}